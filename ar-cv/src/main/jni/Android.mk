@@ -18,6 +18,7 @@ PROJECT_ROOT_FROM_JNI:= ../../../../..
 PROJECT_ROOT:= $(call my-dir)/../../../../..
 TANGO_C_EXAMPLES:=/home/stetro/Source/tango-examples-c
 OPENCV:=/home/stetro/Source/opencv/platforms/build_android_arm/
+NATIVE_CORE:=$(call my-dir)/../../../../native-core
 
 include $(CLEAR_VARS)
 
@@ -28,7 +29,9 @@ include $(OPENCV)/OpenCV.mk
 
 LOCAL_MODULE    := libaugmented_reality_jni_example
 LOCAL_SHARED_LIBRARIES += tango_client_api
+LOCAL_STATIC_LIBRARIES += tango_core
 LOCAL_CFLAGS    += -std=c++11
+LOCAL_ARM_NEON  := true
 
 LOCAL_SRC_FILES += augmented_reality_app.cc \
                    jni_interface.cc \
@@ -62,3 +65,5 @@ include $(BUILD_SHARED_LIBRARY)
 
 $(call import-add-path, $(TANGO_C_EXAMPLES))
 $(call import-module,tango_client_api)
+$(call import-add-path, $(NATIVE_CORE)/..)
+$(call import-module,native-core)
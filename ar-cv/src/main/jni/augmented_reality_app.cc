@@ -15,6 +15,10 @@
  */
 
 #include <tango-gl/conversions.h>
+#include <tango-core/depth_backprojector.h>
+#include <tango-core/depth_splat.h>
+#include <tango-core/pose_buffer.h>
+#include <tango-core/yuv_converter.h>
 
 #include "tango-augmented-reality/augmented_reality_app.h"
 
@@ -35,7 +39,15 @@ TangoCameraIntrinsics depth_camera_intrinsics_;
 tango_augmented_reality::PoseData pose_data_;
 cv::Mat depth;
 
+// The dense cloud is triple buffered: the frame callback fills vertices,
+// publishes it as ready_vertices and the render thread takes it over as
+// render_vertices, swapping instead of copying.
 std::vector <float> vertices;
+std::vector <float> ready_vertices;
+std::vector <float> render_vertices;
+std::mutex vertices_mutex;
+bool vertices_ready = false;
+tango_core::DepthBackProjector back_projector;
 glm::mat4 point_cloud_transformation;
 
 // The defined max distance for a depth value.
@@ -46,30 +58,12 @@ static const int kMeterToMillimeter = 1000;
 
 namespace {
 
-    void Yuv2Rgb(uint8_t yValue, uint8_t uValue, uint8_t vValue, uint8_t *r, uint8_t *g,
-                 uint8_t *b) {
-        *r = yValue + (1.370705 * (vValue - 128));
-        *g = yValue - (0.698001 * (vValue - 128)) - (0.337633 * (uValue - 128));
-        *b = yValue + (1.732446 * (uValue - 128));
-    }
-
-    glm::mat4 GetPoseMatrixAtTimestamp(double timstamp) {
-        TangoPoseData pose_start_service_T_device;
-        TangoCoordinateFramePair frame_pair;
-        frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
-        frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
-        TangoErrorType status = TangoService_getPoseAtTime(
-                timstamp, frame_pair, &pose_start_service_T_device);
-        if (status != TANGO_SUCCESS) {
-            LOGE(
-                    "PoseData: Failed to get transform between the Start of service and "
-                            "device frames at timstamp %lf",
-                    timstamp);
-        }
-        if (pose_start_service_T_device.status_code != TANGO_POSE_VALID) {
-            return glm::mat4(1.0f);
-        }
-        return pose_data_.GetMatrixFromPose(pose_start_service_T_device);
+    // 16 bit depth maps step 0.06 mm up to kMaxDepthDistance
+    tango_core::DepthEncoding DepthMapEncoding() {
+        tango_core::DepthEncoding encoding;
+        encoding.scale = static_cast<float>(kMeterToMillimeter) * USHRT_MAX / kMaxDepthDistance;
+        encoding.offset = 0.0f;
+        return encoding;
     }
 
     const int kVersionStringLength = 128;
@@ -102,6 +96,18 @@ namespace {
         app->onTextureAvailable(id);
     }
 
+// This function routes onPoseAvailable callbacks to the application object for
+// handling.
+//
+// @param context, context will be a pointer to a AugmentedRealityApp
+//        instance on which to call callbacks.
+// @param pose, start of service with respect to device pose.
+    void onPoseAvailableRouter(void *context, const TangoPoseData *pose) {
+        using namespace tango_augmented_reality;
+        AugmentedRealityApp *app = static_cast<AugmentedRealityApp *>(context);
+        app->onPoseAvailable(pose);
+    }
+
 
     void OnPointCloudAvailableRouter(void *context, const TangoXYZij *xyz_ij) {
         if (is_calculating || !is_rendered) {
@@ -116,38 +122,17 @@ namespace {
         is_calculating = true;
 
         //320×180 depth window
-        depth = cv::Mat(320, 180, CV_8UC1);
-        depth.setTo(cv::Scalar(255));
-
-        // load camera intrinsics
-        float fx = static_cast<float>(depth_camera_intrinsics_.fx);
-        float fy = static_cast<float>(depth_camera_intrinsics_.fy);
-        float cx = static_cast<float>(depth_camera_intrinsics_.cx);
-        float cy = static_cast<float>(depth_camera_intrinsics_.cy);
-
-        int width = static_cast<int>(depth_camera_intrinsics_.width);
-        int height = static_cast<int>(depth_camera_intrinsics_.height);
-
-        for (int k = 0; k < xyz_ij->xyz_count; ++k) {
-
-            float X = xyz_ij->xyz[k][0];
-            float Y = xyz_ij->xyz[k][1];
-            float Z = xyz_ij->xyz[k][2];
-
-            // project points with intrinsics
-            int x = static_cast<int>(fx * (X / Z) + cx);
-            int y = static_cast<int>(fy * (Y / Z) + cy);
-
-            if (x < 0 || x > width || y < 0 || y > height) {
-                continue;
-            }
-
-            int depth_value = (Z * kMeterToMillimeter) * UCHAR_MAX / kMaxDepthDistance;
-            if(depth_value <= 255){
-                cv::Point point(y, x);
-                line(depth, point, point, cv::Scalar(depth_value), 7.0);
-            }
-        }
+        depth = cv::Mat(320, 180, CV_16UC1);
+        depth.setTo(cv::Scalar(USHRT_MAX));
+
+        // splat every point as a 7x7 square, the nearest point wins
+        tango_core::SplatDepth(xyz_ij->xyz[0], xyz_ij->xyz_count,
+                               static_cast<float>(depth_camera_intrinsics_.fx),
+                               static_cast<float>(depth_camera_intrinsics_.fy),
+                               static_cast<float>(depth_camera_intrinsics_.cx),
+                               static_cast<float>(depth_camera_intrinsics_.cy),
+                               DepthMapEncoding(), 3, true, depth.ptr<uint16_t>(), depth.rows, depth.cols,
+                               depth.step);
         catch_image = true;
     }
 
@@ -162,41 +147,18 @@ namespace {
         LOGD("getting color grame");
         int yuv_width_ = buffer->width;
         int yuv_height_ = buffer->height;
-        int uv_buffer_offset_ = yuv_width_ * yuv_height_;
-        int yuv_size_ = yuv_width_ * yuv_height_ + yuv_width_ * yuv_height_ / 2;
-        std::vector <uint8_t> yuv_temp_buffer_;
-        yuv_temp_buffer_.resize(yuv_size_);
-        memcpy(&yuv_temp_buffer_[0], buffer->data, yuv_size_);
 
-
-        cv::Mat rgb = cv::Mat(yuv_width_, yuv_height_, CV_8UC3);
+        // convert at half resolution straight from the camera buffer and
+        // transpose into the 640x360 layout of the depth map
+        cv::Mat rgb = cv::Mat(yuv_height_ / 2, yuv_width_ / 2, CV_8UC3);
         cv::Mat scaled_rgb = cv::Mat(640, 360, CV_8UC3);
         cv::Mat scaled_rgb_grayscale = cv::Mat(640, 360, CV_8UC1);
-        for (size_t i = 0; i < yuv_height_; ++i) {
-            for (size_t j = 0; j < yuv_width_; ++j) {
-                size_t x_index = j;
-                if (j % 2 != 0) {
-                    x_index = j - 1;
-                }
-
-                size_t rgb_index = (i * yuv_width_ + j) * 3;
-                uint8_t red;
-                uint8_t green;
-                uint8_t blue;
-                Yuv2Rgb(yuv_temp_buffer_[i * yuv_width_ + j],
-                        yuv_temp_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index + 1],
-                        yuv_temp_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index],
-                        &red, &green, &blue);
-
-                rgb.at<cv::Vec3b>(j, i)[0] = red;
-                rgb.at<cv::Vec3b>(j, i)[1] = green;
-                rgb.at<cv::Vec3b>(j, i)[2] = blue;
-            }
-        }
-        resize(rgb, scaled_rgb, scaled_rgb.size());
+        tango_core::ConvertNV21ToRGB(buffer->data, yuv_width_, yuv_height_, 2, false, rgb.ptr(),
+                                     rgb.step);
+        cv::transpose(rgb, scaled_rgb);
         cv::cvtColor(scaled_rgb, scaled_rgb_grayscale, CV_BGR2GRAY);
 
-        cv::Mat scaled_gray = cv::Mat(640, 360, CV_8UC1);
+        cv::Mat scaled_gray = cv::Mat(640, 360, CV_16UC1);
         resize(depth, scaled_gray, scaled_gray.size());
         LOGD("converted YUV to RGB frame");
 
@@ -207,34 +169,24 @@ namespace {
 //        cv::Mat depth_copy(320, 180, CV_8UC1);
 //        bilateralFilter(depth, depth_copy, 4, 50, 50);
 
-        // 320x180 pixel array with depth coordinates
+        // back-project the filtered 640x360 map, the rays are built once from
+        // the intrinsics at twice the depth camera resolution
         LOGD("create pointcloud ...");
-
-        float fx = static_cast<float>(depth_camera_intrinsics_.fx) * 2;
-        float fy = static_cast<float>(depth_camera_intrinsics_.fy) * 2;
-        float cx = static_cast<float>(depth_camera_intrinsics_.cx) * 2;
-        float cy = static_cast<float>(depth_camera_intrinsics_.cy) * 2;
-
-
-        vertices.clear();
-
-        for (int x = 0; x < 640; ++x) {
-            for (int y = 0; y < 360; ++y) {
-                int depth_value = scaled_gray.at<uint8_t>(x, y);
-
-
-                float Z = ((float) depth_value * (float) kMaxDepthDistance) /
-                          ((float) UCHAR_MAX * (float) kMeterToMillimeter);
-                float Y = (y - cy) / fy * Z;
-                float X = (x - cx) / fx * Z;
-
-
-                glm::vec3 vector(X * 0.9, Y * 1.2, Z);
-
-                vertices.push_back(vector.x);
-                vertices.push_back(vector.y);
-                vertices.push_back(vector.z);
-            }
+        if (back_projector.rows() != scaled_gray.rows || back_projector.cols() != scaled_gray.cols) {
+            // the 0.9 and 1.2 stretch of x and y is folded into the focal lengths
+            back_projector.Reset(scaled_gray.rows, scaled_gray.cols,
+                                 static_cast<float>(depth_camera_intrinsics_.fx) * 2 / 0.9f,
+                                 static_cast<float>(depth_camera_intrinsics_.fy) * 2 / 1.2f,
+                                 static_cast<float>(depth_camera_intrinsics_.cx) * 2,
+                                 static_cast<float>(depth_camera_intrinsics_.cy) * 2,
+                                 true, DepthMapEncoding());
+        }
+        vertices.resize(scaled_gray.total() * 3);
+        back_projector.BackProject(scaled_gray.ptr<uint16_t>(), scaled_gray.step, vertices.data());
+        {
+            std::lock_guard <std::mutex> lock(vertices_mutex);
+            vertices.swap(ready_vertices);
+            vertices_ready = true;
         }
 
         LOGD("DONE");
@@ -258,9 +210,7 @@ namespace tango_augmented_reality {
         }
     }
 
-    AugmentedRealityApp::AugmentedRealityApp()
-            : calling_activity_obj_(nullptr), on_demand_render_(nullptr) {
-        main_scene_.SetCloud(vertices);
+    AugmentedRealityApp::AugmentedRealityApp() : java_vm_(nullptr) {
         main_scene_.SetPointCloudCameraTransformation(point_cloud_transformation);
     }
 
@@ -277,22 +227,13 @@ namespace tango_augmented_reality {
         // We want to be able to trigger rendering on demand in our Java code.
         // As such, we need to store the activity we'd like to interact with and the
         // id of the method we'd like to call on that activity.
-        jclass cls = env->GetObjectClass(caller_activity);
-        on_demand_render_ = env->GetMethodID(cls, "requestRender", "()V");
-
-        calling_activity_obj_ =
-                reinterpret_cast<jobject>(env->NewGlobalRef(caller_activity));
+        render_requester_.Bind(env, java_vm_, caller_activity, "requestRender");
 
         return ret;
     }
 
     void AugmentedRealityApp::ActivityDestroyed() {
-        JNIEnv *env;
-        java_vm_->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6);
-        env->DeleteGlobalRef(calling_activity_obj_);
-
-        calling_activity_obj_ = nullptr;
-        on_demand_render_ = nullptr;
+        render_requester_.Unbind(tango_core::GetThreadJniEnv(java_vm_));
     }
 
     int AugmentedRealityApp::TangoSetupConfig() {
@@ -388,6 +329,18 @@ namespace tango_augmented_reality {
             return ret;
         }
 
+        // Attach onPoseAvailable callback, it fills the pose buffer frames look
+        // their poses up in.
+        TangoCoordinateFramePair frame_pair;
+        frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+        frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
+        ret = TangoService_connectOnPoseAvailable(1, &frame_pair, onPoseAvailableRouter);
+        if (ret != TANGO_SUCCESS) {
+            LOGE("AugmentedRealityApp: Failed to connect to pose callback with error"
+                         "code: %d", ret);
+            return ret;
+        }
+
         return ret;
     }
 
@@ -425,6 +378,7 @@ namespace tango_augmented_reality {
 
     void AugmentedRealityApp::TangoResetMotionTracking() {
         main_scene_.ResetTrajectory();
+        pose_buffer_.Clear();
         TangoService_resetMotionTracking();
     }
 
@@ -434,6 +388,8 @@ namespace tango_augmented_reality {
     }
 
     void AugmentedRealityApp::InitializeGLContent() {
+        // a render queued for the old surface never ran
+        render_requester_.Reset();
         main_scene_.InitGLContent();
 
         // Connect color camera texture. TangoService_connectTextureId expects a valid
@@ -524,6 +480,8 @@ namespace tango_augmented_reality {
     }
 
     void AugmentedRealityApp::Render() {
+        // frames arriving from here on need another render
+        render_requester_.OnRender();
 
         while (!do_pause) {
             if (new_points) {
@@ -536,23 +494,27 @@ namespace tango_augmented_reality {
         TangoErrorType status = TangoService_updateTexture(TANGO_CAMERA_COLOR,
                                                            &timestamp);
 
-        if (!do_pause) {
-            point_cloud_transformation = GetPoseMatrixAtTimestamp(timestamp);
-            point_cloud_transformation = pose_data_.GetExtrinsicsAppliedOpenGLWorldFrame(
-                    point_cloud_transformation);
-        }
-
+        // both are taken at the color frame timestamp
         glm::mat4 color_camera_pose = GetPoseMatrixAtTimestamp(timestamp);
         is_rendered = true;
         color_camera_pose =
                 pose_data_.GetExtrinsicsAppliedOpenGLWorldFrame(color_camera_pose);
+        if (!do_pause) {
+            point_cloud_transformation = color_camera_pose;
+        }
         if (status != TANGO_SUCCESS) {
             LOGE("AugmentedRealityApp: Failed to update video overlay texture with error code: %d",
                  status);
         }
 
-        std::vector <float> point_cloud_vertices = vertices;
-        main_scene_.SetCloud(point_cloud_vertices);
+        {
+            std::lock_guard <std::mutex> lock(vertices_mutex);
+            if (vertices_ready) {
+                render_vertices.swap(ready_vertices);
+                vertices_ready = false;
+                main_scene_.SetCloud(render_vertices);
+            }
+        }
         LOGD("added new pointscloud into scene");
         main_scene_.SetPointCloudCameraTransformation(point_cloud_transformation);
         main_scene_.Render(color_camera_pose);
@@ -589,14 +551,14 @@ namespace tango_augmented_reality {
         LOGI("Touch Event at %d x %d", x, y);
         x = x / 6;
         y = y / 6;
-        uint8_t depth_value = depth.at<uint8_t>(x, y);
+        uint16_t depth_value = depth.at<uint16_t>(x, y);
         float fx = static_cast<float>(depth_camera_intrinsics_.fx);
         float fy = static_cast<float>(depth_camera_intrinsics_.fy);
         float cx = static_cast<float>(depth_camera_intrinsics_.cx);
         float cy = static_cast<float>(depth_camera_intrinsics_.cy);
 
         float Z = ((float) depth_value * (float) kMaxDepthDistance) /
-                  ((float) UCHAR_MAX * (float) kMeterToMillimeter);
+                  ((float) USHRT_MAX * (float) kMeterToMillimeter);
         float Y = (y - cy) / fy * Z;
         float X = (x - cx) / fx * Z;
 
@@ -605,8 +567,27 @@ namespace tango_augmented_reality {
 
     }
 
+    void AugmentedRealityApp::onPoseAvailable(const TangoPoseData *pose) {
+        {
+            std::lock_guard <std::mutex> lock(pose_mutex_);
+            pose_data_.UpdatePose(pose);
+        }
+        if (pose->status_code == TANGO_POSE_VALID) {
+            pose_buffer_.Insert(pose->timestamp, pose->translation, pose->orientation);
+        } else {
+            // poses from before a reset do not connect to the ones after it
+            pose_buffer_.Clear();
+        }
+    }
+
     glm::mat4 AugmentedRealityApp::GetPoseMatrixAtTimestamp(double timstamp) {
         TangoPoseData pose_start_service_T_device;
+        if (pose_buffer_.Lookup(timstamp, pose_start_service_T_device.translation,
+                                pose_start_service_T_device.orientation)) {
+            return pose_data_.GetMatrixFromPose(pose_start_service_T_device);
+        }
+
+        // not buffered yet or across a gap, ask the service
         TangoCoordinateFramePair frame_pair;
         frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
         frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
@@ -619,11 +600,6 @@ namespace tango_augmented_reality {
                     timstamp);
         }
 
-        {
-            std::lock_guard <std::mutex> lock(pose_mutex_);
-            pose_data_.UpdatePose(&pose_start_service_T_device);
-        }
-
         if (pose_start_service_T_device.status_code != TANGO_POSE_VALID) {
             return glm::mat4(1.0f);
         }
@@ -666,15 +642,11 @@ namespace tango_augmented_reality {
     }
 
     void AugmentedRealityApp::RequestRender() {
-        if (calling_activity_obj_ == nullptr || on_demand_render_ == nullptr) {
+        // Here, we notify the Java activity that we'd like it to trigger a render,
+        // unless it still has one queued.
+        if (!render_requester_.Request()) {
             LOGE("Can not reference Activity to request render");
-            return;
         }
-
-        // Here, we notify the Java activity that we'd like it to trigger a render.
-        JNIEnv *env;
-        java_vm_->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6);
-        env->CallVoidMethod(calling_activity_obj_, on_demand_render_);
     }
 
 
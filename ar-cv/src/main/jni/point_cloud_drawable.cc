@@ -68,9 +68,23 @@ namespace tango_augmented_reality {
         }
     }
 
+    void PointCloudDrawable::UpdateVertices(const std::vector <float> &vertices) {
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_);
+        if (vertices.size() > buffer_capacity_) {
+            glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(),
+                         vertices.data(), GL_DYNAMIC_DRAW);
+            buffer_capacity_ = vertices.size();
+        } else if (!vertices.empty()) {
+            glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(GLfloat) * vertices.size(),
+                            vertices.data());
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        point_count_ = vertices.size() / 3;
+        tango_gl::util::CheckGlError("Pointcloud::UpdateVertices()");
+    }
+
     void PointCloudDrawable::Render(glm::mat4 projection_mat, glm::mat4 view_mat,
-                                    glm::mat4 model_mat,
-                                    const std::vector <float> &vertices) {
+                                    glm::mat4 model_mat) {
         glUseProgram(shader_program_);
         vertices_visible_handle_ = glGetUniformLocation(shader_program_, "visible");
         if (visible) {
@@ -85,13 +99,11 @@ namespace tango_augmented_reality {
         glUniformMatrix4fv(mvp_handle_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
 
         glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(),
-                     vertices.data(), GL_STATIC_DRAW);
         glEnableVertexAttribArray(vertices_handle_);
         glVertexAttribPointer(vertices_handle_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glDrawArrays(GL_POINTS, 0, vertices.size() / 3);
+        glDrawArrays(GL_POINTS, 0, point_count_);
 
         glUseProgram(0);
         tango_gl::util::CheckGlError("Pointcloud::Render()");
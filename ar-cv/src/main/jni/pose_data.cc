@@ -24,7 +24,11 @@ const float kMeterToMillimeter = 1000.0f;
 
 namespace tango_augmented_reality {
 
-PoseData::PoseData() {}
+PoseData::PoseData()
+    : opengl_world_T_tango_world_(
+          tango_gl::conversions::opengl_world_T_tango_world()) {
+  UpdateCameraFrame();
+}
 
 PoseData::~PoseData() {}
 
@@ -65,9 +69,13 @@ glm::mat4 PoseData::GetExtrinsicsAppliedOpenGLWorldFrame(
   //   https://developers.google.com/project-tango/overview/frames-of-reference
   // Coordinate System Conventions:
   //   https://developers.google.com/project-tango/overview/coordinate-systems
-  return tango_gl::conversions::opengl_world_T_tango_world() * pose_matrix *
-         glm::inverse(GetImuTDevice()) * GetImuTColorCamera() *
-         tango_gl::conversions::color_camera_T_opengl_camera();
+  return opengl_world_T_tango_world_ * pose_matrix * device_T_opengl_camera_;
+}
+
+void PoseData::UpdateCameraFrame() {
+  device_T_opengl_camera_ =
+      glm::inverse(imu_T_device_) * imu_T_color_camera_ *
+      tango_gl::conversions::color_camera_T_opengl_camera();
 }
 
 glm::mat4 PoseData::GetMatrixFromPose(const TangoPoseData& pose) {
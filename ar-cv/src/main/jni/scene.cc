@@ -145,7 +145,7 @@ namespace tango_augmented_reality {
 
         point_cloud_->Render(gesture_camera_->GetProjectionMatrix(),
                              gesture_camera_->GetViewMatrix(),
-                             point_cloud_camera_transformation, point_cloud_vertices);
+                             point_cloud_camera_transformation);
 
 
         marker_->Render(ar_camera_projection_matrix_,
@@ -33,6 +33,8 @@
 
 #include <tango_client_api.h>  // NOLINT
 #include <tango-gl/util.h>
+#include <tango-core/pose_buffer.h>
+#include <tango-core/render_requester.h>
 
 #include <tango-augmented-reality/pose_data.h>
 #include <tango-augmented-reality/scene.h>
@@ -103,6 +105,12 @@ class AugmentedRealityApp {
   // @param id: camera Id of the updated camera.
   void onTextureAvailable(TangoCameraId id);
 
+  // Tango service pose callback. Called for every start of service with
+  // respect to device pose.
+  //
+  // @param pose: pose data, caller allocated.
+  void onPoseAvailable(const TangoPoseData* pose);
+
   // Allocate OpenGL resources for rendering, mainly initializing the Scene.
   void InitializeGLContent();
 
@@ -180,6 +188,9 @@ class AugmentedRealityApp {
   // thread and TangoService callback thread.
   std::mutex pose_mutex_;
 
+  // poses of the pose callback, color frames look up theirs here
+  tango_core::PoseBuffer pose_buffer_;
+
   // tango_event_data_ handles all Tango event callbacks,
   // onTangoEventAvailable() in this object will be routed to tango_event_data_
   // to handle.
@@ -209,12 +220,10 @@ class AugmentedRealityApp {
   // Tango service version string.
   std::string tango_core_version_string_;
 
-  // Cached Java VM, caller activity object and the request render method. These
-  // variables are used for on demand render request from the onTextureAvailable
-  // callback.
+  // Cached Java VM and the caller activity's request render method, used for
+  // on demand render requests from the onTextureAvailable callback.
   JavaVM* java_vm_;
-  jobject calling_activity_obj_;
-  jmethodID on_demand_render_;
+  tango_core::RenderRequester render_requester_;
 };
 }  // namespace tango_augmented_reality
 
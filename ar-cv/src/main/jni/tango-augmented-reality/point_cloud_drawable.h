@@ -31,14 +31,18 @@ class PointCloudDrawable {
   // Free all GL Resources, i.e, shaders, buffers.
   void DeleteGlResources();
 
-  // Update current point cloud data.
+  // Update current point cloud data. The buffer is reallocated only when it
+  // grows, otherwise the vertices are written into it in place.
+  //
+  // @param vertices: all vertices in this point cloud frame.
+  void UpdateVertices(const std::vector<float>& vertices);
+
+  // Render the last uploaded point cloud.
   //
   // @param projection_mat: projection matrix from current render camera.
   // @param view_mat: view matrix from current render camera.
   // @param model_mat: model matrix for this point cloud frame.
-  // @param vertices: all vertices in this point cloud frame.
-  void Render(glm::mat4 projection_mat, glm::mat4 view_mat, glm::mat4 model_mat,
-              const std::vector<float>& vertices);
+  void Render(glm::mat4 projection_mat, glm::mat4 view_mat, glm::mat4 model_mat);
 
  void SetVisibility(bool visible);
 
@@ -46,6 +50,10 @@ class PointCloudDrawable {
   // Vertex buffer of the point cloud geometry.
   GLuint vertex_buffers_;
 
+  // Floats allocated in and points uploaded to the vertex buffer.
+  size_t buffer_capacity_ = 0;
+  size_t point_count_ = 0;
+
   // Shader to display point cloud.
   GLuint shader_program_;
 
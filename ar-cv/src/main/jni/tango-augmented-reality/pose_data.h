@@ -55,6 +55,7 @@ class PoseData {
   // @param: imu_T_device, imu_T_device_ matrix.
   void SetImuTDevice(const glm::mat4& imu_T_device) {
     imu_T_device_ = imu_T_device;
+    UpdateCameraFrame();
   }
 
   // @return: color camera frame with respect to IMU frame.
@@ -64,6 +65,7 @@ class PoseData {
   // @param: imu_T_color_camera, imu_T_color_camera_ matrix.
   void SetImuTColorCamera(const glm::mat4& imu_T_color_camera) {
     imu_T_color_camera_ = imu_T_color_camera;
+    UpdateCameraFrame();
   }
 
   // Get pose transformation in OpenGL coordinate system. This function also
@@ -89,12 +91,20 @@ class PoseData {
   // Format the pose debug string based on current pose and previous pose data.
   void FormatPoseString();
 
+  // Precomputes the constant part of the extrinsics chain, called whenever
+  // one of the extrinsics is set.
+  void UpdateCameraFrame();
+
   // Device frame with respect to IMU frame.
   glm::mat4 imu_T_device_;
 
   // Color camera frame with respect to IMU frame.
   glm::mat4 imu_T_color_camera_;
 
+  // Constant factors of the chain, the pose is the only part that changes.
+  glm::mat4 opengl_world_T_tango_world_;
+  glm::mat4 device_T_opengl_camera_;
+
   // Pose data of current frame.
   TangoPoseData cur_pose_;
 
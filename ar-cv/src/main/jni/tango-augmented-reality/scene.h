@@ -109,8 +109,9 @@ namespace tango_augmented_reality {
         // @param: scale, frustum's scale.
         void SetFrustumScale(const glm::vec3 &scale) { frustum_->SetScale(scale); }
 
-        void SetCloud(std::vector <float> _point_cloud_vertices) {
-            point_cloud_vertices = _point_cloud_vertices;
+        // Uploads the vertices into the point cloud buffer, call on the GL thread.
+        void SetCloud(const std::vector <float> &point_cloud_vertices) {
+            point_cloud_->UpdateVertices(point_cloud_vertices);
         }
 
         void SetPointCloudCameraTransformation(glm::mat4 _point_cloud_camera_transformation) {
@@ -144,8 +145,6 @@ namespace tango_augmented_reality {
         // Device axis (in device frame of reference).
         tango_gl::Axis *axis_;
 
-        std::vector <float> point_cloud_vertices;
-
         // Device frustum.
         tango_gl::Frustum *frustum_;
 
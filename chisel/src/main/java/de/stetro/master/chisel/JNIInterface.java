@@ -2,6 +2,9 @@
 package de.stetro.master.chisel;
 
 
+import java.nio.ByteBuffer;
+import java.nio.FloatBuffer;
+
 public class JNIInterface {
     static {
         System.loadLibrary("chisel");
@@ -9,8 +12,30 @@ public class JNIInterface {
 
     public static native void addPoints(float[] vertices, float[] transformation);
 
+    /**
+     * Integrates count points read in place from a direct buffer.
+     */
+    public static native void addPointsDirect(FloatBuffer vertices, int count, float[] transformation);
+
     public static native float[] getMesh();
 
+    /**
+     * Writes the mesh triangles into a direct buffer if they fit.
+     *
+     * @return number of floats of the mesh, the buffer is left untouched if
+     * this exceeds its capacity
+     */
+    public static native int getMeshDirect(FloatBuffer mesh);
+
+    /**
+     * Writes the chunks changed after sinceVersion into a direct buffer, see
+     * ChunkMeshDelta for reading it.
+     *
+     * @return size of the delta in bytes, the buffer is left untouched if this
+     * exceeds its capacity
+     */
+    public static native int getMeshDelta(long sinceVersion, ByteBuffer delta);
+
     public static native void clear();
 
     public static native void update();
@@ -16,24 +16,39 @@ import org.rajawali3d.math.Quaternion;
 import org.rajawali3d.math.vector.Vector3;
 import org.rajawali3d.primitives.Cube;
 
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.nio.FloatBuffer;
 import java.util.ArrayList;
+import java.util.HashMap;
 import java.util.List;
+import java.util.Map;
 import java.util.Stack;
 
 import de.stetro.master.chisel.JNIInterface;
+import de.stetro.master.chisel.util.ChunkMeshDelta;
 import de.stetro.master.chisel.util.PLYExporter;
 import de.stetro.master.chisel.util.PointCloudManager;
 
 
 public class PointCloudARRenderer extends TangoRajawaliRenderer {
     private static final int MAX_POINTS = 20000;
+    // floats of the first mesh buffer, it doubles when a mesh does not fit
+    private static final int INITIAL_MESH_FLOATS = 3 * 3 * 20000;
     private static final String tag = PointCloudARRenderer.class.getSimpleName();
     private Points currentPoints;
 
     private PointCloudManager pointCloudManager;
-    private Polygon polygon;
+    // one polygon per chisel chunk, replaced when the chunk changes
+    private Map<Long, Polygon> chunkPolygons = new HashMap<>();
+    private ChunkMeshDelta meshDelta = new ChunkMeshDelta();
+    // fetched chunks waiting for the render thread, guarded by pointCloudManager
+    private List<ChunkMeshDelta.Chunk> pendingChunks = new ArrayList<>();
     private boolean isRunning = true;
-    private float[] mesh;
+    // whole mesh for the export, reused by every getMeshDirect, meshLength
+    // floats of it are valid
+    private FloatBuffer mesh = allocateMeshBuffer(INITIAL_MESH_FLOATS);
+    private int meshLength;
     private boolean updateMesh;
     private Cube cube;
 
@@ -63,20 +78,41 @@ public class PointCloudARRenderer extends TangoRajawaliRenderer {
         if (pointCloudManager != null) {
             long measure = System.currentTimeMillis();
             Pose pose = mScenePoseCalcuator.toOpenGLPointCloudPose(pointCloudManager.getDevicePoseAtCloudTime());
-            float[] points = pointCloudManager.getPoints();
             Matrix4 transformation = poseToTransformation(pose);
-            Vector3 aPoint = new Vector3(points[0], points[1], points[2]);
+            Vector3 aPoint = pointCloudManager.getFirstPoint();
             cube.setPosition(aPoint.multiply(transformation));
             float[] values = transformation.getFloatValues();
             float[] copy = swapMatrixFloatRepresentation(values);
-            JNIInterface.addPoints(points, copy);
+            pointCloudManager.integratePoints(copy);
             JNIInterface.update();
-            mesh = JNIInterface.getMesh();
-            updateMesh = true;
+            fetchMeshDelta();
             Log.d(tag, "Operation took " + (System.currentTimeMillis() - measure) + "ms");
         }
     }
 
+    private void fetchMeshDelta() {
+        synchronized (pointCloudManager) {
+            pendingChunks.addAll(meshDelta.fetch());
+            updateMesh = true;
+        }
+    }
+
+    private static FloatBuffer allocateMeshBuffer(int floats) {
+        return ByteBuffer.allocateDirect(floats * 4).order(ByteOrder.nativeOrder()).asFloatBuffer();
+    }
+
+    /**
+     * Copies the native mesh into mesh, growing it only if the mesh outgrew it.
+     */
+    private void fetchMesh() {
+        int length = JNIInterface.getMeshDirect(mesh);
+        if (length > mesh.capacity()) {
+            mesh = allocateMeshBuffer(Math.max(length, mesh.capacity() * 2));
+            length = JNIInterface.getMeshDirect(mesh);
+        }
+        meshLength = length;
+    }
+
     private float[] swapMatrixFloatRepresentation(float[] values) {
         float[] copy = new float[16];
         copy[0] = values[Matrix4.M00];
@@ -125,29 +161,32 @@ public class PointCloudARRenderer extends TangoRajawaliRenderer {
                 updateMesh = false;
 
                 synchronized (pointCloudManager) {
-
-                    if (polygon != null) {
-                        getCurrentScene().removeChild(polygon);
-                    }
-                    Stack<Vector3> faces = new Stack<>();
-                    for (int i = 0; i < mesh.length / 3; i++) {
-                        faces.add(new Vector3(mesh[i * 3], mesh[i * 3 + 1], mesh[i * 3 + 2]));
+                    for (ChunkMeshDelta.Chunk chunk : pendingChunks) {
+                        Polygon old = chunkPolygons.remove(chunk.key);
+                        if (old != null) {
+                            getCurrentScene().removeChild(old);
+                        }
+                        if (chunk.isRemoved()) {
+                            continue;
+                        }
+                        Polygon polygon = new Polygon(chunk.positions, chunk.normals, chunk.indices);
+                        polygon.setTransparent(true);
+                        polygon.setMaterial(Materials.getDepthMaterial());
+                        polygon.setDepthTestEnabled(true);
+                        polygon.setDoubleSided(true);
+                        getCurrentScene().addChild(polygon);
+                        chunkPolygons.put(chunk.key, polygon);
                     }
-                    polygon = new Polygon(faces);
-                    polygon.setTransparent(true);
-                    polygon.setMaterial(Materials.getDepthMaterial());
-                    polygon.setDepthTestEnabled(true);
-                    polygon.setDoubleSided(true);
-                    getCurrentScene().addChild(polygon);
+                    pendingChunks.clear();
                 }
             }
         }
     }
 
-    public void setFaces(Stack<Vector3> faces) {
-        float[] mesh = JNIInterface.getMesh();
-        for (int i = 0; i < mesh.length / 3; i++) {
-            faces.add(new Vector3(mesh[i * 3], mesh[i * 3 + 1], mesh[i * 3 + 2]));
+    public synchronized void setFaces(Stack<Vector3> faces) {
+        fetchMesh();
+        for (int i = 0; i < meshLength / 3; i++) {
+            faces.add(new Vector3(mesh.get(i * 3), mesh.get(i * 3 + 1), mesh.get(i * 3 + 2)));
         }
     }
 
@@ -156,9 +195,10 @@ public class PointCloudARRenderer extends TangoRajawaliRenderer {
     }
 
     public void clearPoints() {
-        if (polygon != null) {
-            getCurrentScene().removeChild(polygon);
-            JNIInterface.clear();
+        JNIInterface.clear();
+        if (pointCloudManager != null) {
+            // the delta removes the chunk polygons on the render thread
+            fetchMeshDelta();
         }
     }
 
@@ -168,10 +208,11 @@ public class PointCloudARRenderer extends TangoRajawaliRenderer {
     }
 
     public void exportMesh() {
-        if (mesh.length > 0) {
+        fetchMesh();
+        if (meshLength > 0) {
             List<Vector3> vertices = new ArrayList<>();
-            for (int i = 0; i < mesh.length / 3; i++) {
-                vertices.add(new Vector3(mesh[i * 3], mesh[i * 3 + 1], mesh[i * 3 + 2]));
+            for (int i = 0; i < meshLength / 3; i++) {
+                vertices.add(new Vector3(mesh.get(i * 3), mesh.get(i * 3 + 1), mesh.get(i * 3 + 2)));
             }
             PLYExporter plyExporter = new PLYExporter(getContext(), vertices);
             plyExporter.export();
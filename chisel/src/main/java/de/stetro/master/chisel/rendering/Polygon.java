@@ -4,6 +4,7 @@ package de.stetro.master.chisel.rendering;
 import org.rajawali3d.Object3D;
 import org.rajawali3d.math.vector.Vector3;
 
+import java.nio.FloatBuffer;
 import java.util.Stack;
 
 public class Polygon extends Object3D {
@@ -15,12 +16,46 @@ public class Polygon extends Object3D {
         init();
     }
 
-    private void init() {
+    /**
+     * Triangles of the first length floats of mesh, read without Vector3s.
+     */
+    public Polygon(FloatBuffer mesh, int length) {
+        super();
+        int numVertices = length / 3;
+        float[] vertices = new float[numVertices * 3];
+        mesh.position(0);
+        mesh.get(vertices, 0, numVertices * 3);
+        mesh.position(0);
+        init(vertices);
+    }
+
+    /**
+     * Indexed triangles with their vertex normals.
+     */
+    public Polygon(float[] vertices, float[] normals, int[] indices) {
+        super();
         setDoubleSided(true);
+        float[] textureCoors = new float[vertices.length / 3 * 2];
+        setData(vertices, normals, textureCoors, null, indices, false);
+    }
 
+    private void init() {
         int numVertices = mPoints.size();
-
         float[] vertices = new float[numVertices * 3];
+        for (int i = 0; i < numVertices; i++) {
+            Vector3 point = mPoints.get(i);
+            vertices[i * 3] = (float) point.x;
+            vertices[i * 3 + 1] = (float) point.y;
+            vertices[i * 3 + 2] = (float) point.z;
+        }
+        init(vertices);
+    }
+
+    private void init(float[] vertices) {
+        setDoubleSided(true);
+
+        int numVertices = vertices.length / 3;
+
         float[] textureCoors = new float[numVertices * 2];
         float[] normals = new float[numVertices * 3];
 
@@ -28,11 +63,7 @@ public class Polygon extends Object3D {
 
 
         for (int i = 0; i < numVertices; i++) {
-            Vector3 point = mPoints.get(i);
             int index = i * 3;
-            vertices[index] = (float) point.x;
-            vertices[index + 1] = (float) point.y;
-            vertices[index + 2] = (float) point.z;
             normals[index] = 0;
             normals[index + 1] = 0;
             normals[index + 2] = 1;
@@ -0,0 +1,98 @@
+package de.stetro.master.chisel.util;
+
+
+import java.nio.ByteBuffer;
+import java.nio.ByteOrder;
+import java.util.ArrayList;
+import java.util.List;
+
+import de.stetro.master.chisel.JNIInterface;
+
+/**
+ * Fetches the chunk meshes changed since the last fetch, so the transfer
+ * scales with the change instead of the size of the reconstruction. The
+ * buffer is reused and only grows when a delta does not fit.
+ */
+public class ChunkMeshDelta {
+    private static final int INITIAL_BYTES = 1024 * 1024;
+
+    private ByteBuffer buffer = allocate(INITIAL_BYTES);
+    private long version = 0;
+
+    public static class Chunk {
+        public final long key;
+        // all null if the chunk lost its surface
+        public final float[] positions;
+        public final float[] normals;
+        public final int[] indices;
+
+        Chunk(long key, float[] positions, float[] normals, int[] indices) {
+            this.key = key;
+            this.positions = positions;
+            this.normals = normals;
+            this.indices = indices;
+        }
+
+        public boolean isRemoved() {
+            return indices == null;
+        }
+    }
+
+    private static ByteBuffer allocate(int bytes) {
+        return ByteBuffer.allocateDirect(bytes).order(ByteOrder.nativeOrder());
+    }
+
+    /**
+     * Packs a chunk id into one map key, 21 bits per axis.
+     */
+    public static long key(int x, int y, int z) {
+        final long mask = (1L << 21) - 1;
+        return ((x & mask) << 42) | ((y & mask) << 21) | (z & mask);
+    }
+
+    /**
+     * Starts over with the whole mesh on the next fetch.
+     */
+    public void reset() {
+        version = 0;
+    }
+
+    /**
+     * @return the removed chunks first, then the changed ones
+     */
+    public List<Chunk> fetch() {
+        int size = JNIInterface.getMeshDelta(version, buffer);
+        if (size > buffer.capacity()) {
+            buffer = allocate(Math.max(size, buffer.capacity() * 2));
+            size = JNIInterface.getMeshDelta(version, buffer);
+        }
+        List<Chunk> chunks = new ArrayList<>();
+        if (size <= 0 || size > buffer.capacity()) {
+            return chunks;
+        }
+        buffer.position(0);
+        version = buffer.getLong();
+        int changedCount = buffer.getInt();
+        int removedCount = buffer.getInt();
+        for (int i = 0; i < removedCount; i++) {
+            chunks.add(new Chunk(key(buffer.getInt(), buffer.getInt(), buffer.getInt()), null, null, null));
+        }
+        for (int i = 0; i < changedCount; i++) {
+            long key = key(buffer.getInt(), buffer.getInt(), buffer.getInt());
+            int vertexCount = buffer.getInt();
+            int indexCount = buffer.getInt();
+            float[] positions = new float[vertexCount * 3];
+            float[] normals = new float[vertexCount * 3];
+            int[] indices = new int[indexCount];
+            buffer.asFloatBuffer().get(positions);
+            buffer.position(buffer.position() + positions.length * 4);
+            buffer.asFloatBuffer().get(normals);
+            buffer.position(buffer.position() + normals.length * 4);
+            buffer.asIntBuffer().get(indices);
+            buffer.position(buffer.position() + indices.length * 4);
+            chunks.add(new Chunk(key, positions, normals, indices));
+        }
+        buffer.position(0);
+        return chunks;
+    }
+}
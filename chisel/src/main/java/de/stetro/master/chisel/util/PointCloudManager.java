@@ -15,6 +15,8 @@ import org.rajawali3d.math.vector.Vector3;
 import java.nio.ByteBuffer;
 import java.nio.ByteOrder;
 
+import de.stetro.master.chisel.JNIInterface;
+
 
 public class PointCloudManager {
     private static final String tag = PointCloudManager.class.getSimpleName();
@@ -71,6 +73,18 @@ public class PointCloudManager {
         return newCloudTime != lastCloudTime;
     }
 
+    /**
+     * Integrates the current points into the reconstruction, the native side
+     * reads them in place from the direct buffer.
+     */
+    public synchronized void integratePoints(float[] transformation) {
+        JNIInterface.addPointsDirect(xyzIjData.xyz, xyzIjData.xyzCount, transformation);
+    }
+
+    public synchronized Vector3 getFirstPoint() {
+        return new Vector3(xyzIjData.xyz.get(0), xyzIjData.xyz.get(1), xyzIjData.xyz.get(2));
+    }
+
     public synchronized float[] getPoints() {
         float[] floats = new float[xyzIjData.xyzCount * 3];
         xyzIjData.xyz.position(0);
@@ -6,6 +6,7 @@ PROJECT_ROOT := $(LOCAL_PATH)/$(PROJECT_ROOT_FROM_JNI)
 EIGEN_INCLUDE := $(LOCAL_PATH)/../../../../native-libraries/eigen
 CHISEL := $(LOCAL_PATH)/../../../../native-libraries/open_chisel
 BOOST:= $(LOCAL_PATH)/../../../../native-libraries/boost
+NATIVE_CORE := $(LOCAL_PATH)/../../../../native-core
 
 
 # Building Boost
@@ -22,6 +23,8 @@ LOCAL_MODULE := chisel
 LOCAL_C_INCLUDES := $(EIGEN_INCLUDE) \
                     $(CHISEL)/include
 
+LOCAL_STATIC_LIBRARIES := tango_core_reconstruction
+
 LOCAL_SRC_FILES := jni_interface.cc \
                    chisel.cc \
                    $(CHISEL)/src/Chunk.cpp \
@@ -50,3 +53,5 @@ LOCAL_CFLAGS += -mfloat-abi=softfp -mfpu=neon -march=armv7 -mthumb -O3
 
 include $(BUILD_SHARED_LIBRARY)
 
+$(call import-add-path, $(NATIVE_CORE)/..)
+$(call import-module,native-core)
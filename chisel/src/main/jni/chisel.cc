@@ -12,23 +12,92 @@
 
 #include <Eigen/Core>
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+
+namespace {
+    // Vertices with bitwise identical positions are the same vertex.
+    struct VertexKey {
+        uint32_t x, y, z;
+
+        bool operator==(const VertexKey &other) const {
+            return x == other.x && y == other.y && z == other.z;
+        }
+    };
+
+    struct VertexKeyHasher {
+        size_t operator()(const VertexKey &key) const {
+            return (key.x * 73856093u) ^ (key.y * 19349663u) ^ (key.z * 83492791u);
+        }
+    };
+
+    uint32_t FloatBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    template <typename T>
+    uint8_t *Write(uint8_t *out, const T &value) {
+        memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+
+    template <typename T>
+    uint8_t *WriteAll(uint8_t *out, const std::vector <T> &values) {
+        if (!values.empty()) {
+            memcpy(out, values.data(), values.size() * sizeof(T));
+        }
+        return out + values.size() * sizeof(T);
+    }
+}  // namespace
 
 namespace chisel {
 
     void ChiselApplication::addPoints(JNIEnv *env, jfloatArray vertices,
                                       jfloatArray transformation) {
         // move jfloatArray vertices to Chisel PointCloud
-        lastPointCloud->Clear();
         int vertexCount = env->GetArrayLength(vertices) / 3;
-        LOGI("got %d points from as pointcloud data", vertexCount / 3);
+        LOGI("got %d points from as pointcloud data", vertexCount);
         jfloat *verticesData = env->GetFloatArrayElements(vertices, NULL);
-        for (int i = 0; i < vertexCount; ++i) {
-            Vec3 vec3(verticesData[i * 3], verticesData[i * 3 + 1], verticesData[i * 3 + 2]);
-            lastPointCloud->AddPoint(vec3);
+        if (verticesData == NULL) {
+            return;
+        }
+        setPoints(verticesData, vertexCount);
+        // only read, nothing to copy back
+        env->ReleaseFloatArrayElements(vertices, verticesData, JNI_ABORT);
+        integrate(env, transformation);
+    }
+
+    void ChiselApplication::addPointsDirect(JNIEnv *env, jobject vertices, jint count,
+                                            jfloatArray transformation) {
+        float *verticesData = static_cast<float *>(env->GetDirectBufferAddress(vertices));
+        if (verticesData == NULL || env->GetDirectBufferCapacity(vertices) < count * 3) {
+            LOGE("addPointsDirect needs a direct buffer of %d points", count);
+            return;
+        }
+        LOGI("got %d points from as pointcloud data", count);
+        setPoints(verticesData, count);
+        integrate(env, transformation);
+    }
+
+    void ChiselApplication::setPoints(const float *vertices, int count) {
+        // Clear keeps the capacity, resize only grows it for larger frames
+        lastPointCloud->Clear();
+        Vec3List &points = lastPointCloud->GetMutablePoints();
+        points.resize(count);
+        for (int i = 0; i < count; ++i) {
+            points[i] = Vec3(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2]);
         }
+    }
 
+    void ChiselApplication::integrate(JNIEnv *env, jfloatArray transformation) {
         // move extrisics to a Eigen transformation
-        jfloat *transformationData = env->GetFloatArrayElements(transformation, NULL);
+        jfloat transformationData[16];
+        env->GetFloatArrayRegion(transformation, 0, 16, transformationData);
         Transform extrinsic = Transform();
         for (int j = 0; j < 4; ++j) {
             for (int k = 0; k < 4; ++k) {
@@ -48,43 +117,194 @@ namespace chisel {
                 rayTruncation,
                 farClipping
         );
+    }
 
+    size_t ChiselApplication::getMeshSize() const {
+        const MeshMap &meshMap = chiselMap->GetChunkManager().GetAllMeshes();
+        size_t size = 0;
+        for (const std::pair <const chisel::ChunkID, chisel::MeshPtr> &meshes : meshMap) {
+            size += meshes.second->indices.size() * 3;
+        }
+        return size;
     }
 
-    jfloatArray ChiselApplication::getMesh(JNIEnv * env) {
-        LOGD("Getting Mesh ...");
-        MeshMap meshMap = chiselMap->GetChunkManager().GetAllMeshes();
-        LOGD("Map with %d items", meshMap.size());
-        int size = 0;
-        for (const std::pair <chisel::ChunkID, chisel::MeshPtr> &meshes : meshMap) {
-            size += meshes.second->vertices.size();
-        }
-        jfloatArray array = env->NewFloatArray(size * 3);
-        float points[size * 3];
-        int i = 0;
-        for (const std::pair <chisel::ChunkID, chisel::MeshPtr> &meshes : meshMap) {
-            for (size_t &index: meshes.second->indices) {
-                points[i * 3] = meshes.second->vertices[index](0);
-                points[i * 3 + 1] = meshes.second->vertices[index](1);
-                points[i * 3 + 2] = meshes.second->vertices[index](2);
-                i++;
+    void ChiselApplication::writeMesh(float *out) const {
+        const MeshMap &meshMap = chiselMap->GetChunkManager().GetAllMeshes();
+        for (const std::pair <const chisel::ChunkID, chisel::MeshPtr> &meshes : meshMap) {
+            for (size_t index : meshes.second->indices) {
+                const Vec3 &vertex = meshes.second->vertices[index];
+                *out++ = vertex(0);
+                *out++ = vertex(1);
+                *out++ = vertex(2);
             }
         }
-        env->SetFloatArrayRegion(array, 0, size * 3, points);
+    }
 
+    jfloatArray ChiselApplication::getMesh(JNIEnv *env) {
+        LOGD("Getting Mesh ...");
+        size_t size = getMeshSize();
+        jfloatArray array = env->NewFloatArray(size);
+        if (array == NULL || size == 0) {
+            return array;
+        }
+        // written in place, large meshes do not fit on the stack
+        jfloat *points = env->GetFloatArrayElements(array, NULL);
+        writeMesh(points);
+        env->ReleaseFloatArrayElements(array, points, 0);
         return array;
     }
 
+    jint ChiselApplication::getMeshDirect(JNIEnv *env, jobject mesh) {
+        size_t size = getMeshSize();
+        float *out = static_cast<float *>(env->GetDirectBufferAddress(mesh));
+        if (out == NULL) {
+            LOGE("getMeshDirect needs a direct buffer");
+            return 0;
+        }
+        if (env->GetDirectBufferCapacity(mesh) >= static_cast<jlong>(size)) {
+            writeMesh(out);
+        }
+        return size;
+    }
+
     void ChiselApplication::update(JNIEnv * env) {
-        chiselMap->UpdateMeshes();
+        // remember which chunks UpdateMeshes is going to touch
+        std::vector <ChunkID> dirtyChunks;
+        for (const std::pair <const ChunkID, bool> &chunk : chiselMap->GetMeshesToUpdate()) {
+            dirtyChunks.push_back(chunk.first);
+        }
+        // marching cubes on every core, update blocks until all chunks are done
+        int threads = std::max(1u, std::thread::hardware_concurrency());
+        chiselMap->UpdateMeshesParallel([threads](int count, const std::function<void(int)> &body) {
+            tango_core::ThreadedParallelFor(threads, count, body);
+        });
+
+        ++meshVersion;
+        const MeshMap &meshMap = chiselMap->GetChunkManager().GetAllMeshes();
+        for (const ChunkID &id : dirtyChunks) {
+            auto mesh = meshMap.find(id);
+            if (mesh != meshMap.end() && !mesh->second->indices.empty()) {
+                chunkVersions[id] = meshVersion;
+                removedChunks.erase(id);
+            } else if (chunkVersions.erase(id) > 0) {
+                removedChunks[id] = meshVersion;
+            }
+        }
+    }
+
+    void ChiselApplication::exportChunk(const Mesh &mesh, DeltaChunk *out) {
+        out->positions.clear();
+        out->normals.clear();
+        out->indices.clear();
+        out->indices.reserve(mesh.indices.size());
+        bool hasNormals = mesh.normals.size() == mesh.vertices.size();
+        std::unordered_map <VertexKey, int32_t, VertexKeyHasher> welded;
+        for (size_t index : mesh.indices) {
+            const Vec3 &vertex = mesh.vertices[index];
+            VertexKey key = {FloatBits(vertex(0)), FloatBits(vertex(1)), FloatBits(vertex(2))};
+            auto inserted = welded.insert(std::make_pair(key, out->positions.size() / 3));
+            if (inserted.second) {
+                out->positions.push_back(vertex(0));
+                out->positions.push_back(vertex(1));
+                out->positions.push_back(vertex(2));
+                out->normals.push_back(0.0f);
+                out->normals.push_back(0.0f);
+                out->normals.push_back(0.0f);
+            }
+            int32_t welded_index = inserted.first->second;
+            out->indices.push_back(welded_index);
+            if (hasNormals) {
+                // a shared vertex gets the mean of the normals of its copies
+                const Vec3 &normal = mesh.normals[index];
+                for (int i = 0; i < 3; ++i) {
+                    out->normals[welded_index * 3 + i] += normal(i);
+                }
+            }
+        }
+        for (size_t i = 0; i < out->normals.size(); i += 3) {
+            float *normal = &out->normals[i];
+            float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] +
+                                     normal[2] * normal[2]);
+            if (length > 0.0f) {
+                normal[0] /= length;
+                normal[1] /= length;
+                normal[2] /= length;
+            }
+        }
+    }
+
+    jint ChiselApplication::getMeshDelta(JNIEnv *env, jlong sinceVersion, jobject delta) {
+        uint64_t since = sinceVersion < 0 ? 0 : static_cast<uint64_t>(sinceVersion);
+        const MeshMap &meshMap = chiselMap->GetChunkManager().GetAllMeshes();
+
+        size_t changedCount = 0;
+        size_t size = sizeof(int64_t) + 2 * sizeof(int32_t);
+        for (const std::pair <const ChunkID, uint64_t> &chunk : chunkVersions) {
+            auto mesh = meshMap.find(chunk.first);
+            if (chunk.second <= since || mesh == meshMap.end()) {
+                continue;
+            }
+            if (deltaChunks.size() <= changedCount) {
+                deltaChunks.resize(changedCount + 1);
+            }
+            DeltaChunk &exported = deltaChunks[changedCount++];
+            exported.id = chunk.first;
+            exportChunk(*mesh->second, &exported);
+            size += 5 * sizeof(int32_t) + (exported.positions.size() + exported.normals.size()) *
+                                          sizeof(float) + exported.indices.size() * sizeof(int32_t);
+        }
+        size_t removedCount = 0;
+        for (const std::pair <const ChunkID, uint64_t> &chunk : removedChunks) {
+            if (chunk.second > since) {
+                ++removedCount;
+            }
+        }
+        size += removedCount * 3 * sizeof(int32_t);
+
+        uint8_t *out = static_cast<uint8_t *>(env->GetDirectBufferAddress(delta));
+        if (out == NULL) {
+            LOGE("getMeshDelta needs a direct buffer");
+            return 0;
+        }
+        if (env->GetDirectBufferCapacity(delta) < static_cast<jlong>(size)) {
+            return size;
+        }
+        out = Write(out, static_cast<int64_t>(meshVersion));
+        out = Write(out, static_cast<int32_t>(changedCount));
+        out = Write(out, static_cast<int32_t>(removedCount));
+        for (const std::pair <const ChunkID, uint64_t> &chunk : removedChunks) {
+            if (chunk.second > since) {
+                for (int i = 0; i < 3; ++i) {
+                    out = Write(out, static_cast<int32_t>(chunk.first(i)));
+                }
+            }
+        }
+        for (size_t c = 0; c < changedCount; ++c) {
+            const DeltaChunk &exported = deltaChunks[c];
+            for (int i = 0; i < 3; ++i) {
+                out = Write(out, static_cast<int32_t>(exported.id(i)));
+            }
+            out = Write(out, static_cast<int32_t>(exported.positions.size() / 3));
+            out = Write(out, static_cast<int32_t>(exported.indices.size()));
+            out = WriteAll(out, exported.positions);
+            out = WriteAll(out, exported.normals);
+            out = WriteAll(out, exported.indices);
+        }
+        LOGD("Mesh delta since %lld: %d changed, %d removed chunks", (long long) since,
+             (int) changedCount, (int) removedCount);
+        return size;
     }
 
     void ChiselApplication::clear(JNIEnv * env) {
-        chiselMap.reset(new chisel::Chisel(Eigen::Vector3i(chunkSize, chunkSize, chunkSize),
-                                           chunkResolution, false));
+        chunkRecycler.Clear(chiselMap.get());
+        ++meshVersion;
+        for (const std::pair <const ChunkID, uint64_t> &chunk : chunkVersions) {
+            removedChunks[chunk.first] = meshVersion;
+        }
+        chunkVersions.clear();
     }
 
-    ChiselApplication::ChiselApplication() {
+    ChiselApplication::ChiselApplication() : chunkRecycler(64 * 1024 * 1024) {
         chunkSize = 16;
 
         truncationDistConst = 0.001504;
@@ -100,9 +320,9 @@ namespace chisel {
         farClipping = 2.0;
         rayTruncation = 0.5;
 
-        chiselMap = chisel::ChiselPtr(
-                new chisel::Chisel(Eigen::Vector3i(chunkSize, chunkSize, chunkSize),
-                                   chunkResolution, false));
+        chiselMap.reset(
+                new tango_core::ParallelChisel(Eigen::Vector3i(chunkSize, chunkSize, chunkSize),
+                                               chunkResolution, false));
 
         TruncatorPtr truncator(new ConstantTruncator(truncationDistScale));
 
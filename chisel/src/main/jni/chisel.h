@@ -7,6 +7,10 @@
 
 #include <jni.h>
 #include <cstdlib>
+#include <memory>
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
 #include <android/log.h>
 
 #define LOGV(...) __android_log_print(ANDROID_LOG_VERBOSE, "Native",__VA_ARGS__)
@@ -19,6 +23,9 @@
 #include <open_chisel/pointcloud/PointCloud.h>
 #include <open_chisel/ProjectionIntegrator.h>
 
+#include <tango-core/chunk_recycler.h>
+#include <tango-core/parallel_chisel.h>
+
 
 
 namespace chisel {
@@ -32,16 +39,70 @@ namespace chisel {
         // JNI Interface
         void addPoints(JNIEnv *env, jfloatArray vertices, jfloatArray transformation);
 
+        // Reads count points straight from a direct FloatBuffer.
+        void addPointsDirect(JNIEnv *env, jobject vertices, jint count,
+                             jfloatArray transformation);
+
         jfloatArray getMesh(JNIEnv *env);
 
+        // Writes the triangle soup into a direct FloatBuffer if it fits.
+        // @return: number of floats of the mesh, nothing is written if this is
+        //          larger than the buffer's capacity.
+        jint getMeshDirect(JNIEnv *env, jobject mesh);
+
+        // Writes the chunks whose mesh changed after sinceVersion into a direct
+        // ByteBuffer in native byte order, if it fits:
+        //
+        //   int64 version, int32 changedCount, int32 removedCount,
+        //   removedCount times int32 x, y, z of a removed chunk,
+        //   changedCount times int32 x, y, z, vertexCount, indexCount,
+        //       vertexCount * 3 float positions, vertexCount * 3 float normals,
+        //       indexCount int32 triangle indices.
+        //
+        // Pass the returned version as sinceVersion of the next call, 0 gets
+        // the whole mesh.
+        // @return: bytes of the delta, nothing is written if this is larger
+        //          than the buffer's capacity.
+        jint getMeshDelta(JNIEnv *env, jlong sinceVersion, jobject delta);
+
         void clear(JNIEnv *env);
 
         void update(JNIEnv *env);
 
-        chisel::ChiselPtr chiselMap;
+        std::unique_ptr <tango_core::ParallelChisel> chiselMap;
         chisel::PointCloudPtr lastPointCloud = chisel::PointCloudPtr(new PointCloud());
         chisel::ProjectionIntegrator projectionIntegrator;
     protected:
+        // Integrates the points in lastPointCloud.
+        void integrate(JNIEnv *env, jfloatArray transformation);
+
+        // Sets lastPointCloud to count points of three floats.
+        void setPoints(const float *vertices, int count);
+
+        // @return: floats of the triangle soup of all chunk meshes.
+        size_t getMeshSize() const;
+
+        void writeMesh(float *out) const;
+
+        struct DeltaChunk {
+            ChunkID id;
+            std::vector <float> positions;
+            std::vector <float> normals;
+            std::vector <int32_t> indices;
+        };
+
+        // Welds the marching cubes soup of a chunk into indexed vertices.
+        static void exportChunk(const Mesh &mesh, DeltaChunk *out);
+
+        // mesh version of every chunk with a surface, by the update that
+        // changed it last
+        std::unordered_map <ChunkID, uint64_t, ChunkHasher> chunkVersions;
+        // chunks whose surface went away, by the update that removed it
+        std::unordered_map <ChunkID, uint64_t, ChunkHasher> removedChunks;
+        uint64_t meshVersion = 0;
+        // reused by getMeshDelta
+        std::vector <DeltaChunk> deltaChunks;
+
         double truncationDistConst;
         double truncationDistLinear;
         double truncationDistQuad;
@@ -54,6 +115,8 @@ namespace chisel {
         double farClipping;
         double rayTruncation;
 
+        // clear keeps the chunks for the next scan
+        tango_core::ChunkRecycler chunkRecycler;
     };
 
 
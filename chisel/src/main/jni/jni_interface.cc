@@ -48,6 +48,24 @@ Java_de_stetro_master_chisel_JNIInterface_addPoints(
 chiselApplication.addPoints(env, vertices, transformation);
 }
 
+JNIEXPORT void JNICALL
+Java_de_stetro_master_chisel_JNIInterface_addPointsDirect(
+        JNIEnv* env, jobject /*obj*/, jobject vertices, jint count, jfloatArray transformation) {
+    chiselApplication.addPointsDirect(env, vertices, count, transformation);
+}
+
+JNIEXPORT jint JNICALL
+Java_de_stetro_master_chisel_JNIInterface_getMeshDirect(
+        JNIEnv* env, jobject /*obj*/, jobject mesh) {
+    return chiselApplication.getMeshDirect(env, mesh);
+}
+
+JNIEXPORT jint JNICALL
+Java_de_stetro_master_chisel_JNIInterface_getMeshDelta(
+        JNIEnv* env, jobject /*obj*/, jlong since_version, jobject delta) {
+    return chiselApplication.getMeshDelta(env, since_version, delta);
+}
+
 #ifdef __cplusplus
 }
 #endif
\ No newline at end of file
@@ -18,6 +18,8 @@ package de.stetro.master.constructnative;
 
 import android.app.Activity;
 
+import java.nio.FloatBuffer;
+
 /**
  * Interfaces between native C++ code and Java code.
  */
@@ -28,6 +30,23 @@ public class JNIInterface {
 
     public static native float[] reconstructWithGreedy(float[] vertices);
 
+    // reads the first pointCount xyz triples of a direct buffer without copying them
+    public static native float[] reconstructWithGreedyDirect(FloatBuffer vertices, int pointCount);
+
     public static native float[] reconstructPiecewisePlanes(float[] vertices);
 
+    // segments up to maxPlanes planes with at least minSupport of the points each and
+    // returns the triangles of all of them
+    public static native float[] reconstructPlanes(float[] vertices, int maxPlanes, float minSupport,
+                                                   boolean parallel);
+
+    // merges new points into the native greedy session, returns the changed mesh cells
+    public static native float[] addGreedyPoints(float[] points, float[] pose);
+
+    // same for the first pointCount xyz triples of a direct buffer
+    public static native float[] addGreedyPointsDirect(FloatBuffer points, int pointCount,
+                                                       float[] pose);
+
+    public static native void clearGreedySession();
+
 }
@@ -13,7 +13,6 @@ import java.util.ArrayList;
 import java.util.List;
 import java.util.Stack;
 
-import de.stetro.master.constructnative.JNIInterface;
 import de.stetro.master.constructnative.calc.OctTree;
 import de.stetro.master.constructnative.calc.Plane;
 import de.stetro.master.constructnative.calc.RANSAC;
@@ -34,7 +33,6 @@ public class MeshTree extends OctTree {
     private Stack<Vector3> polygons;
     private List<Vector3> newPoints;
     private int generatorDepth;
-    private List<Vector3> patches;
 
     public MeshTree(Vector3 position, double range, int depth, int generatorDepth) {
         super(position, range, depth);
@@ -209,9 +207,6 @@ public class MeshTree extends OctTree {
                 }
             }
         }
-        if (patches != null) {
-            patches = null;
-        }
     }
 
     public void putPoints(List<Vector3> points) {
@@ -277,48 +272,4 @@ public class MeshTree extends OctTree {
             return count;
         }
     }
-
-    public void reconstructPatches() {
-        List<Vector3> boundaries = new ArrayList<>();
-        collectPlaneBoundaries(boundaries);
-        if (boundaries.size() < 3) {
-            return;
-        }
-        float[] points = new float[boundaries.size() * 3];
-        for (int i = 0; i < boundaries.size(); i++) {
-            Vector3 vector3 = boundaries.get(i);
-            points[i * 3] = (float) vector3.x;
-            points[i * 3 + 1] = (float) vector3.y;
-            points[i * 3 + 2] = (float) vector3.z;
-        }
-        float[] floats = JNIInterface.reconstructWithGreedy(points);
-        if (patches == null) {
-            patches = new ArrayList<>();
-        } else {
-            patches.clear();
-        }
-        for (int i = 0; i < floats.length / 3; i++) {
-            patches.add(new Vector3(floats[i * 3], floats[i * 3 + 1], floats[i * 3 + 2]));
-        }
-    }
-
-    private void collectPlaneBoundaries(List<Vector3> boundaries) {
-        if (depth == generatorDepth) {
-            for (Plane plane : planes) {
-                if (plane != null) {
-                    boundaries.addAll(plane.getPoints());
-                }
-            }
-        } else {
-            for (OctTree child : children) {
-                if (child != null) {
-                    ((MeshTree) child).collectPlaneBoundaries(boundaries);
-                }
-            }
-        }
-    }
-
-    public List<Vector3> getPatches() {
-        return patches;
-    }
 }
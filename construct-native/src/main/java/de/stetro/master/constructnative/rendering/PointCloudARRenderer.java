@@ -92,9 +92,7 @@ public class PointCloudARRenderer extends TangoRajawaliRenderer {
                 }
                 Stack<Vector3> faces = new Stack<>();
                 pointCollection.getMeshTree().fillPolygons(faces);
-                if (pointCollection.getMeshTree().getPatches() != null) {
-                    faces.addAll(pointCollection.getMeshTree().getPatches());
-                }
+                faces.addAll(pointCollection.getPatches());
                 polygon = new Polygon(faces);
                 polygon.setTransparent(true);
                 polygon.setMaterial(Materials.getTransparentRed());
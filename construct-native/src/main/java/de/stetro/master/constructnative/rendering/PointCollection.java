@@ -13,11 +13,15 @@ import org.rajawali3d.math.Matrix4;
 import org.rajawali3d.math.vector.Vector3;
 
 import java.nio.FloatBuffer;
+import java.util.List;
+
+import de.stetro.master.constructnative.util.GreedySession;
 
 public class PointCollection extends Object3D {
     public static final int REFRESH_SECTIONS = 15;
     private static final String tag = PointCollection.class.getSimpleName();
     private final MeshTree meshTree;
+    private final GreedySession greedySession = new GreedySession();
     private int mMaxNumberOfVertices;
     private int count = 0;
     private boolean hasNewPolygons;
@@ -53,9 +57,9 @@ public class PointCollection extends Object3D {
         Vector3[] points = new Vector3[pointCount];
         final Matrix4 transformation = Matrix4.createTranslationMatrix(pose.getPosition()).rotate(pose.getOrientation());
         for (int i = 0; i < pointCount; i++) {
-            double x = pointCloudBuffer.get();
-            double y = pointCloudBuffer.get();
-            double z = pointCloudBuffer.get();
+            float x = pointCloudBuffer.get();
+            float y = pointCloudBuffer.get();
+            float z = pointCloudBuffer.get();
             points[i] = new Vector3(x, y, z).multiply(transformation);
         }
         for (int i = 0; i < REFRESH_SECTIONS; i++) {
@@ -66,10 +70,12 @@ public class PointCollection extends Object3D {
         if (clearCollectionNextRound) {
             clearCollectionNextRound = false;
             meshTree.clear();
+            greedySession.clear();
             hasNewPolygons = false;
         } else {
             hasNewPolygons = true;
-            meshTree.reconstructPatches();
+            // only the cells around the new points are triangulated again
+            greedySession.addPoints(pointCloudBuffer, pointCount, transformation);
         }
     }
 
@@ -95,6 +101,10 @@ public class PointCollection extends Object3D {
         return meshTree;
     }
 
+    public List<Vector3> getPatches() {
+        return greedySession.getTriangles();
+    }
+
     public void clear() {
         clearCollectionNextRound = true;
         mGeometry.setNumVertices(0);
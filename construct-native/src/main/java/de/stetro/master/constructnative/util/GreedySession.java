@@ -0,0 +1,84 @@
+package de.stetro.master.constructnative.util;
+
+import org.rajawali3d.math.Matrix4;
+import org.rajawali3d.math.vector.Vector3;
+
+import java.nio.FloatBuffer;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.HashMap;
+import java.util.List;
+import java.util.Map;
+
+import de.stetro.master.constructnative.JNIInterface;
+
+/**
+ * Java side of the native incremental greedy triangulation. Every batch of
+ * points only returns the mesh cells it changed, which replace the cells kept
+ * here.
+ */
+public class GreedySession {
+    private final Map<Long, float[]> cells = new HashMap<>();
+    private final float[] pose = new float[16];
+
+    private static long key(int x, int y, int z) {
+        return ((long) (x & 0x1FFFFF) << 42) | ((long) (y & 0x1FFFFF) << 21) | (z & 0x1FFFFF);
+    }
+
+    /**
+     * @param points         xyz of the new points
+     * @param transformation from the points into the world frame
+     */
+    public synchronized void addPoints(float[] points, Matrix4 transformation) {
+        transformation.toFloatArray(pose);
+        apply(JNIInterface.addGreedyPoints(points, pose));
+    }
+
+    /**
+     * @param points         direct buffer, read in place by the native side
+     * @param pointCount     number of xyz triples from the start of points
+     * @param transformation from the points into the world frame
+     */
+    public synchronized void addPoints(FloatBuffer points, int pointCount, Matrix4 transformation) {
+        if (!points.isDirect()) {
+            float[] copy = new float[pointCount * 3];
+            points.position(0);
+            points.get(copy);
+            addPoints(copy, transformation);
+            return;
+        }
+        transformation.toFloatArray(pose);
+        apply(JNIInterface.addGreedyPointsDirect(points, pointCount, pose));
+    }
+
+    private void apply(float[] delta) {
+        int cellCount = (int) delta[0];
+        int offset = 1;
+        for (int i = 0; i < cellCount; i++) {
+            long key = key((int) delta[offset], (int) delta[offset + 1], (int) delta[offset + 2]);
+            int floatCount = (int) delta[offset + 3];
+            offset += 4;
+            if (floatCount == 0) {
+                cells.remove(key);
+            } else {
+                cells.put(key, Arrays.copyOfRange(delta, offset, offset + floatCount));
+            }
+            offset += floatCount;
+        }
+    }
+
+    public synchronized List<Vector3> getTriangles() {
+        List<Vector3> triangles = new ArrayList<>();
+        for (float[] cell : cells.values()) {
+            for (int i = 0; i < cell.length / 3; i++) {
+                triangles.add(new Vector3(cell[i * 3], cell[i * 3 + 1], cell[i * 3 + 2]));
+            }
+        }
+        return triangles;
+    }
+
+    public synchronized void clear() {
+        JNIInterface.clearGreedySession();
+        cells.clear();
+    }
+}
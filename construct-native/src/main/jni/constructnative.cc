@@ -3,14 +3,22 @@
 //
 #include "constructnative.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+#include <unordered_set>
+
 #include <pcl/point_types.h>
+#include <pcl/common/io.h>
 #include <pcl/kdtree/kdtree_flann.h>
 #include <pcl/kdtree/impl/kdtree_flann.hpp>
 #include <pcl/search/search.h>
 #include <pcl/search/kdtree.h>
 #include <pcl/features/normal_3d.h>
+#include <pcl/features/normal_3d_omp.h>
+#include <pcl/features/impl/normal_3d_omp.hpp>
 #include <pcl/surface/gp3.h>
-#include <pcl/filters/voxel_grid.h>
 #include <pcl/filters/filter.h>
 #include <pcl/filters/passthrough.h>
 #include <pcl/ModelCoefficients.h>
@@ -23,48 +31,95 @@
 
 namespace constructnative {
 
-    void voxelGridDownSampling(const pcl::PointCloud<pcl::PointXYZ>::Ptr source,
+    // neighbourhood of the greedy projection, also how far a new point
+    // reaches into the triangulation of the cells around it
+    const double kGreedySearchRadius = 0.1;
+
+    // voxel grid of GreedySession, the leaf of the one-shot downsampling
+    const float kSessionLeafSize = 0.03f;
+    // edge of the cells GreedySession re-triangulates
+    const float kSessionCellSize = 0.3f;
+    // points after which a voxel centroid is considered settled, later ones
+    // neither move it nor trigger a re-triangulation
+    const int kSettledVoxelPoints = 8;
+
+    Eigen::Vector3i gridKey(float x, float y, float z, float size) {
+        return Eigen::Vector3i(static_cast<int>(std::floor(x / size)),
+                               static_cast<int>(std::floor(y / size)),
+                               static_cast<int>(std::floor(z / size)));
+    }
+
+    // Centroid of the points in every occupied voxel, like pcl::VoxelGrid but
+    // straight from mapped points without a full PointCloud copy first.
+    void voxelGridDownSampling(const PointMap &points,
                                const pcl::PointCloud<pcl::PointXYZ>::Ptr target,
                                float leafSize) {
-        pcl::VoxelGrid <pcl::PointXYZ> sor;
-        sor.setInputCloud(source);
-        sor.setLeafSize(leafSize, leafSize, leafSize);
-        sor.filter(*target);
-    }
-
-    void estimateNormals(const pcl::PointCloud<pcl::PointXYZ>::Ptr source,
-                         const pcl::PointCloud<pcl::PointNormal>::Ptr target,
-                         int kSearch) {
-        pcl::NormalEstimation <pcl::PointXYZ, pcl::Normal> n;
-        pcl::PointCloud<pcl::Normal>::Ptr normals(new pcl::PointCloud <pcl::Normal>);
-        pcl::search::KdTree<pcl::PointXYZ>::Ptr tree(new pcl::search::KdTree <pcl::PointXYZ>);
-        tree->setInputCloud(source);
-        n.setInputCloud(source);
-        n.setSearchMethod(tree);
-        n.setKSearch(kSearch);
-        n.compute(*normals);
-        pcl::concatenateFields(*source, *normals, *target);
+        struct Leaf {
+            float sum[3];
+            int count;
+        };
+        std::unordered_map <Eigen::Vector3i, Leaf, GridKeyHasher> leaves;
+        for (int i = 0; i < points.cols(); ++i) {
+            float x = points(0, i), y = points(1, i), z = points(2, i);
+            Leaf &leaf = leaves[gridKey(x, y, z, leafSize)];
+            leaf.sum[0] += x;
+            leaf.sum[1] += y;
+            leaf.sum[2] += z;
+            ++leaf.count;
+        }
+        target->points.clear();
+        target->points.reserve(leaves.size());
+        for (const auto &leaf : leaves) {
+            const Leaf &l = leaf.second;
+            target->points.push_back(pcl::PointXYZ(l.sum[0] / l.count, l.sum[1] / l.count,
+                                                   l.sum[2] / l.count));
+        }
+        target->width = target->points.size();
+        target->height = 1;
+        target->is_dense = true;
+    }
+
+    // One FLANN index over a cloud, shared by normal estimation and the
+    // triangulation. Both search xyz only, so it is built before the normals.
+    pcl::search::KdTree<pcl::PointNormal>::Ptr buildSearchTree(
+            const pcl::PointCloud<pcl::PointNormal>::Ptr cloud) {
+        pcl::search::KdTree<pcl::PointNormal>::Ptr tree(new pcl::search::KdTree <pcl::PointNormal>);
+        tree->setInputCloud(cloud);
+        return tree;
+    }
+
+    unsigned int hardwareThreads() {
+        return std::max(std::thread::hardware_concurrency(), 1u);
     }
 
-    void estimateNormals(const pcl::PointCloud<pcl::PointXYZ>::Ptr source,
-                         const pcl::PointCloud<pcl::Normal>::Ptr normals,
-                         int kSearch) {
-        pcl::NormalEstimation <pcl::PointXYZ, pcl::Normal> n;
-        pcl::search::KdTree<pcl::PointXYZ>::Ptr tree(new pcl::search::KdTree <pcl::PointXYZ>);
-        tree->setInputCloud(source);
-        n.setInputCloud(source);
+    // Fills in the normals of cloud on the given number of threads. The features
+    // skip rebuilding a tree whose input is their search surface, so tree is
+    // searched as is.
+    void estimateNormals(const pcl::PointCloud<pcl::PointNormal>::Ptr cloud,
+                         const pcl::search::KdTree<pcl::PointNormal>::Ptr tree,
+                         int kSearch, unsigned int threads) {
+        pcl::NormalEstimationOMP <pcl::PointNormal, pcl::PointNormal> n(threads);
+        n.setInputCloud(cloud);
         n.setSearchMethod(tree);
         n.setKSearch(kSearch);
-        n.compute(*normals);
+        // only normal and curvature are written, the positions stay
+        n.compute(*cloud);
     }
 
+    // GP3 that searches the given tree instead of indexing its input again.
+    class SharedTreeTriangulation : public pcl::GreedyProjectionTriangulation <pcl::PointNormal> {
+    public:
+        SharedTreeTriangulation() {
+            check_tree_ = false;
+        }
+    };
+
     pcl::PolygonMesh greedyTriangulationReconstruction(
-            const pcl::PointCloud<pcl::PointNormal>::Ptr source) {
+            const pcl::PointCloud<pcl::PointNormal>::Ptr source,
+            const pcl::search::KdTree<pcl::PointNormal>::Ptr tree) {
         pcl::PolygonMesh triangles;
-        pcl::search::KdTree<pcl::PointNormal>::Ptr tree(new pcl::search::KdTree <pcl::PointNormal>);
-        tree->setInputCloud(source);
-        pcl::GreedyProjectionTriangulation <pcl::PointNormal> gp3;
-        gp3.setSearchRadius(0.1);
+        SharedTreeTriangulation gp3;
+        gp3.setSearchRadius(kGreedySearchRadius);
         gp3.setMu(3.0);
         gp3.setMaximumNearestNeighbors(100);
         gp3.setMaximumSurfaceAngle(M_PI);
@@ -78,62 +133,114 @@ namespace constructnative {
         return triangles;
     }
 
+    // Normals and triangles of cloud over a single search tree, with the
+    // normals estimated on the given number of threads.
+    pcl::PolygonMesh reconstructSurface(const pcl::PointCloud<pcl::PointXYZ>::Ptr cloud,
+                                        int kSearch,
+                                        unsigned int threads) {
+        pcl::PointCloud<pcl::PointNormal>::Ptr cloud_with_normals(
+                new pcl::PointCloud <pcl::PointNormal>);
+        pcl::copyPointCloud(*cloud, *cloud_with_normals);
+        pcl::search::KdTree<pcl::PointNormal>::Ptr tree = buildSearchTree(cloud_with_normals);
+        estimateNormals(cloud_with_normals, tree, kSearch, threads);
+        return greedyTriangulationReconstruction(cloud_with_normals, tree);
+    }
+
+    // One bulk copy of a float[] of xyz triples.
+    PointMap readPoints(JNIEnv *env, jfloatArray vertices, std::vector<float> *target) {
+        target->resize(env->GetArrayLength(vertices) / 3 * 3);
+        env->GetFloatArrayRegion(vertices, 0, target->size(), target->data());
+        return PointMap(target->data(), 3, target->size() / 3);
+    }
+
+    // The xyz triples of a direct FloatBuffer in place.
+    PointMap mapDirectPoints(JNIEnv *env, jobject buffer, jint count) {
+        const float *data = static_cast<const float *>(env->GetDirectBufferAddress(buffer));
+        if (data == NULL || count < 0) {
+            return PointMap(NULL, 3, 0);
+        }
+        jlong capacity = env->GetDirectBufferCapacity(buffer);
+        if (capacity >= 0 && count > capacity / 3) {
+            count = capacity / 3;
+        }
+        return PointMap(data, 3, count);
+    }
+
+    // PCL points are padded to 16 bytes, so this is the one copy left.
+    void pointsToCloud(const PointMap &points, const pcl::PointCloud<pcl::PointXYZ>::Ptr cloud) {
+        cloud->points.resize(points.cols());
+        for (int i = 0; i < points.cols(); ++i) {
+            cloud->points[i].getVector3fMap() = points.col(i);
+        }
+        cloud->width = cloud->points.size();
+        cloud->height = 1;
+        cloud->is_dense = true;
+    }
+
     int verticesToPointCloud(jfloatArray vertices,
                              const pcl::PointCloud<pcl::PointXYZ>::Ptr cloud, JNIEnv *env) {
-        int vertexCount = env->GetArrayLength(vertices) / 3;
-        jfloat *verticesData = env->GetFloatArrayElements(vertices, NULL);
-        cloud->points.resize(vertexCount);
-        for (int i = 0; i < vertexCount; ++i) {
-            pcl::PointXYZ point;
-            point.x = verticesData[i * 3];
-            point.y = verticesData[i * 3 + 1];
-            point.z = verticesData[i * 3 + 2];
-            cloud->points[i] = point;
+        std::vector<float> data;
+        pointsToCloud(readPoints(env, vertices, &data), cloud);
+        return cloud->points.size();
+    }
+
+    jfloatArray toFloatArray(JNIEnv *env, const std::vector<float> &data) {
+        jfloatArray array = env->NewFloatArray(data.size());
+        env->SetFloatArrayRegion(array, 0, data.size(), data.data());
+        return array;
+    }
+
+    // appends the triangle vertices of triangles over cloud to target
+    void appendPolygonMesh(const pcl::PolygonMesh &triangles,
+                           const pcl::PointCloud<pcl::PointXYZ> &cloud,
+                           std::vector<float> *target) {
+        for (const pcl::Vertices &polygon : triangles.polygons) {
+            for (int i = 0; i < 3; ++i) {
+                const pcl::PointXYZ &point = cloud.points[polygon.vertices[i]];
+                target->push_back(point.x);
+                target->push_back(point.y);
+                target->push_back(point.z);
+            }
         }
-        return vertexCount;
     }
 
-    jfloatArray polygonMeshToVertices(pcl::PolygonMesh triangles,
+    jfloatArray polygonMeshToVertices(const pcl::PolygonMesh &triangles,
                                       const pcl::PointCloud<pcl::PointXYZ>::Ptr filtered_cloud,
                                       JNIEnv *env) {
-        int polygonCount = triangles.polygons.size();
-        jfloatArray array = env->NewFloatArray(polygonCount * 9);
-        for (int i = 0; i < polygonCount; i++) {
-            float vertex[9] = {
-                    filtered_cloud->points[triangles.polygons[i].vertices[0]].x,
-                    filtered_cloud->points[triangles.polygons[i].vertices[0]].y,
-                    filtered_cloud->points[triangles.polygons[i].vertices[0]].z,
-                    filtered_cloud->points[triangles.polygons[i].vertices[1]].x,
-                    filtered_cloud->points[triangles.polygons[i].vertices[1]].y,
-                    filtered_cloud->points[triangles.polygons[i].vertices[1]].z,
-                    filtered_cloud->points[triangles.polygons[i].vertices[2]].x,
-                    filtered_cloud->points[triangles.polygons[i].vertices[2]].y,
-                    filtered_cloud->points[triangles.polygons[i].vertices[2]].z
-            };
-            env->SetFloatArrayRegion(array, i * 9, 9, vertex);
-        }
-        return array;
+        std::vector<float> vertices;
+        vertices.reserve(triangles.polygons.size() * 9);
+        appendPolygonMesh(triangles, *filtered_cloud, &vertices);
+        return toFloatArray(env, vertices);
+    }
+
+    void configurePlaneSegmentation(pcl::SACSegmentation <pcl::PointXYZ> *seg) {
+        // Optional
+        seg->setOptimizeCoefficients(true);
+        // Mandatory
+        seg->setModelType(pcl::SACMODEL_PLANE);
+        seg->setMethodType(pcl::SAC_RANSAC);
+        seg->setDistanceThreshold(0.02);
     }
 
     jfloatArray GreedyApplication::reconstruct(JNIEnv *env, jfloatArray vertices) {
+        std::vector<float> data;
+        return reconstruct(env, readPoints(env, vertices, &data));
+    }
 
-        // transform jfloatArray vertices to pcl::PointCloud
-        pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud <pcl::PointXYZ>);
-        verticesToPointCloud(vertices, cloud, env);
-        LOGE("PointCloud has %d points", cloud->points.size());
+    jfloatArray GreedyApplication::reconstructDirect(JNIEnv *env, jobject points, jint count) {
+        return reconstruct(env, mapDirectPoints(env, points, count));
+    }
+
+    jfloatArray GreedyApplication::reconstruct(JNIEnv *env, const PointMap &points) {
+        LOGE("PointCloud has %d points", static_cast<int>(points.cols()));
 
         // filter with voxel grid
         pcl::PointCloud<pcl::PointXYZ>::Ptr filtered_cloud(new pcl::PointCloud <pcl::PointXYZ>);
-        voxelGridDownSampling(cloud, filtered_cloud, 0.03f);
+        voxelGridDownSampling(points, filtered_cloud, kSessionLeafSize);
         LOGE("filtered PointCloud has %d points", filtered_cloud->points.size());
 
-        // Normal estimation
-        pcl::PointCloud<pcl::PointNormal>::Ptr filtered_cloud_with_normals(
-                new pcl::PointCloud <pcl::PointNormal>);
-        estimateNormals(filtered_cloud, filtered_cloud_with_normals, 10);
-
-        // Triangulate with Greedy Triangulation
-        pcl::PolygonMesh triangles = greedyTriangulationReconstruction(filtered_cloud_with_normals);
+        // Normal estimation and Greedy Triangulation
+        pcl::PolygonMesh triangles = reconstructSurface(filtered_cloud, 10, hardwareThreads());
         LOGE("Reconstructed %d polygons", triangles.polygons.size());
 
         // transform pcl::PolygonMesh to jfloatArray vertices
@@ -149,6 +256,146 @@ namespace constructnative {
     }
 
 
+    jfloatArray GreedySession::addPoints(JNIEnv *env, jfloatArray points, jfloatArray pose) {
+        std::vector<float> data;
+        return addPoints(env, readPoints(env, points, &data), pose);
+    }
+
+    jfloatArray GreedySession::addPointsDirect(JNIEnv *env, jobject points, jint count,
+                                               jfloatArray pose) {
+        return addPoints(env, mapDirectPoints(env, points, count), pose);
+    }
+
+    jfloatArray GreedySession::addPoints(JNIEnv *env, const PointMap &points, jfloatArray pose) {
+        float m[16] = {1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1};
+        if (pose != NULL) {
+            env->GetFloatArrayRegion(pose, 0, 16, m);
+        }
+
+        // merge the batch into the voxel grid, remembering the cells that
+        // see a voxel that was added or moved
+        std::unordered_set <Eigen::Vector3i, GridKeyHasher> dirtyCells;
+        float margin = kGreedySearchRadius;
+        for (int i = 0; i < points.cols(); ++i) {
+            float x = points(0, i), y = points(1, i), z = points(2, i);
+            float wx = m[0] * x + m[4] * y + m[8] * z + m[12];
+            float wy = m[1] * x + m[5] * y + m[9] * z + m[13];
+            float wz = m[2] * x + m[6] * y + m[10] * z + m[14];
+            Eigen::Vector3i key = gridKey(wx, wy, wz, kSessionLeafSize);
+            auto found = voxels_.find(key);
+            if (found == voxels_.end()) {
+                Voxel voxel = {{0, 0, 0}, 0};
+                found = voxels_.insert(std::make_pair(key, voxel)).first;
+                cells_[gridKey(wx, wy, wz, kSessionCellSize)].push_back(key);
+            }
+            Voxel &voxel = found->second;
+            if (voxel.count >= kSettledVoxelPoints) {
+                continue;
+            }
+            voxel.sum[0] += wx;
+            voxel.sum[1] += wy;
+            voxel.sum[2] += wz;
+            ++voxel.count;
+            Eigen::Vector3i low = gridKey(wx - margin, wy - margin, wz - margin, kSessionCellSize);
+            Eigen::Vector3i high = gridKey(wx + margin, wy + margin, wz + margin, kSessionCellSize);
+            for (int cx = low.x(); cx <= high.x(); ++cx) {
+                for (int cy = low.y(); cy <= high.y(); ++cy) {
+                    for (int cz = low.z(); cz <= high.z(); ++cz) {
+                        dirtyCells.insert(Eigen::Vector3i(cx, cy, cz));
+                    }
+                }
+            }
+        }
+
+        std::vector<float> delta(1, 0.0f);
+        for (const Eigen::Vector3i &cell : dirtyCells) {
+            std::vector<float> triangles;
+            triangulateCell(cell, &triangles);
+            auto mesh = meshes_.find(cell);
+            if (mesh == meshes_.end() && triangles.empty()) {
+                continue;
+            }
+            delta.push_back(cell.x());
+            delta.push_back(cell.y());
+            delta.push_back(cell.z());
+            delta.push_back(triangles.size());
+            delta.insert(delta.end(), triangles.begin(), triangles.end());
+            ++delta[0];
+            if (triangles.empty()) {
+                meshes_.erase(mesh);
+            } else {
+                meshes_[cell].swap(triangles);
+            }
+        }
+        LOGI("Greedy session: %d voxels, %d of %d cells changed", voxels_.size(),
+             static_cast<int>(delta[0]), meshes_.size());
+
+        return toFloatArray(env, delta);
+    }
+
+    void GreedySession::triangulateCell(const Eigen::Vector3i &cell,
+                                        std::vector<float> *triangles) const {
+        // the voxels of the cell and those within the search radius around it,
+        // which the triangles at its border connect to
+        Eigen::Vector3f low = cell.cast<float>() * kSessionCellSize;
+        Eigen::Vector3f high = low + Eigen::Vector3f::Constant(kSessionCellSize);
+        Eigen::Vector3f margin = Eigen::Vector3f::Constant(kGreedySearchRadius);
+        int reach = static_cast<int>(std::ceil(kGreedySearchRadius / kSessionCellSize));
+        pcl::PointCloud<pcl::PointXYZ>::Ptr cloud(new pcl::PointCloud <pcl::PointXYZ>);
+        bool inside = false;
+        for (int dx = -reach; dx <= reach; ++dx) {
+            for (int dy = -reach; dy <= reach; ++dy) {
+                for (int dz = -reach; dz <= reach; ++dz) {
+                    auto keys = cells_.find(cell + Eigen::Vector3i(dx, dy, dz));
+                    if (keys == cells_.end()) {
+                        continue;
+                    }
+                    for (const Eigen::Vector3i &key : keys->second) {
+                        const Voxel &voxel = voxels_.find(key)->second;
+                        Eigen::Vector3f p(voxel.sum[0] / voxel.count, voxel.sum[1] / voxel.count,
+                                          voxel.sum[2] / voxel.count);
+                        if ((p.array() < (low - margin).array()).any() ||
+                            (p.array() >= (high + margin).array()).any()) {
+                            continue;
+                        }
+                        inside |= dx == 0 && dy == 0 && dz == 0;
+                        cloud->points.push_back(pcl::PointXYZ(p.x(), p.y(), p.z()));
+                    }
+                }
+            }
+        }
+        if (!inside || cloud->points.size() < 3) {
+            return;
+        }
+        cloud->width = cloud->points.size();
+        cloud->height = 1;
+
+        pcl::PolygonMesh mesh = reconstructSurface(cloud, 10, hardwareThreads());
+        // each triangle belongs to the cell holding its centroid, so the
+        // cells around share none
+        for (const pcl::Vertices &polygon : mesh.polygons) {
+            const pcl::PointXYZ &a = cloud->points[polygon.vertices[0]];
+            const pcl::PointXYZ &b = cloud->points[polygon.vertices[1]];
+            const pcl::PointXYZ &c = cloud->points[polygon.vertices[2]];
+            if (gridKey((a.x + b.x + c.x) / 3, (a.y + b.y + c.y) / 3, (a.z + b.z + c.z) / 3,
+                        kSessionCellSize) != cell) {
+                continue;
+            }
+            const pcl::PointXYZ *corners[3] = {&a, &b, &c};
+            for (const pcl::PointXYZ *corner : corners) {
+                triangles->push_back(corner->x);
+                triangles->push_back(corner->y);
+                triangles->push_back(corner->z);
+            }
+        }
+    }
+
+    void GreedySession::clear() {
+        voxels_.clear();
+        cells_.clear();
+        meshes_.clear();
+    }
+
     jfloatArray PlaneApplication::reconstruct(JNIEnv *env, jfloatArray vertices) {
 
         // transform jfloatArray vertices to pcl::PointCloud
@@ -161,12 +408,7 @@ namespace constructnative {
         pcl::PointIndices::Ptr inliers (new pcl::PointIndices);
         // Create the segmentation object
         pcl::SACSegmentation<pcl::PointXYZ> seg;
-        // Optional
-        seg.setOptimizeCoefficients (true);
-        // Mandatory
-        seg.setModelType(pcl::SACMODEL_PLANE);
-        seg.setMethodType(pcl::SAC_RANSAC);
-        seg.setDistanceThreshold (0.02);
+        configurePlaneSegmentation(&seg);
         seg.setInputCloud(cloud);
         seg.segment(*inliers, *coefficients);
 
@@ -180,12 +422,8 @@ namespace constructnative {
         extract.setNegative(false);
         extract.filter(*plane_cloud);
 
-        // Normal estimation
-        pcl::PointCloud<pcl::PointNormal>::Ptr plane_cloud_with_normals(new pcl::PointCloud <pcl::PointNormal>);
-        estimateNormals(plane_cloud, plane_cloud_with_normals, 10);
-
-        // Triangulate with Greedy Triangulation
-        pcl::PolygonMesh triangles = greedyTriangulationReconstruction(plane_cloud_with_normals);
+        // Normal estimation and Greedy Triangulation
+        pcl::PolygonMesh triangles = reconstructSurface(plane_cloud, 10, hardwareThreads());
         LOGE("Reconstructed %d polygons", triangles.polygons.size());
 
         // transform pcl::PolygonMesh to jfloatArray vertices
@@ -194,6 +432,77 @@ namespace constructnative {
         return array;
     }
 
+    jfloatArray PlaneApplication::reconstructPlanes(JNIEnv *env, jfloatArray vertices,
+                                                    int maxPlanes, float minSupport,
+                                                    bool parallel) {
+        pcl::PointCloud<pcl::PointXYZ>::Ptr remaining(new pcl::PointCloud <pcl::PointXYZ>);
+        verticesToPointCloud(vertices, remaining, env);
+        size_t minInliers = std::max(static_cast<size_t>(minSupport * remaining->points.size()),
+                                     static_cast<size_t>(4));
+        LOGE("PointCloud has %d points, planes need %d", remaining->points.size(), minInliers);
+
+        // RANSAC Segmentation of the points no earlier plane took
+        pcl::SACSegmentation<pcl::PointXYZ> seg;
+        configurePlaneSegmentation(&seg);
+        pcl::ExtractIndices<pcl::PointXYZ> extract;
+        pcl::ModelCoefficients::Ptr coefficients(new pcl::ModelCoefficients);
+        pcl::PointIndices::Ptr inliers(new pcl::PointIndices);
+        std::vector<pcl::PointCloud<pcl::PointXYZ>::Ptr> planeClouds;
+        while (static_cast<int>(planeClouds.size()) < maxPlanes &&
+               remaining->points.size() >= minInliers) {
+            seg.setInputCloud(remaining);
+            seg.segment(*inliers, *coefficients);
+            if (inliers->indices.size() < minInliers) {
+                break;
+            }
+            LOGE("Plane %d has %d points %lf %lf %lf %lf", planeClouds.size(),
+                 inliers->indices.size(), coefficients->values[0], coefficients->values[1],
+                 coefficients->values[2], coefficients->values[3]);
+
+            pcl::PointCloud<pcl::PointXYZ>::Ptr plane_cloud(new pcl::PointCloud <pcl::PointXYZ>);
+            pcl::PointCloud<pcl::PointXYZ>::Ptr rest(new pcl::PointCloud <pcl::PointXYZ>);
+            extract.setInputCloud(remaining);
+            extract.setIndices(inliers);
+            extract.setNegative(false);
+            extract.filter(*plane_cloud);
+            extract.setNegative(true);
+            extract.filter(*rest);
+            planeClouds.push_back(plane_cloud);
+            remaining = rest;
+        }
+
+        // the planes triangulate independently, one worker per core takes the
+        // next plane and estimates its normals on its own thread only
+        std::vector<pcl::PolygonMesh> meshes(planeClouds.size());
+        if (parallel) {
+            std::atomic<size_t> next_plane(0);
+            unsigned int workers = std::min<size_t>(hardwareThreads(), planeClouds.size());
+            std::vector<std::thread> threads;
+            for (unsigned int w = 0; w < workers; ++w) {
+                threads.push_back(std::thread([&meshes, &planeClouds, &next_plane] {
+                    for (size_t i = next_plane++; i < planeClouds.size(); i = next_plane++) {
+                        meshes[i] = reconstructSurface(planeClouds[i], 10, 1);
+                    }
+                }));
+            }
+            for (std::thread &thread : threads) {
+                thread.join();
+            }
+        } else {
+            for (size_t i = 0; i < planeClouds.size(); ++i) {
+                meshes[i] = reconstructSurface(planeClouds[i], 10, hardwareThreads());
+            }
+        }
+
+        std::vector<float> triangles;
+        for (size_t i = 0; i < planeClouds.size(); ++i) {
+            appendPolygonMesh(meshes[i], *planeClouds[i], &triangles);
+        }
+        LOGE("Reconstructed %d planes with %d polygons", planeClouds.size(), triangles.size() / 9);
+
+        return toFloatArray(env, triangles);
+    }
+
     PlaneApplication::PlaneApplication() {
     }
 
@@ -7,6 +7,8 @@
 
 #include <jni.h>
 #include <cstdlib>
+#include <unordered_map>
+#include <vector>
 #include <pcl/point_types.h>
 #include <android/log.h>
 
@@ -18,6 +20,15 @@
 
 namespace constructnative {
 
+    // xyz triples in Java or native memory, columns are points
+    typedef Eigen::Map<const Eigen::Matrix<float, 3, Eigen::Dynamic> > PointMap;
+
+    struct GridKeyHasher {
+        size_t operator()(const Eigen::Vector3i &key) const {
+            return (key.x() * 73856093u) ^ (key.y() * 19349663u) ^ (key.z() * 83492791u);
+        }
+    };
+
     class GreedyApplication {
     public:
         GreedyApplication();
@@ -26,6 +37,49 @@ namespace constructnative {
 
         jfloatArray reconstruct(JNIEnv *env, jfloatArray vertices);
 
+        // Same on the first count points of a direct FloatBuffer, read in place.
+        jfloatArray reconstructDirect(JNIEnv *env, jobject points, jint count);
+
+    private:
+        jfloatArray reconstruct(JNIEnv *env, const PointMap &points);
+    };
+
+    // Greedy triangulation of a growing cloud. Points are merged into a
+    // persistent voxel grid and the mesh is kept in cells, so a batch only
+    // re-triangulates the cells within the search radius of the voxels it
+    // created or moved instead of the whole cloud.
+    class GreedySession {
+    public:
+        // Adds a batch of points and re-triangulates the cells it touched.
+        //
+        // @param pose: 16 floats, column major transform of the points into
+        //              the world frame, or NULL if they are in it already.
+        // @return: the changed cells as cell count, then per cell its x, y and
+        //          z index, the float count and the triangle vertices, xyz each.
+        //          A cell without floats lost its triangles.
+        jfloatArray addPoints(JNIEnv *env, jfloatArray points, jfloatArray pose);
+
+        // Same on the first count points of a direct FloatBuffer, read in place.
+        jfloatArray addPointsDirect(JNIEnv *env, jobject points, jint count, jfloatArray pose);
+
+        void clear();
+
+    private:
+        jfloatArray addPoints(JNIEnv *env, const PointMap &points, jfloatArray pose);
+
+        struct Voxel {
+            float sum[3];
+            int count;
+        };
+
+        // triangles of cell from the voxels in and around it
+        void triangulateCell(const Eigen::Vector3i &cell, std::vector<float> *triangles) const;
+
+        std::unordered_map <Eigen::Vector3i, Voxel, GridKeyHasher> voxels_;
+        // voxels by the cell they are in
+        std::unordered_map <Eigen::Vector3i, std::vector <Eigen::Vector3i>, GridKeyHasher> cells_;
+        // triangle vertices of every cell
+        std::unordered_map <Eigen::Vector3i, std::vector<float>, GridKeyHasher> meshes_;
     };
 
     class PlaneApplication {
@@ -36,6 +90,15 @@ namespace constructnative {
 
         jfloatArray reconstruct(JNIEnv *env, jfloatArray vertices);
 
+        // Segments planes one after the other from the points the earlier ones
+        // left, until maxPlanes are found or the best plane has less than
+        // minSupport of all points, and triangulates them all.
+        //
+        // @param parallel: triangulate the planes on a thread each.
+        // @return: triangle vertices of all planes, xyz each.
+        jfloatArray reconstructPlanes(JNIEnv *env, jfloatArray vertices, int maxPlanes,
+                                      float minSupport, bool parallel);
+
     };
 }
 
@@ -20,6 +20,7 @@
 
 static constructnative::GreedyApplication greedyApp;
 static constructnative::PlaneApplication planeApp;
+static constructnative::GreedySession greedySession;
 
 #ifdef __cplusplus
 extern "C" {
@@ -31,12 +32,43 @@ Java_de_stetro_master_constructnative_JNIInterface_reconstructWithGreedy(
   return greedyApp.reconstruct(env, vertices);
 }
 
+JNIEXPORT jfloatArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_reconstructWithGreedyDirect(
+        JNIEnv* env, jobject /*obj*/, jobject vertices, jint pointCount) {
+    return greedyApp.reconstructDirect(env, vertices, pointCount);
+}
+
 JNIEXPORT jfloatArray JNICALL
 Java_de_stetro_master_constructnative_JNIInterface_reconstructPiecewisePlanes(
         JNIEnv* env, jobject /*obj*/, jfloatArray vertices) {
     return planeApp.reconstruct(env, vertices);
 }
 
+JNIEXPORT jfloatArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_reconstructPlanes(
+        JNIEnv* env, jobject /*obj*/, jfloatArray vertices, jint maxPlanes, jfloat minSupport,
+        jboolean parallel) {
+    return planeApp.reconstructPlanes(env, vertices, maxPlanes, minSupport, parallel);
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_addGreedyPoints(
+        JNIEnv* env, jobject /*obj*/, jfloatArray points, jfloatArray pose) {
+    return greedySession.addPoints(env, points, pose);
+}
+
+JNIEXPORT jfloatArray JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_addGreedyPointsDirect(
+        JNIEnv* env, jobject /*obj*/, jobject points, jint pointCount, jfloatArray pose) {
+    return greedySession.addPointsDirect(env, points, pointCount, pose);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_constructnative_JNIInterface_clearGreedySession(
+        JNIEnv*, jobject /*obj*/) {
+    greedySession.clear();
+}
+
 #ifdef __cplusplus
 }
 #endif
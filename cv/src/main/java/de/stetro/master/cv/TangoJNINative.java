@@ -57,4 +57,12 @@ public class TangoJNINative {
 
   // Set texture method.
   public static native void setTextureMethod();
+
+  // Runs every depth filter on the next frameCount frames of the YUV path,
+  // false while a benchmark is still busy.
+  public static native boolean startFilterBenchmark(int frameCount);
+
+  // Latency and depth edge quality per filter of the last finished benchmark,
+  // one line each.
+  public static native String getFilterBenchmarkReport();
 }
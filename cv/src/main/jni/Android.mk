@@ -18,6 +18,7 @@ PROJECT_ROOT_FROM_JNI:= ../../../../..
 PROJECT_ROOT:= $(call my-dir)/../../../../..
 C_EXAMPLES:=/home/stetro/Source/tango-examples-c
 OPENCV:=/home/stetro/Source/opencv/platforms/build_android_arm/
+NATIVE_CORE:=$(call my-dir)/../../../../native-core
 
 
 
@@ -29,11 +30,14 @@ include $(OPENCV)/OpenCV.mk
 
 LOCAL_MODULE    := libvideo_overlay_jni_example
 LOCAL_SHARED_LIBRARIES += tango_client_api
+LOCAL_STATIC_LIBRARIES += tango_core
 LOCAL_CFLAGS    += -std=c++11
+LOCAL_ARM_NEON  := true
 
 LOCAL_SRC_FILES += jni_interface.cc \
                    yuv_drawable.cc \
                    video_overlay_app.cc \
+                   filter_benchmark.cc \
                    $(C_EXAMPLES)/tango-gl/axis.cpp \
                    $(C_EXAMPLES)/tango-gl/bounding_box.cpp \
                    $(C_EXAMPLES)/tango-gl/camera.cpp \
@@ -62,5 +66,7 @@ include $(BUILD_SHARED_LIBRARY)
 
 $(call import-add-path, $(C_EXAMPLES))
 $(call import-module,tango_client_api)
+$(call import-add-path, $(NATIVE_CORE)/..)
+$(call import-module,native-core)
 
 
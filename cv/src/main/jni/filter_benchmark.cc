@@ -0,0 +1,207 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-video-overlay/filter_benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+#include <opencv2/imgproc/imgproc.hpp>
+#include <opencv2/ximgproc.hpp>
+#include <opencv2/photo.hpp>
+#include <tango-gl/util.h>
+
+namespace {
+    const char *kDepthFilterNames[] = {"none", "inpaint", "bilateral", "guided", "combined"};
+
+    // bilateral range sigma in depth map units, about 14.6 per millimeter
+    const double kBilateralSigmaDepth = 2000.0;
+    const double kBilateralSigmaSpace = 3.0;
+    const int kBilateralDiameter = 5;
+
+    // Fills the pixels without depth. cv::inpaint before OpenCV 3.4 takes 8 bit
+    // images only, so the holes are filled on an 8 bit copy and only they are
+    // written back, measured pixels keep their 16 bits.
+    void InpaintDepth(cv::Mat *depth) {
+        cv::Mat holes = (*depth == 0);
+        cv::Mat depth8;
+        depth->convertTo(depth8, CV_8U, 1.0 / 257);
+        cv::inpaint(depth8, holes, depth8, 3.0, cv::INPAINT_TELEA);
+        cv::Mat filled;
+        depth8.convertTo(filled, CV_16U, 257);
+        filled.copyTo(*depth, holes);
+    }
+
+    // Color edges widened by one pixel, the depth edges are scored against.
+    cv::Mat ColorEdges(const cv::Mat &rgb) {
+        cv::Mat gray;
+        cv::cvtColor(rgb, gray, CV_RGB2GRAY);
+        cv::Mat edges;
+        cv::Canny(gray, edges, 50, 150);
+        cv::dilate(edges, edges, cv::Mat());
+        return edges;
+    }
+
+    double EdgePrecision(const cv::Mat &depth, const cv::Mat &color_edges) {
+        cv::Mat depth8;
+        depth.convertTo(depth8, CV_8U, 1.0 / 257);
+        cv::Mat depth_edges;
+        cv::Canny(depth8, depth_edges, 20, 60);
+        int count = cv::countNonZero(depth_edges);
+        if (count == 0) {
+            return 0.0;
+        }
+        return static_cast<double>(cv::countNonZero(depth_edges & color_edges)) / count;
+    }
+}  // namespace
+
+namespace tango_video_overlay {
+
+    const char *GetDepthFilterName(DepthFilter filter) {
+        return kDepthFilterNames[filter];
+    }
+
+    void ApplyDepthFilter(DepthFilter filter, const cv::Mat &rgb, cv::Mat *depth) {
+        switch (filter) {
+            case DEPTH_FILTER_NONE:
+                break;
+            case DEPTH_FILTER_INPAINT:
+                InpaintDepth(depth);
+                break;
+            case DEPTH_FILTER_BILATERAL: {
+                // the bilateral filter takes no 16 bit input
+                cv::Mat source;
+                depth->convertTo(source, CV_32F);
+                cv::Mat filtered;
+                cv::bilateralFilter(source, filtered, kBilateralDiameter,
+                                    kBilateralSigmaDepth, kBilateralSigmaSpace);
+                filtered.convertTo(*depth, CV_16U);
+                break;
+            }
+            case DEPTH_FILTER_GUIDED:
+                cv::ximgproc::guidedFilter(rgb, *depth, *depth, 5, 2.0);
+                break;
+            case DEPTH_FILTER_COMBINED:
+                InpaintDepth(depth);
+                cv::ximgproc::guidedFilter(rgb, *depth, *depth, 5, 2.0);
+                break;
+            default:
+                break;
+        }
+    }
+
+    FilterBenchmark::FilterBenchmark() :
+            frame_count_(0),
+            capturing_(false),
+            running_(false) { }
+
+    FilterBenchmark::~FilterBenchmark() {
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+    }
+
+    bool FilterBenchmark::Start(int frame_count) {
+        if (IsBusy() || frame_count <= 0) {
+            return false;
+        }
+        if (worker_.joinable()) {
+            worker_.join();
+        }
+        rgb_frames_.clear();
+        depth_frames_.clear();
+        frame_count_ = frame_count;
+        capturing_ = true;
+        LOGI("FilterBenchmark: capturing %d frames", frame_count);
+        return true;
+    }
+
+    void FilterBenchmark::AddFrame(const cv::Mat &rgb, const cv::Mat &depth) {
+        if (!capturing_) {
+            return;
+        }
+        rgb_frames_.push_back(rgb.clone());
+        depth_frames_.push_back(depth.clone());
+        if (static_cast<int>(depth_frames_.size()) < frame_count_) {
+            return;
+        }
+        capturing_ = false;
+        running_ = true;
+        worker_ = std::thread(&FilterBenchmark::Run, this);
+    }
+
+    std::string FilterBenchmark::GetReport() const {
+        std::lock_guard <std::mutex> lock(report_mutex_);
+        return report_;
+    }
+
+    void FilterBenchmark::Run() {
+        std::vector <cv::Mat> color_edges;
+        for (const cv::Mat &rgb : rgb_frames_) {
+            color_edges.push_back(ColorEdges(rgb));
+        }
+
+        std::string report;
+        DepthFilterResult results[DEPTH_FILTER_COUNT];
+        for (int f = 0; f < DEPTH_FILTER_COUNT; ++f) {
+            DepthFilter filter = static_cast<DepthFilter>(f);
+            DepthFilterResult &result = results[f];
+            char line[128];
+            try {
+                for (int i = 0; i < depth_frames_.size(); ++i) {
+                    // every filter starts from the same unfiltered map
+                    cv::Mat depth = depth_frames_[i].clone();
+                    auto start = std::chrono::steady_clock::now();
+                    ApplyDepthFilter(filter, rgb_frames_[i], &depth);
+                    double ms = std::chrono::duration<double, std::milli>(
+                            std::chrono::steady_clock::now() - start).count();
+                    result.mean_ms += ms;
+                    result.max_ms = std::max(result.max_ms, ms);
+                    result.edge_precision += EdgePrecision(depth, color_edges[i]);
+                    result.hole_ratio += static_cast<double>(
+                            depth.total() - cv::countNonZero(depth)) / depth.total();
+                }
+            } catch (const cv::Exception &e) {
+                // an exception leaving the worker would take the app down, the
+                // other filters still get measured
+                LOGE("FilterBenchmark: %s failed: %s", GetDepthFilterName(filter), e.what());
+                snprintf(line, sizeof(line), "%-9s failed\n", GetDepthFilterName(filter));
+                report += line;
+                continue;
+            }
+            double frames = depth_frames_.size();
+            result.mean_ms /= frames;
+            result.edge_precision /= frames;
+            result.hole_ratio /= frames;
+
+            snprintf(line, sizeof(line),
+                     "%-9s mean %7.2f ms  max %7.2f ms  edges %.3f  holes %.3f\n",
+                     GetDepthFilterName(filter), result.mean_ms, result.max_ms,
+                     result.edge_precision, result.hole_ratio);
+            LOGI("FilterBenchmark: %s", line);
+            report += line;
+        }
+
+        {
+            std::lock_guard <std::mutex> lock(report_mutex_);
+            report_.swap(report);
+        }
+        rgb_frames_.clear();
+        depth_frames_.clear();
+        running_ = false;
+    }
+}  // namespace tango_video_overlay
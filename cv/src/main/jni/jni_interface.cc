@@ -84,6 +84,18 @@ Java_de_stetro_master_cv_TangoJNINative_setTextureMethod(
   app.SetTextureMethod(1);
 }
 
+JNIEXPORT jboolean JNICALL
+Java_de_stetro_master_cv_TangoJNINative_startFilterBenchmark(
+    JNIEnv*, jobject, jint frame_count) {
+  return app.StartFilterBenchmark(frame_count);
+}
+
+JNIEXPORT jstring JNICALL
+Java_de_stetro_master_cv_TangoJNINative_getFilterBenchmarkReport(
+    JNIEnv* env, jobject) {
+  return env->NewStringUTF(app.GetFilterBenchmarkReport().c_str());
+}
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_VIDEO_OVERLAY_FILTER_BENCHMARK_H_
+#define TANGO_VIDEO_OVERLAY_FILTER_BENCHMARK_H_
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <opencv2/core/core.hpp>
+
+namespace tango_video_overlay {
+
+    enum DepthFilter {
+        DEPTH_FILTER_NONE = 0,
+        DEPTH_FILTER_INPAINT,
+        DEPTH_FILTER_BILATERAL,
+        DEPTH_FILTER_GUIDED,
+        // inpaint followed by the guided filter
+        DEPTH_FILTER_COMBINED,
+        DEPTH_FILTER_COUNT
+    };
+
+    const char *GetDepthFilterName(DepthFilter filter);
+
+    // Filters a 16 bit depth map in place, 0 marks pixels without depth.
+    // Filters without 16 bit support in OpenCV 3.x, inpaint and bilateral, run
+    // on a converted copy, so their latency includes the conversion.
+    // @param rgb: color image scaled to the size of the depth map.
+    void ApplyDepthFilter(DepthFilter filter, const cv::Mat &rgb, cv::Mat *depth);
+
+    struct DepthFilterResult {
+        double mean_ms = 0.0;
+        double max_ms = 0.0;
+        // share of the depth edges that lie within a pixel of a color edge
+        double edge_precision = 0.0;
+        // share of the pixels still without depth
+        double hole_ratio = 0.0;
+    };
+
+    // Runs every DepthFilter on the same captured frames, so their latency
+    // and depth edge quality can be compared on a device instead of judged by
+    // eye from the cycling overlay. Frames are captured on the render thread,
+    // the filters run one after another on a worker thread.
+    class FilterBenchmark {
+    public:
+        FilterBenchmark();
+
+        ~FilterBenchmark();
+
+        // Starts capturing frame_count frames.
+        // @return: false while a benchmark is capturing or running.
+        bool Start(int frame_count);
+
+        // Copies a frame while capturing, the worker starts with the last one.
+        // @param rgb: color image scaled to the size of depth.
+        // @param depth: unfiltered 16 bit depth map.
+        void AddFrame(const cv::Mat &rgb, const cv::Mat &depth);
+
+        // @return: true from Start until the report is written.
+        bool IsBusy() const { return capturing_ || running_; }
+
+        // @return: one line per filter of the last finished run, empty before.
+        std::string GetReport() const;
+
+    private:
+        void Run();
+
+        std::vector <cv::Mat> rgb_frames_;
+        std::vector <cv::Mat> depth_frames_;
+        int frame_count_;
+        std::atomic <bool> capturing_;
+        std::atomic <bool> running_;
+        std::thread worker_;
+        mutable std::mutex report_mutex_;
+        std::string report_;
+    };
+}  // namespace tango_video_overlay
+
+#endif  // TANGO_VIDEO_OVERLAY_FILTER_BENCHMARK_H_
@@ -21,10 +21,12 @@
 #include <jni.h>
 #include <memory>
 #include <mutex>
+#include <string>
 #include <math.h>
 
 #include <tango_client_api.h>  // NOLINT
 #include <tango-gl/util.h>
+#include <tango-video-overlay/filter_benchmark.h>
 #include <tango-video-overlay/yuv_drawable.h>
 #include <tango-gl/video_overlay.h>
 #include <tango-gl/camera.h>
@@ -83,6 +85,13 @@ namespace tango_video_overlay {
             current_texture_method_ = static_cast<TextureMethod>(method);
         }
 
+        // Runs every depth filter on the next frame_count frames of the YUV
+        // path, false while a benchmark is still busy.
+        bool StartFilterBenchmark(int frame_count);
+
+        // Latency and edge quality per filter of the last finished benchmark.
+        std::string GetFilterBenchmarkReport() const;
+
     private:
         // Tango configration file, this object is for configuring Tango Service setup
         // before connect to service. For example, we set the flag
@@ -108,6 +117,8 @@ namespace tango_video_overlay {
         size_t yuv_size_;
         size_t uv_buffer_offset_;
 
+        FilterBenchmark filter_benchmark_;
+
         void AllocateTexture(GLuint texture_id, int width, int height);
 
         void RenderYUV();
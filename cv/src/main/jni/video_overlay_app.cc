@@ -18,9 +18,9 @@
 #include <opencv2/core/core.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 #include <opencv2/highgui/highgui.hpp>
-#include <opencv2/ximgproc.hpp>
 #include <opencv2/videostab.hpp>
-#include <opencv2/photo.hpp>
+#include <tango-core/depth_splat.h>
+#include <tango-core/yuv_converter.h>
 #include <time.h>
 
 cv::Mat depth;
@@ -38,6 +38,13 @@ enum Filter {
 
 Filter filter = SMALL;
 
+// SMALL and BIG differ only in the splat radius
+const tango_video_overlay::DepthFilter kOverlayFilters[] = {
+        tango_video_overlay::DEPTH_FILTER_NONE, tango_video_overlay::DEPTH_FILTER_NONE,
+        tango_video_overlay::DEPTH_FILTER_GUIDED, tango_video_overlay::DEPTH_FILTER_INPAINT,
+        tango_video_overlay::DEPTH_FILTER_COMBINED
+};
+
 // from android samples
 /* return current time in milliseconds */
 static double now_ms(void) {
@@ -65,54 +72,22 @@ namespace {
 
 
         //320×180 depth window
-        depth = cv::Mat(320, 180, CV_8UC1);
+        depth = cv::Mat(320, 180, CV_16UC1);
         depth.setTo(cv::Scalar(0, 0, 0));
 
-        // load camera intrinsics
-        float fx = static_cast<float>(ccIntrinsics.fx);
-        float fy = static_cast<float>(ccIntrinsics.fy);
-        float cx = static_cast<float>(ccIntrinsics.cx);
-        float cy = static_cast<float>(ccIntrinsics.cy);
-
-        int width = static_cast<int>(ccIntrinsics.width);
-        int height = static_cast<int>(ccIntrinsics.height);
-
-        for (int k = 0; k < vertices_count_; ++k) {
-
-            float X = vertices_[k * 3];
-            float Y = vertices_[k * 3 + 1];
-            float Z = vertices_[k * 3 + 2];
-
-            // project points with intrinsics
-            int x = static_cast<int>(fx * (X / Z) + cx);
-            int y = static_cast<int>(fy * (Y / Z) + cy);
-
-            if (x < 0 || x > width || y < 0 || y > height) {
-                continue;
-            }
-
-            uint8_t depth_value = UCHAR_MAX - ((Z * 1000) * UCHAR_MAX / 4500);
-
-            cv::Point point(y, x);
-            if (filter == SMALL) {
-                line(depth, point, point, cv::Scalar(depth_value), 1.0);
-            } else {
-                line(depth, point, point, cv::Scalar(depth_value), 5.0);
-            }
-
-        }
-
-
-    }
-
-    // We could do this conversion in a fragment shader if all we care about is
-    // rendering, but we show it here as an example of how people can use RGB data
-    // on the CPU.
-    inline void Yuv2Rgb(uint8_t yValue, uint8_t uValue, uint8_t vValue, uint8_t *r,
-                        uint8_t *g, uint8_t *b) {
-        *r = yValue + (1.370705 * (vValue - 128));
-        *g = yValue - (0.698001 * (vValue - 128)) - (0.337633 * (uValue - 128));
-        *b = yValue + (1.732446 * (uValue - 128));
+        // near points are bright, the nearest point of a pixel wins. 16 bits
+        // keep the filters free of the 18 mm banding of 8 bit maps.
+        tango_core::DepthEncoding encoding;
+        encoding.scale = -1000.0f * USHRT_MAX / 4500;
+        encoding.offset = USHRT_MAX;
+        int radius = filter == SMALL ? 0 : 2;
+        tango_core::SplatDepth(vertices_.data(), vertices_count_,
+                               static_cast<float>(ccIntrinsics.fx),
+                               static_cast<float>(ccIntrinsics.fy),
+                               static_cast<float>(ccIntrinsics.cx),
+                               static_cast<float>(ccIntrinsics.cy),
+                               encoding, radius, true, depth.ptr<uint16_t>(), depth.rows, depth.cols,
+                               depth.step);
     }
 
 }
@@ -323,28 +298,12 @@ namespace tango_video_overlay {
             }
         }
 
-        cv::Mat rgb(yuv_width_, yuv_height_, CV_8UC3);
-
-        for (size_t i = 0; i < yuv_height_; ++i) {
-            for (size_t j = 0; j < yuv_width_; ++j) {
-                size_t x_index = j;
-                if (j % 2 != 0) {
-                    x_index = j - 1;
-                }
-
-                size_t rgb_index = (i * yuv_width_ + j) * 3;
-
-                Yuv2Rgb(yuv_buffer_[i * yuv_width_ + j],
-                        yuv_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index + 1],
-                        yuv_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index],
-                        &rgb_buffer_[rgb_index], &rgb_buffer_[rgb_index + 1],
-                        &rgb_buffer_[rgb_index + 2]);
-
-                rgb.at<cv::Vec3b>(j, i)[0] = rgb_buffer_[rgb_index];
-                rgb.at<cv::Vec3b>(j, i)[1] = rgb_buffer_[rgb_index + 1];
-                rgb.at<cv::Vec3b>(j, i)[2] = rgb_buffer_[rgb_index + 2];
-            }
-        }
+        // rgb_buffer_ holds the texture, rgb the transposed working copy
+        cv::Mat rgb_texture(yuv_height_, yuv_width_, CV_8UC3, rgb_buffer_.data());
+        tango_core::ConvertNV21ToRGB(yuv_buffer_.data(), yuv_width_, yuv_height_, 1, false,
+                                     rgb_texture.ptr(), rgb_texture.step);
+        cv::Mat rgb;
+        cv::transpose(rgb_texture, rgb);
 
         if (!depth.empty()) {
             cv::Mat tmp_depth(depth);
@@ -354,13 +313,14 @@ namespace tango_video_overlay {
             filter = (Filter) (((int) ((now_ms() - elapsedTime) / 5000)) % 5);
 
             cv::Mat scaled_rgb(320, 180, CV_8UC3);
-            if (filter == INFILL || filter == COMBINED) {
-                inpaint(tmp_depth, (tmp_depth == 0), tmp_depth, 3.0, 1);
-            }
             resize(rgb, scaled_rgb, scaled_rgb.size());
-            if (filter == EDGE || filter == COMBINED) {
-                cv::ximgproc::guidedFilter(scaled_rgb, tmp_depth, tmp_depth, 5, 2.0);
+            filter_benchmark_.AddFrame(scaled_rgb, tmp_depth);
+            // a running benchmark gets the cpu, the overlay shows the raw map
+            if (!filter_benchmark_.IsBusy()) {
+                ApplyDepthFilter(kOverlayFilters[filter], scaled_rgb, &tmp_depth);
             }
+            // quantize only the filtered map for display
+            tmp_depth.convertTo(tmp_depth, CV_8U, 1.0 / 257);
             cv::cvtColor(tmp_depth, tmp_depth, CV_GRAY2RGB);
             addWeighted(scaled_rgb, 0.0, tmp_depth, 1.0, 0.0, scaled_rgb);
 
@@ -380,14 +340,7 @@ namespace tango_video_overlay {
 
         }
 
-        for (size_t i = 0; i < yuv_height_; ++i) {
-            for (size_t j = 0; j < yuv_width_; ++j) {
-                size_t rgb_index = (i * yuv_width_ + j) * 3;
-                rgb_buffer_[rgb_index + 0] = rgb.at<cv::Vec3b>(j, i)[0];
-                rgb_buffer_[rgb_index + 1] = rgb.at<cv::Vec3b>(j, i)[1];
-                rgb_buffer_[rgb_index + 2] = rgb.at<cv::Vec3b>(j, i)[2];
-            }
-        }
+        cv::transpose(rgb, rgb_texture);
 
         glBindTexture(GL_TEXTURE_2D, yuv_drawable_->GetTextureId());
         glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, yuv_width_, yuv_height_, 0, GL_RGB,
@@ -396,6 +349,14 @@ namespace tango_video_overlay {
         yuv_drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
     }
 
+    bool VideoOverlayApp::StartFilterBenchmark(int frame_count) {
+        return filter_benchmark_.Start(frame_count);
+    }
+
+    std::string VideoOverlayApp::GetFilterBenchmarkReport() const {
+        return filter_benchmark_.GetReport();
+    }
+
     void VideoOverlayApp::RenderTextureId() {
         double timestamp;
         // TangoService_updateTexture() updates target camera's
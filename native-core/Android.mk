@@ -0,0 +1,69 @@
+#
+# Copyright 2014 Google Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#
+# Static libraries of the native-core kernels, imported by every app module:
+#
+#   LOCAL_STATIC_LIBRARIES += tango_core
+#   $(call import-add-path, $(PROJECT_ROOT))
+#   $(call import-module, native-core)
+#
+# tango_core holds the kernels without dependencies, tango_core_reconstruction
+# the Eigen and open_chisel based ones. Both export include/.
+#
+LOCAL_PATH := $(call my-dir)
+TANGO_CORE_LIBS := $(LOCAL_PATH)/../native-libraries
+TANGO_CORE_CFLAGS := -std=c++11 -mfloat-abi=softfp -mfpu=neon -march=armv7 -mthumb -O3
+
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE    := tango_core
+LOCAL_ARM_NEON  := true
+LOCAL_CFLAGS    := $(TANGO_CORE_CFLAGS)
+
+LOCAL_SRC_FILES := yuv_converter.cc \
+                   depth_splat.cc \
+                   depth_backprojector.cc \
+                   pose_buffer.cc \
+                   render_requester.cc
+
+LOCAL_C_INCLUDES        := $(LOCAL_PATH)/include
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/include
+
+include $(BUILD_STATIC_LIBRARY)
+
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE    := tango_core_reconstruction
+LOCAL_ARM_NEON  := true
+LOCAL_CFLAGS    := $(TANGO_CORE_CFLAGS)
+
+LOCAL_SRC_FILES := chunk_recycler.cc \
+                   chunk_store.cc \
+                   chunk_file.cc \
+                   resolution_levels.cc \
+                   parallel_chisel.cc \
+                   tsdf_raycast.cc \
+                   mesh_simplifier.cc
+
+LOCAL_C_INCLUDES        := $(LOCAL_PATH)/include \
+                           $(TANGO_CORE_LIBS)/eigen \
+                           $(TANGO_CORE_LIBS)/boost/include \
+                           $(TANGO_CORE_LIBS)/open_chisel/include
+LOCAL_EXPORT_C_INCLUDES := $(LOCAL_PATH)/include
+
+include $(BUILD_STATIC_LIBRARY)
@@ -0,0 +1,32 @@
+#
+# Copyright 2014 Google Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+#
+# Standalone build of the libraries and the kernel benchmark:
+#
+#   ndk-build NDK_PROJECT_PATH=. NDK_APPLICATION_MK=Application.mk
+#   adb push libs/armeabi-v7a/kernel_bench /data/local/tmp
+#   adb shell /data/local/tmp/kernel_bench --iterations 200
+#
+# The apps build the libraries with their own Application.mk, LTO only applies
+# here where the final link is under control.
+#
+APP_BUILD_SCRIPT := $(APP_PROJECT_PATH)/bench/Android.mk
+APP_MODULES := kernel_bench
+APP_ABI := armeabi-v7a
+APP_STL := gnustl_static
+APP_PLATFORM := android-19
+APP_CFLAGS += -O3 -mfpu=neon -flto
+APP_LDFLAGS += -flto
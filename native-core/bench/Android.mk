@@ -0,0 +1,30 @@
+#
+# Copyright 2014 Google Inc. All Rights Reserved.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+KERNEL_BENCH_PATH := $(call my-dir)
+
+include $(KERNEL_BENCH_PATH)/../Android.mk
+
+LOCAL_PATH := $(KERNEL_BENCH_PATH)
+
+include $(CLEAR_VARS)
+
+LOCAL_MODULE           := kernel_bench
+LOCAL_ARM_NEON         := true
+LOCAL_CFLAGS           := $(TANGO_CORE_CFLAGS)
+LOCAL_SRC_FILES        := kernel_bench.cc
+LOCAL_STATIC_LIBRARIES := tango_core
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,163 @@
+//
+// Times the native-core kernels on synthetic input and prints the median and
+// mean latency of each, so a kernel change can be measured once for all apps.
+//
+//   kernel_bench [--iterations N]
+//
+// Runs on the device as an ndk-build executable with NEON and on the host
+// with the scalar paths.
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "tango-core/depth_backprojector.h"
+#include "tango-core/depth_splat.h"
+#include "tango-core/pose_buffer.h"
+#include "tango-core/yuv_converter.h"
+
+namespace {
+
+// color camera and the transposed 320x180 depth maps of the apps
+const int kColorWidth = 1280;
+const int kColorHeight = 720;
+const int kDepthRows = 320;
+const int kDepthCols = 180;
+const int kPointCount = 10000;
+const int kPoseLookups = 10000;
+
+struct Intrinsics {
+  float fx;
+  float fy;
+  float cx;
+  float cy;
+};
+
+// depth camera intrinsics at the resolution of the depth maps
+const Intrinsics kDepthIntrinsics = {260.0f, 260.0f, 160.0f, 90.0f};
+
+void Report(const char* name, int iterations, const std::function<void()>& run) {
+  std::vector<double> latencies;
+  latencies.reserve(iterations);
+  // the first run warms caches and allocations up
+  run();
+  for (int i = 0; i < iterations; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    run();
+    latencies.push_back(std::chrono::duration<double, std::milli>(
+        std::chrono::steady_clock::now() - start).count());
+  }
+  double mean = 0.0;
+  for (double latency : latencies) {
+    mean += latency;
+  }
+  mean /= latencies.size();
+  std::nth_element(latencies.begin(), latencies.begin() + latencies.size() / 2,
+                   latencies.end());
+  printf("%-24s %9.3f %9.3f\n", name, latencies[latencies.size() / 2], mean);
+}
+
+// Points of a wall 2 m away with a box in front, in the depth camera frame.
+std::vector<float> SyntheticPoints() {
+  std::vector<float> xyz;
+  xyz.reserve(3 * kPointCount);
+  unsigned int seed = 1;
+  for (int i = 0; i < kPointCount; ++i) {
+    float u = static_cast<float>(rand_r(&seed)) / RAND_MAX - 0.5f;
+    float v = static_cast<float>(rand_r(&seed)) / RAND_MAX - 0.5f;
+    float z = std::abs(u) < 0.15f && std::abs(v) < 0.15f ? 1.2f : 2.0f;
+    xyz.push_back(u * 1.2f * z);
+    xyz.push_back(v * 0.7f * z);
+    xyz.push_back(z);
+  }
+  return xyz;
+}
+
+void PrintUsage(const char* name) {
+  fprintf(stderr, "usage: %s [--iterations N]\n", name);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  int iterations = 100;
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc) {
+      iterations = atoi(argv[++i]);
+    } else {
+      PrintUsage(argv[0]);
+      return 1;
+    }
+  }
+  if (iterations <= 0) {
+    PrintUsage(argv[0]);
+    return 1;
+  }
+
+  printf("%-24s %9s %9s\n", "kernel", "p50 ms", "mean ms");
+
+  std::vector<uint8_t> nv21(kColorWidth * kColorHeight * 3 / 2);
+  for (size_t i = 0; i < nv21.size(); ++i) {
+    nv21[i] = static_cast<uint8_t>(i * 7);
+  }
+  std::vector<uint8_t> rgb(kColorWidth * kColorHeight * 3);
+  for (int factor = 1; factor <= 2; ++factor) {
+    std::string name = "nv21 to rgb 1/" + std::to_string(factor);
+    Report(name.c_str(), iterations, [&]() {
+      tango_core::ConvertNV21ToRGB(nv21.data(), kColorWidth, kColorHeight,
+                                   factor, true, rgb.data(),
+                                   3 * kColorWidth / factor);
+    });
+  }
+
+  // near points bright, like the overlay maps
+  tango_core::DepthEncoding encoding;
+  encoding.scale = -1000.0f * 65535 / 4500;
+  encoding.offset = 65535;
+  std::vector<float> xyz = SyntheticPoints();
+  std::vector<uint16_t> depth(kDepthRows * kDepthCols);
+  for (int radius = 0; radius <= 2; radius += 2) {
+    std::string name = "splat radius " + std::to_string(radius);
+    Report(name.c_str(), iterations, [&]() {
+      std::fill(depth.begin(), depth.end(), 0);
+      tango_core::SplatDepth(xyz.data(), kPointCount, kDepthIntrinsics.fx,
+                             kDepthIntrinsics.fy, kDepthIntrinsics.cx,
+                             kDepthIntrinsics.cy, encoding, radius, true,
+                             depth.data(), kDepthRows, kDepthCols,
+                             kDepthCols * sizeof(uint16_t));
+    });
+  }
+
+  tango_core::DepthBackProjector back_projector;
+  back_projector.Reset(kDepthRows, kDepthCols, kDepthIntrinsics.fx,
+                       kDepthIntrinsics.fy, kDepthIntrinsics.cx,
+                       kDepthIntrinsics.cy, true, encoding);
+  std::vector<float> points(3 * kDepthRows * kDepthCols);
+  Report("back projection", iterations, [&]() {
+    back_projector.BackProject(depth.data(), kDepthCols * sizeof(uint16_t),
+                               points.data());
+  });
+
+  // 2.56 s of poses at 100 Hz, looked up between two of them each time
+  tango_core::PoseBuffer poses;
+  for (int i = 0; i < 256; ++i) {
+    double translation[3] = {0.01 * i, 0.0, 1.5};
+    double orientation[4] = {0.0, 0.0, 0.0, 1.0};
+    poses.Insert(0.01 * i, translation, orientation);
+  }
+  Report("pose lookup x10000", iterations, [&]() {
+    double translation[3];
+    double orientation[4];
+    for (int i = 0; i < kPoseLookups; ++i) {
+      poses.Lookup(0.5 + 1e-4 * i, translation, orientation);
+    }
+  });
+  return 0;
+}
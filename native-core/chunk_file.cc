@@ -0,0 +1,319 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-core/chunk_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <initializer_list>
+
+namespace {
+
+const uint32_t kIndexMagic = 0x46445354;  // "TSDF"
+const uint32_t kIndexVersion = 1;
+
+struct IndexHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t count;
+  uint32_t reserved;
+};
+
+template <typename Entry>
+bool Less(const Entry& entry, int32_t x, int32_t y, int32_t z) {
+  if (entry.x != x) return entry.x < x;
+  if (entry.y != y) return entry.y < y;
+  return entry.z < z;
+}
+
+// pwrite until all bytes are written
+bool WriteFully(int fd, const uint8_t* data, size_t size, uint64_t offset) {
+  while (size > 0) {
+    ssize_t written = pwrite(fd, data, size, offset);
+    if (written <= 0) {
+      return false;
+    }
+    data += written;
+    size -= written;
+    offset += written;
+  }
+  return true;
+}
+
+bool ReadFully(int fd, uint8_t* data, size_t size, uint64_t offset) {
+  while (size > 0) {
+    ssize_t read = pread(fd, data, size, offset);
+    if (read <= 0) {
+      return false;
+    }
+    data += read;
+    size -= read;
+    offset += read;
+  }
+  return true;
+}
+
+}  // namespace
+
+namespace tango_core {
+
+ChunkFile::ChunkFile() {}
+
+ChunkFile::~ChunkFile() { Close(); }
+
+bool ChunkFile::Open(const std::string& directory) {
+  Close();
+  std::string data_path = directory + "/chunks.dat";
+  index_path_ = directory + "/chunks.idx";
+  data_fd_ = open(data_path.c_str(), O_RDWR | O_CREAT, 0644);
+  if (data_fd_ < 0) {
+    return false;
+  }
+  off_t end = lseek(data_fd_, 0, SEEK_END);
+  data_size_ = end > 0 ? end : 0;
+
+  int index_fd = open(index_path_.c_str(), O_RDONLY);
+  if (index_fd >= 0) {
+    struct stat info;
+    if (fstat(index_fd, &info) == 0 &&
+        info.st_size >= static_cast<off_t>(sizeof(IndexHeader))) {
+      void* mapping = mmap(nullptr, info.st_size, PROT_READ, MAP_PRIVATE,
+                           index_fd, 0);
+      if (mapping != MAP_FAILED) {
+        mapping_ = mapping;
+        mapping_size_ = info.st_size;
+        const IndexHeader* header = static_cast<const IndexHeader*>(mapping);
+        size_t capacity = (mapping_size_ - sizeof(IndexHeader)) /
+                          sizeof(IndexEntry);
+        // an index of another format or a torn write is ignored
+        if (header->magic == kIndexMagic && header->version == kIndexVersion &&
+            header->count <= capacity) {
+          mapped_entries_ = reinterpret_cast<const IndexEntry*>(header + 1);
+          mapped_count_ = header->count;
+        }
+      }
+    }
+    close(index_fd);
+  }
+
+  stop_ = false;
+  writer_ = std::thread(&ChunkFile::WriterLoop, this);
+  return true;
+}
+
+void ChunkFile::Close() {
+  if (writer_.joinable()) {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    writer_condition_.notify_one();
+    writer_.join();
+  }
+  if (data_fd_ >= 0) {
+    close(data_fd_);
+    data_fd_ = -1;
+  }
+  UnmapIndex();
+  written_.clear();
+  pending_.clear();
+  in_flight_.clear();
+}
+
+bool ChunkFile::IsOpen() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return data_fd_ >= 0;
+}
+
+void ChunkFile::UnmapIndex() {
+  if (mapping_ != nullptr) {
+    munmap(mapping_, mapping_size_);
+  }
+  mapping_ = nullptr;
+  mapping_size_ = 0;
+  mapped_entries_ = nullptr;
+  mapped_count_ = 0;
+}
+
+void ChunkFile::Write(const chisel::ChunkID& id, std::vector<uint8_t> data) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (data_fd_ < 0) {
+      return;
+    }
+    pending_[id] = std::move(data);
+  }
+  writer_condition_.notify_one();
+}
+
+const ChunkFile::IndexEntry* ChunkFile::FindMapped(
+    const chisel::ChunkID& id) const {
+  const IndexEntry* end = mapped_entries_ + mapped_count_;
+  const IndexEntry* entry = std::lower_bound(
+      mapped_entries_, end, id, [](const IndexEntry& e, const chisel::ChunkID& k) {
+        return Less(e, k(0), k(1), k(2));
+      });
+  if (entry == end || entry->x != id(0) || entry->y != id(1) ||
+      entry->z != id(2)) {
+    return nullptr;
+  }
+  return entry;
+}
+
+bool ChunkFile::Find(const chisel::ChunkID& id, Location* location) const {
+  auto written = written_.find(id);
+  if (written != written_.end()) {
+    *location = written->second;
+    return true;
+  }
+  const IndexEntry* entry = FindMapped(id);
+  if (entry == nullptr || entry->offset + entry->size > data_size_) {
+    return false;
+  }
+  location->offset = entry->offset;
+  location->size = entry->size;
+  return true;
+}
+
+bool ChunkFile::Contains(const chisel::ChunkID& id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Location location;
+  return pending_.count(id) > 0 || in_flight_.count(id) > 0 ||
+         Find(id, &location);
+}
+
+bool ChunkFile::Read(const chisel::ChunkID& id,
+                     std::vector<uint8_t>* data) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (const auto* queue : {&pending_, &in_flight_}) {
+    auto queued = queue->find(id);
+    if (queued != queue->end()) {
+      *data = queued->second;
+      return true;
+    }
+  }
+  Location location;
+  if (data_fd_ < 0 || !Find(id, &location)) {
+    return false;
+  }
+  data->resize(location.size);
+  return ReadFully(data_fd_, data->data(), location.size, location.offset);
+}
+
+void ChunkFile::Clear() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  pending_.clear();
+  flushed_condition_.wait(lock, [this] { return !writing_; });
+  written_.clear();
+  UnmapIndex();
+  if (data_fd_ >= 0) {
+    // if truncating fails new chunks go after the stale bytes
+    if (ftruncate(data_fd_, 0) == 0) {
+      data_size_ = 0;
+    }
+    WriteIndex(std::vector<IndexEntry>());
+  }
+}
+
+void ChunkFile::Flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  flushed_condition_.wait(lock,
+                          [this] { return pending_.empty() && !writing_; });
+}
+
+bool ChunkFile::WriteIndex(const std::vector<IndexEntry>& entries) {
+  // written next to the index and renamed over it, a crash keeps the old one
+  std::string temp_path = index_path_ + ".tmp";
+  FILE* file = fopen(temp_path.c_str(), "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  IndexHeader header = {kIndexMagic, kIndexVersion,
+                        static_cast<uint32_t>(entries.size()), 0};
+  bool ok = fwrite(&header, sizeof(header), 1, file) == 1 &&
+            (entries.empty() ||
+             fwrite(entries.data(), sizeof(IndexEntry), entries.size(), file) ==
+                 entries.size());
+  ok = fclose(file) == 0 && ok;
+  return ok && rename(temp_path.c_str(), index_path_.c_str()) == 0;
+}
+
+void ChunkFile::WriterLoop() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (true) {
+    writer_condition_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+    if (pending_.empty()) {
+      // stop_, everything queued before it is written
+      return;
+    }
+    in_flight_.swap(pending_);
+    writing_ = true;
+    uint64_t offset = data_size_;
+    lock.unlock();
+
+    std::vector<std::pair<chisel::ChunkID, Location>> locations;
+    locations.reserve(in_flight_.size());
+    for (const auto& chunk : in_flight_) {
+      const std::vector<uint8_t>& data = chunk.second;
+      if (!WriteFully(data_fd_, data.data(), data.size(), offset)) {
+        break;
+      }
+      Location location = {offset, static_cast<uint32_t>(data.size())};
+      locations.push_back(std::make_pair(chunk.first, location));
+      offset += data.size();
+    }
+
+    lock.lock();
+    data_size_ = offset;
+    for (const auto& location : locations) {
+      written_[location.first] = location.second;
+    }
+    in_flight_.clear();
+    // the mapped entries not written again plus this session's ones
+    std::vector<IndexEntry> entries;
+    entries.reserve(mapped_count_ + written_.size());
+    for (size_t i = 0; i < mapped_count_; ++i) {
+      const IndexEntry& entry = mapped_entries_[i];
+      if (written_.count(chisel::ChunkID(entry.x, entry.y, entry.z)) == 0) {
+        entries.push_back(entry);
+      }
+    }
+    for (const auto& chunk : written_) {
+      IndexEntry entry = {chunk.first(0), chunk.first(1), chunk.first(2),
+                          chunk.second.size, chunk.second.offset};
+      entries.push_back(entry);
+    }
+    lock.unlock();
+
+    std::sort(entries.begin(), entries.end(),
+              [](const IndexEntry& a, const IndexEntry& b) {
+                return Less(a, b.x, b.y, b.z);
+              });
+    WriteIndex(entries);
+
+    lock.lock();
+    writing_ = false;
+    flushed_condition_.notify_all();
+  }
+}
+
+}  // namespace tango_core
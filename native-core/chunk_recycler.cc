@@ -0,0 +1,53 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-core/chunk_recycler.h"
+
+#include <open_chisel/Chunk.h>
+#include <open_chisel/ChunkManager.h>
+
+namespace tango_core {
+
+ChunkRecycler::ChunkRecycler(size_t max_voxel_bytes)
+    : max_voxel_bytes_(max_voxel_bytes) {}
+
+size_t ChunkRecycler::VoxelBytes(const chisel::Chisel& map) {
+  size_t bytes = 0;
+  for (const auto& chunk : map.GetChunkManager().GetChunks()) {
+    bytes += chunk.second->GetTotalNumVoxels() * sizeof(chisel::DistVoxel);
+  }
+  return bytes;
+}
+
+void ChunkRecycler::Clear(chisel::Chisel* map) const {
+  if (VoxelBytes(*map) > max_voxel_bytes_) {
+    map->Reset();
+    return;
+  }
+  chisel::ChunkManager& manager = map->GetMutableChunkManager();
+  for (auto& chunk : manager.GetMutableChunks()) {
+    chisel::Chunk* target = chunk.second.get();
+    int count = target->GetTotalNumVoxels();
+    for (int i = 0; i < count; ++i) {
+      // back to the state of a new chunk, no distance and no weight
+      target->GetDistVoxelMutable(i).Reset();
+    }
+  }
+  // the kept chunks are empty now, they mesh again once a scan touches them
+  manager.GetAllMutableMeshes().clear();
+}
+
+}  // namespace tango_core
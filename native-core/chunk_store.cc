@@ -0,0 +1,240 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-core/chunk_store.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#include <open_chisel/Chunk.h>
+#include <open_chisel/ChunkManager.h>
+
+namespace {
+
+// distance steps of 0.1 mm cover +-3.2 m, well past any truncation distance
+const float kDistanceScale = 10000.0f;
+const float kWeightScale = 64.0f;
+const int kMaxRun = 0xffff;
+
+template <typename T>
+void Append(std::vector<uint8_t>* out, T value) {
+  size_t offset = out->size();
+  out->resize(offset + sizeof(T));
+  memcpy(&(*out)[offset], &value, sizeof(T));
+}
+
+template <typename T>
+bool Read(const uint8_t** data, const uint8_t* end, T* value) {
+  if (end - *data < static_cast<ptrdiff_t>(sizeof(T))) {
+    return false;
+  }
+  memcpy(value, *data, sizeof(T));
+  *data += sizeof(T);
+  return true;
+}
+
+template <typename T>
+T Quantize(float value, float scale) {
+  float scaled = std::round(value * scale);
+  scaled = std::max(scaled, static_cast<float>(std::numeric_limits<T>::min()));
+  scaled = std::min(scaled, static_cast<float>(std::numeric_limits<T>::max()));
+  return static_cast<T>(scaled);
+}
+
+Eigen::Vector3f ChunkCenter(const chisel::ChunkManager& manager,
+                            const chisel::ChunkID& id) {
+  Eigen::Vector3f extent =
+      manager.GetChunkSize().cast<float>() * manager.GetResolution();
+  return (id.cast<float>() + Eigen::Vector3f::Constant(0.5f))
+      .cwiseProduct(extent);
+}
+
+}  // namespace
+
+namespace tango_core {
+
+void ChunkStore::Compress(const chisel::Chunk& chunk,
+                          std::vector<uint8_t>* out) {
+  // alternating runs: uint16 empty voxels, uint16 observed voxels followed by
+  // an int16 distance and uint16 weight each
+  out->clear();
+  int count = chunk.GetTotalNumVoxels();
+  int i = 0;
+  while (i < count) {
+    int empty = 0;
+    while (i + empty < count && empty < kMaxRun &&
+           chunk.GetDistVoxel(i + empty).GetWeight() <= 0.0f) {
+      ++empty;
+    }
+    i += empty;
+    int observed = 0;
+    while (i + observed < count && observed < kMaxRun &&
+           chunk.GetDistVoxel(i + observed).GetWeight() > 0.0f) {
+      ++observed;
+    }
+    Append<uint16_t>(out, empty);
+    Append<uint16_t>(out, observed);
+    for (int v = i; v < i + observed; ++v) {
+      const chisel::DistVoxel& voxel = chunk.GetDistVoxel(v);
+      Append(out, Quantize<int16_t>(voxel.GetSDF(), kDistanceScale));
+      Append(out, Quantize<uint16_t>(voxel.GetWeight(), kWeightScale));
+    }
+    i += observed;
+  }
+}
+
+bool ChunkStore::Decompress(const uint8_t* data, size_t size,
+                            chisel::Chunk* chunk) {
+  const uint8_t* end = data + size;
+  int count = chunk->GetTotalNumVoxels();
+  int i = 0;
+  while (data < end) {
+    uint16_t empty;
+    uint16_t observed;
+    if (!Read(&data, end, &empty) || !Read(&data, end, &observed) ||
+        i + empty + observed > count) {
+      return false;
+    }
+    // a new chunk starts out empty
+    i += empty;
+    for (int v = 0; v < observed; ++v, ++i) {
+      int16_t distance;
+      uint16_t weight;
+      if (!Read(&data, end, &distance) || !Read(&data, end, &weight)) {
+        return false;
+      }
+      chisel::DistVoxel& voxel = chunk->GetDistVoxelMutable(i);
+      voxel.SetSDF(distance / kDistanceScale);
+      voxel.SetWeight(weight / kWeightScale);
+    }
+  }
+  return i == count;
+}
+
+bool ChunkStore::Evict(chisel::Chisel* map, const chisel::ChunkID& id) {
+  chisel::ChunkManager& manager = map->GetMutableChunkManager();
+  if (!manager.HasChunk(id)) {
+    return false;
+  }
+  if (file_ != nullptr) {
+    std::vector<uint8_t> data;
+    Compress(*manager.GetChunk(id), &data);
+    file_->Write(id, std::move(data));
+  } else {
+    std::vector<uint8_t>& data = chunks_[id];
+    bytes_ -= data.size();
+    Compress(*manager.GetChunk(id), &data);
+    bytes_ += data.size();
+  }
+  manager.RemoveChunk(id);
+  manager.GetAllMutableMeshes().erase(id);
+  return true;
+}
+
+bool ChunkStore::Persist(const chisel::Chisel& map, const chisel::ChunkID& id) {
+  const chisel::ChunkManager& manager = map.GetChunkManager();
+  if (file_ == nullptr || !manager.HasChunk(id)) {
+    return false;
+  }
+  std::vector<uint8_t> data;
+  Compress(*manager.GetChunk(id), &data);
+  file_->Write(id, std::move(data));
+  return true;
+}
+
+bool ChunkStore::Restore(chisel::Chisel* map, const chisel::ChunkID& id) {
+  const std::vector<uint8_t>* data = nullptr;
+  auto stored = chunks_.find(id);
+  if (stored != chunks_.end()) {
+    data = &stored->second;
+  } else if (file_ != nullptr && file_->Read(id, &scratch_)) {
+    data = &scratch_;
+  } else {
+    return false;
+  }
+  chisel::ChunkManager& manager = map->GetMutableChunkManager();
+  if (!manager.HasChunk(id)) {
+    manager.CreateChunk(id);
+    chisel::ChunkPtr chunk = manager.GetChunk(id);
+    if (!Decompress(data->data(), data->size(), chunk.get())) {
+      // keep what the map has rather than half a chunk
+      manager.RemoveChunk(id);
+    }
+  }
+  if (stored != chunks_.end()) {
+    bytes_ -= stored->second.size();
+    chunks_.erase(stored);
+  }
+  return true;
+}
+
+bool ChunkStore::Contains(const chisel::ChunkID& id) const {
+  return chunks_.find(id) != chunks_.end() ||
+         (file_ != nullptr && file_->Contains(id));
+}
+
+void ChunkStore::Clear() {
+  chunks_.clear();
+  bytes_ = 0;
+  if (file_ != nullptr) {
+    file_->Clear();
+  }
+}
+
+void UpdateActiveRegion(const Eigen::Vector3f& center, float radius,
+                        chisel::Chisel* map, ChunkStore* store,
+                        std::vector<chisel::ChunkID>* changed) {
+  const chisel::ChunkManager& manager = map->GetChunkManager();
+  float extent = manager.GetChunkSize().maxCoeff() * manager.GetResolution();
+  float evict_squared = (radius + extent) * (radius + extent);
+  float restore_squared = radius * radius;
+
+  size_t first = changed->size();
+  for (const auto& chunk : manager.GetChunks()) {
+    if ((ChunkCenter(manager, chunk.first) - center).squaredNorm() >
+        evict_squared) {
+      changed->push_back(chunk.first);
+    }
+  }
+  for (size_t i = first; i < changed->size(); ++i) {
+    store->Evict(map, (*changed)[i]);
+  }
+
+  // the chunks within radius, map chunks are never stored as well
+  size_t evicted = changed->size();
+  int reach = static_cast<int>(std::ceil(radius / extent));
+  Eigen::Vector3i middle =
+      (center / extent).array().floor().cast<int>().matrix();
+  for (int x = -reach; x <= reach; ++x) {
+    for (int y = -reach; y <= reach; ++y) {
+      for (int z = -reach; z <= reach; ++z) {
+        chisel::ChunkID id = middle + chisel::ChunkID(x, y, z);
+        if ((ChunkCenter(manager, id) - center).squaredNorm() <=
+                restore_squared &&
+            !manager.HasChunk(id) && store->Contains(id)) {
+          changed->push_back(id);
+        }
+      }
+    }
+  }
+  for (size_t i = evicted; i < changed->size(); ++i) {
+    store->Restore(map, (*changed)[i]);
+  }
+}
+
+}  // namespace tango_core
@@ -0,0 +1,113 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-core/depth_backprojector.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TANGO_CORE_HAVE_NEON 1
+#endif
+
+#ifdef TANGO_CORE_HAVE_NEON
+namespace {
+
+// Eight depth values widened to 16 bits.
+inline uint16x8_t LoadEight(const uint8_t* values) {
+  return vmovl_u8(vld1_u8(values));
+}
+
+inline uint16x8_t LoadEight(const uint16_t* values) {
+  return vld1q_u16(values);
+}
+
+}  // namespace
+#endif
+
+namespace tango_core {
+
+void DepthBackProjector::Reset(int rows, int cols, float fx, float fy,
+                               float cx, float cy, bool transposed,
+                               const DepthEncoding& encoding) {
+  rows_ = rows;
+  cols_ = cols;
+  transposed_ = transposed;
+  depth_scale_ = 1.0f / encoding.scale;
+  depth_offset_ = -encoding.offset / encoding.scale;
+
+  // transposed rows step along camera x, otherwise along camera y
+  float row_f = transposed ? fx : fy;
+  float row_c = transposed ? cx : cy;
+  float column_f = transposed ? fy : fx;
+  float column_c = transposed ? cy : cx;
+  row_rays_.resize(rows);
+  for (int r = 0; r < rows; ++r) {
+    row_rays_[r] = (r - row_c) / row_f;
+  }
+  column_rays_.resize(cols);
+  for (int c = 0; c < cols; ++c) {
+    column_rays_[c] = (c - column_c) / column_f;
+  }
+}
+
+void DepthBackProjector::BackProject(const uint8_t* depth, size_t stride,
+                                     float* xyz) const {
+  BackProjectRows(depth, stride, xyz);
+}
+
+void DepthBackProjector::BackProject(const uint16_t* depth, size_t stride,
+                                     float* xyz) const {
+  BackProjectRows(depth, stride, xyz);
+}
+
+template <typename T>
+void DepthBackProjector::BackProjectRows(const T* depth, size_t stride,
+                                         float* xyz) const {
+  // output lanes of the row and column ray
+  const int row_axis = transposed_ ? 0 : 1;
+  const int column_axis = 1 - row_axis;
+  for (int r = 0; r < rows_; ++r) {
+    const T* row = reinterpret_cast<const T*>(
+        reinterpret_cast<const uint8_t*>(depth) + r * stride);
+    float* out = xyz + static_cast<size_t>(r) * cols_ * 3;
+    const float row_ray = row_rays_[r];
+    int c = 0;
+#ifdef TANGO_CORE_HAVE_NEON
+    const float32x4_t scale = vdupq_n_f32(depth_scale_);
+    const float32x4_t offset = vdupq_n_f32(depth_offset_);
+    for (; c + 8 <= cols_; c += 8) {
+      uint16x8_t values = LoadEight(row + c);
+      uint32x4_t halves[2] = {vmovl_u16(vget_low_u16(values)),
+                              vmovl_u16(vget_high_u16(values))};
+      for (int h = 0; h < 2; ++h) {
+        float32x4_t z = vmlaq_f32(offset, vcvtq_f32_u32(halves[h]), scale);
+        float32x4x3_t point;
+        point.val[row_axis] = vmulq_n_f32(z, row_ray);
+        point.val[column_axis] = vmulq_f32(z, vld1q_f32(&column_rays_[c + 4 * h]));
+        point.val[2] = z;
+        vst3q_f32(out + 3 * (c + 4 * h), point);
+      }
+    }
+#endif
+    for (; c < cols_; ++c) {
+      float z = depth_offset_ + static_cast<float>(row[c]) * depth_scale_;
+      out[3 * c + row_axis] = z * row_ray;
+      out[3 * c + column_axis] = z * column_rays_[c];
+      out[3 * c + 2] = z;
+    }
+  }
+}
+
+}  // namespace tango_core
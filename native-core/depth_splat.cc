@@ -0,0 +1,168 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-core/depth_splat.h"
+
+#include <algorithm>
+#include <limits>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TANGO_CORE_HAVE_NEON 1
+#endif
+
+namespace {
+
+// Rows of a depth image are stride bytes apart for every pixel type.
+template <typename T>
+inline T* Row(T* image, size_t stride, int row) {
+  return reinterpret_cast<T*>(reinterpret_cast<uint8_t*>(image) + row * stride);
+}
+
+// Writes value into row[begin, end) where it is nearer than the pixel.
+template <bool kKeepMinimum, typename T>
+inline void SplatRowScalar(T value, int begin, int end, T* row) {
+  for (int x = begin; x < end; ++x) {
+    row[x] = kKeepMinimum ? std::min(row[x], value) : std::max(row[x], value);
+  }
+}
+
+#ifdef TANGO_CORE_HAVE_NEON
+// Eight lanes of either pixel type, so both share one footprint mask.
+template <typename T>
+struct Lanes;
+
+template <>
+struct Lanes<uint8_t> {
+  typedef uint8x8_t Vector;
+  static Vector Load(const uint8_t* p) { return vld1_u8(p); }
+  static void Store(uint8_t* p, Vector v) { vst1_u8(p, v); }
+  static Vector Dup(uint8_t v) { return vdup_n_u8(v); }
+  static Vector Or(Vector a, Vector b) { return vorr_u8(a, b); }
+  static Vector Bic(Vector a, Vector b) { return vbic_u8(a, b); }
+  static Vector Min(Vector a, Vector b) { return vmin_u8(a, b); }
+  static Vector Max(Vector a, Vector b) { return vmax_u8(a, b); }
+};
+
+template <>
+struct Lanes<uint16_t> {
+  typedef uint16x8_t Vector;
+  static Vector Load(const uint16_t* p) { return vld1q_u16(p); }
+  static void Store(uint16_t* p, Vector v) { vst1q_u16(p, v); }
+  static Vector Dup(uint16_t v) { return vdupq_n_u16(v); }
+  static Vector Or(Vector a, Vector b) { return vorrq_u16(a, b); }
+  static Vector Bic(Vector a, Vector b) { return vbicq_u16(a, b); }
+  static Vector Min(Vector a, Vector b) { return vminq_u16(a, b); }
+  static Vector Max(Vector a, Vector b) { return vmaxq_u16(a, b); }
+};
+#endif
+
+template <bool kKeepMinimum, typename T>
+void SplatPoints(const float* xyz, size_t count, float fx, float fy, float cx,
+                 float cy, const tango_core::DepthEncoding& encoding,
+                 int radius, bool transposed, T* image, int rows, int cols,
+                 size_t stride) {
+  const float max_value = std::numeric_limits<T>::max();
+#ifdef TANGO_CORE_HAVE_NEON
+  typedef Lanes<T> L;
+  const int size = 2 * radius + 1;
+  // lanes past the footprint hold the identity of min or max
+  T lane_mask[8];
+  for (int i = 0; i < 8; ++i) {
+    lane_mask[i] = i < size ? 0 : std::numeric_limits<T>::max();
+  }
+  const typename L::Vector outside = L::Load(lane_mask);
+#endif
+
+  for (size_t i = 0; i < count; ++i) {
+    float z = xyz[3 * i + 2];
+    if (z <= 0.0f) {
+      continue;
+    }
+    float value = encoding.offset + encoding.scale * z;
+    if (value < 0.0f || value > max_value) {
+      continue;
+    }
+    float inverse_z = 1.0f / z;
+    int x = static_cast<int>(fx * xyz[3 * i] * inverse_z + cx);
+    int y = static_cast<int>(fy * xyz[3 * i + 1] * inverse_z + cy);
+    int row = transposed ? x : y;
+    int column = transposed ? y : x;
+    if (row < 0 || row >= rows || column < 0 || column >= cols) {
+      continue;
+    }
+
+    T pixel = static_cast<T>(value);
+    int top = std::max(row - radius, 0);
+    int bottom = std::min(row + radius + 1, rows);
+    int left = std::max(column - radius, 0);
+    int right = std::min(column + radius + 1, cols);
+#ifdef TANGO_CORE_HAVE_NEON
+    if (size <= 8 && column - radius >= 0 && column - radius + 8 <= cols) {
+      typename L::Vector splat = kKeepMinimum ? L::Or(L::Dup(pixel), outside)
+                                              : L::Bic(L::Dup(pixel), outside);
+      for (int r = top; r < bottom; ++r) {
+        T* target = Row(image, stride, r) + left;
+        typename L::Vector current = L::Load(target);
+        L::Store(target, kKeepMinimum ? L::Min(current, splat)
+                                      : L::Max(current, splat));
+      }
+      continue;
+    }
+#endif
+    for (int r = top; r < bottom; ++r) {
+      SplatRowScalar<kKeepMinimum>(pixel, left, right, Row(image, stride, r));
+    }
+  }
+}
+
+template <typename T>
+void Splat(const float* xyz, size_t count, float fx, float fy, float cx,
+           float cy, const tango_core::DepthEncoding& encoding, int radius,
+           bool transposed, T* image, int rows, int cols, size_t stride) {
+  if (radius < 0) {
+    radius = 0;
+  }
+  if (encoding.scale >= 0.0f) {
+    SplatPoints<true>(xyz, count, fx, fy, cx, cy, encoding, radius, transposed,
+                      image, rows, cols, stride);
+  } else {
+    SplatPoints<false>(xyz, count, fx, fy, cx, cy, encoding, radius,
+                       transposed, image, rows, cols, stride);
+  }
+}
+
+}  // namespace
+
+namespace tango_core {
+
+void SplatDepth(const float* xyz, size_t count, float fx, float fy, float cx,
+                float cy, const DepthEncoding& encoding, int radius,
+                bool transposed, uint8_t* image, int rows, int cols,
+                size_t stride) {
+  Splat(xyz, count, fx, fy, cx, cy, encoding, radius, transposed, image, rows,
+        cols, stride);
+}
+
+void SplatDepth(const float* xyz, size_t count, float fx, float fy, float cx,
+                float cy, const DepthEncoding& encoding, int radius,
+                bool transposed, uint16_t* image, int rows, int cols,
+                size_t stride) {
+  Splat(xyz, count, fx, fy, cx, cy, encoding, radius, transposed, image, rows,
+        cols, stride);
+}
+
+}  // namespace tango_core
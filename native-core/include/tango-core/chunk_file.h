@@ -0,0 +1,124 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_CORE_CHUNK_FILE_H_
+#define TANGO_CORE_CHUNK_FILE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <open_chisel/Chisel.h>
+
+namespace tango_core {
+
+// On-disk store of compressed chunks (see ChunkStore) that outlives the app.
+// chunks.dat holds the chunk data back to back, chunks.idx a sorted table of
+// chunk id, offset and size. The index of an earlier session is memory-mapped
+// on Open, chunk data is only read when a chunk is asked for.
+//
+// Writes are queued and appended by a background thread, which rewrites the
+// index after every batch. A chunk written again is appended again and the
+// index points at the newest copy, the older bytes stay unused until Clear.
+//
+// All calls are thread safe.
+class ChunkFile {
+ public:
+  ChunkFile();
+
+  ~ChunkFile();
+
+  // Opens or creates the store in directory, which has to exist.
+  // @return: false if the files could not be opened.
+  bool Open(const std::string& directory);
+
+  // Writes what is queued and closes the files.
+  void Close();
+
+  bool IsOpen() const;
+
+  // Queues the data of a chunk for writing, replacing its older versions.
+  void Write(const chisel::ChunkID& id, std::vector<uint8_t> data);
+
+  bool Contains(const chisel::ChunkID& id) const;
+
+  // @return: false if the store has no such chunk or reading failed.
+  bool Read(const chisel::ChunkID& id, std::vector<uint8_t>* data) const;
+
+  // Removes all chunks, also from disk.
+  void Clear();
+
+  // Blocks until the queued writes are on disk.
+  void Flush();
+
+ private:
+  struct IndexEntry {
+    int32_t x, y, z;
+    uint32_t size;
+    uint64_t offset;
+  };
+
+  struct Location {
+    uint64_t offset;
+    uint32_t size;
+  };
+
+  // newest location of a chunk, mutex_ held
+  bool Find(const chisel::ChunkID& id, Location* location) const;
+
+  // index entry of the mapped index, or nullptr
+  const IndexEntry* FindMapped(const chisel::ChunkID& id) const;
+
+  bool WriteIndex(const std::vector<IndexEntry>& entries);
+
+  void UnmapIndex();
+
+  void WriterLoop();
+
+  std::string index_path_;
+  int data_fd_ = -1;
+  uint64_t data_size_ = 0;
+
+  // index of the earlier session, sorted by id
+  void* mapping_ = nullptr;
+  size_t mapping_size_ = 0;
+  const IndexEntry* mapped_entries_ = nullptr;
+  size_t mapped_count_ = 0;
+  // chunks written in this session
+  std::unordered_map<chisel::ChunkID, Location, chisel::ChunkHasher> written_;
+  // queued for the writer and being written, readable until written
+  std::unordered_map<chisel::ChunkID, std::vector<uint8_t>, chisel::ChunkHasher>
+      pending_;
+  std::unordered_map<chisel::ChunkID, std::vector<uint8_t>, chisel::ChunkHasher>
+      in_flight_;
+
+  mutable std::mutex mutex_;
+  std::condition_variable writer_condition_;
+  std::condition_variable flushed_condition_;
+  std::thread writer_;
+  bool writing_ = false;
+  bool stop_ = false;
+};
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_CHUNK_FILE_H_
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_CORE_CHUNK_RECYCLER_H_
+#define TANGO_CORE_CHUNK_RECYCLER_H_
+
+#include <stddef.h>
+
+#include <open_chisel/Chisel.h>
+
+namespace tango_core {
+
+// Clears a chisel reconstruction without freeing its chunks. Chisel::Reset,
+// like recreating the Chisel, drops every chunk and the next scan of the same
+// space allocates them again one by one with their voxel arrays. Clear resets
+// the voxels of the chunks in place instead and keeps them, so a clear and
+// rescan reuses the chunks it had. Maps holding more than the budget are
+// reset for real, which bounds the memory kept across clears.
+//
+// The chunks have to be created without colors, like both wrappers do. Call
+// on the thread integrating into the map.
+class ChunkRecycler {
+ public:
+  // @param max_voxel_bytes: largest voxel storage kept through a clear.
+  explicit ChunkRecycler(size_t max_voxel_bytes);
+
+  void Clear(chisel::Chisel* map) const;
+
+  // @return: bytes of voxel storage held by the chunks of map.
+  static size_t VoxelBytes(const chisel::Chisel& map);
+
+ private:
+  size_t max_voxel_bytes_;
+};
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_CHUNK_RECYCLER_H_
@@ -0,0 +1,103 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_CORE_CHUNK_STORE_H_
+#define TANGO_CORE_CHUNK_STORE_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include <Eigen/Core>
+#include <open_chisel/Chisel.h>
+
+#include "tango-core/chunk_file.h"
+
+namespace tango_core {
+
+// Compressed copies of chisel chunks taken out of the map. Empty voxels are
+// stored as run lengths and observed ones as a 16 bit distance (0.1 mm steps)
+// and a 16 bit weight, so a mostly empty 8^3 chunk shrinks from 4 KB to a few
+// hundred bytes.
+//
+// With a ChunkFile evicted chunks are spilled to it instead of being kept in
+// memory, and the chunks of an earlier session in the file can be restored as
+// well.
+//
+// Not thread safe, call on the thread integrating into the map.
+class ChunkStore {
+ public:
+  // @param file: where later evictions go, nullptr keeps them in memory.
+  void SetFile(ChunkFile* file) { file_ = file; }
+
+  // Writes the current state of a chunk of map to the file as well, so it
+  // survives a restart while it is still in the map.
+  // @return: false without a file or if map has no such chunk.
+  bool Persist(const chisel::Chisel& map, const chisel::ChunkID& id);
+
+  // Compresses the chunk into the store and removes it and its mesh from map.
+  // @return: false if map has no such chunk.
+  bool Evict(chisel::Chisel* map, const chisel::ChunkID& id);
+
+  // Recreates a stored chunk in map and drops the copy kept in memory, the
+  // file keeps its copy. The chunk has no mesh until it is remeshed.
+  // @return: false if the store has no such chunk.
+  bool Restore(chisel::Chisel* map, const chisel::ChunkID& id);
+
+  bool Contains(const chisel::ChunkID& id) const;
+
+  // Drops the stored chunks, including those of the file.
+  void Clear();
+
+  // @return: chunks held in memory.
+  size_t GetChunkCount() const { return chunks_.size(); }
+
+  // @return: bytes of compressed voxels held in memory.
+  size_t GetBytes() const { return bytes_; }
+
+  // Compressed voxels of chunk in the format Restore reads.
+  static void Compress(const chisel::Chunk& chunk, std::vector<uint8_t>* out);
+
+  // @return: false if data does not match the chunk's voxel count.
+  static bool Decompress(const uint8_t* data, size_t size,
+                         chisel::Chunk* chunk);
+
+ private:
+  std::unordered_map<chisel::ChunkID, std::vector<uint8_t>,
+                     chisel::ChunkHasher> chunks_;
+  size_t bytes_ = 0;
+  ChunkFile* file_ = nullptr;
+  // chunk read back from the file
+  std::vector<uint8_t> scratch_;
+};
+
+// Keeps the chunks of map within radius of center and moves the rest into
+// store, so the map and the cost of meshing it stay bounded however far the
+// device walks. Chunks are evicted one chunk beyond radius and restored
+// within it, moving back and forth at the border does not thrash. The cost
+// depends on the radius only, not on how many chunks are stored.
+//
+// @param changed: chunks evicted or restored, their meshes have to be
+//                 dropped or rebuilt together with those of their neighbours.
+void UpdateActiveRegion(const Eigen::Vector3f& center, float radius,
+                        chisel::Chisel* map, ChunkStore* store,
+                        std::vector<chisel::ChunkID>* changed);
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_CHUNK_STORE_H_
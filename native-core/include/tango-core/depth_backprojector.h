@@ -0,0 +1,68 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_CORE_DEPTH_BACKPROJECTOR_H_
+#define TANGO_CORE_DEPTH_BACKPROJECTOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "tango-core/depth_encoding.h"
+
+namespace tango_core {
+
+// Turns an 8 or 16 bit depth map back into a dense point cloud. For a pinhole
+// camera the ray of a pixel is (column ray, row ray, 1) scaled by depth, so
+// the rays of all pixels are kept in one table per axis built from the
+// intrinsics, and a point costs a few multiplies. Rows run vectorized on NEON.
+class DepthBackProjector {
+ public:
+  // Builds the ray tables of a rows x cols depth map.
+  //
+  // @param fx, fy, cx, cy: intrinsics at the resolution of the map.
+  // @param transposed: map rows are camera columns (x), as for SplatDepth.
+  // @param encoding: encoding the map was written with.
+  void Reset(int rows, int cols, float fx, float fy, float cx, float cy,
+             bool transposed, const DepthEncoding& encoding);
+
+  int rows() const { return rows_; }
+  int cols() const { return cols_; }
+
+  // Writes rows * cols points of three floats, in map order, to xyz.
+  // Rows of depth are stride bytes apart.
+  void BackProject(const uint8_t* depth, size_t stride, float* xyz) const;
+  void BackProject(const uint16_t* depth, size_t stride, float* xyz) const;
+
+ private:
+  template <typename T>
+  void BackProjectRows(const T* depth, size_t stride, float* xyz) const;
+
+  int rows_ = 0;
+  int cols_ = 0;
+  bool transposed_ = false;
+  // z = depth_scale_ * value + depth_offset_
+  float depth_scale_ = 0.0f;
+  float depth_offset_ = 0.0f;
+  // camera space x or y per unit z of each map row and column
+  std::vector<float> row_rays_;
+  std::vector<float> column_rays_;
+};
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_DEPTH_BACKPROJECTOR_H_
@@ -0,0 +1,30 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_CORE_DEPTH_ENCODING_H_
+#define TANGO_CORE_DEPTH_ENCODING_H_
+
+namespace tango_core {
+
+// Maps a depth z in meters to the pixel value offset + scale * z.
+struct DepthEncoding {
+  float scale;
+  float offset;
+};
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_DEPTH_ENCODING_H_
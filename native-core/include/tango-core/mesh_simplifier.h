@@ -0,0 +1,49 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_CORE_MESH_SIMPLIFIER_H_
+#define TANGO_CORE_MESH_SIMPLIFIER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+namespace tango_core {
+
+// Decimates an indexed triangle mesh with quadric error metrics (Garland &
+// Heckbert). Edges collapse one vertex onto the other, cheapest first, so the
+// result indexes a subset of the original vertices and can share their
+// buffer. Vertices on boundary or non-manifold edges never move: the open
+// borders of a chunk mesh stay exactly where its neighbours expect them, and
+// a simplified chunk never cracks against a full resolution one. Collapses
+// that would flip a triangle are skipped.
+//
+// @param vertices: vertex_count points of three floats.
+// @param indices: three per triangle.
+// @param target_triangles: stops once no more than this many remain.
+// @param max_error: stops before a collapse moves a vertex farther than this
+//                   from the planes of its original triangles, in metres.
+// @param result: indices of the remaining triangles.
+void SimplifyMesh(const float* vertices, size_t vertex_count,
+                  const uint32_t* indices, size_t index_count,
+                  size_t target_triangles, float max_error,
+                  std::vector<uint32_t>* result);
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_MESH_SIMPLIFIER_H_
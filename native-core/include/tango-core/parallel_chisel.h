@@ -0,0 +1,63 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_CORE_PARALLEL_CHISEL_H_
+#define TANGO_CORE_PARALLEL_CHISEL_H_
+
+#include <functional>
+#include <vector>
+
+#include <Eigen/Core>
+#include <open_chisel/Chisel.h>
+
+namespace tango_core {
+
+// Runs body(i) for every i in [0, count) and returns when all are done.
+typedef std::function<void(int count, const std::function<void(int)>& body)>
+    ParallelFor;
+
+// Runs a ParallelFor on thread_count threads started for this call, for
+// callers without a thread pool.
+void ThreadedParallelFor(int thread_count, int count,
+                         const std::function<void(int)>& body);
+
+// Chisel that runs marching cubes of the dirty chunks in parallel. Chunks
+// mesh independently: each reads its own voxels and the border voxels of its
+// neighbours, and integration already marks the neighbours of a changed chunk
+// dirty, so borders stay consistent. Meshes are stored under a lock as each
+// chunk finishes, and the call returns only after the last one.
+//
+// Integration must not run during UpdateMeshesParallel, both wrappers
+// integrate and mesh on the same thread.
+class ParallelChisel : public chisel::Chisel {
+ public:
+  ParallelChisel(const Eigen::Vector3i& chunk_size, float voxel_resolution,
+                 bool use_color);
+
+  // Same result as UpdateMeshes.
+  void UpdateMeshesParallel(const ParallelFor& parallel_for);
+
+  // Queues the chunk and its neighbours for remeshing, e.g. after it was
+  // added or removed outside of integration.
+  void MarkMeshDirty(const chisel::ChunkID& id);
+
+ private:
+  std::vector<chisel::ChunkID> dirty_chunks_;
+};
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_PARALLEL_CHISEL_H_
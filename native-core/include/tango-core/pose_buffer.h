@@ -0,0 +1,71 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_CORE_POSE_BUFFER_H_
+#define TANGO_CORE_POSE_BUFFER_H_
+
+#include <stddef.h>
+
+#include <mutex>
+#include <vector>
+
+namespace tango_core {
+
+// Ring buffer of the device poses delivered by the pose callback, so looking
+// up the pose of a depth or color frame does not make a blocking service call.
+// Between two buffered poses the position is interpolated linearly and the
+// orientation with slerp. Translations are x, y, z and orientations x, y, z,
+// w quaternions like in TangoPoseData.
+//
+// Insert is called from the callback thread, Lookup from any thread.
+class PoseBuffer {
+ public:
+  // @param capacity: number of poses kept, the pose callback runs at about
+  //                  100 Hz.
+  explicit PoseBuffer(size_t capacity = 256);
+
+  // Poses have to arrive in timestamp order, older ones are dropped.
+  void Insert(double timestamp, const double translation[3],
+              const double orientation[4]);
+
+  // Drops all poses, e.g. when tracking was lost.
+  void Clear();
+
+  // @param timestamp: time of the pose, 0 for the newest pose.
+  // @return: false if no two buffered poses close enough to each other
+  //          enclose timestamp, the caller has to ask the service then.
+  bool Lookup(double timestamp, double translation[3],
+              double orientation[4]) const;
+
+ private:
+  struct Sample {
+    double timestamp;
+    double translation[3];
+    double orientation[4];
+  };
+
+  // i-th oldest sample, mutex_ held
+  const Sample& At(size_t i) const;
+
+  mutable std::mutex mutex_;
+  std::vector<Sample> samples_;
+  size_t oldest_ = 0;
+  size_t count_ = 0;
+};
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_POSE_BUFFER_H_
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_CORE_RENDER_REQUESTER_H_
+#define TANGO_CORE_RENDER_REQUESTER_H_
+
+#include <jni.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace tango_core {
+
+// The JNIEnv of the calling thread. It is looked up once per thread and
+// cached; threads the VM does not know yet are attached until they exit.
+JNIEnv* GetThreadJniEnv(JavaVM* vm);
+
+// Asks the Java activity for an on demand render from any thread. Requests
+// that arrive while one is pending collapse into it, so a color and a depth
+// frame between two vsyncs queue a single render and the callback threads
+// skip the JNI call.
+class RenderRequester {
+ public:
+  RenderRequester();
+
+  // Keeps a global reference to activity and looks up its void method.
+  void Bind(JNIEnv* env, JavaVM* vm, jobject activity, const char* method);
+
+  // Drops the activity, requests do nothing afterwards.
+  void Unbind(JNIEnv* env);
+
+  // @return: false if no activity is bound.
+  bool Request();
+
+  // Call on the GL thread before rendering, requests after it queue the next
+  // render.
+  void OnRender() { pending_.store(false, std::memory_order_release); }
+
+  // Forgets a pending request that will not be served, e.g. because the
+  // surface was recreated.
+  void Reset() { OnRender(); }
+
+ private:
+  std::atomic<bool> pending_;
+  // guards the activity against Unbind during a call
+  std::mutex mutex_;
+  JavaVM* vm_;
+  jobject activity_;
+  jmethodID method_;
+};
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_RENDER_REQUESTER_H_
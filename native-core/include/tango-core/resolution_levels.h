@@ -0,0 +1,95 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_CORE_RESOLUTION_LEVELS_H_
+#define TANGO_CORE_RESOLUTION_LEVELS_H_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include <Eigen/Core>
+#include <open_chisel/Chisel.h>
+
+namespace tango_core {
+
+// Truncation distance of chisel's QuadraticTruncator at a depth,
+// scale * (quadratic * depth^2 + linear * depth + constant). It follows the
+// depth noise of the sensor.
+struct TruncationModel {
+  float quadratic;
+  float linear;
+  float constant;
+  float scale;
+
+  float Truncation(float depth) const;
+
+  // @return: depth at which the truncation reaches truncation, 0 if it is
+  //          larger there already.
+  float DepthForTruncation(float truncation) const;
+};
+
+// Voxel resolutions finest * 2^level of a multi-resolution TSDF, one chisel
+// map each. A depth is integrated at the coarsest resolution not larger than
+// its truncation distance, so the noise band spans one to two voxels at every
+// depth: close surfaces get fine voxels and distant ones, which the sensor
+// sees too noisy for fine voxels anyway, coarse ones.
+//
+// The depth ranges of neighbouring levels overlap by kOverlap of the depth
+// between them, so both maps see the surfaces at the border and the finer one
+// can replace the coarser one there without a gap.
+class ResolutionLevels {
+ public:
+  static const float kOverlap;
+
+  // @param near, far: depth range of all levels.
+  ResolutionLevels(const TruncationModel& model, float finest_resolution,
+                   int count, float near, float far);
+
+  int GetCount() const { return static_cast<int>(boundaries_.size()) - 1; }
+
+  float GetResolution(int level) const;
+
+  // Depth range integrated into level, empty if the sensor range holds no
+  // depth at its resolution.
+  float GetNear(int level) const;
+  float GetFar(int level) const;
+
+  bool IsEmpty(int level) const {
+    return boundaries_[level] >= boundaries_[level + 1];
+  }
+
+  // @return: level a depth is integrated into, ignoring the overlap.
+  int GetLevel(float depth) const;
+
+ private:
+  float finest_resolution_;
+  // count + 1 depths, level i integrates [boundaries_[i], boundaries_[i + 1])
+  std::vector<float> boundaries_;
+};
+
+// Copies the count depths within [near, far) from source into target and
+// writes NaN, chisel's missing depth, for all others.
+void MaskDepthRange(const float* source, size_t count, float near, float far,
+                    float* target);
+
+// @return: true if the voxel of map at position has been observed, i.e. has
+//          a weight.
+bool IsObserved(const chisel::Chisel& map, const Eigen::Vector3f& position);
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_RESOLUTION_LEVELS_H_
@@ -0,0 +1,50 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_CORE_TSDF_RAYCAST_H_
+#define TANGO_CORE_TSDF_RAYCAST_H_
+
+#include <Eigen/Core>
+#include <open_chisel/Chisel.h>
+
+#include "tango-core/parallel_chisel.h"
+
+namespace tango_core {
+
+// Window depth of the TSDF surface through every pixel of a width x height
+// target, without extracting a mesh. Each pixel ray steps through the map at
+// the signed distance of its voxels, skips chunks the map does not hold, and
+// stops at the first crossing from free to occupied space, linearly between
+// the two samples around it. Surfaces seen from behind are ignored.
+//
+// Only reads the map, so it must not run during integration. Rows are cast
+// in parallel.
+//
+// @param view_projection: clip from world matrix of the target view.
+// @param max_distance: longest ray in metres from the near plane.
+// @param depth: width x height window depths in [0, 1], bottom row first as
+//               for glTexImage2D. A hit is only written where it is nearer
+//               than the value already there, so several maps can be cast
+//               into one target cleared to 1.
+void RaycastTsdf(const chisel::Chisel& map,
+                 const Eigen::Matrix4f& view_projection, int width, int height,
+                 float max_distance,
+                 const ParallelFor& parallel_for, float* depth);
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_TSDF_RAYCAST_H_
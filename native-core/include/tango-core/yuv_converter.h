@@ -0,0 +1,47 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_CORE_YUV_CONVERTER_H_
+#define TANGO_CORE_YUV_CONVERTER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace tango_core {
+
+// Converts a NV21 (TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP) camera image to packed
+// 8 bit RGB in a single pass. The image is downsampled by sampling every
+// factor-th pixel of every factor-th row and can be written bottom up, which
+// is the row order glTexImage2D expects.
+//
+// Factors 1 and 2 run vectorized on NEON, other factors fall back to a scalar
+// loop with the same fixed point math, so results are identical.
+//
+// @param nv21: Y plane of width * height bytes followed by the interleaved
+//              VU plane.
+// @param width, height: size of the camera image, has to be even.
+// @param factor: downsampling factor, output is width / factor x
+//                height / factor pixels.
+// @param flip_vertical: write the last output row first.
+// @param rgb: output image.
+// @param rgb_stride: bytes between two output rows, at least 3 * width /
+//                    factor.
+void ConvertNV21ToRGB(const uint8_t* nv21, int width, int height, int factor,
+                      bool flip_vertical, uint8_t* rgb, size_t rgb_stride);
+
+}  // namespace tango_core
+
+#endif  // TANGO_CORE_YUV_CONVERTER_H_
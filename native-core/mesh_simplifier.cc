@@ -0,0 +1,257 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-core/mesh_simplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+#include <unordered_map>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+
+namespace {
+
+// Symmetric 4x4 quadric, sum of squared distances to a set of planes.
+struct Quadric {
+  double a[10];
+
+  Quadric() { std::fill(a, a + 10, 0.0); }
+
+  // plane n . x + d = 0 with unit n
+  void AddPlane(const Eigen::Vector3d& n, double d) {
+    a[0] += n.x() * n.x(); a[1] += n.x() * n.y(); a[2] += n.x() * n.z();
+    a[3] += n.x() * d;     a[4] += n.y() * n.y(); a[5] += n.y() * n.z();
+    a[6] += n.y() * d;     a[7] += n.z() * n.z(); a[8] += n.z() * d;
+    a[9] += d * d;
+  }
+
+  void Add(const Quadric& other) {
+    for (int i = 0; i < 10; ++i) {
+      a[i] += other.a[i];
+    }
+  }
+
+  double Error(const Eigen::Vector3d& p) const {
+    double x = p.x(), y = p.y(), z = p.z();
+    return a[0] * x * x + 2 * a[1] * x * y + 2 * a[2] * x * z +
+           2 * a[3] * x + a[4] * y * y + 2 * a[5] * y * z + 2 * a[6] * y +
+           a[7] * z * z + 2 * a[8] * z + a[9];
+  }
+};
+
+// Collapse of from onto to, stale once either vertex changed since.
+struct Collapse {
+  double cost;
+  uint32_t from;
+  uint32_t to;
+  uint32_t from_version;
+  uint32_t to_version;
+
+  bool operator>(const Collapse& other) const { return cost > other.cost; }
+};
+
+class Simplifier {
+ public:
+  Simplifier(const float* vertices, size_t vertex_count,
+             const uint32_t* indices, size_t index_count)
+      : positions_(vertex_count),
+        quadrics_(vertex_count),
+        faces_of_(vertex_count),
+        locked_(vertex_count, false),
+        version_(vertex_count, 0),
+        triangles_(indices, indices + index_count / 3 * 3),
+        alive_(index_count / 3, true),
+        alive_count_(index_count / 3) {
+    for (size_t i = 0; i < vertex_count; ++i) {
+      positions_[i] = Eigen::Vector3d(vertices[3 * i], vertices[3 * i + 1],
+                                      vertices[3 * i + 2]);
+    }
+    std::unordered_map<uint64_t, int> edge_faces;
+    for (size_t f = 0; f < alive_.size(); ++f) {
+      const uint32_t* t = &triangles_[3 * f];
+      Eigen::Vector3d normal = (positions_[t[1]] - positions_[t[0]])
+                                   .cross(positions_[t[2]] - positions_[t[0]]);
+      double length = normal.norm();
+      for (int k = 0; k < 3; ++k) {
+        faces_of_[t[k]].push_back(f);
+        ++edge_faces[EdgeKey(t[k], t[(k + 1) % 3])];
+      }
+      if (length <= 0.0) {
+        continue;
+      }
+      normal /= length;
+      double d = -normal.dot(positions_[t[0]]);
+      for (int k = 0; k < 3; ++k) {
+        quadrics_[t[k]].AddPlane(normal, d);
+      }
+    }
+    // open and non-manifold edges pin their vertices
+    for (const std::pair<const uint64_t, int>& edge : edge_faces) {
+      if (edge.second != 2) {
+        locked_[edge.first >> 32] = true;
+        locked_[edge.first & 0xFFFFFFFFu] = true;
+      }
+    }
+    for (size_t f = 0; f < alive_.size(); ++f) {
+      for (int k = 0; k < 3; ++k) {
+        Push(triangles_[3 * f + k], triangles_[3 * f + (k + 1) % 3]);
+        Push(triangles_[3 * f + (k + 1) % 3], triangles_[3 * f + k]);
+      }
+    }
+  }
+
+  void Run(size_t target_triangles, double max_error) {
+    while (alive_count_ > target_triangles && !queue_.empty()) {
+      Collapse collapse = queue_.top();
+      queue_.pop();
+      if (collapse.cost > max_error) {
+        break;
+      }
+      if (version_[collapse.from] != collapse.from_version ||
+          version_[collapse.to] != collapse.to_version ||
+          !CanCollapse(collapse.from, collapse.to)) {
+        continue;
+      }
+      Apply(collapse.from, collapse.to);
+    }
+  }
+
+  void GetTriangles(std::vector<uint32_t>* result) const {
+    result->clear();
+    result->reserve(alive_count_ * 3);
+    for (size_t f = 0; f < alive_.size(); ++f) {
+      if (alive_[f]) {
+        result->insert(result->end(), &triangles_[3 * f],
+                       &triangles_[3 * f + 3]);
+      }
+    }
+  }
+
+ private:
+  static uint64_t EdgeKey(uint32_t a, uint32_t b) {
+    return a < b ? (static_cast<uint64_t>(a) << 32) | b
+                 : (static_cast<uint64_t>(b) << 32) | a;
+  }
+
+  void Push(uint32_t from, uint32_t to) {
+    if (locked_[from] || from == to) {
+      return;
+    }
+    Quadric sum = quadrics_[from];
+    sum.Add(quadrics_[to]);
+    Collapse collapse = {std::max(sum.Error(positions_[to]), 0.0), from, to,
+                         version_[from], version_[to]};
+    queue_.push(collapse);
+  }
+
+  // No triangle around from may fold over when from moves onto to.
+  bool CanCollapse(uint32_t from, uint32_t to) const {
+    for (uint32_t f : faces_of_[from]) {
+      if (!alive_[f]) {
+        continue;
+      }
+      const uint32_t* t = &triangles_[3 * f];
+      if (t[0] == to || t[1] == to || t[2] == to) {
+        continue;
+      }
+      Eigen::Vector3d p[3];
+      Eigen::Vector3d q[3];
+      for (int k = 0; k < 3; ++k) {
+        p[k] = positions_[t[k]];
+        q[k] = t[k] == from ? positions_[to] : p[k];
+      }
+      Eigen::Vector3d before = (p[1] - p[0]).cross(p[2] - p[0]);
+      Eigen::Vector3d after = (q[1] - q[0]).cross(q[2] - q[0]);
+      double after_length = after.norm();
+      if (after_length <= 0.0 ||
+          before.dot(after) < 0.2 * before.norm() * after_length) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  void Apply(uint32_t from, uint32_t to) {
+    for (uint32_t f : faces_of_[from]) {
+      if (!alive_[f]) {
+        continue;
+      }
+      uint32_t* t = &triangles_[3 * f];
+      if (t[0] == to || t[1] == to || t[2] == to) {
+        alive_[f] = false;
+        --alive_count_;
+        continue;
+      }
+      for (int k = 0; k < 3; ++k) {
+        if (t[k] == from) {
+          t[k] = to;
+        }
+      }
+      faces_of_[to].push_back(f);
+    }
+    faces_of_[from].clear();
+    quadrics_[to].Add(quadrics_[from]);
+    ++version_[from];
+    ++version_[to];
+    // only the edges around to have a new cost, stale ones skip on version
+    std::vector<uint32_t>& faces = faces_of_[to];
+    faces.erase(std::remove_if(faces.begin(), faces.end(),
+                               [this](uint32_t f) { return !alive_[f]; }),
+                faces.end());
+    std::sort(faces.begin(), faces.end());
+    faces.erase(std::unique(faces.begin(), faces.end()), faces.end());
+    for (uint32_t f : faces) {
+      for (int k = 0; k < 3; ++k) {
+        uint32_t other = triangles_[3 * f + k];
+        if (other != to) {
+          Push(to, other);
+          Push(other, to);
+        }
+      }
+    }
+  }
+
+  std::vector<Eigen::Vector3d> positions_;
+  std::vector<Quadric> quadrics_;
+  std::vector<std::vector<uint32_t> > faces_of_;
+  std::vector<bool> locked_;
+  std::vector<uint32_t> version_;
+  std::vector<uint32_t> triangles_;
+  std::vector<bool> alive_;
+  size_t alive_count_;
+  std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse> >
+      queue_;
+};
+
+}  // namespace
+
+namespace tango_core {
+
+void SimplifyMesh(const float* vertices, size_t vertex_count,
+                  const uint32_t* indices, size_t index_count,
+                  size_t target_triangles, float max_error,
+                  std::vector<uint32_t>* result) {
+  Simplifier simplifier(vertices, vertex_count, indices, index_count);
+  // the quadric error is a squared distance
+  simplifier.Run(target_triangles,
+                 static_cast<double>(max_error) * max_error);
+  simplifier.GetTriangles(result);
+}
+
+}  // namespace tango_core
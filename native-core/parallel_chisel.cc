@@ -0,0 +1,74 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-core/parallel_chisel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tango_core {
+
+void ThreadedParallelFor(int thread_count, int count,
+                         const std::function<void(int)>& body) {
+  thread_count = std::max(1, std::min(thread_count, count));
+  std::atomic<int> next(0);
+  auto run = [&]() {
+    for (int i = next++; i < count; i = next++) {
+      body(i);
+    }
+  };
+  std::vector<std::thread> threads;
+  for (int t = 1; t < thread_count; ++t) {
+    threads.push_back(std::thread(run));
+  }
+  run();
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+}
+
+ParallelChisel::ParallelChisel(const Eigen::Vector3i& chunk_size,
+                               float voxel_resolution, bool use_color)
+    : chisel::Chisel(chunk_size, voxel_resolution, use_color) {}
+
+void ParallelChisel::UpdateMeshesParallel(const ParallelFor& parallel_for) {
+  dirty_chunks_.clear();
+  for (const auto& chunk : meshesToUpdate) {
+    dirty_chunks_.push_back(chunk.first);
+  }
+  // guards the mesh map, marching cubes itself runs unlocked
+  std::mutex mesh_mutex;
+  parallel_for(dirty_chunks_.size(), [this, &mesh_mutex](int i) {
+    chunkManager.RecomputeMesh(dirty_chunks_[i], mesh_mutex);
+  });
+  meshesToUpdate.clear();
+}
+
+void ParallelChisel::MarkMeshDirty(const chisel::ChunkID& id) {
+  // border triangles of the neighbours read this chunk's voxels
+  for (int dx = -1; dx <= 1; ++dx) {
+    for (int dy = -1; dy <= 1; ++dy) {
+      for (int dz = -1; dz <= 1; ++dz) {
+        meshesToUpdate[id + chisel::ChunkID(dx, dy, dz)] = true;
+      }
+    }
+  }
+}
+
+}  // namespace tango_core
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-core/pose_buffer.h"
+
+#include <cmath>
+
+namespace {
+
+// neighbouring poses further apart than this leave a gap, the service knows
+// better what happened in between
+const double kMaxPoseGap = 0.1;
+
+// orientations closer than this are interpolated linearly
+const double kSlerpThreshold = 0.9995;
+
+void Slerp(const double* a, const double* b, double t, double* result) {
+  double dot = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+  // q and -q are the same rotation, take the shorter arc
+  double sign = dot < 0.0 ? -1.0 : 1.0;
+  dot *= sign;
+  double weight_a = 1.0 - t;
+  double weight_b = t;
+  if (dot < kSlerpThreshold) {
+    double theta = std::acos(dot);
+    double inverse_sin = 1.0 / std::sin(theta);
+    weight_a = std::sin((1.0 - t) * theta) * inverse_sin;
+    weight_b = std::sin(t * theta) * inverse_sin;
+  }
+  weight_b *= sign;
+  double norm = 0.0;
+  for (int i = 0; i < 4; ++i) {
+    result[i] = weight_a * a[i] + weight_b * b[i];
+    norm += result[i] * result[i];
+  }
+  norm = 1.0 / std::sqrt(norm);
+  for (int i = 0; i < 4; ++i) {
+    result[i] *= norm;
+  }
+}
+
+}  // namespace
+
+namespace tango_core {
+
+PoseBuffer::PoseBuffer(size_t capacity) : samples_(capacity < 2 ? 2 : capacity) {}
+
+void PoseBuffer::Insert(double timestamp, const double translation[3],
+                        const double orientation[4]) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ > 0 && timestamp <= At(count_ - 1).timestamp) {
+    return;
+  }
+  size_t index;
+  if (count_ < samples_.size()) {
+    index = (oldest_ + count_) % samples_.size();
+    ++count_;
+  } else {
+    index = oldest_;
+    oldest_ = (oldest_ + 1) % samples_.size();
+  }
+  Sample& sample = samples_[index];
+  sample.timestamp = timestamp;
+  for (int i = 0; i < 3; ++i) {
+    sample.translation[i] = translation[i];
+  }
+  for (int i = 0; i < 4; ++i) {
+    sample.orientation[i] = orientation[i];
+  }
+}
+
+void PoseBuffer::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  oldest_ = 0;
+  count_ = 0;
+}
+
+bool PoseBuffer::Lookup(double timestamp, double translation[3],
+                        double orientation[4]) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (count_ == 0) {
+    return false;
+  }
+  if (timestamp <= 0.0) {
+    const Sample& newest = At(count_ - 1);
+    for (int i = 0; i < 3; ++i) {
+      translation[i] = newest.translation[i];
+    }
+    for (int i = 0; i < 4; ++i) {
+      orientation[i] = newest.orientation[i];
+    }
+    return true;
+  }
+  if (timestamp < At(0).timestamp || timestamp > At(count_ - 1).timestamp) {
+    return false;
+  }
+
+  // first sample not older than timestamp
+  size_t low = 0;
+  size_t high = count_ - 1;
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    if (At(middle).timestamp < timestamp) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  const Sample& after = At(low);
+  const Sample& before = At(low > 0 ? low - 1 : 0);
+  double gap = after.timestamp - before.timestamp;
+  if (gap > kMaxPoseGap) {
+    return false;
+  }
+  double t = gap > 0.0 ? (timestamp - before.timestamp) / gap : 0.0;
+  for (int i = 0; i < 3; ++i) {
+    translation[i] = before.translation[i] +
+                     t * (after.translation[i] - before.translation[i]);
+  }
+  Slerp(before.orientation, after.orientation, t, orientation);
+  return true;
+}
+
+const PoseBuffer::Sample& PoseBuffer::At(size_t i) const {
+  return samples_[(oldest_ + i) % samples_.size()];
+}
+
+}  // namespace tango_core
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-core/render_requester.h"
+
+#include <pthread.h>
+
+namespace {
+
+pthread_key_t env_key;
+pthread_once_t env_key_once = PTHREAD_ONCE_INIT;
+
+// gnustl has no thread_local, a POD __thread cache is enough
+__thread JNIEnv* thread_env = nullptr;
+
+// runs on exit of the threads GetThreadJniEnv attached
+void DetachThread(void* vm) {
+  static_cast<JavaVM*>(vm)->DetachCurrentThread();
+}
+
+void CreateEnvKey() { pthread_key_create(&env_key, DetachThread); }
+
+}  // namespace
+
+namespace tango_core {
+
+JNIEnv* GetThreadJniEnv(JavaVM* vm) {
+  if (thread_env != nullptr) {
+    return thread_env;
+  }
+  JNIEnv* env = nullptr;
+  if (vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) ==
+      JNI_EDETACHED) {
+    if (vm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+      return nullptr;
+    }
+    pthread_once(&env_key_once, CreateEnvKey);
+    pthread_setspecific(env_key, vm);
+  }
+  thread_env = env;
+  return env;
+}
+
+RenderRequester::RenderRequester()
+    : pending_(false), vm_(nullptr), activity_(nullptr), method_(nullptr) {}
+
+void RenderRequester::Bind(JNIEnv* env, JavaVM* vm, jobject activity,
+                           const char* method) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  vm_ = vm;
+  activity_ = env->NewGlobalRef(activity);
+  jclass cls = env->GetObjectClass(activity);
+  method_ = env->GetMethodID(cls, method, "()V");
+  env->DeleteLocalRef(cls);
+  pending_.store(false);
+}
+
+void RenderRequester::Unbind(JNIEnv* env) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (activity_ != nullptr) {
+    env->DeleteGlobalRef(activity_);
+  }
+  activity_ = nullptr;
+  method_ = nullptr;
+}
+
+bool RenderRequester::Request() {
+  if (pending_.exchange(true, std::memory_order_acq_rel)) {
+    return true;
+  }
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (activity_ == nullptr || method_ == nullptr) {
+    pending_.store(false);
+    return false;
+  }
+  JNIEnv* env = GetThreadJniEnv(vm_);
+  if (env == nullptr) {
+    pending_.store(false);
+    return false;
+  }
+  env->CallVoidMethod(activity_, method_);
+  return true;
+}
+
+}  // namespace tango_core
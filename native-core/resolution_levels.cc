@@ -0,0 +1,117 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-core/resolution_levels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <open_chisel/Chunk.h>
+#include <open_chisel/ChunkManager.h>
+
+namespace tango_core {
+
+const float ResolutionLevels::kOverlap = 0.1f;
+
+float TruncationModel::Truncation(float depth) const {
+  return scale * (quadratic * depth * depth + linear * depth + constant);
+}
+
+float TruncationModel::DepthForTruncation(float truncation) const {
+  // solve quadratic * z^2 + linear * z + (constant - truncation / scale) = 0
+  float c = constant - truncation / scale;
+  if (c >= 0.0f) {
+    return 0.0f;
+  }
+  if (quadratic == 0.0f) {
+    return linear > 0.0f ? -c / linear : std::numeric_limits<float>::max();
+  }
+  float discriminant = linear * linear - 4.0f * quadratic * c;
+  return (-linear + std::sqrt(discriminant)) / (2.0f * quadratic);
+}
+
+ResolutionLevels::ResolutionLevels(const TruncationModel& model,
+                                   float finest_resolution, int count,
+                                   float near, float far)
+    : finest_resolution_(finest_resolution) {
+  count = std::max(count, 1);
+  boundaries_.push_back(near);
+  for (int level = 1; level < count; ++level) {
+    float depth = model.DepthForTruncation(GetResolution(level));
+    boundaries_.push_back(std::min(std::max(depth, near), far));
+  }
+  boundaries_.push_back(far);
+}
+
+float ResolutionLevels::GetResolution(int level) const {
+  return finest_resolution_ * static_cast<float>(1 << level);
+}
+
+float ResolutionLevels::GetNear(int level) const {
+  if (level == 0 || IsEmpty(level)) {
+    return boundaries_[level];
+  }
+  return std::max(boundaries_[level] * (1.0f - kOverlap), boundaries_.front());
+}
+
+float ResolutionLevels::GetFar(int level) const {
+  if (level == GetCount() - 1 || IsEmpty(level)) {
+    return boundaries_[level + 1];
+  }
+  return std::min(boundaries_[level + 1] * (1.0f + kOverlap),
+                  boundaries_.back());
+}
+
+int ResolutionLevels::GetLevel(float depth) const {
+  int level = 0;
+  while (level + 1 < GetCount() && depth >= boundaries_[level + 1]) {
+    ++level;
+  }
+  return level;
+}
+
+void MaskDepthRange(const float* source, size_t count, float near, float far,
+                    float* target) {
+  const float missing = std::numeric_limits<float>::quiet_NaN();
+  for (size_t i = 0; i < count; ++i) {
+    float depth = source[i];
+    target[i] = depth >= near && depth < far ? depth : missing;
+  }
+}
+
+bool IsObserved(const chisel::Chisel& map, const Eigen::Vector3f& position) {
+  const chisel::ChunkManager& manager = map.GetChunkManager();
+  const Eigen::Vector3i& size = manager.GetChunkSize();
+  float resolution = manager.GetResolution();
+  Eigen::Vector3i voxel =
+      (position / resolution).array().floor().cast<int>().matrix();
+  chisel::ChunkID id(voxel.x() >= 0 ? voxel.x() / size.x()
+                                    : (voxel.x() + 1) / size.x() - 1,
+                     voxel.y() >= 0 ? voxel.y() / size.y()
+                                    : (voxel.y() + 1) / size.y() - 1,
+                     voxel.z() >= 0 ? voxel.z() / size.z()
+                                    : (voxel.z() + 1) / size.z() - 1);
+  if (!manager.HasChunk(id)) {
+    return false;
+  }
+  Eigen::Vector3i local = voxel - id.cwiseProduct(size);
+  // chisel's linear voxel order, x fastest
+  int index = local.x() + size.x() * (local.y() + size.y() * local.z());
+  return manager.GetChunk(id)->GetDistVoxel(index).GetWeight() > 0.0f;
+}
+
+}  // namespace tango_core
@@ -0,0 +1,176 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-core/tsdf_raycast.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <Eigen/LU>
+#include <open_chisel/Chunk.h>
+#include <open_chisel/ChunkManager.h>
+
+namespace {
+
+// Signed distances of one ray, with the chunk of the last sample cached so
+// a ray inside one chunk does a single map lookup.
+class VoxelSampler {
+ public:
+  explicit VoxelSampler(const chisel::ChunkManager& manager)
+      : manager_(manager),
+        size_(manager.GetChunkSize()),
+        resolution_(manager.GetResolution()),
+        chunk_(nullptr),
+        chunk_valid_(false) {}
+
+  float GetChunkEdge() const { return size_.x() * resolution_; }
+
+  // @param sdf: distance of the voxel at position, if it was observed.
+  // @param has_chunk: false if the map holds no chunk there.
+  // @return: true if the voxel was observed.
+  bool Sample(const Eigen::Vector3f& position, float* sdf, bool* has_chunk) {
+    Eigen::Vector3i voxel =
+        (position / resolution_).array().floor().cast<int>().matrix();
+    chisel::ChunkID id(FloorDivide(voxel.x(), size_.x()),
+                       FloorDivide(voxel.y(), size_.y()),
+                       FloorDivide(voxel.z(), size_.z()));
+    if (!chunk_valid_ || id != chunk_id_) {
+      chunk_id_ = id;
+      chunk_valid_ = true;
+      chunk_ = manager_.HasChunk(id) ? manager_.GetChunk(id).get() : nullptr;
+    }
+    *has_chunk = chunk_ != nullptr;
+    if (chunk_ == nullptr) {
+      return false;
+    }
+    Eigen::Vector3i local = voxel - id.cwiseProduct(size_);
+    // chisel's linear voxel order, x fastest
+    int index = local.x() + size_.x() * (local.y() + size_.y() * local.z());
+    const chisel::DistVoxel& distance = chunk_->GetDistVoxel(index);
+    if (distance.GetWeight() <= 0.0f) {
+      return false;
+    }
+    *sdf = distance.GetSDF();
+    return true;
+  }
+
+  // Ray distance to the exit of the chunk around position.
+  float ChunkExit(const Eigen::Vector3f& position,
+                  const Eigen::Vector3f& direction) const {
+    float edge = GetChunkEdge();
+    float exit = INFINITY;
+    for (int i = 0; i < 3; ++i) {
+      float low = std::floor(position[i] / edge) * edge;
+      if (direction[i] > 0.0f) {
+        exit = std::min(exit, (low + edge - position[i]) / direction[i]);
+      } else if (direction[i] < 0.0f) {
+        exit = std::min(exit, (low - position[i]) / direction[i]);
+      }
+    }
+    return exit;
+  }
+
+ private:
+  static int FloorDivide(int value, int divisor) {
+    return value >= 0 ? value / divisor : (value + 1) / divisor - 1;
+  }
+
+  const chisel::ChunkManager& manager_;
+  const Eigen::Vector3i size_;
+  const float resolution_;
+  chisel::ChunkID chunk_id_;
+  const chisel::Chunk* chunk_;
+  bool chunk_valid_;
+};
+
+// Distance along the ray of its first free to occupied crossing, or a
+// negative value.
+float CastRay(VoxelSampler* sampler, const Eigen::Vector3f& origin,
+              const Eigen::Vector3f& direction, float max_distance,
+              float resolution) {
+  // a little into the next chunk, so the sample after a skip lands in it
+  const float skip_margin = 0.5f * resolution;
+  float previous_t = 0.0f;
+  float previous_sdf = 0.0f;
+  bool previous_free = false;
+  float t = 0.0f;
+  while (t <= max_distance) {
+    Eigen::Vector3f position = origin + t * direction;
+    float sdf;
+    bool has_chunk;
+    if (!sampler->Sample(position, &sdf, &has_chunk)) {
+      previous_free = false;
+      t += has_chunk ? resolution
+                     : sampler->ChunkExit(position, direction) + skip_margin;
+      continue;
+    }
+    if (sdf < 0.0f && previous_free) {
+      return previous_t +
+             (t - previous_t) * previous_sdf / (previous_sdf - sdf);
+    }
+    previous_free = sdf >= 0.0f;
+    previous_t = t;
+    previous_sdf = sdf;
+    // the truncated distance never overshoots the surface, still at least
+    // one voxel per step
+    t += std::max(sdf, resolution);
+  }
+  return -1.0f;
+}
+
+}  // namespace
+
+namespace tango_core {
+
+void RaycastTsdf(const chisel::Chisel& map,
+                 const Eigen::Matrix4f& view_projection, int width, int height,
+                 float max_distance,
+                 const ParallelFor& parallel_for, float* depth) {
+  const chisel::ChunkManager& manager = map.GetChunkManager();
+  const float resolution = manager.GetResolution();
+  const Eigen::Matrix4f world_from_clip = view_projection.inverse();
+  parallel_for(height, [&](int row) {
+    VoxelSampler sampler(manager);
+    float y = (row + 0.5f) / height * 2.0f - 1.0f;
+    float* target = depth + static_cast<size_t>(row) * width;
+    for (int column = 0; column < width; ++column) {
+      float x = (column + 0.5f) / width * 2.0f - 1.0f;
+      Eigen::Vector4f near =
+          world_from_clip * Eigen::Vector4f(x, y, -1.0f, 1.0f);
+      Eigen::Vector4f far = world_from_clip * Eigen::Vector4f(x, y, 1.0f, 1.0f);
+      Eigen::Vector3f origin = near.head<3>() / near.w();
+      Eigen::Vector3f direction = far.head<3>() / far.w() - origin;
+      float length = direction.norm();
+      if (length <= 0.0f) {
+        continue;
+      }
+      direction /= length;
+      float t = CastRay(&sampler, origin, direction,
+                        std::min(max_distance, length), resolution);
+      if (t < 0.0f) {
+        continue;
+      }
+      Eigen::Vector3f hit = origin + t * direction;
+      Eigen::Vector4f clip =
+          view_projection * Eigen::Vector4f(hit.x(), hit.y(), hit.z(), 1.0f);
+      float window = 0.5f * clip.z() / clip.w() + 0.5f;
+      target[column] = std::min(target[column], std::max(window, 0.0f));
+    }
+  });
+}
+
+}  // namespace tango_core
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-core/yuv_converter.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#define TANGO_CORE_HAVE_NEON 1
+#endif
+
+namespace {
+
+// Same coefficients the samples used in their Yuv2Rgb helpers, in 6 bit
+// fixed point so the intermediate values fit into int16 lanes.
+const int kShift = 6;
+const int kVToR = 88;   // 1.370705
+const int kVToG = 45;   // 0.698001
+const int kUToG = 22;   // 0.337633
+const int kUToB = 111;  // 1.732446
+
+inline uint8_t Saturate(int value) {
+  return value < 0 ? 0 : (value > 255 ? 255 : static_cast<uint8_t>(value));
+}
+
+inline void ConvertPixel(int y, int u, int v, uint8_t* rgb) {
+  const int round = 1 << (kShift - 1);
+  y <<= kShift;
+  u -= 128;
+  v -= 128;
+  rgb[0] = Saturate((y + kVToR * v + round) >> kShift);
+  rgb[1] = Saturate((y - kVToG * v - kUToG * u + round) >> kShift);
+  rgb[2] = Saturate((y + kUToB * u + round) >> kShift);
+}
+
+// Scalar conversion of output pixels [begin, end) of one row.
+void ConvertRowScalar(const uint8_t* y_row, const uint8_t* vu_row, int factor,
+                      int begin, int end, uint8_t* rgb) {
+  for (int x = begin; x < end; ++x) {
+    int source_x = x * factor;
+    int pair = source_x & ~1;
+    ConvertPixel(y_row[source_x], vu_row[pair + 1], vu_row[pair], rgb + 3 * x);
+  }
+}
+
+#ifdef TANGO_CORE_HAVE_NEON
+// Converts eight pixels into planar R, G and B lanes.
+inline uint8x8x3_t ConvertPixels8(uint8x8_t y, uint8x8_t u, uint8x8_t v) {
+  int16x8_t y16 = vreinterpretq_s16_u16(vshll_n_u8(y, kShift));
+  int16x8_t u16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), vdupq_n_s16(128));
+  int16x8_t v16 = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), vdupq_n_s16(128));
+  uint8x8x3_t out;
+  out.val[0] = vqrshrun_n_s16(vmlaq_n_s16(y16, v16, kVToR), kShift);
+  out.val[1] = vqrshrun_n_s16(vmlsq_n_s16(vmlsq_n_s16(y16, v16, kVToG), u16, kUToG),
+                              kShift);
+  out.val[2] = vqrshrun_n_s16(vmlaq_n_s16(y16, u16, kUToB), kShift);
+  return out;
+}
+
+// Full resolution, 16 pixels per iteration. Neighbouring pixels share one VU
+// pair, so even and odd pixels are converted separately and zipped again.
+int ConvertRowNeonFactor1(const uint8_t* y_row, const uint8_t* vu_row,
+                          int width, uint8_t* rgb) {
+  int x = 0;
+  for (; x + 16 <= width; x += 16) {
+    uint8x8x2_t y = vld2_u8(y_row + x);
+    uint8x8x2_t vu = vld2_u8(vu_row + x);
+    uint8x8x3_t even = ConvertPixels8(y.val[0], vu.val[1], vu.val[0]);
+    uint8x8x3_t odd = ConvertPixels8(y.val[1], vu.val[1], vu.val[0]);
+    uint8x8x2_t r = vzip_u8(even.val[0], odd.val[0]);
+    uint8x8x2_t g = vzip_u8(even.val[1], odd.val[1]);
+    uint8x8x2_t b = vzip_u8(even.val[2], odd.val[2]);
+    uint8x8x3_t low = {{r.val[0], g.val[0], b.val[0]}};
+    uint8x8x3_t high = {{r.val[1], g.val[1], b.val[1]}};
+    vst3_u8(rgb + 3 * x, low);
+    vst3_u8(rgb + 3 * x + 24, high);
+  }
+  return x;
+}
+
+// Half resolution, 8 output pixels per iteration. Every output pixel maps to
+// an even source pixel and owns exactly one VU pair.
+int ConvertRowNeonFactor2(const uint8_t* y_row, const uint8_t* vu_row,
+                          int out_width, uint8_t* rgb) {
+  int x = 0;
+  for (; x + 8 <= out_width; x += 8) {
+    uint8x8x2_t y = vld2_u8(y_row + 2 * x);
+    uint8x8x2_t vu = vld2_u8(vu_row + 2 * x);
+    vst3_u8(rgb + 3 * x, ConvertPixels8(y.val[0], vu.val[1], vu.val[0]));
+  }
+  return x;
+}
+#endif  // TANGO_CORE_HAVE_NEON
+
+}  // namespace
+
+namespace tango_core {
+
+void ConvertNV21ToRGB(const uint8_t* nv21, int width, int height, int factor,
+                      bool flip_vertical, uint8_t* rgb, size_t rgb_stride) {
+  if (factor < 1) {
+    factor = 1;
+  }
+  const int out_width = width / factor;
+  const int out_height = height / factor;
+  const uint8_t* vu_plane = nv21 + width * height;
+
+  for (int row = 0; row < out_height; ++row) {
+    int source_row = row * factor;
+    const uint8_t* y_row = nv21 + source_row * width;
+    const uint8_t* vu_row = vu_plane + (source_row / 2) * width;
+    int out_row = flip_vertical ? out_height - 1 - row : row;
+    uint8_t* rgb_row = rgb + out_row * rgb_stride;
+
+    int done = 0;
+#ifdef TANGO_CORE_HAVE_NEON
+    if (factor == 1) {
+      done = ConvertRowNeonFactor1(y_row, vu_row, out_width, rgb_row);
+    } else if (factor == 2) {
+      done = ConvertRowNeonFactor2(y_row, vu_row, out_width, rgb_row);
+    }
+#endif
+    ConvertRowScalar(y_row, vu_row, factor, done, out_width, rgb_row);
+  }
+}
+
+}  // namespace tango_core
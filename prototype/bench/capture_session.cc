@@ -0,0 +1,65 @@
+//
+// Replays the point clouds of a session recorded with CaptureWriter.
+//
+
+#include "capture_session.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace tango_augmented_reality {
+
+    CaptureSession::CaptureSession() : max_points_(0), frame_(0) {
+        memset(&intrinsics_, 0, sizeof(intrinsics_));
+    }
+
+    bool CaptureSession::Open(const std::string &path) {
+        if (!reader_.Open(path)) {
+            return false;
+        }
+        const CaptureIntrinsics *intrinsics = reader_.FindIntrinsics(TANGO_CAMERA_DEPTH);
+        if (intrinsics == nullptr) {
+            return false;
+        }
+        intrinsics_.camera_id = TANGO_CAMERA_DEPTH;
+        intrinsics_.calibration_type =
+                static_cast<TangoCalibrationType>(intrinsics->calibration_type);
+        intrinsics_.width = intrinsics->width;
+        intrinsics_.height = intrinsics->height;
+        intrinsics_.fx = intrinsics->fx;
+        intrinsics_.fy = intrinsics->fy;
+        intrinsics_.cx = intrinsics->cx;
+        intrinsics_.cy = intrinsics->cy;
+        memcpy(intrinsics_.distortion, intrinsics->distortion, sizeof(intrinsics->distortion));
+
+        point_clouds_.clear();
+        max_points_ = 0;
+        for (uint32_t i = 0; i < reader_.GetChunkCount(); ++i) {
+            CapturePointCloudView view;
+            if (reader_.GetPointCloud(i, &view)) {
+                point_clouds_.push_back(i);
+                max_points_ = std::max(max_points_, static_cast<int>(view.xyz_count));
+            }
+        }
+        frame_ = 0;
+        return true;
+    }
+
+    bool CaptureSession::NextFrame(TangoXYZij *xyz_ij, glm::mat4 *point_cloud_transformation) {
+        CapturePointCloudView view;
+        if (frame_ >= static_cast<int>(point_clouds_.size()) ||
+            !reader_.GetPointCloud(point_clouds_[frame_], &view)) {
+            return false;
+        }
+        ++frame_;
+        // The scene gets a TangoXYZij it modifies in place, so this is the one
+        // copy the device does as well.
+        memcpy(&(*point_cloud_transformation)[0][0], view.point_cloud_transformation,
+               16 * sizeof(float));
+        memcpy(xyz_ij->xyz, view.xyz, view.xyz_count * 3 * sizeof(float));
+        xyz_ij->xyz_count = view.xyz_count;
+        xyz_ij->timestamp = view.timestamp;
+        return true;
+    }
+
+}  // namespace tango_augmented_reality
@@ -0,0 +1,44 @@
+//
+// Replays the point clouds of a session recorded with CaptureWriter.
+//
+
+#ifndef PROTOTYPE_BENCH_CAPTURE_SESSION_H_
+#define PROTOTYPE_BENCH_CAPTURE_SESSION_H_
+
+#include <string>
+#include <vector>
+
+#include "frame_source.h"
+#include "tango-augmented-reality/capture_reader.h"
+
+namespace tango_augmented_reality {
+
+    class CaptureSession : public FrameSource {
+    public:
+        CaptureSession();
+
+        // @return: false if the file is not a closed capture with depth intrinsics.
+        bool Open(const std::string &path);
+
+        TangoCameraIntrinsics GetDepthIntrinsics() const { return intrinsics_; }
+
+        int GetFrameCount() const { return point_clouds_.size(); }
+
+        int GetMaxPoints() const { return max_points_; }
+
+        bool NextFrame(TangoXYZij *xyz_ij, glm::mat4 *point_cloud_transformation);
+
+        void Rewind() { frame_ = 0; }
+
+    private:
+        CaptureReader reader_;
+        TangoCameraIntrinsics intrinsics_;
+        // Chunk indices of all point clouds in recording order.
+        std::vector <uint32_t> point_clouds_;
+        int max_points_;
+        int frame_;
+    };
+
+}  // namespace tango_augmented_reality
+
+#endif  // PROTOTYPE_BENCH_CAPTURE_SESSION_H_
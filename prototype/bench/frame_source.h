@@ -0,0 +1,38 @@
+//
+// Source of depth frames replayed by the bench.
+//
+
+#ifndef PROTOTYPE_BENCH_FRAME_SOURCE_H_
+#define PROTOTYPE_BENCH_FRAME_SOURCE_H_
+
+#include <glm/glm.hpp>
+#include <tango_client_api.h>
+
+namespace tango_augmented_reality {
+
+    class FrameSource {
+    public:
+        virtual ~FrameSource() { }
+
+        // Intrinsics of the depth camera the frames were captured with.
+        virtual TangoCameraIntrinsics GetDepthIntrinsics() const = 0;
+
+        // Number of frames in the session.
+        virtual int GetFrameCount() const = 0;
+
+        // Fills xyz_ij with the next frame and point_cloud_transformation with
+        // the matrix Scene::SetPointCloudTransformation receives for it. xyz_ij
+        // has to be created with enough capacity for GetMaxPoints().
+        // @return: false at the end of the session.
+        virtual bool NextFrame(TangoXYZij *xyz_ij, glm::mat4 *point_cloud_transformation) = 0;
+
+        // Largest point count of a single frame.
+        virtual int GetMaxPoints() const = 0;
+
+        // Restarts the session at the first frame.
+        virtual void Rewind() = 0;
+    };
+
+}  // namespace tango_augmented_reality
+
+#endif  // PROTOTYPE_BENCH_FRAME_SOURCE_H_
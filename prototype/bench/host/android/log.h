@@ -0,0 +1,34 @@
+//
+// Host replacement for the NDK logging header used by the replay bench.
+//
+
+#ifndef PROTOTYPE_BENCH_ANDROID_LOG_H_
+#define PROTOTYPE_BENCH_ANDROID_LOG_H_
+
+typedef enum android_LogPriority {
+    ANDROID_LOG_UNKNOWN = 0,
+    ANDROID_LOG_DEFAULT,
+    ANDROID_LOG_VERBOSE,
+    ANDROID_LOG_DEBUG,
+    ANDROID_LOG_INFO,
+    ANDROID_LOG_WARN,
+    ANDROID_LOG_ERROR,
+    ANDROID_LOG_FATAL,
+    ANDROID_LOG_SILENT,
+} android_LogPriority;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int __android_log_print(int prio, const char *tag, const char *fmt, ...);
+
+// Messages below this priority are dropped, defaults to ANDROID_LOG_SILENT so
+// the per-frame logging of the reconstruction code does not skew timings.
+void __android_log_set_host_priority(int prio);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // PROTOTYPE_BENCH_ANDROID_LOG_H_
@@ -0,0 +1,29 @@
+//
+// Host implementation of __android_log_print writing to stderr.
+//
+
+#include <android/log.h>
+
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+    int min_priority = ANDROID_LOG_SILENT;
+}  // namespace
+
+extern "C" int __android_log_print(int prio, const char *tag, const char *fmt, ...) {
+    if (prio < min_priority) {
+        return 0;
+    }
+    va_list args;
+    va_start(args, fmt);
+    fprintf(stderr, "%s: ", tag);
+    int written = vfprintf(stderr, fmt, args);
+    fputc('\n', stderr);
+    va_end(args);
+    return written;
+}
+
+extern "C" void __android_log_set_host_priority(int prio) {
+    min_priority = prio;
+}
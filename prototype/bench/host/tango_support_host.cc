@@ -0,0 +1,139 @@
+//
+// Host implementation of the TangoSupport calls used by the prototype.
+//
+// Only the behaviour the reconstruction code relies on is reproduced: point
+// clouds are plain copies and the depth upsampling projects every point with
+// the interpolator intrinsics and fills the neighbouring pixels with the
+// closest sample.
+//
+
+#include <tango_support_api.h>
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+struct TangoSupportDepthInterpolator {
+    TangoCameraIntrinsics intrinsics;
+};
+
+namespace {
+    // Radius in pixels filled around every projected point.
+    const int kUpsampleRadius = 2;
+}  // namespace
+
+TangoErrorType TangoSupport_createXYZij(uint32_t max_points, TangoXYZij *xyz_ij) {
+    if (xyz_ij == nullptr) {
+        return TANGO_INVALID;
+    }
+    memset(xyz_ij, 0, sizeof(TangoXYZij));
+    xyz_ij->xyz = static_cast<float (*)[3]>(calloc(max_points, 3 * sizeof(float)));
+    return xyz_ij->xyz != nullptr ? TANGO_SUCCESS : TANGO_ERROR;
+}
+
+TangoErrorType TangoSupport_freeXYZij(TangoXYZij *xyz_ij) {
+    if (xyz_ij == nullptr) {
+        return TANGO_INVALID;
+    }
+    free(xyz_ij->xyz);
+    xyz_ij->xyz = nullptr;
+    xyz_ij->xyz_count = 0;
+    return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoSupport_copyXYZij(const TangoXYZij *input, TangoXYZij *output) {
+    if (input == nullptr || output == nullptr || output->xyz == nullptr) {
+        return TANGO_INVALID;
+    }
+    output->timestamp = input->timestamp;
+    output->xyz_count = input->xyz_count;
+    memcpy(output->xyz, input->xyz, input->xyz_count * 3 * sizeof(float));
+    return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoSupport_createDepthInterpolator(TangoCameraIntrinsics *intrinsics,
+                                                    TangoSupportDepthInterpolator **interpolator) {
+    if (intrinsics == nullptr || interpolator == nullptr) {
+        return TANGO_INVALID;
+    }
+    *interpolator = new TangoSupportDepthInterpolator();
+    (*interpolator)->intrinsics = *intrinsics;
+    return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoSupport_freeDepthInterpolator(TangoSupportDepthInterpolator *interpolator) {
+    delete interpolator;
+    return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoSupport_initializeDepthBuffer(uint32_t width, uint32_t height,
+                                                  TangoSupportDepthBuffer *depth_buffer) {
+    if (depth_buffer == nullptr) {
+        return TANGO_INVALID;
+    }
+    depth_buffer->width = width;
+    depth_buffer->height = height;
+    depth_buffer->depths = static_cast<float *>(calloc(width * height, sizeof(float)));
+    return depth_buffer->depths != nullptr ? TANGO_SUCCESS : TANGO_ERROR;
+}
+
+TangoErrorType TangoSupport_freeDepthBuffer(TangoSupportDepthBuffer *depth_buffer) {
+    if (depth_buffer == nullptr) {
+        return TANGO_INVALID;
+    }
+    free(depth_buffer->depths);
+    depth_buffer->depths = nullptr;
+    return TANGO_SUCCESS;
+}
+
+TangoErrorType TangoSupport_upsampleImageNearestNeighbor(
+        TangoSupportDepthInterpolator *interpolator, const TangoXYZij *xyz_ij,
+        const TangoPoseData *color_camera_T_depth_camera, TangoSupportDepthBuffer *depth_buffer) {
+    if (interpolator == nullptr || xyz_ij == nullptr || depth_buffer == nullptr ||
+        depth_buffer->depths == nullptr) {
+        return TANGO_INVALID;
+    }
+    // The prototype passes a zero pose, depth and color camera are treated as
+    // the same frame just like it expects.
+    (void) color_camera_T_depth_camera;
+
+    const TangoCameraIntrinsics &intrinsics = interpolator->intrinsics;
+    const int width = depth_buffer->width;
+    const int height = depth_buffer->height;
+    std::vector<int> distance(width * height, std::numeric_limits<int>::max());
+    memset(depth_buffer->depths, 0, width * height * sizeof(float));
+
+    for (uint32_t i = 0; i < xyz_ij->xyz_count; ++i) {
+        const float *point = xyz_ij->xyz[i];
+        if (point[2] <= 0.0f) {
+            continue;
+        }
+        float u = static_cast<float>(intrinsics.fx) * point[0] / point[2] +
+                  static_cast<float>(intrinsics.cx);
+        float v = static_cast<float>(intrinsics.fy) * point[1] / point[2] +
+                  static_cast<float>(intrinsics.cy);
+        int px = static_cast<int>(std::floor(u));
+        int py = static_cast<int>(std::floor(v));
+        for (int dy = -kUpsampleRadius; dy <= kUpsampleRadius; ++dy) {
+            int y = py + dy;
+            if (y < 0 || y >= height) {
+                continue;
+            }
+            for (int dx = -kUpsampleRadius; dx <= kUpsampleRadius; ++dx) {
+                int x = px + dx;
+                if (x < 0 || x >= width) {
+                    continue;
+                }
+                int d = dx * dx + dy * dy;
+                int index = y * width + x;
+                if (d < distance[index]) {
+                    distance[index] = d;
+                    depth_buffer->depths[index] = point[2];
+                }
+            }
+        }
+    }
+    return TANGO_SUCCESS;
+}
@@ -0,0 +1,249 @@
+//
+// Replays depth sessions into the three reconstruction modes of
+// Scene::Tap() and reports per-frame latency, peak memory and triangle counts.
+//
+//   replay_bench [--mode pointcloud|tsdf|plane|all] [--session FILE]
+//                [--frames N] [--step N] [--tap-interval SECONDS] [--verbose]
+//
+// Without --session a synthetic room of --frames frames is replayed, --step
+// sets its depth image sampling.
+//
+// Every mode runs in its own process so the reported peak resident set size
+// belongs to that mode alone.
+//
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <android/log.h>
+#include <glm/glm.hpp>
+#include <tango_support_api.h>
+
+#include "capture_session.h"
+#include "frame_source.h"
+#include "synthetic_session.h"
+#include "tango-augmented-reality/chisel_mesh.h"
+#include "tango-augmented-reality/plane_mesh.h"
+#include "tango-augmented-reality/point_cloud_frame_pool.h"
+#include "tango-augmented-reality/profiler.h"
+
+namespace {
+    using tango_augmented_reality::CaptureSession;
+    using tango_augmented_reality::ChiselMesh;
+    using tango_augmented_reality::FrameSource;
+    using tango_augmented_reality::PlaneMesh;
+    using tango_augmented_reality::PointCloudFrame;
+    using tango_augmented_reality::PointCloudFramePool;
+    using tango_augmented_reality::SyntheticSession;
+
+    const char *kModeNames[] = {"pointcloud", "tsdf", "plane"};
+
+    struct Options {
+        int mode = -1;
+        std::string session;
+        int frames = 300;
+        int step = 2;
+        double tap_interval = 0.0;
+        bool verbose = false;
+    };
+
+    struct ModeResult {
+        std::vector<double> latencies_ms;
+        int taps = 0;
+        size_t triangles = 0;
+    };
+
+    // Same work Scene::OnXYZijAvailable and the start of Scene::Render do for
+    // every incoming frame.
+    PointCloudFrame *IngestPointCloud(const TangoXYZij *XYZ_ij,
+                                      const glm::mat4 &transformation,
+                                      PointCloudFramePool *pool) {
+        PointCloudFrame *frame = pool->BeginWrite();
+        pool->SetPointCount(frame, XYZ_ij->xyz_count);
+        float *points = frame->vertices.data();
+        for (int i = 0; i < XYZ_ij->xyz_count; ++i) {
+            points[i * 3] = XYZ_ij->xyz[i][0] * .9f;
+            points[i * 3 + 1] = XYZ_ij->xyz[i][1] * 1.2f;
+            points[i * 3 + 2] = XYZ_ij->xyz[i][2];
+        }
+        frame->XYZij.timestamp = XYZ_ij->timestamp;
+        frame->transformation = transformation;
+        pool->Publish();
+        pool->Acquire();
+        return pool->Current();
+    }
+
+    ModeResult RunMode(int mode, FrameSource *source, const Options &options) {
+        ModeResult result;
+        TangoCameraIntrinsics intrinsics = source->GetDepthIntrinsics();
+
+        std::unique_ptr<ChiselMesh> chisel_mesh;
+        std::unique_ptr<PlaneMesh> plane_mesh;
+        if (mode == tango_augmented_reality::TSDF) {
+            chisel_mesh.reset(new ChiselMesh());
+            chisel_mesh->init(intrinsics);
+        } else if (mode == tango_augmented_reality::PLANE) {
+            plane_mesh.reset(new PlaneMesh());
+        }
+
+        TangoXYZij incoming;
+        TangoSupport_createXYZij(source->GetMaxPoints(), &incoming);
+        PointCloudFramePool pool(source->GetMaxPoints());
+        glm::mat4 point_cloud_transformation;
+        double last_tap_timestamp = -1e9;
+
+        source->Rewind();
+        while (source->NextFrame(&incoming, &point_cloud_transformation)) {
+            auto start = std::chrono::steady_clock::now();
+            PointCloudFrame *frame = IngestPointCloud(&incoming, point_cloud_transformation, &pool);
+            if (mode != tango_augmented_reality::POINTCLOUD &&
+                frame->XYZij.timestamp - last_tap_timestamp >= options.tap_interval) {
+                glm::mat4 transformation = glm::transpose(frame->transformation);
+                last_tap_timestamp = frame->XYZij.timestamp;
+                if (chisel_mesh) {
+                    chisel_mesh->addPoints(transformation, intrinsics, &frame->XYZij);
+                    chisel_mesh->updateVertices();
+                } else {
+                    plane_mesh->addPoints(transformation, frame->vertices);
+                    plane_mesh->updateVertices();
+                }
+                ++result.taps;
+            }
+            auto end = std::chrono::steady_clock::now();
+            result.latencies_ms.push_back(
+                    std::chrono::duration<double, std::milli>(end - start).count());
+        }
+
+        if (chisel_mesh) {
+            result.triangles = chisel_mesh->getTriangleCount();
+        } else if (plane_mesh) {
+            result.triangles = plane_mesh->getTriangleCount();
+        }
+        TangoSupport_freeXYZij(&incoming);
+        return result;
+    }
+
+    double Percentile(const std::vector<double> &sorted, double percentile) {
+        if (sorted.empty()) {
+            return 0.0;
+        }
+        size_t index = static_cast<size_t>(percentile * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(index, sorted.size() - 1)];
+    }
+
+    void PrintResult(int mode, ModeResult &result) {
+        std::vector<double> &latencies = result.latencies_ms;
+        std::sort(latencies.begin(), latencies.end());
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        printf("%-10s %7zu %5d %9.2f %9.2f %9.2f %9.2f %10.1f %10zu\n", kModeNames[mode],
+               latencies.size(), result.taps, Percentile(latencies, 0.5),
+               Percentile(latencies, 0.9), Percentile(latencies, 0.99),
+               latencies.empty() ? 0.0 : latencies.back(), usage.ru_maxrss / 1024.0,
+               result.triangles);
+        fflush(stdout);
+    }
+
+    int RunModeInChild(int mode, const Options &options) {
+        fflush(stdout);
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return 1;
+        }
+        if (pid == 0) {
+            std::unique_ptr<FrameSource> source;
+            if (options.session.empty()) {
+                source.reset(new SyntheticSession(options.frames, options.step));
+            } else {
+                CaptureSession *capture = new CaptureSession();
+                source.reset(capture);
+                if (!capture->Open(options.session)) {
+                    fprintf(stderr, "could not load session %s\n", options.session.c_str());
+                    _exit(1);
+                }
+            }
+            ModeResult result = RunMode(mode, source.get(), options);
+            PrintResult(mode, result);
+            if (options.verbose) {
+                fputs(tango_augmented_reality::GetProfileReport().c_str(), stderr);
+            }
+            _exit(0);
+        }
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "%s mode failed\n", kModeNames[mode]);
+            return 1;
+        }
+        return 0;
+    }
+
+    void PrintUsage(const char *name) {
+        fprintf(stderr, "usage: %s [--mode pointcloud|tsdf|plane|all] [--session FILE]\n"
+                "          [--frames N] [--step N] [--tap-interval SECONDS] [--verbose]\n", name);
+    }
+
+    bool ParseOptions(int argc, char **argv, Options *options) {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool has_value = i + 1 < argc;
+            if (arg == "--mode" && has_value) {
+                std::string mode = argv[++i];
+                options->mode = -1;
+                for (int m = 0; m < 3; ++m) {
+                    if (mode == kModeNames[m]) {
+                        options->mode = m;
+                    }
+                }
+                if (options->mode < 0 && mode != "all") {
+                    return false;
+                }
+            } else if (arg == "--session" && has_value) {
+                options->session = argv[++i];
+            } else if (arg == "--frames" && has_value) {
+                options->frames = atoi(argv[++i]);
+            } else if (arg == "--step" && has_value) {
+                options->step = atoi(argv[++i]);
+            } else if (arg == "--tap-interval" && has_value) {
+                options->tap_interval = atof(argv[++i]);
+            } else if (arg == "--verbose") {
+                options->verbose = true;
+            } else {
+                return false;
+            }
+        }
+        return options->frames > 0;
+    }
+}  // namespace
+
+int main(int argc, char **argv) {
+    Options options;
+    if (!ParseOptions(argc, argv, &options)) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    if (options.verbose) {
+        __android_log_set_host_priority(ANDROID_LOG_VERBOSE);
+    }
+
+    printf("%-10s %7s %5s %9s %9s %9s %9s %10s %10s\n", "mode", "frames", "taps", "p50 ms",
+           "p90 ms", "p99 ms", "max ms", "peak MB", "triangles");
+    int failures = 0;
+    for (int mode = 0; mode < 3; ++mode) {
+        if (options.mode < 0 || options.mode == mode) {
+            failures += RunModeInChild(mode, options);
+        }
+    }
+    return failures == 0 ? 0 : 1;
+}
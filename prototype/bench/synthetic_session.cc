@@ -0,0 +1,136 @@
+//
+// Deterministic depth session of a furnished box room.
+//
+
+#include "synthetic_session.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+    // Depth frames arrive with 5Hz on the device.
+    const double kFrameInterval = 0.2;
+    const float kMinDepth = 0.3f;
+    const float kMaxDepth = 4.0f;
+
+    // Room and a table standing in it, in OpenGL world coordinates (y up).
+    const glm::vec3 kRoomMin(-3.0f, -1.3f, -3.0f);
+    const glm::vec3 kRoomMax(3.0f, 1.3f, 3.0f);
+    const glm::vec3 kTableMin(0.4f, -1.3f, -2.2f);
+    const glm::vec3 kTableMax(1.6f, -0.55f, -1.4f);
+
+    bool IntersectBox(const glm::vec3 &origin, const glm::vec3 &direction,
+                      const glm::vec3 &box_min, const glm::vec3 &box_max,
+                      float *t_enter, float *t_exit) {
+        float enter = -1e30f;
+        float exit = 1e30f;
+        for (int axis = 0; axis < 3; ++axis) {
+            if (std::fabs(direction[axis]) < 1e-9f) {
+                if (origin[axis] < box_min[axis] || origin[axis] > box_max[axis]) {
+                    return false;
+                }
+                continue;
+            }
+            float t0 = (box_min[axis] - origin[axis]) / direction[axis];
+            float t1 = (box_max[axis] - origin[axis]) / direction[axis];
+            enter = std::max(enter, std::min(t0, t1));
+            exit = std::min(exit, std::max(t0, t1));
+        }
+        *t_enter = enter;
+        *t_exit = exit;
+        return enter <= exit;
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    SyntheticSession::SyntheticSession(int frame_count, int pixel_step)
+            : frame_count_(frame_count), pixel_step_(std::max(1, pixel_step)), frame_(0) {
+        // Depth camera intrinsics reported by the Tango development kit.
+        memset(&intrinsics_, 0, sizeof(intrinsics_));
+        intrinsics_.camera_id = TANGO_CAMERA_DEPTH;
+        intrinsics_.width = 320;
+        intrinsics_.height = 180;
+        intrinsics_.fx = 256.7;
+        intrinsics_.fy = 256.7;
+        intrinsics_.cx = 160.0;
+        intrinsics_.cy = 90.0;
+    }
+
+    int SyntheticSession::GetMaxPoints() const {
+        int columns = (intrinsics_.width + pixel_step_ - 1) / pixel_step_;
+        int rows = (intrinsics_.height + pixel_step_ - 1) / pixel_step_;
+        return columns * rows;
+    }
+
+    void SyntheticSession::Rewind() {
+        frame_ = 0;
+        random_.seed(std::mt19937::default_seed);
+    }
+
+    float SyntheticSession::CastRay(const glm::vec3 &origin, const glm::vec3 &direction) const {
+        float enter, exit;
+        float depth = 0.0f;
+        if (IntersectBox(origin, direction, kRoomMin, kRoomMax, &enter, &exit)) {
+            depth = exit;
+        }
+        if (IntersectBox(origin, direction, kTableMin, kTableMax, &enter, &exit) && enter > 0.0f) {
+            depth = std::min(depth, enter);
+        }
+        if (depth < kMinDepth || depth > kMaxDepth) {
+            return 0.0f;
+        }
+        return depth;
+    }
+
+    bool SyntheticSession::NextFrame(TangoXYZij *xyz_ij, glm::mat4 *point_cloud_transformation) {
+        if (frame_ >= frame_count_) {
+            return false;
+        }
+
+        // Slow pan across the room while walking a small ellipse.
+        float t = static_cast<float>(frame_ * kFrameInterval);
+        float yaw = 0.35f * t;
+        glm::vec3 position(0.6f * std::sin(0.2f * t), 0.05f * std::sin(0.9f * t),
+                           0.4f * std::cos(0.2f * t));
+
+        // Depth camera frame (x right, y down, z forward) into OpenGL world, the
+        // same convention GetExtrinsicsAppliedOpenGLWorldDepthCameraFrame uses.
+        float c = std::cos(yaw);
+        float s = std::sin(yaw);
+        glm::mat4 world_T_depth(1.0f);
+        world_T_depth[0] = glm::vec4(c, 0.0f, -s, 0.0f);
+        world_T_depth[1] = glm::vec4(0.0f, -1.0f, 0.0f, 0.0f);
+        world_T_depth[2] = glm::vec4(-s, 0.0f, -c, 0.0f);
+        world_T_depth[3] = glm::vec4(position, 1.0f);
+        *point_cloud_transformation = world_T_depth;
+
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+        uint32_t count = 0;
+        for (int v = 0; v < static_cast<int>(intrinsics_.height); v += pixel_step_) {
+            for (int u = 0; u < static_cast<int>(intrinsics_.width); u += pixel_step_) {
+                // Ray with unit z in the depth frame, the hit distance along it
+                // is directly the depth value.
+                glm::vec3 ray((u - intrinsics_.cx) / intrinsics_.fx,
+                              (v - intrinsics_.cy) / intrinsics_.fy, 1.0f);
+                glm::vec3 direction = glm::vec3(world_T_depth * glm::vec4(ray, 0.0f));
+                float depth = CastRay(position, direction);
+                if (depth == 0.0f) {
+                    continue;
+                }
+                // Tango depth noise grows quadratically with the distance.
+                depth += noise(random_) * 0.0025f * depth * depth;
+                xyz_ij->xyz[count][0] = ray.x * depth;
+                xyz_ij->xyz[count][1] = ray.y * depth;
+                xyz_ij->xyz[count][2] = depth;
+                ++count;
+            }
+        }
+        xyz_ij->xyz_count = count;
+        xyz_ij->timestamp = frame_ * kFrameInterval;
+        ++frame_;
+        return true;
+    }
+
+}  // namespace tango_augmented_reality
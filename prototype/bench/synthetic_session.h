@@ -0,0 +1,46 @@
+//
+// Deterministic depth session of a furnished box room, used when no recording
+// is passed to the bench.
+//
+
+#ifndef PROTOTYPE_BENCH_SYNTHETIC_SESSION_H_
+#define PROTOTYPE_BENCH_SYNTHETIC_SESSION_H_
+
+#include <random>
+
+#include "frame_source.h"
+
+namespace tango_augmented_reality {
+
+    class SyntheticSession : public FrameSource {
+    public:
+        // @param: frame_count, number of frames in the session.
+        // @param: pixel_step, sampling step on the depth image, 2 gives about
+        //         the 14k points per frame a Tango device delivers.
+        SyntheticSession(int frame_count, int pixel_step);
+
+        TangoCameraIntrinsics GetDepthIntrinsics() const { return intrinsics_; }
+
+        int GetFrameCount() const { return frame_count_; }
+
+        int GetMaxPoints() const;
+
+        bool NextFrame(TangoXYZij *xyz_ij, glm::mat4 *point_cloud_transformation);
+
+        void Rewind();
+
+    private:
+        // Depth along the camera z axis of the first surface hit by the ray,
+        // 0 if nothing is hit within the depth camera range.
+        float CastRay(const glm::vec3 &origin, const glm::vec3 &direction) const;
+
+        TangoCameraIntrinsics intrinsics_;
+        int frame_count_;
+        int pixel_step_;
+        int frame_;
+        std::mt19937 random_;
+    };
+
+}  // namespace tango_augmented_reality
+
+#endif  // PROTOTYPE_BENCH_SYNTHETIC_SESSION_H_
@@ -39,6 +39,8 @@ import android.widget.Toast;
 
 import com.erz.joysticklibrary.JoyStick;
 
+import java.io.File;
+
 // The main activity of the application which shows debug information and a
 // glSurfaceView that renders graphic content.
 public class MainActivity extends Activity implements
@@ -48,6 +50,8 @@ public class MainActivity extends Activity implements
     public static final int DIAMETER_FACTOR = 3;
     // calculation factor for sigma slider
     public static final double SIGMA_FACTOR = 50.0;
+    // point cloud frames fused for the occlusion, see PointCloudDrawable::kMaxFusedFrames
+    private static final int FUSED_POINTCLOUD_FRAMES = 4;
     // This code indicates success.
     private static final int TANGO_SUCCESS = 0;
     // The minimum Tango Core version required from this application.
@@ -112,6 +116,8 @@ public class MainActivity extends Activity implements
         findViewById(R.id.top_down_button).setOnClickListener(this);
         findViewById(R.id.show_occlusion).setOnClickListener(this);
         findViewById(R.id.depth_fullscreen).setOnClickListener(this);
+        findViewById(R.id.tsdf_raycast).setOnClickListener(this);
+        findViewById(R.id.fuse_pointclouds).setOnClickListener(this);
 
         // init the joystick and listener
         JoyStick joyStick = (JoyStick) findViewById(R.id.joystick);
@@ -151,8 +157,9 @@ public class MainActivity extends Activity implements
         // OpenGL view where all of the graphics are drawn
         mGLView = (GLSurfaceView) findViewById(R.id.gl_surface_view);
 
-        // Configure OpenGL renderer
-        mGLView.setEGLContextClientVersion(2);
+        // Configure OpenGL renderer, the native side uses GLES 3 shaders, vertex
+        // arrays, fences, PBOs and timer queries
+        mGLView.setEGLContextClientVersion(3);
 
         // Set up button click listeners
         mMotionReset.setOnClickListener(this);
@@ -177,6 +184,13 @@ public class MainActivity extends Activity implements
         // between the application and Tango Service.
         // The activity object is used for checking if the API version is outdated.
         TangoJNINative.initialize(this);
+
+        File chunkStore = new File(getFilesDir(), "tsdf");
+        if (chunkStore.isDirectory() || chunkStore.mkdirs()) {
+            TangoJNINative.openChunkStore(chunkStore.getAbsolutePath());
+        } else {
+            Log.w(TAG, "Could not create chunk store " + chunkStore);
+        }
     }
 
     @Override
@@ -252,6 +266,12 @@ public class MainActivity extends Activity implements
             case R.id.show_occlusion:
                 TangoJNINative.setShowOcclusion(((CheckBox) v).isChecked());
                 break;
+            case R.id.tsdf_raycast:
+                TangoJNINative.setTsdfRaycast(((CheckBox) v).isChecked());
+                break;
+            case R.id.fuse_pointclouds:
+                TangoJNINative.setFusedFrames(((CheckBox) v).isChecked() ? FUSED_POINTCLOUD_FRAMES : 1);
+                break;
             case R.id.place_object:
                 tapGestureDetector.setAddObject();
                 changeAddObjectLabel();
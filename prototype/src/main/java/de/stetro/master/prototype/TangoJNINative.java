@@ -85,15 +85,39 @@ public class TangoJNINative {
     // change the the depth map to fullscreen
     public static native void setDepthFullscreen(boolean checked);
 
+    // raycast the TSDF for the occlusion depth instead of meshing it
+    public static native void setTsdfRaycast(boolean checked);
+
+    // number of point cloud frames fused for the occlusion, 1 disables fusion
+    public static native void setFusedFrames(int count);
+
     // raypicking for the object placement
     public static native void addObject(float x, float y);
 
     // clear the current reconstruction
     public static native void clearReconstruction();
 
+    // keep the reconstruction in the given directory across sessions
+    public static native void openChunkStore(String directory);
+
     // changing filter properties
     public static native void setFilterSettings(int diameter, double sigma);
 
     // set joy stick movement
     public static native void joyStick(double angle, double power);
+
+    // start recording depth, pose and color frames into the given file
+    public static native int startRecording(String path);
+
+    // stop the recording and finish the session file
+    public static native void stopRecording();
+
+    // rolling p50/p90/p99 of the render and reconstruction stages, one line per stage
+    public static native String getProfileReport();
+
+    // native memory the reconstruction may hold before it drops old data, 0 for no limit
+    public static native void setMemoryBudget(int megabytes);
+
+    // bytes held by the point buffers, octree, chisel chunks and GPU buffers
+    public static native String getMemoryReport();
 }
@@ -24,6 +24,7 @@ OPENCV:=/home/stetro/Source/opencv/platforms/build_android_arm/
 BOOST_ANDROID_INCLUDE := $(LOCAL_PATH)/../../../../native-libraries/boost
 EIGEN_INCLUDE := $(LOCAL_PATH)/../../../../native-libraries/eigen
 CHISEL := $(LOCAL_PATH)/../../../../native-libraries/open_chisel
+NATIVE_CORE := $(LOCAL_PATH)/../../../../native-core
 
 
 include $(CLEAR_VARS)
@@ -36,6 +37,7 @@ include $(OPENCV)/OpenCV.mk
 LOCAL_MODULE    := libaugmented_reality_jni_example
 LOCAL_SHARED_LIBRARIES += tango_client_api
 LOCAL_SHARED_LIBRARIES += tango_support_api
+LOCAL_STATIC_LIBRARIES += tango_core tango_core_reconstruction
 
 
 LOCAL_SRC_FILES += $(TANGO_GL)/axis.cc \
@@ -76,13 +78,30 @@ LOCAL_SRC_FILES += $(TANGO_GL)/axis.cc \
                    pose_data.cc \
                    scene.cc \
                    chisel_mesh.cc \
+                   chunk_mesh_cache.cc \
                    plane_mesh.cc \
+                   indexed_mesh.cc \
                    reconstruction_octree.cc \
                    reconstructor.cc \
+                   plane_ransac.cc \
+                   thread_pool.cc \
                    convex_hull.cc \
+                   plane_occupancy_grid.cc \
+                   plane_sample_grid.cc \
+                   plane_registry.cc \
                    point_cloud_drawable.cc \
+                   point_cloud_frame_pool.cc \
                    yuv_drawable.cc \
                    depth_drawable.cc \
+                   guided_depth_filter.cc \
+                   occlusion_resolve.cc \
+                   async_depth_filter.cc \
+                   profiler.cc \
+                   memory_budget.cc \
+                   update_scheduler.cc \
+                   ray_cast.cc \
+                   view_frustum.cc \
+                   capture_writer.cc \
                    tango_event_data.cc
 
 LOCAL_C_INCLUDES += $(TANGO_GL)/include \
@@ -102,3 +121,5 @@ include $(BUILD_SHARED_LIBRARY)
 $(call import-add-path, $(NATIVE_LIBS))
 $(call import-module,tango_client_api)
 $(call import-module,tango_support_api)
+$(call import-add-path, $(NATIVE_CORE)/..)
+$(call import-module,native-core)
@@ -0,0 +1,207 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cstring>
+
+#include <opencv2/ximgproc.hpp>
+
+#include "tango-augmented-reality/async_depth_filter.h"
+#include "tango-augmented-reality/profiler.h"
+
+namespace tango_augmented_reality {
+
+    AsyncDepthFilter::AsyncDepthFilter() {
+        for (int i = 0; i < kRingSize; ++i) {
+            pixel_buffers_[i] = 0;
+            fences_[i] = 0;
+        }
+    }
+
+    AsyncDepthFilter::~AsyncDepthFilter() {
+        stopWorker();
+    }
+
+    void AsyncDepthFilter::Initialize(int width, int height, GLenum gl_type, int cv_type) {
+        DeleteGlResources();
+        width_ = width;
+        height_ = height;
+        gl_type_ = gl_type;
+
+        cv::Mat depth(height_, width_, cv_type);
+        glGenBuffers(kRingSize, pixel_buffers_);
+        for (int i = 0; i < kRingSize; ++i) {
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[i]);
+            glBufferData(GL_PIXEL_PACK_BUFFER, depth.total() * depth.elemSize(), NULL,
+                         GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        write_slot_ = 0;
+
+        pending_depth_ = depth.clone();
+        result_ = depth.clone();
+        upload_ = depth.clone();
+        job_pending_ = false;
+        result_ready_ = false;
+        tango_gl::util::CheckGlError("AsyncDepthFilter::Initialize()");
+        startWorker();
+    }
+
+    void AsyncDepthFilter::Readback(GLuint depth_frame_buffer, const cv::Mat &guide, int radius,
+                                    double eps) {
+        if (!pixel_buffers_[0]) {
+            return;
+        }
+        // reads complete in order, only the newest finished one is filtered
+        int newest = -1;
+        for (int k = 0; k < kRingSize; ++k) {
+            int slot = (write_slot_ + k) % kRingSize;
+            if (fences_[slot] &&
+                glClientWaitSync(fences_[slot], 0, 0) != GL_TIMEOUT_EXPIRED) {
+                if (newest >= 0) {
+                    release(newest);
+                }
+                newest = slot;
+            }
+        }
+        if (newest >= 0) {
+            {
+                std::lock_guard <std::mutex> lock(mutex_);
+                radius_ = radius;
+                eps_ = eps;
+            }
+            consume(newest);
+            release(newest);
+        }
+
+        // the slot is still in flight only if the GPU is more than a ring behind
+        release(write_slot_);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, depth_frame_buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[write_slot_]);
+        glReadPixels(0, 0, width_, height_, GL_DEPTH_COMPONENT, gl_type_, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        fences_[write_slot_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        guide.copyTo(guides_[write_slot_]);
+        write_slot_ = (write_slot_ + 1) % kRingSize;
+        tango_gl::util::CheckGlError("AsyncDepthFilter::Readback()");
+    }
+
+    void AsyncDepthFilter::consume(int slot) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pixel_buffers_[slot]);
+        size_t size = pending_depth_.total() * pending_depth_.elemSize();
+        void *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, size, GL_MAP_READ_BIT);
+        if (pixels != nullptr) {
+            {
+                std::lock_guard <std::mutex> lock(mutex_);
+                memcpy(pending_depth_.ptr(), pixels, size);
+                std::swap(pending_guide_, guides_[slot]);
+                job_pending_ = true;
+            }
+            condition_.notify_one();
+        } else {
+            LOGE("AsyncDepthFilter: could not map depth pixel buffer");
+        }
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }
+
+    void AsyncDepthFilter::release(int slot) {
+        if (fences_[slot]) {
+            glDeleteSync(fences_[slot]);
+            fences_[slot] = 0;
+        }
+    }
+
+    bool AsyncDepthFilter::Upload(GLuint depth_texture) {
+        {
+            std::lock_guard <std::mutex> lock(mutex_);
+            if (!result_ready_) {
+                return false;
+            }
+            std::swap(result_, upload_);
+            result_ready_ = false;
+        }
+        glBindTexture(GL_TEXTURE_2D, depth_texture);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, upload_.cols, upload_.rows, GL_DEPTH_COMPONENT,
+                        gl_type_, upload_.ptr());
+        glBindTexture(GL_TEXTURE_2D, 0);
+        return true;
+    }
+
+    void AsyncDepthFilter::startWorker() {
+        stop_worker_ = false;
+        worker_ = std::thread(&AsyncDepthFilter::workerLoop, this);
+    }
+
+    void AsyncDepthFilter::stopWorker() {
+        if (!worker_.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard <std::mutex> lock(mutex_);
+            stop_worker_ = true;
+        }
+        condition_.notify_one();
+        worker_.join();
+    }
+
+    void AsyncDepthFilter::workerLoop() {
+        cv::Mat depth = pending_depth_.clone();
+        cv::Mat guide;
+        cv::Mat filtered = pending_depth_.clone();
+        while (true) {
+            int radius;
+            double eps;
+            {
+                std::unique_lock <std::mutex> lock(mutex_);
+                condition_.wait(lock, [this] {
+                    return stop_worker_ || job_pending_;
+                });
+                if (stop_worker_) {
+                    return;
+                }
+                std::swap(depth, pending_depth_);
+                std::swap(guide, pending_guide_);
+                radius = radius_;
+                eps = eps_;
+                job_pending_ = false;
+            }
+
+            {
+                ScopedTimer timer(PROFILE_FILTER);
+                cv::ximgproc::guidedFilter(guide, depth, filtered, radius, eps);
+            }
+
+            std::lock_guard <std::mutex> lock(mutex_);
+            std::swap(filtered, result_);
+            result_ready_ = true;
+        }
+    }
+
+    void AsyncDepthFilter::DeleteGlResources() {
+        stopWorker();
+        for (int i = 0; i < kRingSize; ++i) {
+            release(i);
+        }
+        if (pixel_buffers_[0]) {
+            glDeleteBuffers(kRingSize, pixel_buffers_);
+            for (int i = 0; i < kRingSize; ++i) {
+                pixel_buffers_[i] = 0;
+            }
+        }
+    }
+}  // namespace tango_augmented_reality
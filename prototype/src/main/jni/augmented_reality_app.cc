@@ -38,6 +38,18 @@ namespace {
         app->onXYZijAvailable(XYZ_ij);
     }
 
+    // This function routes onPoseAvailable callbacks to the application object for
+    // handling
+    //
+    // @param context, context will be a pointer to a AugmentedRealityApp instance
+    //        on which to call callbacks
+    // @param pose, start of service with respect to device pose
+    void onPoseAvailableRouter(void *context, const TangoPoseData *pose) {
+        using namespace tango_augmented_reality;
+        AugmentedRealityApp *app = static_cast<AugmentedRealityApp *>(context);
+        app->onPoseAvailable(pose);
+    }
+
     // This function routes onFrameAvailable callbacks to the application object for
     // handling
     //
@@ -50,6 +62,18 @@ namespace {
         app->onFrameAvailable(buffer);
     }
 
+    // This function routes texture callbacks to the application object for
+    // handling.
+    //
+    // @param context, context will be a pointer to a AugmentedRealityApp
+    //        instance on which to call callbacks.
+    // @param id, id of the updated camera.
+    void onTextureAvailableRouter(void *context, TangoCameraId id) {
+        using namespace tango_augmented_reality;
+        AugmentedRealityApp *app = static_cast<AugmentedRealityApp *>(context);
+        app->onTextureAvailable(id);
+    }
+
     // This function routes onTangoEvent callbacks to the application object for
     // handling.
     //
@@ -67,28 +91,47 @@ namespace {
 namespace tango_augmented_reality {
 
     void AugmentedRealityApp::onFrameAvailable(const TangoImageBuffer *buffer) {
-        skip_value++;
-        if (skip_value % SKIP_INTERVAL == 0) {
-            skip_value = 0;
-            if (init) {
-                time(&timev);
-                init = false;
-            }
-            time_t now;
-            time(&now);
-            if (timev + INIT_DELAY_SECONDS > now) {
-                return;
-            }
-            main_scene_.OnFrameAvailable(buffer);
+        // converts frames until the first one is shown and a depth frame
+        // arrived, then as often as the motion and the render cost ask for
+        if (!main_scene_.ShouldProcessColorFrame()) {
+            return;
+        }
+        capture_writer_.WriteYuvFrame(buffer);
+        main_scene_.OnFrameAvailable(buffer);
+        if (!main_scene_.IsCameraTextureMode()) {
+            RequestRender();
+        }
+    }
+
+    void AugmentedRealityApp::onTextureAvailable(TangoCameraId id) {
+        if (id == TANGO_CAMERA_COLOR) {
             RequestRender();
         }
     }
 
     void AugmentedRealityApp::onXYZijAvailable(const TangoXYZij *XYZ_ij) {
-        main_scene_.OnXYZijAvailable(XYZ_ij);
-        glm::mat4 transformation = GetPoseMatrixAtTimestamp(XYZ_ij->timestamp);
+        glm::mat4 transformation;
+        if (!GetPoseMatrixAtTimestamp(XYZ_ij->timestamp, &transformation)) {
+            // a frame without pose would be integrated at the origin
+            return;
+        }
         transformation = pose_data_.GetExtrinsicsAppliedOpenGLWorldDepthCameraFrame(transformation);
-        main_scene_.SetPointCloudTransformation(transformation);
+        capture_writer_.WritePointCloud(XYZ_ij, transformation);
+        main_scene_.OnXYZijAvailable(XYZ_ij, transformation);
+    }
+
+    void AugmentedRealityApp::onPoseAvailable(const TangoPoseData *pose) {
+        {
+            std::lock_guard <std::mutex> lock(pose_mutex_);
+            pose_data_.UpdatePose(pose);
+        }
+        capture_writer_.WritePose(*pose);
+        if (pose->status_code == TANGO_POSE_VALID) {
+            pose_buffer_.Insert(pose->timestamp, pose->translation, pose->orientation);
+        } else {
+            // poses from before a reset do not connect to the ones after it
+            pose_buffer_.Clear();
+        }
     }
 
     void AugmentedRealityApp::onTangoEventAvailable(const TangoEvent *event) {
@@ -96,8 +139,7 @@ namespace tango_augmented_reality {
         tango_event_data_.UpdateTangoEvent(event);
     }
 
-    AugmentedRealityApp::AugmentedRealityApp() : calling_activity_obj_(nullptr),
-                                                 on_demand_render_(nullptr) {
+    AugmentedRealityApp::AugmentedRealityApp() : java_vm_(nullptr) {
     }
 
     AugmentedRealityApp::~AugmentedRealityApp() {
@@ -113,21 +155,13 @@ namespace tango_augmented_reality {
         // We want to be able to trigger rendering on demand in our Java code.
         // As such, we need to store the activity we'd like to interact with and the
         // id of the method we'd like to call on that activity.
-        jclass cls = env->GetObjectClass(caller_activity);
-        on_demand_render_ = env->GetMethodID(cls, "requestRender", "()V");
-
-        calling_activity_obj_ = reinterpret_cast<jobject>(env->NewGlobalRef(caller_activity));
+        render_requester_.Bind(env, java_vm_, caller_activity, "requestRender");
 
         return ret;
     }
 
     void AugmentedRealityApp::ActivityDestroyed() {
-        JNIEnv *env;
-        java_vm_->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6);
-        env->DeleteGlobalRef(calling_activity_obj_);
-
-        calling_activity_obj_ = nullptr;
-        on_demand_render_ = nullptr;
+        render_requester_.Unbind(tango_core::GetThreadJniEnv(java_vm_));
     }
 
     int AugmentedRealityApp::TangoSetupConfig() {
@@ -208,6 +242,17 @@ namespace tango_augmented_reality {
             return ret;
         }
 
+        // Attach onPoseAvailable callback, it fills the pose buffer frames look
+        // their poses up in.
+        TangoCoordinateFramePair frame_pair;
+        frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
+        frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
+        ret = TangoService_connectOnPoseAvailable(1, &frame_pair, onPoseAvailableRouter);
+        if (ret != TANGO_SUCCESS) {
+            LOGE("Failed to connect to pose callback with error code: %d", ret);
+            return ret;
+        }
+
         return ret;
     }
 
@@ -234,6 +279,7 @@ namespace tango_augmented_reality {
         // resets all configuration, and disconnects all callbacks. If an application
         // resumes after disconnecting, it must re-register configuration and
         // callbacks with the service.
+        StopRecording();
         TangoConfig_free(tango_config_);
         tango_config_ = nullptr;
         TangoService_disconnect();
@@ -241,11 +287,26 @@ namespace tango_augmented_reality {
 
     void AugmentedRealityApp::TangoResetMotionTracking() {
         main_scene_.ResetTrajectory();
+        pose_buffer_.Clear();
         TangoService_resetMotionTracking();
     }
 
     void AugmentedRealityApp::InitializeGLContent() {
+        // a render queued for the old surface never ran
+        render_requester_.Reset();
+        main_scene_.SetCameraTextureMode(USE_CAMERA_TEXTURE);
         main_scene_.InitGLContent();
+
+        if (main_scene_.IsCameraTextureMode()) {
+            // Connect color camera texture. TangoService_connectTextureId expects a
+            // valid texture id, so the GL content has to be allocated first.
+            TangoErrorType ret = TangoService_connectTextureId(
+                    TANGO_CAMERA_COLOR, main_scene_.GetCameraTextureId(), this,
+                    onTextureAvailableRouter);
+            if (ret != TANGO_SUCCESS) {
+                LOGE("Failed to connect the texture id with error code: %d", ret);
+            }
+        }
     }
 
     void AugmentedRealityApp::SetViewPort(int width, int height) {
@@ -299,10 +360,29 @@ namespace tango_augmented_reality {
     }
 
     void AugmentedRealityApp::Render() {
-        double video_overlay_timestamp;
-        glm::mat4 color_camera_pose = GetPoseMatrixAtTimestamp(video_overlay_timestamp);
-        color_camera_pose = pose_data_.GetExtrinsicsAppliedOpenGLWorldFrame(color_camera_pose);
-        main_scene_.Render(color_camera_pose);
+        // frames arriving from here on need another render
+        render_requester_.OnRender();
+        // the color frame shown this render, the CPU copy is latched also in
+        // camera texture mode where it guides the filter
+        double video_overlay_timestamp = main_scene_.LatchColorFrame();
+        if (main_scene_.IsCameraTextureMode()) {
+            TangoErrorType ret = TangoService_updateTexture(TANGO_CAMERA_COLOR,
+                                                            &video_overlay_timestamp);
+            if (ret != TANGO_SUCCESS) {
+                LOGE("Failed to update the camera texture with error code: %d", ret);
+                video_overlay_timestamp = color_frame_timestamp_;
+            }
+        }
+
+        // the overlay is drawn with the pose of its own frame, renders of the
+        // same frame reuse it, and a frame without pose keeps the last one
+        glm::mat4 pose;
+        if (video_overlay_timestamp != color_frame_timestamp_ &&
+            GetPoseMatrixAtTimestamp(video_overlay_timestamp, &pose)) {
+            color_camera_pose_ = pose_data_.GetExtrinsicsAppliedOpenGLWorldFrame(pose);
+            color_frame_timestamp_ = video_overlay_timestamp;
+        }
+        main_scene_.Render(color_camera_pose_);
     }
 
     void AugmentedRealityApp::DeleteResources() { main_scene_.DeleteResources(); }
@@ -318,8 +398,15 @@ namespace tango_augmented_reality {
         main_scene_.OnTouchEvent(touch_count, event, x0, y0, x1, y1);
     }
 
-    glm::mat4 AugmentedRealityApp::GetPoseMatrixAtTimestamp(double timstamp) {
+    bool AugmentedRealityApp::GetPoseMatrixAtTimestamp(double timstamp, glm::mat4 *pose) {
         TangoPoseData pose_start_service_T_device;
+        if (pose_buffer_.Lookup(timstamp, pose_start_service_T_device.translation,
+                                pose_start_service_T_device.orientation)) {
+            *pose = pose_data_.GetMatrixFromPose(pose_start_service_T_device);
+            return true;
+        }
+
+        // not buffered yet or across a gap, ask the service
         TangoCoordinateFramePair frame_pair;
         frame_pair.base = TANGO_COORDINATE_FRAME_START_OF_SERVICE;
         frame_pair.target = TANGO_COORDINATE_FRAME_DEVICE;
@@ -330,15 +417,12 @@ namespace tango_augmented_reality {
                  timstamp);
         }
 
-        {
-            std::lock_guard <std::mutex> lock(pose_mutex_);
-            pose_data_.UpdatePose(&pose_start_service_T_device);
-        }
-
-        if (pose_start_service_T_device.status_code != TANGO_POSE_VALID) {
-            return glm::mat4(1.0f);
+        if (status != TANGO_SUCCESS ||
+            pose_start_service_T_device.status_code != TANGO_POSE_VALID) {
+            return false;
         }
-        return pose_data_.GetMatrixFromPose(pose_start_service_T_device);
+        *pose = pose_data_.GetMatrixFromPose(pose_start_service_T_device);
+        return true;
     }
 
     TangoErrorType AugmentedRealityApp::UpdateExtrinsics() {
@@ -384,15 +468,11 @@ namespace tango_augmented_reality {
     }
 
     void AugmentedRealityApp::RequestRender() {
-        if (calling_activity_obj_ == nullptr || on_demand_render_ == nullptr) {
+        // Here, we notify the Java activity that we'd like it to trigger a render,
+        // unless it still has one queued.
+        if (!render_requester_.Request()) {
             LOGE("Can not reference Activity to request render");
-            return;
         }
-
-        // Here, we notify the Java activity that we'd like it to trigger a render.
-        JNIEnv *env;
-        java_vm_->GetEnv(reinterpret_cast<void **>(&env), JNI_VERSION_1_6);
-        env->CallVoidMethod(calling_activity_obj_, on_demand_render_);
     }
 
     void AugmentedRealityApp::ToggleFilter() {
@@ -404,7 +484,6 @@ namespace tango_augmented_reality {
     }
 
     void AugmentedRealityApp::setMode(int id) {
-        init = true;
         main_scene_.SetMode(id);
     }
 
@@ -416,6 +495,14 @@ namespace tango_augmented_reality {
         main_scene_.SetDepthFullscreen(show);
     }
 
+    void AugmentedRealityApp::setTsdfRaycast(bool enabled) {
+        main_scene_.SetTsdfRaycast(enabled);
+    }
+
+    void AugmentedRealityApp::setFusedFrames(int count) {
+        main_scene_.SetFusedFrames(count);
+    }
+
     void AugmentedRealityApp::addObject(float x, float y) {
         x *= image_width;
         y *= image_height;
@@ -437,6 +524,10 @@ namespace tango_augmented_reality {
         main_scene_.ClearReconstruction();
     }
 
+    void AugmentedRealityApp::openChunkStore(const std::string &directory) {
+        main_scene_.OpenChunkStore(directory);
+    }
+
     void AugmentedRealityApp::setFilterSettings(int diameter, double sigma) {
         main_scene_.SetFilterSettings(diameter, sigma);
     }
@@ -445,4 +536,19 @@ namespace tango_augmented_reality {
         main_scene_.joyStick(angle, power);
     }
 
+    int AugmentedRealityApp::StartRecording(const std::string &path) {
+        if (!capture_writer_.Open(path)) {
+            return TANGO_ERROR;
+        }
+        capture_writer_.WriteIntrinsics(color_camera_intrinsics_);
+        capture_writer_.WriteIntrinsics(depth_camera_intrinsics_);
+        capture_writer_.WriteExtrinsics(pose_data_.GetImuTDevice(), pose_data_.GetImuTColorCamera(),
+                                        pose_data_.GetImuTDepthCamera());
+        return TANGO_SUCCESS;
+    }
+
+    void AugmentedRealityApp::StopRecording() {
+        capture_writer_.Close();
+    }
+
 }  // namespace tango_augmented_reality
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <tango-gl/util.h>
+
+#include "tango-augmented-reality/capture_reader.h"
+
+namespace tango_augmented_reality {
+
+    CaptureReader::CaptureReader() : data_(nullptr), size_(0), index_(nullptr),
+                                     index_count_(0) { }
+
+    CaptureReader::~CaptureReader() {
+        Close();
+    }
+
+    bool CaptureReader::Open(const std::string &path) {
+        Close();
+        int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            LOGE("Could not open capture file %s", path.c_str());
+            return false;
+        }
+        struct stat file_stat;
+        if (fstat(fd, &file_stat) != 0 ||
+            file_stat.st_size < (off_t) (sizeof(CaptureFileHeader) + sizeof(CaptureFileFooter))) {
+            LOGE("Capture file %s is too small", path.c_str());
+            close(fd);
+            return false;
+        }
+        size_t size = file_stat.st_size;
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) {
+            LOGE("Could not map capture file %s", path.c_str());
+            return false;
+        }
+        data_ = static_cast<const uint8_t *>(data);
+        size_ = size;
+
+        const CaptureFileHeader *header = reinterpret_cast<const CaptureFileHeader *>(data_);
+        const CaptureFileFooter *footer =
+                reinterpret_cast<const CaptureFileFooter *>(data_ + size_ - sizeof(CaptureFileFooter));
+        if (header->magic != kCaptureMagic || header->version != kCaptureVersion) {
+            LOGE("%s is not a capture of version %d", path.c_str(), kCaptureVersion);
+            Close();
+            return false;
+        }
+        if (footer->magic != kCaptureFooterMagic ||
+            footer->index_offset + (uint64_t) footer->index_count * sizeof(CaptureIndexEntry) >
+            size_ - sizeof(CaptureFileFooter)) {
+            LOGE("Capture file %s has no valid index, recording was not closed", path.c_str());
+            Close();
+            return false;
+        }
+        index_ = reinterpret_cast<const CaptureIndexEntry *>(data_ + footer->index_offset);
+        index_count_ = footer->index_count;
+
+        // Depth frames are read front to back, let the kernel prefetch.
+        madvise(const_cast<uint8_t *>(data_), size_, MADV_SEQUENTIAL);
+        return true;
+    }
+
+    void CaptureReader::Close() {
+        if (data_ != nullptr) {
+            munmap(const_cast<uint8_t *>(data_), size_);
+        }
+        data_ = nullptr;
+        size_ = 0;
+        index_ = nullptr;
+        index_count_ = 0;
+    }
+
+    const uint8_t *CaptureReader::GetPayload(uint32_t i, CaptureChunkType type,
+                                             size_t min_size) const {
+        if (i >= index_count_) {
+            return nullptr;
+        }
+        const CaptureIndexEntry &entry = index_[i];
+        if (entry.type != type || entry.payload_size < min_size ||
+            entry.offset + sizeof(CaptureChunkHeader) + entry.payload_size > size_) {
+            return nullptr;
+        }
+        return data_ + entry.offset + sizeof(CaptureChunkHeader);
+    }
+
+    const CaptureIntrinsics *CaptureReader::GetIntrinsics(uint32_t i) const {
+        return reinterpret_cast<const CaptureIntrinsics *>(
+                GetPayload(i, CAPTURE_CHUNK_INTRINSICS, sizeof(CaptureIntrinsics)));
+    }
+
+    const CaptureExtrinsics *CaptureReader::GetExtrinsics(uint32_t i) const {
+        return reinterpret_cast<const CaptureExtrinsics *>(
+                GetPayload(i, CAPTURE_CHUNK_EXTRINSICS, sizeof(CaptureExtrinsics)));
+    }
+
+    const CapturePose *CaptureReader::GetPose(uint32_t i) const {
+        return reinterpret_cast<const CapturePose *>(
+                GetPayload(i, CAPTURE_CHUNK_POSE, sizeof(CapturePose)));
+    }
+
+    bool CaptureReader::GetPointCloud(uint32_t i, CapturePointCloudView *view) const {
+        const uint8_t *payload = GetPayload(i, CAPTURE_CHUNK_POINT_CLOUD,
+                                            sizeof(CapturePointCloud));
+        if (payload == nullptr) {
+            return false;
+        }
+        const CapturePointCloud *point_cloud = reinterpret_cast<const CapturePointCloud *>(payload);
+        if (sizeof(CapturePointCloud) + point_cloud->xyz_count * 3 * sizeof(float) >
+            index_[i].payload_size) {
+            return false;
+        }
+        view->timestamp = index_[i].timestamp;
+        view->point_cloud_transformation = point_cloud->point_cloud_transformation;
+        view->xyz_count = point_cloud->xyz_count;
+        view->xyz = reinterpret_cast<const float (*)[3]>(payload + sizeof(CapturePointCloud));
+        return true;
+    }
+
+    bool CaptureReader::GetYuvFrame(uint32_t i, CaptureYuvFrameView *view) const {
+        const uint8_t *payload = GetPayload(i, CAPTURE_CHUNK_YUV_FRAME, sizeof(CaptureYuvFrame));
+        if (payload == nullptr) {
+            return false;
+        }
+        const CaptureYuvFrame *frame = reinterpret_cast<const CaptureYuvFrame *>(payload);
+        if (sizeof(CaptureYuvFrame) + (size_t) frame->width * frame->height * 3 / 2 >
+            index_[i].payload_size) {
+            return false;
+        }
+        view->timestamp = index_[i].timestamp;
+        view->width = frame->width;
+        view->height = frame->height;
+        view->data = payload + sizeof(CaptureYuvFrame);
+        return true;
+    }
+
+    const CaptureIntrinsics *CaptureReader::FindIntrinsics(uint32_t camera_id) const {
+        for (uint32_t i = 0; i < index_count_; ++i) {
+            const CaptureIntrinsics *intrinsics = GetIntrinsics(i);
+            if (intrinsics != nullptr && intrinsics->camera_id == camera_id) {
+                return intrinsics;
+            }
+        }
+        return nullptr;
+    }
+
+}  // namespace tango_augmented_reality
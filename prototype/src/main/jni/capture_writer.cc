@@ -0,0 +1,255 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstring>
+
+#include <glm/ext.hpp>
+#include <tango-gl/util.h>
+
+#include "tango-augmented-reality/capture_writer.h"
+
+namespace {
+    // Upper bound of memory held by chunks waiting for the disk.
+    const size_t kMaxQueuedBytes = 64 * 1024 * 1024;
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    CaptureWriter::CaptureWriter() : file_(nullptr), queued_bytes_(0), stop_(false),
+                                     is_open_(false), dropped_chunks_(0), offset_(0) { }
+
+    CaptureWriter::~CaptureWriter() {
+        Close();
+    }
+
+    bool CaptureWriter::Open(const std::string &path) {
+        Close();
+        file_ = fopen(path.c_str(), "wb");
+        if (file_ == nullptr) {
+            LOGE("Could not create capture file %s", path.c_str());
+            return false;
+        }
+        CaptureFileHeader header;
+        header.magic = kCaptureMagic;
+        header.version = kCaptureVersion;
+        if (fwrite(&header, sizeof(header), 1, file_) != 1) {
+            LOGE("Could not write capture header to %s", path.c_str());
+            fclose(file_);
+            file_ = nullptr;
+            return false;
+        }
+        offset_ = CaptureAlign(sizeof(header));
+        fseek(file_, offset_, SEEK_SET);
+        index_.clear();
+        queue_.clear();
+        queued_bytes_ = 0;
+        stop_ = false;
+        dropped_chunks_ = 0;
+        thread_ = std::thread(&CaptureWriter::WriterThread, this);
+        is_open_ = true;
+        LOGI("Recording session to %s", path.c_str());
+        return true;
+    }
+
+    void CaptureWriter::Close() {
+        if (!is_open_) {
+            return;
+        }
+        is_open_ = false;
+        {
+            std::lock_guard <std::mutex> lock(queue_mutex_);
+            stop_ = true;
+        }
+        queue_condition_.notify_one();
+        thread_.join();
+
+        CaptureFileFooter footer;
+        footer.index_offset = offset_;
+        footer.index_count = index_.size();
+        footer.magic = kCaptureFooterMagic;
+        fwrite(index_.data(), sizeof(CaptureIndexEntry), index_.size(), file_);
+        fwrite(&footer, sizeof(footer), 1, file_);
+        fclose(file_);
+        file_ = nullptr;
+        LOGI("Recorded %d chunks, dropped %d", (int) index_.size(), (int) dropped_chunks_);
+    }
+
+    std::vector <uint8_t> CaptureWriter::CreateChunk(CaptureChunkType type, double timestamp,
+                                                    size_t payload_size) {
+        std::vector <uint8_t> chunk(CaptureAlign(sizeof(CaptureChunkHeader) + payload_size));
+        CaptureChunkHeader *header = reinterpret_cast<CaptureChunkHeader *>(chunk.data());
+        header->type = type;
+        header->payload_size = payload_size;
+        header->timestamp = timestamp;
+        return chunk;
+    }
+
+    void CaptureWriter::Enqueue(std::vector <uint8_t> &&chunk) {
+        {
+            std::lock_guard <std::mutex> lock(queue_mutex_);
+            if (queued_bytes_ + chunk.size() > kMaxQueuedBytes) {
+                ++dropped_chunks_;
+                return;
+            }
+            queued_bytes_ += chunk.size();
+            queue_.push_back(std::move(chunk));
+        }
+        queue_condition_.notify_one();
+    }
+
+    void CaptureWriter::WriterThread() {
+        while (true) {
+            std::vector <uint8_t> chunk;
+            {
+                std::unique_lock <std::mutex> lock(queue_mutex_);
+                queue_condition_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    return;
+                }
+                chunk = std::move(queue_.front());
+                queue_.pop_front();
+                queued_bytes_ -= chunk.size();
+            }
+            if (fwrite(chunk.data(), 1, chunk.size(), file_) != chunk.size()) {
+                LOGE("Capture write failed, dropping chunk");
+                fseek(file_, offset_, SEEK_SET);
+                ++dropped_chunks_;
+                continue;
+            }
+            const CaptureChunkHeader *header =
+                    reinterpret_cast<const CaptureChunkHeader *>(chunk.data());
+            CaptureIndexEntry entry;
+            entry.offset = offset_;
+            entry.type = header->type;
+            entry.payload_size = header->payload_size;
+            entry.timestamp = header->timestamp;
+            index_.push_back(entry);
+            offset_ += chunk.size();
+        }
+    }
+
+    void CaptureWriter::WriteIntrinsics(const TangoCameraIntrinsics &intrinsics) {
+        if (!is_open_) {
+            return;
+        }
+        std::vector <uint8_t> chunk = CreateChunk(CAPTURE_CHUNK_INTRINSICS, 0.0,
+                                                  sizeof(CaptureIntrinsics));
+        CaptureIntrinsics *payload =
+                reinterpret_cast<CaptureIntrinsics *>(chunk.data() + sizeof(CaptureChunkHeader));
+        payload->camera_id = intrinsics.camera_id;
+        payload->calibration_type = intrinsics.calibration_type;
+        payload->width = intrinsics.width;
+        payload->height = intrinsics.height;
+        payload->fx = intrinsics.fx;
+        payload->fy = intrinsics.fy;
+        payload->cx = intrinsics.cx;
+        payload->cy = intrinsics.cy;
+        memcpy(payload->distortion, intrinsics.distortion, sizeof(payload->distortion));
+        Enqueue(std::move(chunk));
+    }
+
+    void CaptureWriter::WriteExtrinsics(const glm::mat4 &imu_T_device,
+                                        const glm::mat4 &imu_T_color_camera,
+                                        const glm::mat4 &imu_T_depth_camera) {
+        if (!is_open_) {
+            return;
+        }
+        std::vector <uint8_t> chunk = CreateChunk(CAPTURE_CHUNK_EXTRINSICS, 0.0,
+                                                  sizeof(CaptureExtrinsics));
+        CaptureExtrinsics *payload =
+                reinterpret_cast<CaptureExtrinsics *>(chunk.data() + sizeof(CaptureChunkHeader));
+        memcpy(payload->imu_T_device, glm::value_ptr(imu_T_device), 16 * sizeof(float));
+        memcpy(payload->imu_T_color_camera, glm::value_ptr(imu_T_color_camera),
+               16 * sizeof(float));
+        memcpy(payload->imu_T_depth_camera, glm::value_ptr(imu_T_depth_camera),
+               16 * sizeof(float));
+        Enqueue(std::move(chunk));
+    }
+
+    void CaptureWriter::WritePose(const TangoPoseData &pose) {
+        if (!is_open_) {
+            return;
+        }
+        std::vector <uint8_t> chunk = CreateChunk(CAPTURE_CHUNK_POSE, pose.timestamp,
+                                                  sizeof(CapturePose));
+        CapturePose *payload =
+                reinterpret_cast<CapturePose *>(chunk.data() + sizeof(CaptureChunkHeader));
+        memcpy(payload->orientation, pose.orientation, sizeof(payload->orientation));
+        memcpy(payload->translation, pose.translation, sizeof(payload->translation));
+        payload->status_code = pose.status_code;
+        payload->base_frame = pose.frame.base;
+        payload->target_frame = pose.frame.target;
+        payload->reserved = 0;
+        Enqueue(std::move(chunk));
+    }
+
+    void CaptureWriter::WritePointCloud(const TangoXYZij *XYZ_ij,
+                                        const glm::mat4 &point_cloud_transformation) {
+        if (!is_open_) {
+            return;
+        }
+        size_t points_size = XYZ_ij->xyz_count * 3 * sizeof(float);
+        std::vector <uint8_t> chunk = CreateChunk(CAPTURE_CHUNK_POINT_CLOUD, XYZ_ij->timestamp,
+                                                  sizeof(CapturePointCloud) + points_size);
+        uint8_t *data = chunk.data() + sizeof(CaptureChunkHeader);
+        CapturePointCloud *payload = reinterpret_cast<CapturePointCloud *>(data);
+        memcpy(payload->point_cloud_transformation, glm::value_ptr(point_cloud_transformation),
+               16 * sizeof(float));
+        payload->xyz_count = XYZ_ij->xyz_count;
+        payload->reserved = 0;
+        memcpy(data + sizeof(CapturePointCloud), XYZ_ij->xyz, points_size);
+        Enqueue(std::move(chunk));
+    }
+
+    void CaptureWriter::WriteYuvFrame(const TangoImageBuffer *buffer) {
+        if (!is_open_ || buffer->format != TANGO_HAL_PIXEL_FORMAT_YCrCb_420_SP) {
+            return;
+        }
+        const uint32_t width = buffer->width / 2;
+        const uint32_t height = buffer->height / 2;
+        std::vector <uint8_t> chunk = CreateChunk(CAPTURE_CHUNK_YUV_FRAME, buffer->timestamp,
+                                                  sizeof(CaptureYuvFrame) +
+                                                  width * height * 3 / 2);
+        uint8_t *data = chunk.data() + sizeof(CaptureChunkHeader);
+        CaptureYuvFrame *payload = reinterpret_cast<CaptureYuvFrame *>(data);
+        payload->width = width;
+        payload->height = height;
+
+        // Keep every second luma sample and every second VU pair of every second
+        // chroma row, the result is again a valid NV21 image.
+        const uint8_t *src_y = buffer->data;
+        const uint8_t *src_vu = buffer->data + buffer->width * buffer->height;
+        uint8_t *dst_y = data + sizeof(CaptureYuvFrame);
+        uint8_t *dst_vu = dst_y + width * height;
+        for (uint32_t y = 0; y < height; ++y) {
+            const uint8_t *src_row = src_y + 2 * y * buffer->width;
+            uint8_t *dst_row = dst_y + y * width;
+            for (uint32_t x = 0; x < width; ++x) {
+                dst_row[x] = src_row[2 * x];
+            }
+        }
+        for (uint32_t y = 0; y < height / 2; ++y) {
+            const uint8_t *src_row = src_vu + 2 * y * buffer->width;
+            uint8_t *dst_row = dst_vu + y * width;
+            for (uint32_t x = 0; x < width / 2; ++x) {
+                dst_row[2 * x] = src_row[4 * x];
+                dst_row[2 * x + 1] = src_row[4 * x + 1];
+            }
+        }
+        Enqueue(std::move(chunk));
+    }
+
+}  // namespace tango_augmented_reality
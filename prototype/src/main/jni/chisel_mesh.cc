@@ -15,48 +15,109 @@
  */
 
 #include "tango-augmented-reality/chisel_mesh.h"
+#include <sys/stat.h>
+
+#include <cstdio>
+
 #include <tango-gl/shaders.h>
+#include <tango-core/mesh_simplifier.h>
+
+#include "tango-augmented-reality/memory_budget.h"
+#include "tango-augmented-reality/thread_pool.h"
+
+namespace {
+    // Frames waiting for integration. Integration is slower than the depth
+    // rate, so older frames are only stale and get dropped.
+    const size_t kMaxQueuedFrames = 2;
+
+    // voxel storage kept through a clear by all levels, 4 KB per 8^3 chunk
+    const size_t kRecycledVoxelBytes = 32 * 1024 * 1024;
+
+    // QuadraticTruncator of the integration, also picks the level of a depth
+    const tango_core::TruncationModel kTruncation = {0.0030f, 0.00152f, 0.001504f, 8.0f};
+
+    // 2, 4 and 8 cm voxels, switching at about 0.86 m and 1.45 m of depth,
+    // 1 gives a single resolution TSDF
+    const int kResolutionLevels = 3;
+    const float kFinestResolution = 0.02f;
+
+    // floor(value / divisor) for positive divisors
+    int FloorDivide(int value, int divisor) {
+        return value >= 0 ? value / divisor : (value + 1) / divisor - 1;
+    }
+
+    // chunks farther from the depth camera are compressed out of the map
+    const float kActiveRegionRadius = 4.0f;
+
+    // over the memory budget the region shrinks by this factor per step, down
+    // to a radius that still covers the depth range
+    const float kActiveRegionShrink = 0.75f;
+    const float kMinActiveRegionRadius = 2.0f;
+
+    // seconds of depth frames between writes of the changed chunks
+    const double kPersistInterval = 5.0;
+
+    // Chunks farther than this from the eye draw their coarse mesh. It keeps
+    // a quarter of the triangles and moves the surface by at most half a
+    // voxel, below the noise of the depth at that range.
+    const float kLodDistance = 2.0f;
+    const float kLodTriangleRatio = 0.25f;
+    const float kLodMaxError = 0.5f;
+}  // namespace
 
 namespace tango_augmented_reality {
-    ChiselMesh::ChiselMesh() {
+    ChiselMesh::ChiselMesh() : dropped_frames_(0), triangle_count_(0), meshing_enabled_(true),
+                               active_region_radius_(kActiveRegionRadius),
+                               region_reset_requested_(false) {
         render_mode_ = GL_TRIANGLES;
         SetShader();
 
         chunkSize = 8;
-        truncationDistScale = 8.0;
+        truncationDistScale = kTruncation.scale;
         weighting = 0.5;
         enableCarving = true;
         carvingDistance = 0.3;
-        chunkResolution = 0.04;
+        chunkResolution = kFinestResolution;
         farClipping = 2.0;
         rayTruncation = 0.5;
 
-
-        chiselMap = chisel::ChiselPtr(
-                new chisel::Chisel(Eigen::Vector3i(chunkSize, chunkSize, chunkSize),
-                                   chunkResolution, false));
         // float quadratic, float linear, float constant, float scale
-        chisel::TruncatorPtr truncator(new chisel::QuadraticTruncator(0.0030, 0.00152, 0.001504, 8.0));
+        chisel::TruncatorPtr truncator(new chisel::QuadraticTruncator(
+                kTruncation.quadratic, kTruncation.linear, kTruncation.constant,
+                kTruncation.scale));
         chisel::ConstantWeighterPtr weighter(new chisel::ConstantWeighter(weighting));
 
-        chisel::Vec3List centroids;
-        projectionIntegrator = chisel::ProjectionIntegrator(truncator, weighter, carvingDistance,
-                                                            enableCarving, centroids);
-        projectionIntegrator.SetCentroids(chiselMap->GetChunkManager().GetCentroids());
+        Eigen::Vector3i chunk_size(chunkSize, chunkSize, chunkSize);
+        for (int i = 0; i < kResolutionLevels; ++i) {
+            Level *level = new Level(chunk_size, chunkResolution * (1 << i),
+                                     kRecycledVoxelBytes / kResolutionLevels);
+            chisel::Vec3List centroids;
+            level->integrator = chisel::ProjectionIntegrator(truncator, weighter, carvingDistance,
+                                                             enableCarving, centroids);
+            level->integrator.SetCentroids(level->map->GetChunkManager().GetCentroids());
+            levels_.emplace_back(level);
+        }
+        pending_updates_.resize(levels_.size());
         LOGI("chisel container was created in native environment");
     }
 
+    ChiselMesh::Level::Level(const Eigen::Vector3i &chunk_size, float resolution,
+                             size_t recycled_voxel_bytes) :
+            resolution(resolution),
+            map(new tango_core::ParallelChisel(chunk_size, resolution, false)),
+            depth(new chisel::DepthImage<float>()),
+            recycler(recycled_voxel_bytes) {
+    }
+
     void ChiselMesh::addPoints(glm::mat4 transformation, TangoCameraIntrinsics intrinsics,
                                TangoXYZij *XYZij) {
-
+        ScopedTimer timer(PROFILE_CHISEL_ADD_POINTS);
         LOGE("Interpolating depth %d x %d", intrinsics.width, intrinsics.height);
 
-        TangoSupportDepthInterpolator *depth_interpolator;
-        TangoSupport_createDepthInterpolator(&intrinsics, &depth_interpolator);
-
-        TangoSupportDepthBuffer depth_buffer;
-        TangoSupport_initializeDepthBuffer(intrinsics.width, intrinsics.height, &depth_buffer);
-
+        setupDepthUpsampling(intrinsics);
+        if (depth_interpolator_ == nullptr) {
+            return;
+        }
 
         TangoPoseData pose;
 
@@ -70,14 +131,12 @@ namespace tango_augmented_reality {
         pose.translation[2] = 0;
 
 
-        if (TangoSupport_upsampleImageNearestNeighbor(depth_interpolator, XYZij, &pose, &depth_buffer) !=
-            TANGO_SUCCESS) {
+        if (TangoSupport_upsampleImageNearestNeighbor(depth_interpolator_, XYZij, &pose,
+                                                      &depth_buffer_) != TANGO_SUCCESS) {
             LOGE("Error upsampling the image.");
             return;
         }
 
-        lastDepthImage->SetData(depth_buffer.depths);
-
         chisel::Transform extrinsic = chisel::Transform();
         for (int j = 0; j < 4; ++j) {
             for (int k = 0; k < 4; ++k) {
@@ -86,21 +145,78 @@ namespace tango_augmented_reality {
         }
 
 
-        chiselMap->IntegrateDepthScan<float>(
-                projectionIntegrator,
-                lastDepthImage,
-                extrinsic,
-                pinHoleCamera
-        );
+        // every level integrates its slice of the frustum, so it only allocates
+        // the chunks of its depth range
+        size_t depth_count = static_cast<size_t>(intrinsics.width) * intrinsics.height;
+        for (const std::unique_ptr <Level> &level : levels_) {
+            float near = level->camera.GetNearPlane();
+            float far = level->camera.GetFarPlane();
+            if (near >= far) {
+                continue;
+            }
+            tango_core::MaskDepthRange(lastDepthImage->GetData(), depth_count, near, far,
+                                       level->depth->GetMutableData());
+            level->map->IntegrateDepthScan<float>(
+                    level->integrator,
+                    level->depth,
+                    extrinsic,
+                    level->camera
+            );
+            // saved with the next persistChunks whether or not they get meshed
+            for (const std::pair <const chisel::ChunkID, bool> &chunk :
+                    level->map->GetMeshesToUpdate()) {
+                level->unsaved.insert(chunk.first);
+            }
+        }
+    }
 
-        TangoSupport_freeDepthBuffer(&depth_buffer);
-        TangoSupport_freeDepthInterpolator(depth_interpolator);
+    void ChiselMesh::setupDepthUpsampling(const TangoCameraIntrinsics &intrinsics) {
+        if (depth_interpolator_ != nullptr &&
+            depth_buffer_intrinsics_.width == intrinsics.width &&
+            depth_buffer_intrinsics_.height == intrinsics.height &&
+            depth_buffer_intrinsics_.fx == intrinsics.fx &&
+            depth_buffer_intrinsics_.fy == intrinsics.fy &&
+            depth_buffer_intrinsics_.cx == intrinsics.cx &&
+            depth_buffer_intrinsics_.cy == intrinsics.cy) {
+            return;
+        }
+        if (depth_interpolator_ != nullptr) {
+            TangoSupport_freeDepthInterpolator(depth_interpolator_);
+            depth_interpolator_ = nullptr;
+        }
+        depth_buffer_intrinsics_ = intrinsics;
+        TangoCameraIntrinsics interpolator_intrinsics = intrinsics;
+        if (TangoSupport_createDepthInterpolator(&interpolator_intrinsics, &depth_interpolator_) !=
+            TANGO_SUCCESS) {
+            LOGE("Could not create depth interpolator.");
+            depth_interpolator_ = nullptr;
+            return;
+        }
 
+        lastDepthImage.reset(new chisel::DepthImage<float>(intrinsics.width, intrinsics.height));
+        for (const std::unique_ptr <Level> &level : levels_) {
+            level->depth.reset(new chisel::DepthImage<float>(intrinsics.width, intrinsics.height));
+        }
+        depth_buffer_.width = intrinsics.width;
+        depth_buffer_.height = intrinsics.height;
+        depth_buffer_.depths = lastDepthImage->GetMutableData();
     }
 
-    void ChiselMesh::init(TangoCameraIntrinsics intrinsics) {
+    ChiselMesh::~ChiselMesh() {
+        stopWorker();
+        persistChunks();
+        for (const std::unique_ptr <Level> &level : levels_) {
+            level->file.Close();
+        }
+        if (depth_interpolator_ != nullptr) {
+            TangoSupport_freeDepthInterpolator(depth_interpolator_);
+        }
+    }
 
-        lastDepthImage.reset(new chisel::DepthImage<float>(intrinsics.width, intrinsics.height));
+    void ChiselMesh::init(TangoCameraIntrinsics intrinsics) {
+        stopWorker();
+        intrinsics_ = intrinsics;
+        setupDepthUpsampling(intrinsics);
 
         chiselIntrinsics.SetFx(intrinsics.fx);
         chiselIntrinsics.SetFy(intrinsics.fy);
@@ -110,41 +226,536 @@ namespace tango_augmented_reality {
         pinHoleCamera.SetWidth(intrinsics.width);
         pinHoleCamera.SetHeight(intrinsics.height);
         pinHoleCamera.SetNearPlane(0.1);
-        pinHoleCamera.SetFarPlane(2.0);
+        pinHoleCamera.SetFarPlane(farClipping);
         pinHoleCamera.SetIntrinsics(chiselIntrinsics);
 
+        tango_core::ResolutionLevels ranges(kTruncation, chunkResolution, levels_.size(),
+                                            pinHoleCamera.GetNearPlane(),
+                                            pinHoleCamera.GetFarPlane());
+        for (size_t i = 0; i < levels_.size(); ++i) {
+            Level &level = *levels_[i];
+            level.camera = pinHoleCamera;
+            level.camera.SetNearPlane(ranges.GetNear(i));
+            level.camera.SetFarPlane(ranges.GetFar(i));
+            LOGI("Level %d: %.0f mm voxels from %.2f to %.2f m", static_cast<int>(i),
+                 level.resolution * 1000.0f, ranges.GetNear(i), ranges.GetFar(i));
+        }
+
+        startWorker();
     }
 
-    void ChiselMesh::updateVertices() {
-        chiselMap->UpdateMeshes();
-        LOGI("Generating Mesh ...");
-        chisel::MeshMap meshMap = chiselMap->GetChunkManager().GetAllMeshes();
-        LOGI("Map with %d items", meshMap.size());
+    void ChiselMesh::startWorker() {
+        stop_worker_ = false;
+        worker_ = std::thread(&ChiselMesh::workerLoop, this);
+    }
+
+    void ChiselMesh::stopWorker() {
+        if (!worker_.joinable()) {
+            return;
+        }
+        {
+            std::lock_guard <std::mutex> lock(queue_mutex_);
+            stop_worker_ = true;
+        }
+        queue_condition_.notify_one();
+        worker_.join();
+    }
+
+    void ChiselMesh::queuePoints(glm::mat4 transformation, const TangoXYZij *XYZij) {
+        {
+            std::lock_guard <std::mutex> lock(queue_mutex_);
+            if (queue_.size() >= kMaxQueuedFrames) {
+                spare_points_.push_back(std::move(queue_.front().points));
+                queue_.pop_front();
+                ++dropped_frames_;
+            }
+            QueuedFrame frame;
+            if (!spare_points_.empty()) {
+                frame.points = std::move(spare_points_.back());
+                spare_points_.pop_back();
+            }
+            const float *xyz = XYZij->xyz[0];
+            frame.points.assign(xyz, xyz + XYZij->xyz_count * 3);
+            frame.transformation = transformation;
+            frame.timestamp = XYZij->timestamp;
+            queue_.push_back(std::move(frame));
+        }
+        queue_condition_.notify_one();
+    }
+
+    void ChiselMesh::workerLoop() {
+        while (true) {
+            QueuedFrame frame;
+            bool clear = false;
+            bool has_frame = false;
+            bool mesh = false;
+            {
+                std::unique_lock <std::mutex> lock(queue_mutex_);
+                queue_condition_.wait(lock, [this] {
+                    return stop_worker_ || clear_requested_ || open_store_requested_ ||
+                           mesh_requested_ || depth_requested_ || !queue_.empty();
+                });
+                if (stop_worker_) {
+                    return;
+                }
+                if (open_store_requested_) {
+                    open_store_requested_ = false;
+                    lock.unlock();
+                    openChunkFile();
+                    continue;
+                }
+                if (clear_requested_) {
+                    // frames queued before the clear belong to the old reconstruction
+                    for (QueuedFrame &queued : queue_) {
+                        spare_points_.push_back(std::move(queued.points));
+                    }
+                    queue_.clear();
+                    clear_requested_ = false;
+                    clear = true;
+                } else if (!queue_.empty()) {
+                    frame = std::move(queue_.front());
+                    queue_.pop_front();
+                    has_frame = true;
+                }
+                mesh = mesh_requested_;
+                mesh_requested_ = false;
+            }
+
+            if (clear) {
+                clearLevels();
+            } else if (has_frame) {
+                TangoXYZij XYZij = TangoXYZij();
+                XYZij.timestamp = frame.timestamp;
+                XYZij.xyz_count = frame.points.size() / 3;
+                XYZij.xyz = reinterpret_cast<float (*)[3]>(frame.points.data());
+                addPoints(frame.transformation, intrinsics_, &XYZij);
+                updateActiveRegion(frame.transformation);
+                reportMemory();
+
+                bool more_queued;
+                {
+                    std::lock_guard <std::mutex> lock(queue_mutex_);
+                    spare_points_.push_back(std::move(frame.points));
+                    more_queued = !queue_.empty();
+                }
+                // a burst of frames is meshed once after its last frame, the
+                // chunks stay dirty until then
+                mesh |= !more_queued && meshing_enabled_;
+                if (frame.timestamp - last_persist_timestamp_ > kPersistInterval) {
+                    persistChunks();
+                    last_persist_timestamp_ = frame.timestamp;
+                }
+            }
+            if (mesh) {
+                updateVertices();
+            }
+            // the newest view over the newest geometry
+            raycastDepth();
+        }
+    }
+
+    void ChiselMesh::requestDepth(const glm::mat4 &view_projection, int width, int height) {
+        {
+            std::lock_guard <std::mutex> lock(queue_mutex_);
+            depth_view_projection_ = view_projection;
+            depth_width_ = width;
+            depth_height_ = height;
+            depth_requested_ = true;
+        }
+        queue_condition_.notify_one();
+    }
+
+    bool ChiselMesh::takeDepth(std::vector <uint16_t> *depth) {
+        std::lock_guard <std::mutex> lock(updates_mutex_);
+        if (!depth_ready_) {
+            return false;
+        }
+        depth->swap(pending_depth_);
+        depth_ready_ = false;
+        return true;
+    }
+
+    void ChiselMesh::setMeshing(bool enabled) {
+        if (meshing_enabled_.exchange(enabled) == enabled || !enabled) {
+            return;
+        }
+        // the chunks integrated meanwhile are still dirty
+        {
+            std::lock_guard <std::mutex> lock(queue_mutex_);
+            mesh_requested_ = true;
+        }
+        queue_condition_.notify_one();
+    }
+
+    void ChiselMesh::raycastDepth() {
+        Eigen::Matrix4f view_projection;
+        int width;
+        int height;
+        {
+            std::lock_guard <std::mutex> lock(queue_mutex_);
+            if (!depth_requested_) {
+                return;
+            }
+            depth_requested_ = false;
+            for (int j = 0; j < 4; ++j) {
+                for (int k = 0; k < 4; ++k) {
+                    view_projection(k, j) = depth_view_projection_[j][k];
+                }
+            }
+            width = depth_width_;
+            height = depth_height_;
+        }
+        ScopedTimer timer(PROFILE_TSDF_RAYCAST);
+        ThreadPool &pool = ThreadPool::Shared();
+        tango_core::ParallelFor parallel_for = [&pool](int count,
+                                                       const std::function<void(int)> &body) {
+            pool.ParallelFor(count, body);
+        };
+
+        // every level up to the end of its depth range, the nearest hit wins
+        size_t pixels = static_cast<size_t>(width) * height;
+        raycast_depth_.assign(pixels, 1.0f);
+        for (const std::unique_ptr <Level> &level : levels_) {
+            tango_core::RaycastTsdf(*level->map, view_projection, width, height,
+                                    level->camera.GetFarPlane(), parallel_for,
+                                    raycast_depth_.data());
+        }
+        raycast_window_depth_.resize(pixels);
+        for (size_t i = 0; i < pixels; ++i) {
+            raycast_window_depth_[i] = static_cast<uint16_t>(raycast_depth_[i] * 65535.0f + 0.5f);
+        }
+
+        std::lock_guard <std::mutex> lock(updates_mutex_);
+        pending_depth_.swap(raycast_window_depth_);
+        depth_ready_ = true;
+    }
 
-        std::vector <GLfloat> mesh;
-        for (const std::pair <chisel::ChunkID, chisel::MeshPtr> &meshes : meshMap) {
-            for (size_t &index: meshes.second->indices) {
-                mesh.push_back(meshes.second->vertices[index](0));
-                mesh.push_back(meshes.second->vertices[index](1));
-                mesh.push_back(meshes.second->vertices[index](2));
+    void ChiselMesh::updateActiveRegion(const glm::mat4 &transformation) {
+        float radius = active_region_radius_;
+        if (radius <= 0.0f) {
+            return;
+        }
+        if (region_reset_requested_.exchange(false)) {
+            region_valid_ = false;
+        }
+        // the rows of the transposed pose hold the translation in their last column
+        Eigen::Vector3f center(transformation[0][3], transformation[1][3], transformation[2][3]);
+        // the region only changes by whole chunks, a small move cannot reach a new one
+        float step = 0.5f * chunkSize * chunkResolution;
+        if (region_valid_ && (center - region_center_).squaredNorm() < step * step) {
+            return;
+        }
+        region_center_ = center;
+        region_valid_ = true;
+        size_t moved = 0;
+        size_t stored_bytes = 0;
+        std::vector <chisel::ChunkID> changed;
+        for (const std::unique_ptr <Level> &level : levels_) {
+            changed.clear();
+            tango_core::UpdateActiveRegion(center, radius, level->map.get(), &level->store,
+                                           &changed);
+            // evicted chunks drop out of the render mesh and restored ones come
+            // back with the next updateVertices, so do their neighbours' borders
+            for (const chisel::ChunkID &id : changed) {
+                level->map->MarkMeshDirty(id);
             }
+            moved += changed.size();
+            stored_bytes += level->store.GetBytes();
         }
-        LOGI("Got %d polygons", mesh.size() / 3);
+        if (moved > 0) {
+            LOGI("Active region moved %d chunks, %d bytes stored in memory", moved, stored_bytes);
+        }
+    }
+
+    bool ChiselMesh::shrinkActiveRegion() {
+        float radius = active_region_radius_;
+        float shrunk = radius > 0.0f
+                       ? std::max(radius * kActiveRegionShrink, kMinActiveRegionRadius)
+                       : kActiveRegionRadius;
+        if (shrunk == radius) {
+            return false;
+        }
+        LOGI("Memory budget exceeded, active region shrinks to %.2f m", shrunk);
+        active_region_radius_ = shrunk;
+        region_reset_requested_ = true;
+        return true;
+    }
 
+    void ChiselMesh::reportMemory() {
+        size_t bytes = chisel_mesh_bytes_;
+        for (const std::unique_ptr <Level> &level : levels_) {
+            bytes += tango_core::ChunkRecycler::VoxelBytes(*level->map) + level->store.GetBytes();
+        }
+        SetMemoryUsage(MEMORY_CHISEL_CHUNKS, bytes);
+    }
+
+    size_t ChiselMesh::getGpuBytes() const {
+        size_t bytes = 0;
+        for (const std::unique_ptr <Level> &level : levels_) {
+            bytes += level->cache.GetGpuBytes();
+        }
+        return bytes;
+    }
+
+    void ChiselMesh::openStore(const std::string &directory) {
+        if (worker_.joinable()) {
+            {
+                std::lock_guard <std::mutex> lock(queue_mutex_);
+                store_directory_ = directory;
+                open_store_requested_ = true;
+            }
+            queue_condition_.notify_one();
+            return;
+        }
+        store_directory_ = directory;
+        openChunkFile();
+    }
+
+    void ChiselMesh::openChunkFile() {
+        std::string directory;
+        {
+            std::lock_guard <std::mutex> lock(queue_mutex_);
+            directory = store_directory_;
+        }
+        persistChunks();
+        for (size_t i = 0; i < levels_.size(); ++i) {
+            Level &level = *levels_[i];
+            level.store.SetFile(nullptr);
+            level.file.Close();
+            // levels keep apart, their chunk ids cover different space
+            char name[16];
+            snprintf(name, sizeof(name), "/level%d", static_cast<int>(i));
+            std::string level_directory = directory + name;
+            mkdir(level_directory.c_str(), 0700);
+            if (!level.file.Open(level_directory)) {
+                LOGE("Could not open chunk store in %s", level_directory.c_str());
+                continue;
+            }
+            level.store.SetFile(&level.file);
+        }
+        // the stored chunks around the camera load with the next frame
+        region_valid_ = false;
+        LOGI("Opened chunk store in %s", directory.c_str());
+    }
+
+    void ChiselMesh::persistChunks() {
+        for (const std::unique_ptr <Level> &level : levels_) {
+            // evicted chunks were written when they left the map
+            if (level->file.IsOpen()) {
+                for (const chisel::ChunkID &id : level->unsaved) {
+                    level->store.Persist(*level->map, id);
+                }
+            }
+            level->unsaved.clear();
+        }
+    }
+
+    bool ChiselMesh::updateRenderMesh() {
+        std::vector <ChunkMeshUpdates> updates(levels_.size());
+        bool reset;
         {
-            std::lock_guard <std::mutex> lock(render_mutex);
-            SetVertices(mesh);
+            std::lock_guard <std::mutex> lock(updates_mutex_);
+            updates.swap(pending_updates_);
+            reset = pending_reset_;
+            pending_reset_ = false;
+        }
+        bool changed = reset;
+        for (size_t i = 0; i < levels_.size(); ++i) {
+            if (reset) {
+                levels_[i]->cache.Clear();
+            }
+            changed |= !updates[i].empty();
+            levels_[i]->cache.Apply(&updates[i]);
+        }
+        return changed;
+    }
+
+    bool ChiselMesh::raycast(const glm::vec3 &origin, const glm::vec3 &direction,
+                             float max_distance, RayHit *hit) const {
+        bool found = false;
+        for (const std::unique_ptr <Level> &level : levels_) {
+            RayHit level_hit;
+            if (level->cache.RayCast(origin, direction, chunkSize * level->resolution,
+                                     max_distance, &level_hit) &&
+                (!found || level_hit.distance < hit->distance)) {
+                *hit = level_hit;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void ChiselMesh::updateVertices() {
+        ScopedTimer timer(PROFILE_CHISEL_MESH);
+        ThreadPool &pool = ThreadPool::Shared();
+        tango_core::ParallelFor parallel_for = [&pool](int count,
+                                                       const std::function<void(int)> &body) {
+            pool.ParallelFor(count, body);
+        };
+
+        // remember which chunks the meshing is going to touch
+        std::vector <std::unordered_set <chisel::ChunkID, chisel::ChunkHasher>> dirty_chunks(
+                levels_.size());
+        size_t remeshed = 0;
+        for (size_t i = 0; i < levels_.size(); ++i) {
+            tango_core::ParallelChisel &map = *levels_[i]->map;
+            for (const std::pair <const chisel::ChunkID, bool> &chunk : map.GetMeshesToUpdate()) {
+                dirty_chunks[i].insert(chunk.first);
+            }
+            remeshed += dirty_chunks[i].size();
+            map.UpdateMeshesParallel(parallel_for);
+        }
+
+        // a changed finer chunk may cover more or less of the coarser chunk
+        // around it, which drops the triangles a finer level observed
+        for (size_t i = 0; i < levels_.size(); ++i) {
+            for (size_t coarser = i + 1; coarser < levels_.size(); ++coarser) {
+                const chisel::MeshMap &meshMap =
+                        levels_[coarser]->map->GetChunkManager().GetAllMeshes();
+                int ratio = 1 << (coarser - i);
+                for (const chisel::ChunkID &id : dirty_chunks[i]) {
+                    chisel::ChunkID coarse_id(FloorDivide(id.x(), ratio),
+                                              FloorDivide(id.y(), ratio),
+                                              FloorDivide(id.z(), ratio));
+                    if (meshMap.find(coarse_id) != meshMap.end()) {
+                        dirty_chunks[coarser].insert(coarse_id);
+                    }
+                }
+            }
+        }
+
+        // chunks weld independently, the maps are only read
+        std::vector <std::pair <int, chisel::ChunkID>> exports;
+        for (size_t i = 0; i < levels_.size(); ++i) {
+            for (const chisel::ChunkID &id : dirty_chunks[i]) {
+                exports.push_back(std::make_pair(static_cast<int>(i), id));
+            }
+        }
+        std::vector <ChunkMeshData> meshes(exports.size());
+        pool.ParallelFor(exports.size(), [&](int i) {
+            exportChunk(exports[i].first, exports[i].second, &meshes[i]);
+        });
+        std::vector <ChunkMeshUpdates> updates(levels_.size());
+        for (size_t i = 0; i < exports.size(); ++i) {
+            updates[exports[i].first][exports[i].second] = std::move(meshes[i]);
+        }
+
+        size_t chunks = 0;
+        size_t triangles = 0;
+        size_t mesh_bytes = 0;
+        for (const std::unique_ptr <Level> &level : levels_) {
+            const chisel::MeshMap &meshMap = level->map->GetChunkManager().GetAllMeshes();
+            chunks += meshMap.size();
+            for (const std::pair <const chisel::ChunkID, chisel::MeshPtr> &chunk_mesh : meshMap) {
+                const chisel::Mesh &mesh = *chunk_mesh.second;
+                triangles += mesh.indices.size() / 3;
+                mesh_bytes += (mesh.vertices.capacity() + mesh.normals.capacity() +
+                               mesh.colors.capacity()) * sizeof(chisel::Vec3) +
+                              mesh.indices.capacity() * sizeof(mesh.indices[0]);
+            }
+        }
+        triangle_count_ = triangles;
+        chisel_mesh_bytes_ = mesh_bytes;
+        LOGI("Remeshed %d of %d chunks, got %d polygons", remeshed, chunks, triangles);
+
+        publishUpdates(&updates, false);
+    }
+
+    void ChiselMesh::exportChunk(int level, const chisel::ChunkID &id,
+                                 ChunkMeshData *data) const {
+        const chisel::MeshMap &meshMap = levels_[level]->map->GetChunkManager().GetAllMeshes();
+        auto chunk_mesh = meshMap.find(id);
+        if (chunk_mesh == meshMap.end()) {
+            return;
+        }
+        // marching cubes emits three vertices per triangle, share them
+        const chisel::Mesh &mesh = *chunk_mesh->second;
+        VertexWelder welder;
+        data->indices.reserve(mesh.indices.size());
+        for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3) {
+            const chisel::Vec3 *corners[3] = {&mesh.vertices[mesh.indices[i]],
+                                              &mesh.vertices[mesh.indices[i + 1]],
+                                              &mesh.vertices[mesh.indices[i + 2]]};
+            // a finer level meshes all of the triangle once it observed its
+            // corners, the coarse triangles at the border overlap its edge
+            bool covered = false;
+            for (int finer = 0; finer < level && !covered; ++finer) {
+                const chisel::Chisel &map = *levels_[finer]->map;
+                covered = tango_core::IsObserved(map, *corners[0]) &&
+                          tango_core::IsObserved(map, *corners[1]) &&
+                          tango_core::IsObserved(map, *corners[2]);
+            }
+            if (covered) {
+                continue;
+            }
+            for (const chisel::Vec3 *vertex : corners) {
+                data->indices.push_back(
+                        welder.Add(glm::vec3((*vertex)(0), (*vertex)(1), (*vertex)(2))));
+            }
+        }
+        data->vertices = welder.GetVertices();
+
+        // the simplifier pins the open chunk and level borders, so coarse
+        // chunks still meet their neighbours of either lod
+        std::vector <uint32_t> indices(data->indices.begin(), data->indices.end());
+        std::vector <uint32_t> coarse;
+        tango_core::SimplifyMesh(data->vertices.data(), data->vertices.size() / 3,
+                                 indices.data(), indices.size(),
+                                 static_cast<size_t>(indices.size() / 3 * kLodTriangleRatio),
+                                 kLodMaxError * levels_[level]->resolution, &coarse);
+        // nothing to gain from a copy of nearly the full mesh
+        if (coarse.size() < indices.size() * 3 / 4) {
+            data->coarse_indices.assign(coarse.begin(), coarse.end());
+        }
+        PackChunkVertices(id, chunkSize * levels_[level]->resolution, data->vertices,
+                          &data->packed_vertices);
+    }
+
+    void ChiselMesh::publishUpdates(std::vector <ChunkMeshUpdates> *updates, bool reset) {
+        std::lock_guard <std::mutex> lock(updates_mutex_);
+        for (size_t i = 0; i < pending_updates_.size(); ++i) {
+            if (reset) {
+                pending_updates_[i].clear();
+            }
+            for (std::pair <const chisel::ChunkID, ChunkMeshData> &update : (*updates)[i]) {
+                pending_updates_[i][update.first] = std::move(update.second);
+            }
+        }
+        if (reset) {
+            pending_reset_ = true;
         }
     }
 
     void ChiselMesh::clear() {
-        std::lock_guard <std::mutex> lock(render_mutex);
-        std::vector <GLfloat> mesh;
-        SetVertices(mesh);
-        chiselMap->Reset();
+        if (worker_.joinable()) {
+            {
+                std::lock_guard <std::mutex> lock(queue_mutex_);
+                clear_requested_ = true;
+            }
+            queue_condition_.notify_one();
+            return;
+        }
+        clearLevels();
     }
 
-    ChiselMesh::ChiselMesh(GLenum render_mode) {
+    void ChiselMesh::clearLevels() {
+        for (const std::unique_ptr <Level> &level : levels_) {
+            level->recycler.Clear(level->map.get());
+            level->store.Clear();
+            level->unsaved.clear();
+        }
+        region_valid_ = false;
+        triangle_count_ = 0;
+        chisel_mesh_bytes_ = 0;
+        reportMemory();
+        std::vector <ChunkMeshUpdates> none(levels_.size());
+        publishUpdates(&none, true);
+    }
+
+    ChiselMesh::ChiselMesh(GLenum render_mode) : dropped_frames_(0), triangle_count_(0),
+                                                meshing_enabled_(true),
+                                                active_region_radius_(kActiveRegionRadius),
+                                                region_reset_requested_(false) {
         render_mode_ = render_mode;
     }
 
@@ -169,23 +780,19 @@ namespace tango_augmented_reality {
         glm::mat4 model_mat = GetTransformationMatrix();
         glm::mat4 mv_mat = view_mat * model_mat;
         glm::mat4 mvp_mat = projection_mat * mv_mat;
-        glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
         glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
 
-        glEnableVertexAttribArray(attrib_vertices_);
-
-        if (!indices_.empty()) {
-            glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                                  3 * sizeof(GLfloat), vertices_.data());
-            glDrawElements(render_mode_, indices_.size(), GL_UNSIGNED_SHORT,
-                           indices_.data());
-        } else {
-            glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                                  3 * sizeof(GLfloat), &vertices_[0]);
-            glDrawArrays(render_mode_, 0, vertices_.size() / 3);
+        // lod by the distance of the eye in the mesh frame, the chunks set the
+        // mvp with their vertex decoding
+        glm::vec3 eye = glm::vec3(glm::inverse(mv_mat)[3]);
+        CullStats stats;
+        for (const std::unique_ptr <Level> &level : levels_) {
+            level->cache.Render(attrib_vertices_, uniform_mvp_mat_, mvp_mat, render_mode_, eye,
+                                chunkSize * level->resolution, kLodDistance, &stats);
         }
+        SetProfileCounter(PROFILE_DRAWN_BATCHES, stats.drawn);
+        SetProfileCounter(PROFILE_CULLED_BATCHES, stats.culled);
 
-        glDisableVertexAttribArray(attrib_vertices_);
         glUseProgram(0);
     }
 }  // namespace tango_augmented_reality
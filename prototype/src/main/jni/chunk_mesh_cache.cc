@@ -0,0 +1,222 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-augmented-reality/chunk_mesh_cache.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/type_ptr.hpp>
+
+namespace {
+    // packed box reaches this fraction of a chunk past each side
+    const float kPackMargin = 0.25f;
+    const float kPackRange = 65535.0f;
+
+    glm::vec3 PackOrigin(const chisel::ChunkID &id, float chunk_extent) {
+        return (glm::vec3(id.x(), id.y(), id.z()) - glm::vec3(kPackMargin)) * chunk_extent;
+    }
+
+    // Uploads data into buffer, growing its storage only when it does not fit.
+    void UploadBuffer(GLenum target, GLuint buffer, const void *data, size_t size,
+                      size_t *capacity) {
+        glBindBuffer(target, buffer);
+        if (size > *capacity) {
+            glBufferData(target, size, data, GL_DYNAMIC_DRAW);
+            *capacity = size;
+        } else if (size > 0) {
+            glBufferSubData(target, 0, size, data);
+        }
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    void PackChunkVertices(const chisel::ChunkID &id, float chunk_extent,
+                           const std::vector <GLfloat> &vertices,
+                           std::vector <GLushort> *packed) {
+        glm::vec3 origin = PackOrigin(id, chunk_extent);
+        float scale = kPackRange / ((1.0f + 2.0f * kPackMargin) * chunk_extent);
+        size_t count = vertices.size() / 3;
+        packed->resize(4 * count);
+        for (size_t i = 0; i < count; ++i) {
+            for (int k = 0; k < 3; ++k) {
+                float value = std::floor((vertices[3 * i + k] - origin[k]) * scale + 0.5f);
+                (*packed)[4 * i + k] = static_cast<GLushort>(
+                        std::min(std::max(value, 0.0f), kPackRange));
+            }
+            (*packed)[4 * i + 3] = 0;
+        }
+    }
+
+    glm::mat4 ChunkDecodeMatrix(const chisel::ChunkID &id, float chunk_extent) {
+        glm::mat4 translation = glm::translate(glm::mat4(1.0f), PackOrigin(id, chunk_extent));
+        return glm::scale(translation, glm::vec3((1.0f + 2.0f * kPackMargin) * chunk_extent));
+    }
+
+    ChunkMeshCache::ChunkMeshCache() { }
+
+    ChunkMeshCache::~ChunkMeshCache() {
+        Clear();
+    }
+
+    ChunkMeshCache::ChunkBuffers ChunkMeshCache::AcquireBuffers() {
+        if (!free_buffers_.empty()) {
+            ChunkBuffers buffers = free_buffers_.back();
+            free_buffers_.pop_back();
+            return buffers;
+        }
+        ChunkBuffers buffers;
+        GLuint names[2];
+        glGenBuffers(2, names);
+        buffers.vertex_buffer = names[0];
+        buffers.index_buffer = names[1];
+        buffers.vertex_capacity = 0;
+        buffers.index_capacity = 0;
+        buffers.index_count = 0;
+        buffers.coarse_index_count = 0;
+        return buffers;
+    }
+
+    void ChunkMeshCache::Apply(ChunkMeshUpdates *updates) {
+        for (std::pair <const chisel::ChunkID, ChunkMeshData> &update : *updates) {
+            auto chunk = chunks_.find(update.first);
+            if (update.second.indices.empty()) {
+                if (chunk != chunks_.end()) {
+                    chunk->second.mesh = ChunkMeshData();
+                    free_buffers_.push_back(chunk->second);
+                    chunks_.erase(chunk);
+                }
+                continue;
+            }
+            if (chunk == chunks_.end()) {
+                chunk = chunks_.insert(std::make_pair(update.first, AcquireBuffers())).first;
+            }
+            ChunkBuffers &buffers = chunk->second;
+            const ChunkMeshData &mesh = update.second;
+            UploadBuffer(GL_ARRAY_BUFFER, buffers.vertex_buffer, mesh.packed_vertices.data(),
+                         mesh.packed_vertices.size() * sizeof(GLushort),
+                         &buffers.vertex_capacity);
+            // one buffer for both lods, they share the vertices
+            size_t index_bytes = mesh.indices.size() * sizeof(GLushort);
+            size_t coarse_bytes = mesh.coarse_indices.size() * sizeof(GLushort);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.index_buffer);
+            if (index_bytes + coarse_bytes > buffers.index_capacity) {
+                glBufferData(GL_ELEMENT_ARRAY_BUFFER, index_bytes + coarse_bytes, nullptr,
+                             GL_DYNAMIC_DRAW);
+                buffers.index_capacity = index_bytes + coarse_bytes;
+            }
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, index_bytes, mesh.indices.data());
+            if (coarse_bytes > 0) {
+                glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, index_bytes, coarse_bytes,
+                                mesh.coarse_indices.data());
+            }
+            buffers.index_count = mesh.indices.size();
+            buffers.coarse_index_count = mesh.coarse_indices.size();
+            buffers.mesh = std::move(update.second);
+            // ray casts only test the full float mesh
+            std::vector <GLushort>().swap(buffers.mesh.coarse_indices);
+            std::vector <GLushort>().swap(buffers.mesh.packed_vertices);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        tango_gl::util::CheckGlError("ChunkMeshCache::Apply()");
+    }
+
+    bool ChunkMeshCache::RayCast(const glm::vec3 &origin, const glm::vec3 &direction,
+                                 float chunk_extent, float max_distance, RayHit *hit) const {
+        hit->distance = max_distance;
+        bool found = false;
+        TraverseGrid(origin, direction, chunk_extent, max_distance,
+                     [&](int x, int y, int z, float enter, float exit) {
+            auto chunk = chunks_.find(chisel::ChunkID(x, y, z));
+            if (chunk != chunks_.end()) {
+                const ChunkMeshData &mesh = chunk->second.mesh;
+                found |= RayCastIndexedTriangles(origin, direction, mesh.vertices.data(),
+                                                 mesh.indices.data(), mesh.indices.size(), hit);
+            }
+            // a hit inside this chunk is nearer than anything in the next ones
+            return !found || hit->distance > exit;
+        });
+        return found;
+    }
+
+    void ChunkMeshCache::Render(GLuint attrib_vertices, GLint uniform_mvp, const glm::mat4 &mvp,
+                                GLenum render_mode, const glm::vec3 &eye, float chunk_extent,
+                                float lod_distance, CullStats *stats) const {
+        float lod_distance_squared = lod_distance * lod_distance;
+        // the packed box holds every vertex of its chunk
+        glm::vec3 box_size((1.0f + 2.0f * kPackMargin) * chunk_extent);
+        ViewFrustum frustum(mvp);
+        glEnableVertexAttribArray(attrib_vertices);
+        for (const std::pair <const chisel::ChunkID, ChunkBuffers> &chunk : chunks_) {
+            const ChunkBuffers &buffers = chunk.second;
+            glm::vec3 box_min = PackOrigin(chunk.first, chunk_extent);
+            if (!frustum.IsBoxVisible(box_min, box_min + box_size)) {
+                ++stats->culled;
+                continue;
+            }
+            ++stats->drawn;
+            glm::vec3 center = (glm::vec3(chunk.first.x(), chunk.first.y(), chunk.first.z()) +
+                                glm::vec3(0.5f)) * chunk_extent;
+            glm::vec3 offset = center - eye;
+            bool coarse = buffers.coarse_index_count > 0 &&
+                          glm::dot(offset, offset) > lod_distance_squared;
+            glm::mat4 chunk_mvp = mvp * ChunkDecodeMatrix(chunk.first, chunk_extent);
+            glUniformMatrix4fv(uniform_mvp, 1, GL_FALSE, glm::value_ptr(chunk_mvp));
+            glBindBuffer(GL_ARRAY_BUFFER, buffers.vertex_buffer);
+            // normalized to [0, 1] in the packed box, w stays 1
+            glVertexAttribPointer(attrib_vertices, 3, GL_UNSIGNED_SHORT, GL_TRUE,
+                                  4 * sizeof(GLushort), nullptr);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, buffers.index_buffer);
+            if (coarse) {
+                glDrawElements(render_mode, buffers.coarse_index_count, GL_UNSIGNED_SHORT,
+                               reinterpret_cast<const GLvoid *>(
+                                       buffers.index_count * sizeof(GLushort)));
+            } else {
+                glDrawElements(render_mode, buffers.index_count, GL_UNSIGNED_SHORT, nullptr);
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        glDisableVertexAttribArray(attrib_vertices);
+    }
+
+    size_t ChunkMeshCache::GetGpuBytes() const {
+        size_t bytes = 0;
+        for (const std::pair <const chisel::ChunkID, ChunkBuffers> &chunk : chunks_) {
+            bytes += chunk.second.vertex_capacity + chunk.second.index_capacity;
+        }
+        for (const ChunkBuffers &buffers : free_buffers_) {
+            bytes += buffers.vertex_capacity + buffers.index_capacity;
+        }
+        return bytes;
+    }
+
+    void ChunkMeshCache::Clear() {
+        for (std::pair <const chisel::ChunkID, ChunkBuffers> &chunk : chunks_) {
+            chunk.second.mesh = ChunkMeshData();
+            free_buffers_.push_back(chunk.second);
+        }
+        chunks_.clear();
+        for (const ChunkBuffers &buffers : free_buffers_) {
+            GLuint names[2] = {buffers.vertex_buffer, buffers.index_buffer};
+            glDeleteBuffers(2, names);
+        }
+        free_buffers_.clear();
+    }
+}  // namespace tango_augmented_reality
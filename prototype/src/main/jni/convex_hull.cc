@@ -13,27 +13,67 @@ namespace tango_augmented_reality {
         return (P1.x - P0.x) * (P2.y - P0.y) - (P2.x - P0.x) * (P1.y - P0.y);
     }
 
-    std::vector <glm::vec2> ConvexHull::generateConvexHull(std::vector < glm::vec2 > &points) {
+    bool ConvexHull::contains(glm::vec2 point) const {
+        int n = vertices_.size();
+        if (n < 3) {
+            return false;
+        }
+        // outside the wedge spanned by the fan around the first vertex
+        if (isLeft(vertices_[0], vertices_[1], point) < 0 ||
+            isLeft(vertices_[0], vertices_[n - 1], point) > 0) {
+            return false;
+        }
+        // binary search the fan triangle (0, low, low + 1) holding the point
+        int low = 1;
+        int high = n - 1;
+        while (high - low > 1) {
+            int middle = (low + high) / 2;
+            if (isLeft(vertices_[0], vertices_[middle], point) >= 0) {
+                low = middle;
+            } else {
+                high = middle;
+            }
+        }
+        return isLeft(vertices_[low], vertices_[low + 1], point) >= 0;
+    }
+
+    bool ConvexHull::insert(const std::vector <glm::vec2> &points) {
+        candidates_.clear();
+        for (int i = 0; i < points.size(); ++i) {
+            if (!contains(points[i])) {
+                candidates_.push_back(points[i]);
+            }
+        }
+        if (candidates_.empty()) {
+            return false;
+        }
+        // the old vertices stand in for everything inside the hull
+        candidates_.insert(candidates_.end(), vertices_.begin(), vertices_.end());
 
-        int n = points.size(), k = 0;
-        std::vector <glm::vec2> hull(2 * n);
+        int n = candidates_.size(), k = 0;
+        chain_.resize(2 * n);
 
         // Sort points lexicographically
-        std::sort(points.begin(), points.end(), less_equal);
+        std::sort(candidates_.begin(), candidates_.end(), less_equal);
 
         // Build lower hull
         for (int i = 0; i < n; ++i) {
-            while (k >= 2 && isLeft(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
-            hull[k++] = points[i];
+            while (k >= 2 && isLeft(chain_[k - 2], chain_[k - 1], candidates_[i]) <= 0) k--;
+            chain_[k++] = candidates_[i];
         }
 
         // Build upper hull
         for (int i = n - 2, t = k + 1; i >= 0; i--) {
-            while (k >= t && isLeft(hull[k - 2], hull[k - 1], points[i]) <= 0) k--;
-            hull[k++] = points[i];
+            while (k >= t && isLeft(chain_[k - 2], chain_[k - 1], candidates_[i]) <= 0) k--;
+            chain_[k++] = candidates_[i];
         }
 
-        hull.resize(k);
-        return hull;
+        // the chain ends on its first point again unless it is a single point
+        vertices_.assign(chain_.begin(), chain_.begin() + (k > 1 ? k - 1 : k));
+        return true;
     }
-}
\ No newline at end of file
+
+    void ConvexHull::clear() {
+        vertices_.clear();
+    }
+}
@@ -0,0 +1,243 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string>
+
+#include "tango-augmented-reality/guided_depth_filter.h"
+
+namespace {
+    const std::string kVertexShader =
+            "#version 300 es\n"
+                    "void main() {\n"
+                    "  vec2 position = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));\n"
+                    "  gl_Position = vec4(position * 2.0 - 1.0, 0.0, 1.0);\n"
+                    "}\n";
+
+    // Box mean of Sample() along direction, Sample() is defined per pass.
+    // Borders replicate the outermost pixels.
+    const std::string kBoxHeader =
+            "#version 300 es\n"
+                    "precision highp float;\n"
+                    "precision highp int;\n"
+                    "uniform highp sampler2D source;\n"
+                    "uniform highp sampler2D guide;\n"
+                    "uniform ivec2 direction;\n"
+                    "uniform int radius;\n"
+                    "uniform float eps;\n"
+                    "float Luminance(ivec2 p) {\n"
+                    "  return dot(texelFetch(guide, p, 0).rgb, vec3(0.299, 0.587, 0.114));\n"
+                    "}\n";
+
+    const std::string kBoxMean =
+            "vec4 BoxMean(ivec2 center) {\n"
+                    "  ivec2 last = textureSize(source, 0) - 1;\n"
+                    "  vec4 sum = vec4(0.0);\n"
+                    "  for (int k = -radius; k <= radius; ++k) {\n"
+                    "    sum += Sample(clamp(center + k * direction, ivec2(0), last));\n"
+                    "  }\n"
+                    "  return sum / float(2 * radius + 1);\n"
+                    "}\n";
+
+    // guide I and depth p to (I, p, I * I, I * p)
+    const std::string kStatsSample =
+            "vec4 Sample(ivec2 p) {\n"
+                    "  float i = Luminance(p);\n"
+                    "  float d = texelFetch(source, p, 0).r;\n"
+                    "  return vec4(i, d, i * i, i * d);\n"
+                    "}\n";
+
+    const std::string kBoxSample =
+            "vec4 Sample(ivec2 p) {\n"
+                    "  return texelFetch(source, p, 0);\n"
+                    "}\n";
+
+    // means to the coefficients of q = a * I + b
+    const std::string kCoefficientSample =
+            "vec4 Sample(ivec2 p) {\n"
+                    "  vec4 m = texelFetch(source, p, 0);\n"
+                    "  float a = (m.w - m.x * m.y) / (m.z - m.x * m.x + eps);\n"
+                    "  return vec4(a, m.y - a * m.x, 0.0, 0.0);\n"
+                    "}\n";
+
+    const std::string kTargetMain =
+            "out vec4 result;\n"
+                    "void main() {\n"
+                    "  result = BoxMean(ivec2(gl_FragCoord.xy));\n"
+                    "}\n";
+
+    const std::string kDepthMain =
+            "void main() {\n"
+                    "  ivec2 center = ivec2(gl_FragCoord.xy);\n"
+                    "  vec4 coefficients = BoxMean(center);\n"
+                    "  gl_FragDepth = clamp(coefficients.x * Luminance(center) + coefficients.y,\n"
+                    "                       0.0, 1.0);\n"
+                    "}\n";
+
+    GLuint CreateBoxProgram(const std::string &sample, const std::string &main) {
+        std::string fragment_shader = kBoxHeader + sample + kBoxMean + main;
+        GLuint program = tango_gl::util::CreateProgram(kVertexShader.c_str(),
+                                                       fragment_shader.c_str());
+        if (!program) {
+            LOGE("GuidedDepthFilter: could not create program.");
+        }
+        return program;
+    }
+
+    void SetTexture(GLuint program, const char *name, int unit, GLuint texture) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glUniform1i(glGetUniformLocation(program, name), unit);
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    GuidedDepthFilter::GuidedDepthFilter() : width_(0), height_(0), available_(false),
+                                             stats_program_(0), box_program_(0),
+                                             coefficient_program_(0), output_program_(0),
+                                             vertex_array_(0) {
+        textures_[0] = textures_[1] = 0;
+        frame_buffers_[0] = frame_buffers_[1] = 0;
+    }
+
+    GuidedDepthFilter::~GuidedDepthFilter() { }
+
+    bool GuidedDepthFilter::Initialize(int width, int height) {
+        DeleteGlResources();
+        width_ = width;
+        height_ = height;
+
+        stats_program_ = CreateBoxProgram(kStatsSample, kTargetMain);
+        box_program_ = CreateBoxProgram(kBoxSample, kTargetMain);
+        coefficient_program_ = CreateBoxProgram(kCoefficientSample, kTargetMain);
+        output_program_ = CreateBoxProgram(kBoxSample, kDepthMain);
+        glGenVertexArrays(1, &vertex_array_);
+
+        // 32 bit floats, the variance of the guide is a difference of close
+        // values and eps is about 1e-4 for normalized guides
+        glGenTextures(2, textures_);
+        glGenFramebuffers(2, frame_buffers_);
+        available_ = stats_program_ && box_program_ && coefficient_program_ && output_program_;
+        for (int i = 0; i < 2; ++i) {
+            glBindTexture(GL_TEXTURE_2D, textures_[i]);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32F, width_, height_, 0, GL_RGBA, GL_FLOAT,
+                         NULL);
+            glBindFramebuffer(GL_FRAMEBUFFER, frame_buffers_[i]);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                                   textures_[i], 0);
+            if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+                LOGE("GuidedDepthFilter: float targets not supported, filtering on the CPU");
+                available_ = false;
+            }
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        tango_gl::util::CheckGlError("GuidedDepthFilter::Initialize()");
+        return available_;
+    }
+
+    void GuidedDepthFilter::RunPass(GLuint program, GLuint target, int dx, int dy, int radius) {
+        glBindFramebuffer(GL_FRAMEBUFFER, target);
+        glUniform2i(glGetUniformLocation(program, "direction"), dx, dy);
+        glUniform1i(glGetUniformLocation(program, "radius"), radius);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+    }
+
+    void GuidedDepthFilter::Apply(GLuint guide_texture, GLuint depth_texture,
+                                  GLuint depth_frame_buffer, int radius, double eps) {
+        if (!available_) {
+            return;
+        }
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        GLboolean blend = glIsEnabled(GL_BLEND);
+        GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+        GLint depth_func;
+        glGetIntegerv(GL_DEPTH_FUNC, &depth_func);
+
+        glViewport(0, 0, width_, height_);
+        glDisable(GL_BLEND);
+        glDisable(GL_DEPTH_TEST);
+        glBindVertexArray(vertex_array_);
+
+        // 1. box mean of (I, p, I * I, I * p)
+        glUseProgram(stats_program_);
+        SetTexture(stats_program_, "source", 0, depth_texture);
+        SetTexture(stats_program_, "guide", 1, guide_texture);
+        RunPass(stats_program_, frame_buffers_[0], 1, 0, radius);
+        glUseProgram(box_program_);
+        SetTexture(box_program_, "source", 0, textures_[0]);
+        RunPass(box_program_, frame_buffers_[1], 0, 1, radius);
+
+        // 2. box mean of the coefficients a and b
+        glUseProgram(coefficient_program_);
+        glUniform1f(glGetUniformLocation(coefficient_program_, "eps"),
+                    static_cast<float>(eps / (255.0 * 255.0)));
+        SetTexture(coefficient_program_, "source", 0, textures_[1]);
+        RunPass(coefficient_program_, frame_buffers_[0], 1, 0, radius);
+
+        // 3. q = mean a * I + mean b into the depth texture, the depth test
+        // is the only way to write depth
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_ALWAYS);
+        glDepthMask(GL_TRUE);
+        glUseProgram(output_program_);
+        SetTexture(output_program_, "source", 0, textures_[0]);
+        SetTexture(output_program_, "guide", 1, guide_texture);
+        RunPass(output_program_, depth_frame_buffer, 0, 1, radius);
+
+        glBindVertexArray(0);
+        glUseProgram(0);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glActiveTexture(GL_TEXTURE0);
+        glDepthFunc(depth_func);
+        if (!depth_test) {
+            glDisable(GL_DEPTH_TEST);
+        }
+        if (blend) {
+            glEnable(GL_BLEND);
+        }
+        glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+        tango_gl::util::CheckGlError("GuidedDepthFilter::Apply()");
+    }
+
+    void GuidedDepthFilter::DeleteGlResources() {
+        GLuint *programs[] = {&stats_program_, &box_program_, &coefficient_program_,
+                              &output_program_};
+        for (GLuint *program : programs) {
+            if (*program) {
+                glDeleteProgram(*program);
+                *program = 0;
+            }
+        }
+        if (textures_[0]) {
+            glDeleteTextures(2, textures_);
+            textures_[0] = textures_[1] = 0;
+        }
+        if (frame_buffers_[0]) {
+            glDeleteFramebuffers(2, frame_buffers_);
+            frame_buffers_[0] = frame_buffers_[1] = 0;
+        }
+        if (vertex_array_) {
+            glDeleteVertexArrays(1, &vertex_array_);
+            vertex_array_ = 0;
+        }
+        available_ = false;
+    }
+}  // namespace tango_augmented_reality
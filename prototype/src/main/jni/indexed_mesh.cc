@@ -0,0 +1,218 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "tango-augmented-reality/indexed_mesh.h"
+
+namespace {
+    // edge of the grid cells triangles are clustered by, in meters
+    const float kClusterSize = 1.0f;
+
+    // cell of the triangle centroid, 21 bits per axis around the origin
+    uint64_t ClusterKey(const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c) {
+        glm::vec3 cell = glm::floor((a + b + c) / (3.0f * kClusterSize));
+        uint64_t key = 0;
+        for (int i = 0; i < 3; ++i) {
+            int64_t value = static_cast<int64_t>(cell[i]) + (1 << 20);
+            key = (key << 21) | (static_cast<uint64_t>(value) & 0x1FFFFF);
+        }
+        return key;
+    }
+
+    // OpenGL ES 3 has 32 bit indices in core, ES 2 needs the extension.
+    bool HasUintIndices() {
+        static int supported = -1;
+        if (supported < 0) {
+            const char *version = reinterpret_cast<const char *>(glGetString(GL_VERSION));
+            const char *extensions = reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
+            supported = (version != nullptr && strncmp(version, "OpenGL ES 3", 11) == 0) ||
+                        (extensions != nullptr &&
+                         strstr(extensions, "GL_OES_element_index_uint") != nullptr);
+        }
+        return supported == 1;
+    }
+
+    uint32_t FloatBits(float value) {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    void VertexWelder::Clear() {
+        indices_.clear();
+        vertices_.clear();
+    }
+
+    uint32_t VertexWelder::Add(const glm::vec3 &position) {
+        Key key = {FloatBits(position.x), FloatBits(position.y), FloatBits(position.z)};
+        auto inserted = indices_.insert(std::make_pair(key, vertices_.size() / 3));
+        if (inserted.second) {
+            vertices_.push_back(position.x);
+            vertices_.push_back(position.y);
+            vertices_.push_back(position.z);
+        }
+        return inserted.first->second;
+    }
+
+    IndexedMesh::IndexedMesh() : dirty_(false), vertex_buffer_(0), index_buffer_(0),
+                                 draw_count_(0), indexed_(true), gpu_bytes_(0) { }
+
+    void IndexedMesh::SetTriangles(const std::vector <glm::vec3> &triangles) {
+        welder_.Clear();
+        indices_.clear();
+        clusters_.clear();
+        indices_.reserve(triangles.size());
+
+        // triangles of a cluster are contiguous, one draw call each
+        size_t triangle_count = triangles.size() / 3;
+        std::vector <std::pair <uint64_t, uint32_t>> order(triangle_count);
+        for (size_t t = 0; t < triangle_count; ++t) {
+            order[t] = std::make_pair(ClusterKey(triangles[3 * t], triangles[3 * t + 1],
+                                                 triangles[3 * t + 2]),
+                                      static_cast<uint32_t>(t));
+        }
+        std::sort(order.begin(), order.end());
+        for (size_t i = 0; i < order.size(); ++i) {
+            if (i == 0 || order[i].first != order[i - 1].first) {
+                Cluster cluster = {i, 0, triangles[3 * order[i].second],
+                                   triangles[3 * order[i].second]};
+                clusters_.push_back(cluster);
+            }
+            Cluster &cluster = clusters_.back();
+            ++cluster.count;
+            for (int k = 0; k < 3; ++k) {
+                const glm::vec3 &vertex = triangles[3 * order[i].second + k];
+                cluster.min = glm::min(cluster.min, vertex);
+                cluster.max = glm::max(cluster.max, vertex);
+                indices_.push_back(welder_.Add(vertex));
+            }
+        }
+        dirty_ = true;
+    }
+
+    void IndexedMesh::Clear() {
+        welder_.Clear();
+        indices_.clear();
+        clusters_.clear();
+        dirty_ = true;
+    }
+
+    bool IndexedMesh::RayCast(const glm::vec3 &origin, const glm::vec3 &direction,
+                              RayHit *hit) const {
+        return RayCastIndexedTriangles(origin, direction, welder_.GetVertices().data(),
+                                       indices_.data(), indices_.size(), hit);
+    }
+
+    void IndexedMesh::Upload() {
+        if (vertex_buffer_ == 0) {
+            GLuint buffers[2];
+            glGenBuffers(2, buffers);
+            vertex_buffer_ = buffers[0];
+            index_buffer_ = buffers[1];
+            indexed_ = HasUintIndices();
+        }
+
+        const std::vector <GLfloat> &vertices = welder_.GetVertices();
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+        if (indexed_) {
+            glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(GLfloat), vertices.data(),
+                         GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices_.size() * sizeof(uint32_t),
+                         indices_.data(), GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            draw_count_ = indices_.size();
+            gpu_bytes_ = vertices.size() * sizeof(GLfloat) + indices_.size() * sizeof(uint32_t);
+        } else {
+            std::vector <GLfloat> soup;
+            soup.reserve(indices_.size() * 3);
+            for (uint32_t index : indices_) {
+                soup.insert(soup.end(), &vertices[index * 3], &vertices[index * 3] + 3);
+            }
+            glBufferData(GL_ARRAY_BUFFER, soup.size() * sizeof(GLfloat), soup.data(),
+                         GL_STATIC_DRAW);
+            draw_count_ = indices_.size();
+            gpu_bytes_ = soup.size() * sizeof(GLfloat);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        dirty_ = false;
+    }
+
+    void IndexedMesh::Render(GLuint attrib_vertices, GLenum render_mode, const glm::mat4 &mvp,
+                             CullStats *stats) {
+        if (dirty_) {
+            Upload();
+        }
+        if (draw_count_ == 0) {
+            return;
+        }
+        ViewFrustum frustum(mvp);
+        glEnableVertexAttribArray(attrib_vertices);
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer_);
+        glVertexAttribPointer(attrib_vertices, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), nullptr);
+        if (indexed_) {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer_);
+        }
+        // neighbouring visible clusters share a draw call
+        size_t first = 0;
+        size_t count = 0;
+        for (size_t i = 0; i <= clusters_.size(); ++i) {
+            bool visible = i < clusters_.size() &&
+                           frustum.IsBoxVisible(clusters_[i].min, clusters_[i].max);
+            if (i < clusters_.size()) {
+                ++(visible ? stats->drawn : stats->culled);
+            }
+            if (visible && count > 0 && first + count == clusters_[i].first) {
+                count += clusters_[i].count;
+                continue;
+            }
+            if (count > 0) {
+                if (indexed_) {
+                    glDrawElements(render_mode, 3 * count, GL_UNSIGNED_INT,
+                                   reinterpret_cast<const GLvoid *>(
+                                           3 * first * sizeof(uint32_t)));
+                } else {
+                    glDrawArrays(render_mode, 3 * first, 3 * count);
+                }
+            }
+            first = visible ? clusters_[i].first : 0;
+            count = visible ? clusters_[i].count : 0;
+        }
+        if (indexed_) {
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glDisableVertexAttribArray(attrib_vertices);
+    }
+
+    void IndexedMesh::DeleteGlResources() {
+        if (vertex_buffer_ != 0) {
+            GLuint buffers[2] = {vertex_buffer_, index_buffer_};
+            glDeleteBuffers(2, buffers);
+            vertex_buffer_ = 0;
+            index_buffer_ = 0;
+        }
+        draw_count_ = 0;
+        gpu_bytes_ = 0;
+        dirty_ = !indices_.empty();
+    }
+}  // namespace tango_augmented_reality
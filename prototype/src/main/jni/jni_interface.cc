@@ -18,6 +18,8 @@
 
 #include <jni.h>
 #include <tango-augmented-reality/augmented_reality_app.h>
+#include <tango-augmented-reality/memory_budget.h>
+#include <tango-augmented-reality/profiler.h>
 
 static tango_augmented_reality::AugmentedRealityApp app;
 
@@ -123,6 +125,15 @@ Java_de_stetro_master_prototype_TangoJNINative_clearReconstruction(
   app.clearReconstruction();
 }
 
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_openChunkStore(
+    JNIEnv* env, jobject, jstring directory) {
+  const char* directory_chars = env->GetStringUTFChars(directory, nullptr);
+  std::string directory_string(directory_chars);
+  env->ReleaseStringUTFChars(directory, directory_chars);
+  app.openChunkStore(directory_string);
+}
+
 
 
 JNIEXPORT void JNICALL
@@ -137,6 +148,21 @@ Java_de_stetro_master_prototype_TangoJNINative_joyStick(
   app.joyStick(angle, power);
 }
 
+JNIEXPORT jint JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_startRecording(
+    JNIEnv* env, jobject, jstring path) {
+  const char* path_chars = env->GetStringUTFChars(path, nullptr);
+  std::string path_string(path_chars);
+  env->ReleaseStringUTFChars(path, path_chars);
+  return app.StartRecording(path_string);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_stopRecording(
+    JNIEnv*, jobject) {
+  app.StopRecording();
+}
+
 JNIEXPORT void JNICALL
 Java_de_stetro_master_prototype_TangoJNINative_setCamera(
     JNIEnv*, jobject, int camera_index) {
@@ -158,12 +184,45 @@ Java_de_stetro_master_prototype_TangoJNINative_setDepthFullscreen(
 app.setDepthFullscreen(show);
 }
 
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setTsdfRaycast(
+        JNIEnv*, jobject, jboolean enabled) {
+app.setTsdfRaycast(enabled);
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setFusedFrames(
+        JNIEnv*, jobject, jint count) {
+app.setFusedFrames(count);
+}
+
 JNIEXPORT void JNICALL
 Java_de_stetro_master_prototype_TangoJNINative_addObject(
         JNIEnv*, jobject, float x, float y) {
 app.addObject(x,y);
 }
 
+JNIEXPORT jstring JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_getProfileReport(
+    JNIEnv* env, jobject) {
+  std::string report = tango_augmented_reality::GetProfileReport();
+  return env->NewStringUTF(report.c_str());
+}
+
+JNIEXPORT void JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_setMemoryBudget(
+    JNIEnv*, jobject, jint megabytes) {
+  size_t bytes = megabytes > 0 ? static_cast<size_t>(megabytes) * 1024 * 1024 : 0;
+  tango_augmented_reality::SetMemoryBudget(bytes);
+}
+
+JNIEXPORT jstring JNICALL
+Java_de_stetro_master_prototype_TangoJNINative_getMemoryReport(
+    JNIEnv* env, jobject) {
+  std::string report = tango_augmented_reality::GetMemoryReport();
+  return env->NewStringUTF(report.c_str());
+}
+
 JNIEXPORT void JNICALL
 Java_de_stetro_master_prototype_TangoJNINative_onTouchEvent(
     JNIEnv*, jobject, int touch_count, int event, float x0, float y0, float x1,
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <atomic>
+#include <cstdio>
+
+#include "tango-augmented-reality/memory_budget.h"
+
+namespace {
+    using tango_augmented_reality::MEMORY_SUBSYSTEM_COUNT;
+
+    const char *kSubsystemNames[MEMORY_SUBSYSTEM_COUNT] = {
+            "point buffers", "octree", "chisel chunks", "gpu buffers"
+    };
+
+    std::atomic <size_t> usage[MEMORY_SUBSYSTEM_COUNT];
+    // leaves room for the app and the Tango service on a device with 4 GB
+    const size_t kDefaultBudget = 512 * 1024 * 1024;
+
+    std::atomic <size_t> budget(kDefaultBudget);
+
+    float Megabytes(size_t bytes) {
+        return bytes / (1024.0f * 1024.0f);
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    void SetMemoryUsage(MemorySubsystem subsystem, size_t bytes) {
+        usage[subsystem].store(bytes, std::memory_order_relaxed);
+    }
+
+    size_t GetMemoryUsage(MemorySubsystem subsystem) {
+        return usage[subsystem].load(std::memory_order_relaxed);
+    }
+
+    size_t GetTotalMemoryUsage() {
+        size_t total = 0;
+        for (int i = 0; i < MEMORY_SUBSYSTEM_COUNT; ++i) {
+            total += usage[i].load(std::memory_order_relaxed);
+        }
+        return total;
+    }
+
+    void SetMemoryBudget(size_t bytes) {
+        budget.store(bytes, std::memory_order_relaxed);
+    }
+
+    size_t GetMemoryBudget() {
+        return budget.load(std::memory_order_relaxed);
+    }
+
+    bool IsOverMemoryBudget() {
+        size_t limit = GetMemoryBudget();
+        return limit > 0 && GetTotalMemoryUsage() > limit;
+    }
+
+    std::string GetMemoryReport() {
+        std::string report;
+        char line[96];
+        for (int i = 0; i < MEMORY_SUBSYSTEM_COUNT; ++i) {
+            snprintf(line, sizeof(line), "mem %-17s %8.2f MB\n", kSubsystemNames[i],
+                     Megabytes(GetMemoryUsage(static_cast<MemorySubsystem>(i))));
+            report += line;
+        }
+        snprintf(line, sizeof(line), "mem %-17s %8.2f MB of %.0f MB\n", "total",
+                 Megabytes(GetTotalMemoryUsage()), Megabytes(GetMemoryBudget()));
+        report += line;
+        return report;
+    }
+
+    const char *GetMemorySubsystemName(MemorySubsystem subsystem) {
+        return kSubsystemNames[subsystem];
+    }
+}  // namespace tango_augmented_reality
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <string>
+
+#include "tango-augmented-reality/occlusion_resolve.h"
+
+namespace {
+    const std::string kVertexShader =
+            "#version 300 es\n"
+                    "out vec2 uv;\n"
+                    "void main() {\n"
+                    "  uv = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2));\n"
+                    "  gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);\n"
+                    "}\n";
+
+    const std::string kFragmentShader =
+            "#version 300 es\n"
+                    "precision highp float;\n"
+                    "uniform highp sampler2D color;\n"
+                    "uniform highp sampler2D depth;\n"
+                    "in vec2 uv;\n"
+                    "out vec4 result;\n"
+                    "void main() {\n"
+                    "  gl_FragDepth = texture(depth, uv).r;\n"
+                    "  result = texture(color, uv);\n"
+                    "}\n";
+
+    void SetTexture(GLuint program, const char *name, int unit, GLuint texture) {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        glBindTexture(GL_TEXTURE_2D, texture);
+        glUniform1i(glGetUniformLocation(program, name), unit);
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    OcclusionResolve::OcclusionResolve() : available_(false), program_(0), color_texture_(0),
+                                           depth_texture_(0), frame_buffer_(0),
+                                           vertex_array_(0) { }
+
+    OcclusionResolve::~OcclusionResolve() { }
+
+    bool OcclusionResolve::Initialize(GLuint depth_texture, int width, int height) {
+        DeleteGlResources();
+        depth_texture_ = depth_texture;
+        program_ = tango_gl::util::CreateProgram(kVertexShader.c_str(),
+                                                 kFragmentShader.c_str());
+        if (!program_) {
+            LOGE("OcclusionResolve: could not create program.");
+        }
+        glGenVertexArrays(1, &vertex_array_);
+
+        // cleared to transparent, uncovered pixels keep the camera image
+        glGenTextures(1, &color_texture_);
+        glBindTexture(GL_TEXTURE_2D, color_texture_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE,
+                     NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &frame_buffer_);
+        glBindFramebuffer(GL_FRAMEBUFFER, frame_buffer_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D,
+                               color_texture_, 0);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D,
+                               depth_texture_, 0);
+        bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        if (!complete) {
+            LOGE("OcclusionResolve: ERROR in fb %d ", frame_buffer_);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        tango_gl::util::CheckGlError("OcclusionResolve::Initialize()");
+        available_ = complete && program_;
+        return available_;
+    }
+
+    void OcclusionResolve::Render(bool show_color) const {
+        GLboolean depth_test = glIsEnabled(GL_DEPTH_TEST);
+        GLint depth_func;
+        glGetIntegerv(GL_DEPTH_FUNC, &depth_func);
+
+        // the depth test is the only way to write depth
+        glEnable(GL_DEPTH_TEST);
+        glDepthFunc(GL_ALWAYS);
+        glDepthMask(GL_TRUE);
+        if (!show_color) {
+            glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+        }
+
+        glUseProgram(program_);
+        SetTexture(program_, "color", 0, color_texture_);
+        SetTexture(program_, "depth", 1, depth_texture_);
+        glBindVertexArray(vertex_array_);
+        glDrawArrays(GL_TRIANGLES, 0, 3);
+        glBindVertexArray(0);
+        glUseProgram(0);
+        glActiveTexture(GL_TEXTURE0);
+
+        glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+        glDepthFunc(depth_func);
+        if (!depth_test) {
+            glDisable(GL_DEPTH_TEST);
+        }
+        tango_gl::util::CheckGlError("OcclusionResolve::Render()");
+    }
+
+    void OcclusionResolve::DeleteGlResources() {
+        available_ = false;
+        if (program_) {
+            glDeleteProgram(program_);
+            program_ = 0;
+        }
+        if (color_texture_) {
+            glDeleteTextures(1, &color_texture_);
+            color_texture_ = 0;
+        }
+        if (frame_buffer_) {
+            glDeleteFramebuffers(1, &frame_buffer_);
+            frame_buffer_ = 0;
+        }
+        if (vertex_array_) {
+            glDeleteVertexArrays(1, &vertex_array_);
+            vertex_array_ = 0;
+        }
+    }
+
+}  // namespace tango_augmented_reality
@@ -17,6 +17,46 @@
 #include "tango-augmented-reality/plane_mesh.h"
 #include <tango-gl/shaders.h>
 
+#include "tango-augmented-reality/memory_budget.h"
+#include "tango-augmented-reality/profiler.h"
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace {
+    // out[i] = (vec4(xyz[i], 1) * matrix).xyz, four points at a time with NEON.
+    void TransformPoints(const glm::mat4 &matrix, const float *xyz, size_t count,
+                         glm::vec3 *out) {
+        // a row vector times matrix dots the point with each column
+        const float *m = glm::value_ptr(matrix);
+        float *result = &out[0].x;
+        size_t i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+        for (; i + 4 <= count; i += 4) {
+            float32x4x3_t p = vld3q_f32(xyz + i * 3);
+            float32x4x3_t r;
+            for (int column = 0; column < 3; ++column) {
+                const float *c = m + column * 4;
+                float32x4_t v = vdupq_n_f32(c[3]);
+                v = vmlaq_n_f32(v, p.val[0], c[0]);
+                v = vmlaq_n_f32(v, p.val[1], c[1]);
+                v = vmlaq_n_f32(v, p.val[2], c[2]);
+                r.val[column] = v;
+            }
+            vst3q_f32(result + i * 3, r);
+        }
+#endif
+        for (; i < count; ++i) {
+            const float *p = xyz + i * 3;
+            for (int column = 0; column < 3; ++column) {
+                const float *c = m + column * 4;
+                result[i * 3 + column] = c[0] * p[0] + c[1] * p[1] + c[2] * p[2] + c[3];
+            }
+        }
+    }
+}  // namespace
+
 namespace tango_augmented_reality {
 
     PlaneMesh::PlaneMesh() {
@@ -27,35 +67,63 @@ namespace tango_augmented_reality {
     }
 
     void PlaneMesh::addPoints(glm::mat4 transformation, std::vector <float> &vertices) {
-        int count = vertices.size() / 3;
-        for (int i = 0; i < count; ++i) {
-            glm::vec4 point(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2], 1);
-            point = point * transformation;
-            tree->addPoint(glm::vec3(point.x, point.y, point.z));
-        }
+        insertPoints(transformation, vertices);
         LOGE("got %d points into %d clusters", tree->getSize(), tree->getClusterCount());
+        LOGI("%d planes after merging", tree->getPlaneCount());
+        reconstruct();
+    }
+
+    void PlaneMesh::insertPoints(const glm::mat4 &transformation,
+                                 const std::vector <float> &vertices) {
+        size_t count = vertices.size() / 3;
+        transformed_points_.resize(count);
+        if (count == 0) {
+            return;
+        }
+        TransformPoints(transformation, vertices.data(), count, transformed_points_.data());
+        tree->addPoints(transformed_points_.data(), count);
+    }
+
+    void PlaneMesh::reconstruct() {
         tree->reconstruct();
     }
 
     void PlaneMesh::updateVertices() {
-        std::vector <GLfloat> mesh;
         std::vector <glm::vec3> reconstruction = tree->getMesh();
-        for (int i = 0; i < reconstruction.size(); ++i) {
-            mesh.push_back(reconstruction[i].x);
-            mesh.push_back(reconstruction[i].y);
-            mesh.push_back(reconstruction[i].z);
-        }
-        LOGI("Got %d polygons", mesh.size() / 9);
-        if (mesh.size() >= 0) {
-            std::lock_guard <std::mutex> lock(render_mutex);
-            SetVertices(mesh);
-        }
+        std::lock_guard <std::mutex> lock(render_mutex);
+        mesh_.SetTriangles(reconstruction);
+        LOGI("Got %d polygons with %d vertices", mesh_.GetTriangleCount(), mesh_.GetVertexCount());
+    }
+
+    bool PlaneMesh::raycast(const glm::vec3 &origin, const glm::vec3 &direction,
+                            float max_distance, RayHit *hit) {
+        std::lock_guard <std::mutex> lock(render_mutex);
+        hit->distance = max_distance;
+        return mesh_.RayCast(origin, direction, hit);
+    }
+
+    void PlaneMesh::reportMemory() {
+        size_t point_bytes;
+        size_t tree_bytes;
+        tree->getMemoryUsage(&point_bytes, &tree_bytes);
+        point_bytes += transformed_points_.capacity() * sizeof(glm::vec3);
+        SetMemoryUsage(MEMORY_POINT_BUFFERS, point_bytes);
+        SetMemoryUsage(MEMORY_OCTREE, tree_bytes);
+    }
+
+    void PlaneMesh::trimPoints() {
+        tree->trimPoints();
+        std::vector <glm::vec3>().swap(transformed_points_);
     }
 
     PlaneMesh::PlaneMesh(GLenum render_mode) {
         render_mode_ = render_mode;
     }
 
+    PlaneMesh::~PlaneMesh() {
+        mesh_.DeleteGlResources();
+    }
+
     void PlaneMesh::SetShader() {
         shader_program_ = tango_gl::util::CreateProgram(
                 tango_gl::shaders::GetBasicVertexShader().c_str(),
@@ -73,8 +141,7 @@ namespace tango_augmented_reality {
 
     void PlaneMesh::clear() {
         std::lock_guard <std::mutex> lock(render_mutex);
-        std::vector <GLfloat> mesh;
-        SetVertices(mesh);
+        mesh_.Clear();
         tree->clear();
     }
 
@@ -87,20 +154,11 @@ namespace tango_augmented_reality {
         glUniformMatrix4fv(uniform_mvp_mat_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
         glUniform4f(uniform_color_, red_, green_, blue_, alpha_);
 
-        glEnableVertexAttribArray(attrib_vertices_);
-
-        if (!indices_.empty()) {
-            glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                                  3 * sizeof(GLfloat), vertices_.data());
-            glDrawElements(render_mode_, indices_.size(), GL_UNSIGNED_SHORT,
-                           indices_.data());
-        } else {
-            glVertexAttribPointer(attrib_vertices_, 3, GL_FLOAT, GL_FALSE,
-                                  3 * sizeof(GLfloat), &vertices_[0]);
-            glDrawArrays(render_mode_, 0, vertices_.size() / 3);
-        }
+        CullStats stats;
+        mesh_.Render(attrib_vertices_, render_mode_, mvp_mat, &stats);
+        SetProfileCounter(PROFILE_DRAWN_BATCHES, stats.drawn);
+        SetProfileCounter(PROFILE_CULLED_BATCHES, stats.culled);
 
-        glDisableVertexAttribArray(attrib_vertices_);
         glUseProgram(0);
     }
 }  // namespace tango_augmented_reality
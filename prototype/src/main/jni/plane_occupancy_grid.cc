@@ -0,0 +1,173 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "tango-augmented-reality/plane_occupancy_grid.h"
+
+namespace {
+    // Inliers a cell needs to count as occupied, single stray points would
+    // otherwise fray the outline.
+    const uint16_t kMinCellPoints = 3;
+
+    uint64_t CellKey(int32_t x, int32_t y) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+    }
+
+    int32_t CellX(uint64_t key) {
+        return static_cast<int32_t>(static_cast<uint32_t>(key >> 32));
+    }
+
+    int32_t CellY(uint64_t key) {
+        return static_cast<int32_t>(static_cast<uint32_t>(key));
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    PlaneOccupancyGrid::PlaneOccupancyGrid(float cell_size) : cell_size_(cell_size) { }
+
+    bool PlaneOccupancyGrid::insert(const std::vector <glm::vec2> &points) {
+        bool changed = false;
+        for (const glm::vec2 &point : points) {
+            changed |= insert(point, 1);
+        }
+        return changed;
+    }
+
+    bool PlaneOccupancyGrid::insert(glm::vec2 point, int count) {
+        int32_t x = static_cast<int32_t>(std::floor(point.x / cell_size_));
+        int32_t y = static_cast<int32_t>(std::floor(point.y / cell_size_));
+        uint16_t &cell = cell_points_[CellKey(x, y)];
+        if (cell >= kMinCellPoints) {
+            return false;
+        }
+        // counting stops at the threshold, more points change nothing
+        cell = std::min<int>(cell + count, kMinCellPoints);
+        if (cell < kMinCellPoints) {
+            return false;
+        }
+        if (occupied_count_ == 0) {
+            min_x_ = max_x_ = x;
+            min_y_ = max_y_ = y;
+        } else {
+            min_x_ = std::min(min_x_, x);
+            min_y_ = std::min(min_y_, y);
+            max_x_ = std::max(max_x_, x);
+            max_y_ = std::max(max_y_, y);
+        }
+        ++occupied_count_;
+        return true;
+    }
+
+    void PlaneOccupancyGrid::getCells(std::vector <glm::vec2> *centers,
+                                      std::vector <int> *counts) const {
+        centers->clear();
+        counts->clear();
+        for (const auto &cell : cell_points_) {
+            centers->push_back(glm::vec2((CellX(cell.first) + 0.5f) * cell_size_,
+                                         (CellY(cell.first) + 0.5f) * cell_size_));
+            counts->push_back(cell.second);
+        }
+    }
+
+    void PlaneOccupancyGrid::coverCells(int level, std::vector <Rectangle> *rectangles) const {
+        int width = ((max_x_ - min_x_) >> level) + 1;
+        int height = ((max_y_ - min_y_) >> level) + 1;
+        std::vector <uint8_t> occupied(width * height, 0);
+        for (const auto &cell : cell_points_) {
+            if (cell.second >= kMinCellPoints) {
+                int x = (CellX(cell.first) - min_x_) >> level;
+                int y = (CellY(cell.first) - min_y_) >> level;
+                occupied[y * width + x] = 1;
+            }
+        }
+
+        // grow each free occupied cell right, then the whole run upwards, and
+        // mark what the rectangle covers
+        rectangles->clear();
+        for (int y = 0; y < height; ++y) {
+            for (int x = 0; x < width; ++x) {
+                if (occupied[y * width + x] != 1) {
+                    continue;
+                }
+                int right = x + 1;
+                while (right < width && occupied[y * width + right] == 1) {
+                    ++right;
+                }
+                int top = y + 1;
+                while (top < height &&
+                       std::all_of(&occupied[top * width + x], &occupied[top * width + right],
+                                   [](uint8_t cell) { return cell == 1; })) {
+                    ++top;
+                }
+                for (int row = y; row < top; ++row) {
+                    std::fill(&occupied[row * width + x], &occupied[row * width + right], 2);
+                }
+                Rectangle rectangle = {x, y, right - x, top - y};
+                rectangles->push_back(rectangle);
+            }
+        }
+    }
+
+    void PlaneOccupancyGrid::triangulate(int vertex_budget,
+                                         std::vector <glm::vec2> *triangles) const {
+        triangles->clear();
+        if (occupied_count_ == 0) {
+            return;
+        }
+        int level = 0;
+        std::vector <Rectangle> rectangles;
+        while (true) {
+            coverCells(level, &rectangles);
+            bool single_cell = ((max_x_ - min_x_) >> level) == 0 &&
+                               ((max_y_ - min_y_) >> level) == 0;
+            if (4 * static_cast<int>(rectangles.size()) <= vertex_budget || single_cell) {
+                break;
+            }
+            ++level;
+        }
+
+        float merged_size = cell_size_ * (1 << level);
+        for (const Rectangle &rectangle : rectangles) {
+            float x0 = min_x_ * cell_size_ + rectangle.x * merged_size;
+            float y0 = min_y_ * cell_size_ + rectangle.y * merged_size;
+            float x1 = x0 + rectangle.width * merged_size;
+            float y1 = y0 + rectangle.height * merged_size;
+            triangles->push_back(glm::vec2(x0, y0));
+            triangles->push_back(glm::vec2(x1, y0));
+            triangles->push_back(glm::vec2(x1, y1));
+            triangles->push_back(glm::vec2(x0, y0));
+            triangles->push_back(glm::vec2(x1, y1));
+            triangles->push_back(glm::vec2(x0, y1));
+        }
+    }
+
+    size_t PlaneOccupancyGrid::getBytes() const {
+        // a hash node with its next pointer per cell, and the buckets
+        size_t node = sizeof(std::pair <const uint64_t, uint16_t>) + 2 * sizeof(void *);
+        return cell_points_.size() * node + cell_points_.bucket_count() * sizeof(void *);
+    }
+
+    void PlaneOccupancyGrid::clear() {
+        cell_points_.clear();
+        occupied_count_ = 0;
+        min_x_ = min_y_ = 0;
+        max_x_ = max_y_ = -1;
+    }
+}  // namespace tango_augmented_reality
@@ -0,0 +1,210 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#include "tango-augmented-reality/plane_ransac.h"
+#include "tango-augmented-reality/thread_pool.h"
+
+namespace {
+    // Points scored in the first preemptive round, doubled every round.
+    const size_t kPreemptiveFirstBlock = 128;
+
+    // Smallest subset the adaptive stop trusts.
+    const size_t kPreemptiveMinSample = 512;
+    // Draws three distinct point indices, false if the points are degenerate.
+    bool PickSample(std::minstd_rand *random, size_t count, const glm::vec3 *points,
+                    glm::vec3 *normal, float *distance) {
+        std::uniform_int_distribution<size_t> index(0, count - 1);
+        size_t i0 = index(*random);
+        size_t i1;
+        size_t i2;
+        do { i1 = index(*random); } while (i1 == i0);
+        do { i2 = index(*random); } while (i2 == i0 || i2 == i1);
+
+        glm::vec3 cross = glm::cross(points[i1] - points[i0], points[i2] - points[i0]);
+        float length = glm::length(cross);
+        if (length <= 0.0f) {
+            return false;
+        }
+        *normal = cross / length;
+        *distance = glm::dot(points[i0], *normal);
+        return true;
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    int CountPlaneSupport(const glm::vec3 &normal, float distance, float threshold,
+                          const glm::vec3 *points, size_t count) {
+        const float *xyz = &points[0].x;
+        size_t i = 0;
+        int support = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+        float32x4_t nx = vdupq_n_f32(normal.x);
+        float32x4_t ny = vdupq_n_f32(normal.y);
+        float32x4_t nz = vdupq_n_f32(normal.z);
+        float32x4_t offset = vdupq_n_f32(-distance);
+        float32x4_t limit = vdupq_n_f32(threshold);
+        uint32x4_t counter = vdupq_n_u32(0);
+        for (; i + 4 <= count; i += 4) {
+            float32x4x3_t p = vld3q_f32(xyz + i * 3);
+            float32x4_t d = vmlaq_f32(offset, nx, p.val[0]);
+            d = vmlaq_f32(d, ny, p.val[1]);
+            d = vmlaq_f32(d, nz, p.val[2]);
+            d = vabsq_f32(d);
+            // a true lane is all ones, subtracting it adds one
+            counter = vsubq_u32(counter, vcltq_f32(d, limit));
+        }
+        uint32x2_t sum = vadd_u32(vget_low_u32(counter), vget_high_u32(counter));
+        support = vget_lane_u32(vpadd_u32(sum, sum), 0);
+#endif
+        for (; i < count; ++i) {
+            float d = normal.x * xyz[i * 3] + normal.y * xyz[i * 3 + 1] +
+                      normal.z * xyz[i * 3 + 2] - distance;
+            if (std::abs(d) < threshold) {
+                ++support;
+            }
+        }
+        return support;
+    }
+
+    void ComputePlaneDistances(const glm::vec3 &normal, float distance,
+                               const glm::vec3 *points, size_t count, float *distances) {
+        const float *xyz = &points[0].x;
+        size_t i = 0;
+#if defined(__ARM_NEON__) || defined(__ARM_NEON)
+        float32x4_t nx = vdupq_n_f32(normal.x);
+        float32x4_t ny = vdupq_n_f32(normal.y);
+        float32x4_t nz = vdupq_n_f32(normal.z);
+        float32x4_t offset = vdupq_n_f32(-distance);
+        for (; i + 4 <= count; i += 4) {
+            float32x4x3_t p = vld3q_f32(xyz + i * 3);
+            float32x4_t d = vmlaq_f32(offset, nx, p.val[0]);
+            d = vmlaq_f32(d, ny, p.val[1]);
+            d = vmlaq_f32(d, nz, p.val[2]);
+            vst1q_f32(distances + i, d);
+        }
+#endif
+        for (; i < count; ++i) {
+            distances[i] = normal.x * xyz[i * 3] + normal.y * xyz[i * 3 + 1] +
+                           normal.z * xyz[i * 3 + 2] - distance;
+        }
+    }
+
+    PlaneHypothesis DetectPlaneRansac(const std::vector <glm::vec3> &points, int iterations,
+                                      float threshold, int sufficient_support, uint32_t seed) {
+        PlaneHypothesis best;
+        if (points.size() < 3) {
+            return best;
+        }
+        ThreadPool &pool = ThreadPool::Shared();
+        int batch_size = pool.GetConcurrency();
+        std::vector <PlaneHypothesis> batch(batch_size);
+
+        for (int first = 0; first < iterations; first += batch_size) {
+            int batch_count = std::min(batch_size, iterations - first);
+            pool.ParallelFor(batch_count, [&](int i) {
+                std::minstd_rand random(seed * 2654435761u + first + i + 1);
+                PlaneHypothesis &hypothesis = batch[i];
+                hypothesis.support = -1;
+                if (PickSample(&random, points.size(), points.data(), &hypothesis.normal,
+                               &hypothesis.distance)) {
+                    hypothesis.support = CountPlaneSupport(hypothesis.normal,
+                                                           hypothesis.distance, threshold,
+                                                           points.data(), points.size());
+                }
+            });
+            // in hypothesis order, so ties resolve the same as a serial search
+            for (int i = 0; i < batch_count; ++i) {
+                if (batch[i].support > best.support) {
+                    best = batch[i];
+                }
+            }
+            if (best.support >= sufficient_support) {
+                break;
+            }
+        }
+        return best;
+    }
+
+    PlaneHypothesis DetectPlanePreemptive(const std::vector <glm::vec3> &points, int hypotheses,
+                                          float threshold, int sufficient_support,
+                                          uint32_t seed) {
+        PlaneHypothesis best;
+        size_t count = points.size();
+        if (count < 3 || hypotheses <= 0) {
+            return best;
+        }
+        std::minstd_rand random(seed * 2654435761u + 1);
+
+        std::vector <PlaneHypothesis> candidates;
+        for (int i = 0; i < hypotheses; ++i) {
+            PlaneHypothesis hypothesis;
+            if (PickSample(&random, count, points.data(), &hypothesis.normal,
+                           &hypothesis.distance)) {
+                hypothesis.support = 0;
+                candidates.push_back(hypothesis);
+            }
+        }
+        if (candidates.empty()) {
+            return best;
+        }
+
+        // the random subset is a prefix of sample, shuffled in as far as needed
+        std::vector <glm::vec3> sample(points);
+        size_t begin = 0;
+        size_t block = kPreemptiveFirstBlock;
+        float sufficient_ratio = static_cast<float>(sufficient_support) / count;
+        ThreadPool &pool = ThreadPool::Shared();
+
+        while (true) {
+            size_t end = std::min(count, begin + block);
+            for (size_t i = begin; i < end; ++i) {
+                std::uniform_int_distribution<size_t> pick(i, count - 1);
+                std::swap(sample[i], sample[pick(random)]);
+            }
+            pool.ParallelFor(candidates.size(), [&](int i) {
+                PlaneHypothesis &hypothesis = candidates[i];
+                hypothesis.support += CountPlaneSupport(hypothesis.normal, hypothesis.distance,
+                                                        threshold, &sample[begin], end - begin);
+            });
+            begin = end;
+
+            std::stable_sort(candidates.begin(), candidates.end(),
+                             [](const PlaneHypothesis &a, const PlaneHypothesis &b) {
+                                 return a.support > b.support;
+                             });
+            bool sufficient = end >= kPreemptiveMinSample &&
+                              candidates[0].support >= sufficient_ratio * end;
+            if (sufficient || end == count || candidates.size() == 1) {
+                break;
+            }
+            candidates.resize(candidates.size() / 2);
+            block *= 2;
+        }
+
+        best = candidates[0];
+        best.support = static_cast<int>(static_cast<double>(best.support) * count / begin);
+        return best;
+    }
+}  // namespace tango_augmented_reality
@@ -0,0 +1,187 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "tango-augmented-reality/plane_registry.h"
+
+namespace tango_augmented_reality {
+
+    int PlaneRegistry::find(int id) {
+        while (parents_[id] != id) {
+            // halve the path on the way up
+            parents_[id] = parents_[parents_[id]];
+            id = parents_[id];
+        }
+        return id;
+    }
+
+    bool PlaneRegistry::isCompatible(const Plane &shared_plane, const Plane &plane) const {
+        if (std::abs(glm::dot(shared_plane.normal, plane.normal)) < merge_normal_cos ||
+            plane.point_count == 0) {
+            return false;
+        }
+        Eigen::Vector3d centroid = plane.point_sum / plane.point_count;
+        glm::vec3 point(centroid.x(), centroid.y(), centroid.z());
+        return std::abs(shared_plane.distanceTo(point)) < merge_distance;
+    }
+
+    void PlaneRegistry::update(uint64_t leaf_key, const std::vector <uint64_t> &neighbour_keys,
+                               Reconstructor *reconstructor) {
+        for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+            if (!reconstructor->isPlaneAvailable(i)) {
+                continue;
+            }
+            Plane &plane = reconstructor->getPlane(i);
+            if (plane.shared_id < 0) {
+                // shared planes of the neighbourhood this plane fits into
+                std::vector <int> candidates;
+                for (uint64_t key : neighbour_keys) {
+                    auto leaf = leaf_planes_.find(key);
+                    if (leaf == leaf_planes_.end()) {
+                        continue;
+                    }
+                    for (int id : leaf->second) {
+                        id = find(id);
+                        if (std::find(candidates.begin(), candidates.end(), id) ==
+                            candidates.end() && isCompatible(planes_[id], plane)) {
+                            candidates.push_back(id);
+                        }
+                    }
+                }
+
+                int id;
+                if (candidates.empty()) {
+                    id = planes_.size();
+                    planes_.push_back(Plane(plane.normal, plane.distance));
+                    parents_.push_back(id);
+                    changed_.push_back(false);
+                    ++plane_count_;
+                } else {
+                    // the largest plane absorbs the others, it moves the least
+                    id = *std::max_element(candidates.begin(), candidates.end(),
+                                           [this](int a, int b) {
+                                               return planes_[a].point_count <
+                                                      planes_[b].point_count;
+                                           });
+                    for (int other : candidates) {
+                        if (other != id) {
+                            merge(id, other);
+                        }
+                    }
+                }
+                plane.shared_id = id;
+                leaf_planes_[leaf_key].push_back(id);
+            }
+
+            if (plane.last_inliers.empty()) {
+                continue;
+            }
+            Plane &shared_plane = planes_[find(plane.shared_id)];
+            bool changed = false;
+            std::vector <glm::vec2> projection;
+            projection.reserve(plane.last_inliers.size());
+            bool occupancy_changed = false;
+            for (const PlaneSample &sample : plane.last_inliers) {
+                shared_plane.addToFit(sample.point, sample.count);
+                projection.push_back(shared_plane.toPlane(sample.point));
+                occupancy_changed |= shared_plane.occupancy.insert(projection.back(),
+                                                                   sample.count);
+            }
+            changed |= shared_plane.hull.insert(projection) && !mesh_occupancy_grid;
+            changed |= occupancy_changed && mesh_occupancy_grid;
+            plane.last_inliers.clear();
+            if (changed) {
+                changed_[find(plane.shared_id)] = true;
+            }
+        }
+    }
+
+    void PlaneRegistry::merge(int target, int source) {
+        Plane &to = planes_[target];
+        Plane &from = planes_[source];
+        to.point_count += from.point_count;
+        to.point_sum += from.point_sum;
+        to.scatter += from.scatter;
+
+        // outlines go over 3d into the projection frame of target
+        std::vector <glm::vec2> vertices;
+        for (const glm::vec2 &vertex : from.hull.getVertices()) {
+            vertices.push_back(to.toPlane(from.fromPlane(vertex)));
+        }
+        to.hull.insert(vertices);
+        std::vector <glm::vec2> centers;
+        std::vector <int> counts;
+        from.occupancy.getCells(&centers, &counts);
+        for (int i = 0; i < centers.size(); ++i) {
+            to.occupancy.insert(to.toPlane(from.fromPlane(centers[i])), counts[i]);
+        }
+
+        from = Plane();
+        parents_[source] = target;
+        changed_[target] = true;
+        changed_[source] = false;
+        // its triangles have to leave the merged mesh
+        mesh_changed_ = true;
+        --plane_count_;
+    }
+
+    void PlaneRegistry::updateMeshes() {
+        for (int id = 0; id < planes_.size(); ++id) {
+            if (!changed_[id]) {
+                continue;
+            }
+            planes_[id].refit();
+            planes_[id].updateMesh(mesh_occupancy_grid, mesh_vertex_budget);
+            changed_[id] = false;
+            mesh_changed_ = true;
+        }
+        if (!mesh_changed_) {
+            return;
+        }
+        mesh_.clear();
+        for (int id = 0; id < planes_.size(); ++id) {
+            if (parents_[id] == id) {
+                mesh_.insert(mesh_.end(), planes_[id].mesh.begin(), planes_[id].mesh.end());
+            }
+        }
+        mesh_changed_ = false;
+    }
+
+    size_t PlaneRegistry::getBytes() const {
+        size_t bytes = planes_.capacity() * sizeof(Plane) + mesh_.capacity() * sizeof(glm::vec3) +
+                       parents_.capacity() * sizeof(int);
+        for (const Plane &plane : planes_) {
+            bytes += plane.getPointBytes() + plane.getOutlineBytes();
+        }
+        for (const std::pair <const uint64_t, std::vector <int>> &leaf : leaf_planes_) {
+            bytes += sizeof(leaf) + 2 * sizeof(void *) + leaf.second.capacity() * sizeof(int);
+        }
+        return bytes;
+    }
+
+    void PlaneRegistry::clear() {
+        planes_.clear();
+        parents_.clear();
+        changed_.clear();
+        leaf_planes_.clear();
+        mesh_.clear();
+        mesh_changed_ = false;
+        plane_count_ = 0;
+    }
+}  // namespace tango_augmented_reality
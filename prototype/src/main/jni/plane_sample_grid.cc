@@ -0,0 +1,77 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <cmath>
+
+#include "tango-augmented-reality/plane_sample_grid.h"
+
+namespace {
+    uint64_t CellKey(int32_t x, int32_t y) {
+        return static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32 | static_cast<uint32_t>(y);
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    PlaneSampleGrid::PlaneSampleGrid(float cell_size, size_t capacity) :
+            cell_size_(cell_size),
+            capacity_(capacity) { }
+
+    void PlaneSampleGrid::insert(const glm::vec3 &point, glm::vec2 projection) {
+        int32_t x = static_cast<int32_t>(std::floor(projection.x / cell_size_));
+        int32_t y = static_cast<int32_t>(std::floor(projection.y / cell_size_));
+        auto cell = cells_.find(CellKey(x, y));
+        if (cell == cells_.end()) {
+            if (samples_.size() >= capacity_) {
+                return;
+            }
+            cells_.insert(std::make_pair(CellKey(x, y), static_cast<uint32_t>(samples_.size())));
+            PlaneSample sample = {point, projection, 1};
+            samples_.push_back(sample);
+            return;
+        }
+        // reservoir of one: the n-th inlier of a cell replaces its sample with
+        // probability 1 / n
+        PlaneSample &sample = samples_[cell->second];
+        ++sample.count;
+        random_ ^= random_ << 13;
+        random_ ^= random_ >> 17;
+        random_ ^= random_ << 5;
+        if (random_ % static_cast<uint32_t>(sample.count) == 0) {
+            sample.point = point;
+            sample.projection = projection;
+        }
+    }
+
+    void PlaneSampleGrid::take(std::vector <PlaneSample> *samples) {
+        samples->clear();
+        samples->swap(samples_);
+        cells_.clear();
+    }
+
+    void PlaneSampleGrid::clear() {
+        samples_.clear();
+        cells_.clear();
+    }
+
+    size_t PlaneSampleGrid::getBytes() const {
+        // a hash node with its next pointer per cell, and the buckets
+        size_t node = sizeof(std::pair <const uint64_t, uint32_t>) + 2 * sizeof(void *);
+        return samples_.capacity() * sizeof(PlaneSample) + cells_.size() * node +
+               cells_.bucket_count() * sizeof(void *);
+    }
+}  // namespace tango_augmented_reality
@@ -14,6 +14,8 @@
  * limitations under the License.
  */
 
+#include <algorithm>
+#include <cstring>
 #include <sstream>
 
 #include "tango-augmented-reality/point_cloud_drawable.h"
@@ -25,13 +27,14 @@ namespace {
                     "attribute vec4 vertex;\n"
                     "uniform bool visible;\n"
                     "uniform mat4 mvp;\n"
+                    "uniform float point_size;\n"
                     "varying vec4 v_color;\n"
                     "void main() {\n"
                     "  gl_Position = mvp*vertex;\n"
                     "  v_color = vec4(0.0,0.0,0.0,0.0);\n"
 //                    "if(visible){ v_color = vec4(vertex.z / 4.5,vertex.z / 4.5,vertex.z / 4.5,1.0);}\n" // grayscale
                     "if(visible){v_color = vertex;}\n" // colored
-                    " gl_PointSize = 7.0;\n"
+                    " gl_PointSize = point_size;\n"
                     "}\n";
     const std::string kPointCloudFragmentShader =
             "precision mediump float;\n"
@@ -41,6 +44,17 @@ namespace {
                     "  gl_FragColor = vec4(v_color);\n"
                     "}\n";
 
+    // Initial buffer size, one Tango depth frame holds up to about 15k points.
+    const size_t kInitialBufferFloats = 20000 * 3;
+
+    // pixels per point for the newest frame alone, and when frames are fused
+    const float kSinglePointSize = 7.0f;
+    const float kFusedPointSize = 3.0f;
+
+    // frames older than this behind the newest one are not drawn, the scene
+    // may have changed since
+    const double kMaxFrameAge = 1.0;
+
 }  // namespace
 
 namespace tango_augmented_reality {
@@ -51,44 +65,89 @@ namespace tango_augmented_reality {
 
         mvp_handle_ = glGetUniformLocation(shader_program_, "mvp");
         vertices_visible_handle_ = glGetUniformLocation(shader_program_, "visible");
+        point_size_handle_ = glGetUniformLocation(shader_program_, "point_size");
 
         vertices_handle_ = glGetAttribLocation(shader_program_, "vertex");
-        glGenBuffers(1, &vertex_buffers_);
+        glGenBuffers(kBufferCount, vertex_buffers_);
+        for (int i = 0; i < kBufferCount; ++i) {
+            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[i]);
+            glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * kInitialBufferFloats, nullptr,
+                         GL_STREAM_DRAW);
+            buffer_capacity_[i] = kInitialBufferFloats;
+            point_count_[i] = 0;
+            timestamp_[i] = 0.0;
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        current_buffer_ = 0;
     }
 
     void PointCloudDrawable::DeleteGlResources() {
-        if (vertex_buffers_) {
-            glDeleteBuffers(1, &vertex_buffers_);
+        if (vertex_buffers_[0]) {
+            glDeleteBuffers(kBufferCount, vertex_buffers_);
+            vertex_buffers_[0] = 0;
         }
         if (shader_program_) {
             glDeleteShader(shader_program_);
         }
     }
 
-    void PointCloudDrawable::Render(glm::mat4 projection_mat, glm::mat4 view_mat,
-                                    glm::mat4 model_mat,
-                                    const std::vector <float> &vertices) {
+    void PointCloudDrawable::UpdateVertices(const std::vector <float> &vertices,
+                                            const glm::mat4 &model_mat, double timestamp) {
+        int next_buffer = (current_buffer_ + 1) % kBufferCount;
+        size_t size = sizeof(GLfloat) * vertices.size();
+        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[next_buffer]);
+        if (vertices.size() > buffer_capacity_[next_buffer]) {
+            // only grows, later frames of the same size reuse the storage
+            glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+            buffer_capacity_[next_buffer] = vertices.size();
+        }
+        if (size > 0) {
+            void *mapped = glMapBufferRange(GL_ARRAY_BUFFER, 0, size,
+                                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+            if (mapped != nullptr) {
+                memcpy(mapped, vertices.data(), size);
+                glUnmapBuffer(GL_ARRAY_BUFFER);
+            } else {
+                glBufferSubData(GL_ARRAY_BUFFER, 0, size, vertices.data());
+            }
+        }
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        current_buffer_ = next_buffer;
+        point_count_[next_buffer] = vertices.size() / 3;
+        model_mat_[next_buffer] = model_mat;
+        timestamp_[next_buffer] = timestamp;
+    }
+
+    void PointCloudDrawable::Render(glm::mat4 projection_mat, glm::mat4 view_mat) {
+        if (point_count_[current_buffer_] == 0) {
+            return;
+        }
         glUseProgram(shader_program_);
-        vertices_visible_handle_ = glGetUniformLocation(shader_program_, "visible");
         if (visible) {
             glUniform1i(vertices_visible_handle_, GL_TRUE);
         } else {
             glUniform1i(vertices_visible_handle_, GL_FALSE);
         }
-
-        mvp_handle_ = glGetUniformLocation(shader_program_, "mvp");
-        // Calculate model view projection matrix.
-        glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;
-        glUniformMatrix4fv(mvp_handle_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
-
-        glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_);
-        glBufferData(GL_ARRAY_BUFFER, sizeof(GLfloat) * vertices.size(),
-                     vertices.data(), GL_STATIC_DRAW);
+        glUniform1f(point_size_handle_, fused_frames_ > 1 ? kFusedPointSize : kSinglePointSize);
         glEnableVertexAttribArray(vertices_handle_);
-        glVertexAttribPointer(vertices_handle_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
-        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-        glDrawArrays(GL_POINTS, 0, vertices.size() / 3);
+        // every frame with its own pose into the current view, newest first
+        glm::mat4 view_projection_mat = projection_mat * view_mat;
+        double newest = timestamp_[current_buffer_];
+        for (int i = 0; i < fused_frames_; ++i) {
+            int buffer = (current_buffer_ + kBufferCount - i) % kBufferCount;
+            if (point_count_[buffer] == 0 || newest - timestamp_[buffer] > kMaxFrameAge) {
+                break;
+            }
+            glm::mat4 mvp_mat = view_projection_mat * model_mat_[buffer];
+            glUniformMatrix4fv(mvp_handle_, 1, GL_FALSE, glm::value_ptr(mvp_mat));
+
+            glBindBuffer(GL_ARRAY_BUFFER, vertex_buffers_[buffer]);
+            glVertexAttribPointer(vertices_handle_, 3, GL_FLOAT, GL_FALSE, 0, nullptr);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+            glDrawArrays(GL_POINTS, 0, point_count_[buffer]);
+        }
 
         glUseProgram(0);
         tango_gl::util::CheckGlError("Pointcloud::Render()");
@@ -98,4 +157,8 @@ namespace tango_augmented_reality {
         visible = _visible;
     }
 
+    void PointCloudDrawable::SetFusedFrames(int count) {
+        fused_frames_ = std::max(1, std::min(count, static_cast<int>(kMaxFusedFrames)));
+    }
+
 }  // namespace tango-augmented-reality
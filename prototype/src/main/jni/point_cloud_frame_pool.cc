@@ -0,0 +1,36 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "tango-augmented-reality/point_cloud_frame_pool.h"
+
+namespace tango_augmented_reality {
+
+    PointCloudFramePool::PointCloudFramePool(size_t max_points) {
+        for (int i = 0; i < TripleBuffer<PointCloudFrame>::kSlotCount; ++i) {
+            PointCloudFrame &frame = frames_.Slot(i);
+            frame.vertices.reserve(max_points * 3);
+            frame.XYZij = TangoXYZij();
+            frame.XYZij.xyz = reinterpret_cast<float (*)[3]>(frame.vertices.data());
+            frame.transformation = glm::mat4(1.0f);
+        }
+    }
+
+    void PointCloudFramePool::SetPointCount(PointCloudFrame *frame, size_t point_count) {
+        frame->vertices.resize(point_count * 3);
+        frame->XYZij.xyz = reinterpret_cast<float (*)[3]>(frame->vertices.data());
+        frame->XYZij.xyz_count = point_count;
+    }
+}  // namespace tango_augmented_reality
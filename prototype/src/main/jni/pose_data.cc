@@ -24,7 +24,10 @@ namespace {
 
 namespace tango_augmented_reality {
 
-    PoseData::PoseData() { }
+    PoseData::PoseData() :
+            opengl_world_T_tango_world_(tango_gl::conversions::opengl_world_T_tango_world()) {
+        UpdateCameraFrames();
+    }
 
     PoseData::~PoseData() { }
 
@@ -65,9 +68,7 @@ namespace tango_augmented_reality {
         //   https://developers.google.com/project-tango/overview/frames-of-reference
         // Coordinate System Conventions:
         //   https://developers.google.com/project-tango/overview/coordinate-systems
-        return tango_gl::conversions::opengl_world_T_tango_world() * pose_matrix *
-               glm::inverse(GetImuTDevice()) * GetImuTColorCamera() *
-               tango_gl::conversions::color_camera_T_opengl_camera();
+        return opengl_world_T_tango_world_ * pose_matrix * device_T_opengl_color_camera_;
     }
 
     glm::mat4 PoseData::GetMatrixFromPose(const TangoPoseData &pose) {
@@ -88,17 +89,22 @@ namespace tango_augmented_reality {
     }
 
     glm::mat4 PoseData::GetExtrinsicsAppliedOpenGLWorldDepthCameraFrame(const glm::mat4 &pose_matrix){
+        return opengl_world_T_tango_world_ * pose_matrix * device_T_opengl_depth_camera_;
+    }
+
+    void PoseData::UpdateCameraFrames() {
         glm::mat4 invertYandZMatrix = glm::mat4(
                     1.0f, 0.0f, 0.0f, 0.0f,
                     0.0f, -1.0f, 0.0f, 0.0f,
                     0.0f, 0.0f, -1.0f, 0.0f,
                     0.0f, 0.0f, 0.0f, 1.0f);
 
-        glm::mat4 mDeviceTDepthCamera = glm::inverse(imu_T_device_) * imu_T_depth_camera_;
-
-        glm::mat4 openglTDevice = tango_gl::conversions::opengl_world_T_tango_world() * pose_matrix;
-        glm::mat4 openglWorldTOpenglCamera = openglTDevice * mDeviceTDepthCamera * tango_gl::conversions::depth_camera_T_opengl_camera() * invertYandZMatrix;
-        return openglWorldTOpenglCamera;
+        glm::mat4 device_T_imu = glm::inverse(imu_T_device_);
+        device_T_opengl_color_camera_ = device_T_imu * imu_T_color_camera_ *
+                                        tango_gl::conversions::color_camera_T_opengl_camera();
+        device_T_opengl_depth_camera_ = device_T_imu * imu_T_depth_camera_ *
+                                        tango_gl::conversions::depth_camera_T_opengl_camera() *
+                                        invertYandZMatrix;
     }
 
     std::string PoseData::GetStringFromStatusCode(TangoPoseStatusType status) {
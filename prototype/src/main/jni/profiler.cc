@@ -0,0 +1,297 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "tango-augmented-reality/profiler.h"
+
+// EXT_disjoint_timer_query, the queries themselves are core GLES3
+#ifndef GL_TIME_ELAPSED_EXT
+#define GL_TIME_ELAPSED_EXT 0x88BF
+#endif
+#ifndef GL_GPU_DISJOINT_EXT
+#define GL_GPU_DISJOINT_EXT 0x8FBB
+#endif
+
+namespace {
+    using tango_augmented_reality::ProfileStage;
+    using tango_augmented_reality::PROFILE_STAGE_COUNT;
+
+    // samples per stage the percentiles roll over
+    const int kProfileWindow = 128;
+
+    // threads alive at the same time beyond this many record nothing
+    const int kMaxProfiledThreads = 8;
+
+    // CPU stages followed by GPU stages
+    const int kSampleKinds = 2 * PROFILE_STAGE_COUNT;
+
+    const char *kStageNames[PROFILE_STAGE_COUNT] = {
+            "frame", "yuv convert", "texture upload", "occlusion draw", "fbo pass",
+            "readback", "filter", "depth preview", "integrate", "chisel add points",
+            "chisel mesh", "reconstruct", "tsdf raycast"
+    };
+
+    const char *kCounterNames[tango_augmented_reality::PROFILE_COUNTER_COUNT] = {
+            "drawn batches", "culled batches"
+    };
+
+    std::atomic <int> counters[tango_augmented_reality::PROFILE_COUNTER_COUNT];
+
+    // Written only by the thread that claimed it, count is published after
+    // the sample. A slot goes back when its thread exits, so the worker and GL
+    // threads recreated on every pause and resume do not run out of slots, and
+    // the stats never mix in the window of a dead thread.
+    struct ThreadProfile {
+        std::atomic <bool> in_use;
+        std::atomic <uint32_t> samples[kSampleKinds][kProfileWindow];
+        std::atomic <uint32_t> counts[kSampleKinds];
+    };
+
+    ThreadProfile profiles[kMaxProfiledThreads];
+
+    // gnustl has no thread_local, a POD __thread pointer is enough
+    __thread ThreadProfile *thread_profile = nullptr;
+
+    pthread_key_t release_key;
+    pthread_once_t release_key_once = PTHREAD_ONCE_INIT;
+
+    void ReleaseThreadProfile(void *value) {
+        static_cast<ThreadProfile *>(value)->in_use.store(false, std::memory_order_release);
+    }
+
+    void CreateReleaseKey() {
+        pthread_key_create(&release_key, ReleaseThreadProfile);
+    }
+
+    ThreadProfile *ClaimThreadProfile() {
+        if (thread_profile != nullptr) {
+            return thread_profile;
+        }
+        pthread_once(&release_key_once, CreateReleaseKey);
+        for (int i = 0; i < kMaxProfiledThreads; ++i) {
+            bool in_use = false;
+            if (!profiles[i].in_use.compare_exchange_strong(in_use, true)) {
+                continue;
+            }
+            // the window of the previous owner starts over
+            for (int kind = 0; kind < kSampleKinds; ++kind) {
+                profiles[i].counts[kind].store(0, std::memory_order_release);
+            }
+            thread_profile = &profiles[i];
+            pthread_setspecific(release_key, thread_profile);
+            break;
+        }
+        return thread_profile;
+    }
+
+    float Percentile(const std::vector <uint32_t> &sorted, float fraction) {
+        size_t index = static_cast<size_t>(fraction * (sorted.size() - 1) + 0.5f);
+        return sorted[index] / 1000.0f;
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    void RecordProfileSample(ProfileStage stage, uint32_t microseconds, bool gpu) {
+        ThreadProfile *profile = ClaimThreadProfile();
+        if (profile == nullptr) {
+            return;
+        }
+        int kind = stage + (gpu ? PROFILE_STAGE_COUNT : 0);
+        uint32_t count = profile->counts[kind].load(std::memory_order_relaxed);
+        profile->samples[kind][count % kProfileWindow].store(microseconds,
+                                                             std::memory_order_relaxed);
+        profile->counts[kind].store(count + 1, std::memory_order_release);
+    }
+
+    bool GetProfileStats(ProfileStage stage, bool gpu, ProfileStats *stats) {
+        int kind = stage + (gpu ? PROFILE_STAGE_COUNT : 0);
+        std::vector <uint32_t> samples;
+        uint32_t total = 0;
+        for (int t = 0; t < kMaxProfiledThreads; ++t) {
+            if (!profiles[t].in_use.load(std::memory_order_acquire)) {
+                continue;
+            }
+            uint32_t count = profiles[t].counts[kind].load(std::memory_order_acquire);
+            total += count;
+            // a sample overwritten while copying only shifts the window
+            uint32_t available = std::min<uint32_t>(count, kProfileWindow);
+            for (uint32_t i = 0; i < available; ++i) {
+                samples.push_back(profiles[t].samples[kind][i].load(std::memory_order_relaxed));
+            }
+        }
+        if (samples.empty()) {
+            return false;
+        }
+        std::sort(samples.begin(), samples.end());
+        double sum = 0;
+        for (uint32_t sample : samples) {
+            sum += sample;
+        }
+        stats->count = total;
+        stats->mean = static_cast<float>(sum / samples.size() / 1000.0);
+        stats->p50 = Percentile(samples, 0.5f);
+        stats->p90 = Percentile(samples, 0.9f);
+        stats->p99 = Percentile(samples, 0.99f);
+        return true;
+    }
+
+    std::string GetProfileReport() {
+        std::string report;
+        char line[128];
+        for (int gpu = 0; gpu < 2; ++gpu) {
+            for (int stage = 0; stage < PROFILE_STAGE_COUNT; ++stage) {
+                ProfileStats stats;
+                if (!GetProfileStats(static_cast<ProfileStage>(stage), gpu != 0, &stats)) {
+                    continue;
+                }
+                snprintf(line, sizeof(line),
+                         "%s %-17s n=%-6u mean=%6.2f p50=%6.2f p90=%6.2f p99=%6.2f ms\n",
+                         gpu ? "gpu" : "cpu", kStageNames[stage], stats.count, stats.mean,
+                         stats.p50, stats.p90, stats.p99);
+                report += line;
+            }
+        }
+        for (int counter = 0; counter < PROFILE_COUNTER_COUNT; ++counter) {
+            snprintf(line, sizeof(line), "count %-17s %d\n", kCounterNames[counter],
+                     counters[counter].load(std::memory_order_relaxed));
+            report += line;
+        }
+        return report;
+    }
+
+    void SetProfileCounter(ProfileCounter counter, int value) {
+        counters[counter].store(value, std::memory_order_relaxed);
+    }
+
+    int GetProfileCounter(ProfileCounter counter) {
+        return counters[counter].load(std::memory_order_relaxed);
+    }
+
+    const char *GetProfileStageName(ProfileStage stage) {
+        return kStageNames[stage];
+    }
+
+    const char *GetProfileCounterName(ProfileCounter counter) {
+        return kCounterNames[counter];
+    }
+
+    int64_t ProfileNowMicroseconds() {
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        return static_cast<int64_t>(tv.tv_sec) * 1000000 + tv.tv_usec;
+    }
+
+    GpuTimer::GpuTimer() : available_(false), active_stage_(-1) {
+        memset(queries_, 0, sizeof(queries_));
+        memset(pending_, 0, sizeof(pending_));
+        memset(next_, 0, sizeof(next_));
+    }
+
+    void GpuTimer::Initialize() {
+        DeleteGlResources();
+        const char *extensions = reinterpret_cast<const char *>(glGetString(GL_EXTENSIONS));
+        available_ = extensions != nullptr &&
+                     strstr(extensions, "GL_EXT_disjoint_timer_query") != nullptr;
+        if (available_) {
+            glGenQueries(PROFILE_STAGE_COUNT * kLatency, &queries_[0][0]);
+        }
+    }
+
+    void GpuTimer::DeleteGlResources() {
+        if (available_) {
+            glDeleteQueries(PROFILE_STAGE_COUNT * kLatency, &queries_[0][0]);
+        }
+        memset(queries_, 0, sizeof(queries_));
+        memset(pending_, 0, sizeof(pending_));
+        available_ = false;
+        active_stage_ = -1;
+    }
+
+    void GpuTimer::Begin(ProfileStage stage) {
+        if (!available_ || active_stage_ >= 0) {
+            return;
+        }
+        int slot = next_[stage];
+        if (pending_[stage][slot]) {
+            // the GPU is kLatency frames behind, skip instead of waiting
+            return;
+        }
+        glBeginQuery(GL_TIME_ELAPSED_EXT, queries_[stage][slot]);
+        active_stage_ = stage;
+    }
+
+    void GpuTimer::End() {
+        if (active_stage_ < 0) {
+            return;
+        }
+        glEndQuery(GL_TIME_ELAPSED_EXT);
+        pending_[active_stage_][next_[active_stage_]] = true;
+        next_[active_stage_] = (next_[active_stage_] + 1) % kLatency;
+        active_stage_ = -1;
+    }
+
+    void GpuTimer::Collect() {
+        if (!available_) {
+            return;
+        }
+        // a disjoint event invalidates every result in flight
+        GLint disjoint = 0;
+        glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+        for (int stage = 0; stage < PROFILE_STAGE_COUNT; ++stage) {
+            for (int slot = 0; slot < kLatency; ++slot) {
+                if (!pending_[stage][slot]) {
+                    continue;
+                }
+                GLuint ready = 0;
+                glGetQueryObjectuiv(queries_[stage][slot], GL_QUERY_RESULT_AVAILABLE, &ready);
+                if (!ready) {
+                    continue;
+                }
+                pending_[stage][slot] = false;
+                GLuint nanoseconds = 0;
+                glGetQueryObjectuiv(queries_[stage][slot], GL_QUERY_RESULT, &nanoseconds);
+                if (!disjoint) {
+                    RecordProfileSample(static_cast<ProfileStage>(stage), nanoseconds / 1000,
+                                        true);
+                }
+            }
+        }
+    }
+
+    ScopedTimer::ScopedTimer(ProfileStage stage, GpuTimer *gpu_timer)
+            : stage_(stage), gpu_timer_(gpu_timer), start_(ProfileNowMicroseconds()) {
+        if (gpu_timer_ != nullptr) {
+            gpu_timer_->Begin(stage_);
+        }
+    }
+
+    ScopedTimer::~ScopedTimer() {
+        if (gpu_timer_ != nullptr) {
+            gpu_timer_->End();
+        }
+        RecordProfileSample(stage_, static_cast<uint32_t>(ProfileNowMicroseconds() - start_));
+    }
+}  // namespace tango_augmented_reality
@@ -0,0 +1,242 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+
+#include <Eigen/Eigenvalues>
+
+#include "tango-augmented-reality/ray_cast.h"
+
+namespace {
+    // rays closer to parallel with a triangle miss it
+    const float kParallelEpsilon = 1e-7f;
+
+    // Möller-Trumbore, updates hit if the triangle is nearer
+    bool IntersectTriangle(const glm::vec3 &origin, const glm::vec3 &direction,
+                           const glm::vec3 &a, const glm::vec3 &b, const glm::vec3 &c,
+                           tango_augmented_reality::RayHit *hit) {
+        glm::vec3 edge1 = b - a;
+        glm::vec3 edge2 = c - a;
+        glm::vec3 p = glm::cross(direction, edge2);
+        float determinant = glm::dot(edge1, p);
+        if (std::abs(determinant) < kParallelEpsilon) {
+            return false;
+        }
+        float inverse = 1.0f / determinant;
+        glm::vec3 s = origin - a;
+        float u = glm::dot(s, p) * inverse;
+        if (u < 0.0f || u > 1.0f) {
+            return false;
+        }
+        glm::vec3 q = glm::cross(s, edge1);
+        float v = glm::dot(direction, q) * inverse;
+        if (v < 0.0f || u + v > 1.0f) {
+            return false;
+        }
+        float t = glm::dot(edge2, q) * inverse;
+        if (t < 0.0f || t >= hit->distance) {
+            return false;
+        }
+        glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
+        hit->distance = t;
+        hit->position = origin + direction * t;
+        hit->normal = glm::dot(normal, direction) > 0.0f ? -normal : normal;
+        return true;
+    }
+
+    template <typename Index>
+    bool IntersectIndexed(const glm::vec3 &origin, const glm::vec3 &direction,
+                          const float *vertices, const Index *indices, size_t index_count,
+                          tango_augmented_reality::RayHit *hit) {
+        bool found = false;
+        for (size_t i = 0; i + 2 < index_count; i += 3) {
+            const float *a = vertices + 3 * indices[i];
+            const float *b = vertices + 3 * indices[i + 1];
+            const float *c = vertices + 3 * indices[i + 2];
+            found |= IntersectTriangle(origin, direction, glm::vec3(a[0], a[1], a[2]),
+                                       glm::vec3(b[0], b[1], b[2]),
+                                       glm::vec3(c[0], c[1], c[2]), hit);
+        }
+        return found;
+    }
+
+    int CellOf(float value, float cell_size) {
+        return static_cast<int>(std::floor(value / cell_size));
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    bool RayCastTriangles(const glm::vec3 &origin, const glm::vec3 &direction,
+                          const glm::vec3 *triangles, size_t triangle_count, RayHit *hit) {
+        bool found = false;
+        for (size_t i = 0; i < triangle_count; ++i) {
+            found |= IntersectTriangle(origin, direction, triangles[3 * i],
+                                       triangles[3 * i + 1], triangles[3 * i + 2], hit);
+        }
+        return found;
+    }
+
+    bool RayCastIndexedTriangles(const glm::vec3 &origin, const glm::vec3 &direction,
+                                 const float *vertices, const uint16_t *indices,
+                                 size_t index_count, RayHit *hit) {
+        return IntersectIndexed(origin, direction, vertices, indices, index_count, hit);
+    }
+
+    bool RayCastIndexedTriangles(const glm::vec3 &origin, const glm::vec3 &direction,
+                                 const float *vertices, const uint32_t *indices,
+                                 size_t index_count, RayHit *hit) {
+        return IntersectIndexed(origin, direction, vertices, indices, index_count, hit);
+    }
+
+    PointCloudRayIndex::PointCloudRayIndex(float cell_size) : cell_size_(cell_size) { }
+
+    uint64_t PointCloudRayIndex::Key(int x, int y, int z) {
+        // 21 bits per axis cover +-50 km at 5 cm cells
+        const uint64_t mask = (1 << 21) - 1;
+        return ((static_cast<uint64_t>(x) & mask) << 42) |
+               ((static_cast<uint64_t>(y) & mask) << 21) | (static_cast<uint64_t>(z) & mask);
+    }
+
+    void PointCloudRayIndex::Clear() {
+        points_.clear();
+        cells_.clear();
+    }
+
+    void PointCloudRayIndex::Build(const float *xyz, size_t count) {
+        Clear();
+        sort_buffer_.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            const float *p = xyz + 3 * i;
+            sort_buffer_[i] = std::make_pair(Key(CellOf(p[0], cell_size_), CellOf(p[1], cell_size_),
+                                                 CellOf(p[2], cell_size_)),
+                                             static_cast<uint32_t>(i));
+        }
+        std::sort(sort_buffer_.begin(), sort_buffer_.end());
+
+        points_.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            const float *p = xyz + 3 * sort_buffer_[i].second;
+            points_[i] = glm::vec3(p[0], p[1], p[2]);
+            uint64_t key = sort_buffer_[i].first;
+            if (i == 0 || key != sort_buffer_[i - 1].first) {
+                CellRange range = {static_cast<uint32_t>(i), static_cast<uint32_t>(i + 1)};
+                cells_[key] = range;
+            } else {
+                cells_[key].end = static_cast<uint32_t>(i + 1);
+            }
+        }
+    }
+
+    const PointCloudRayIndex::CellRange *PointCloudRayIndex::Find(int x, int y, int z) const {
+        std::unordered_map <uint64_t, CellRange>::const_iterator it = cells_.find(Key(x, y, z));
+        return it == cells_.end() ? nullptr : &it->second;
+    }
+
+    bool PointCloudRayIndex::Cast(const glm::vec3 &origin, const glm::vec3 &direction,
+                                  float max_distance, RayHit *hit) const {
+        if (points_.empty()) {
+            return false;
+        }
+        const float radius_squared = cell_size_ * cell_size_;
+        // points within cell_size of the ray lie in the cells around its path,
+        // their distance along it differs by at most two cell diagonals
+        const float margin = 2.0f * std::sqrt(3.0f) * cell_size_;
+        float best = max_distance;
+        const glm::vec3 *best_point = nullptr;
+
+        TraverseGrid(origin, direction, cell_size_, max_distance,
+                     [&](int x, int y, int z, float enter, float exit) {
+            if (best_point != nullptr && enter > best + margin) {
+                return false;
+            }
+            for (int dx = -1; dx <= 1; ++dx) {
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dz = -1; dz <= 1; ++dz) {
+                        const CellRange *range = Find(x + dx, y + dy, z + dz);
+                        if (range == nullptr) {
+                            continue;
+                        }
+                        for (uint32_t i = range->begin; i < range->end; ++i) {
+                            glm::vec3 offset = points_[i] - origin;
+                            float t = glm::dot(offset, direction);
+                            if (t < 0.0f || t >= best) {
+                                continue;
+                            }
+                            glm::vec3 perpendicular = offset - direction * t;
+                            if (glm::dot(perpendicular, perpendicular) <= radius_squared) {
+                                best = t;
+                                best_point = &points_[i];
+                            }
+                        }
+                    }
+                }
+            }
+            return true;
+        });
+
+        if (best_point == nullptr) {
+            return false;
+        }
+        hit->position = *best_point;
+        hit->distance = best;
+        hit->normal = FitNormal(*best_point, direction);
+        return true;
+    }
+
+    glm::vec3 PointCloudRayIndex::FitNormal(const glm::vec3 &position,
+                                            const glm::vec3 &direction) const {
+        int cx = CellOf(position.x, cell_size_);
+        int cy = CellOf(position.y, cell_size_);
+        int cz = CellOf(position.z, cell_size_);
+        const float radius_squared = 4.0f * cell_size_ * cell_size_;
+        Eigen::Vector3d sum = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d scatter = Eigen::Matrix3d::Zero();
+        int count = 0;
+        for (int dx = -2; dx <= 2; ++dx) {
+            for (int dy = -2; dy <= 2; ++dy) {
+                for (int dz = -2; dz <= 2; ++dz) {
+                    const CellRange *range = Find(cx + dx, cy + dy, cz + dz);
+                    if (range == nullptr) {
+                        continue;
+                    }
+                    for (uint32_t i = range->begin; i < range->end; ++i) {
+                        glm::vec3 offset = points_[i] - position;
+                        if (glm::dot(offset, offset) > radius_squared) {
+                            continue;
+                        }
+                        Eigen::Vector3d p(points_[i].x, points_[i].y, points_[i].z);
+                        sum += p;
+                        scatter += p * p.transpose();
+                        ++count;
+                    }
+                }
+            }
+        }
+        if (count < 3) {
+            return -direction;
+        }
+        Eigen::Vector3d centroid = sum / count;
+        Eigen::Matrix3d covariance = scatter / count - centroid * centroid.transpose();
+        // the eigen vector of the smallest eigen value, sorted ascending
+        Eigen::SelfAdjointEigenSolver <Eigen::Matrix3d> solver(covariance);
+        glm::vec3 normal(solver.eigenvectors()(0, 0), solver.eigenvectors()(1, 0),
+                         solver.eigenvectors()(2, 0));
+        normal = glm::normalize(normal);
+        return glm::dot(normal, direction) > 0.0f ? -normal : normal;
+    }
+}  // namespace tango_augmented_reality
@@ -2,144 +2,227 @@
 // Created by stetro on 09.02.16.
 //
 
+#include <algorithm>
+
 #include "tango-augmented-reality/reconstruction_octree.h"
+#include "tango-augmented-reality/thread_pool.h"
+
+namespace {
+    // spreads the lower 21 bits of v to every third bit
+    uint64_t SplitBy3(uint32_t v) {
+        uint64_t x = v & 0x1fffff;
+        x = (x | x << 32) & 0x1f00000000ffffull;
+        x = (x | x << 16) & 0x1f0000ff0000ffull;
+        x = (x | x << 8) & 0x100f00f00f00f00full;
+        x = (x | x << 4) & 0x10c30c30c30c30c3ull;
+        x = (x | x << 2) & 0x1249249249249249ull;
+        return x;
+    }
 
+    // gathers every third bit of x, the inverse of SplitBy3
+    uint32_t CompactBy3(uint64_t x) {
+        x &= 0x1249249249249249ull;
+        x = (x ^ (x >> 2)) & 0x10c30c30c30c30c3ull;
+        x = (x ^ (x >> 4)) & 0x100f00f00f00f00full;
+        x = (x ^ (x >> 8)) & 0x1f0000ff0000ffull;
+        x = (x ^ (x >> 16)) & 0x1f00000000ffffull;
+        x = (x ^ (x >> 32)) & 0x1fffff;
+        return static_cast<uint32_t>(x);
+    }
+
+    // Stable LSD radix sort on the lower key_bits of the keys, one byte per
+    // pass. The result ends up in values, buffer is scratch space.
+    template<typename T>
+    void RadixSortByKey(int key_bits, std::vector <T> *values, std::vector <T> *buffer) {
+        buffer->resize(values->size());
+        for (int shift = 0; shift < key_bits; shift += 8) {
+            size_t offsets[256] = {0};
+            for (const T &value : *values) {
+                ++offsets[(value.key >> shift) & 0xff];
+            }
+            size_t sum = 0;
+            for (size_t &offset : offsets) {
+                size_t bucket = offset;
+                offset = sum;
+                sum += bucket;
+            }
+            for (const T &value : *values) {
+                (*buffer)[offsets[(value.key >> shift) & 0xff]++] = value;
+            }
+            values->swap(*buffer);
+        }
+    }
+}  // namespace
 
 namespace tango_augmented_reality {
 
     ReconstructionOcTree::ReconstructionOcTree(glm::vec3 position, float range, int depth) {
         position_ = position;
         range_ = range;
-        halfRange_ = range / 2;
-        depth_ = depth;
-        children_ = (ReconstructionOcTree **) malloc(sizeof(ReconstructionOcTree *) * 8);
-        for (int i = 0; i < 8; ++i) {
-            is_available_[i] = false;
-        }
-        if (depth_ == 0) {
-            reconstructor = new Reconstructor();
-        }
+        // Morton codes hold 21 bits per axis
+        resolution_ = 1u << std::min(depth, 21);
+        key_bits_ = 3 * std::min(depth, 21);
+        inverse_leaf_range_ = resolution_ / range;
     }
 
     int ReconstructionOcTree::getSize() {
         int size = 0;
-        if (depth_ == 0) {
-            size = reconstructor->getPointCount();
-        } else {
-            for (int i = 0; i < 8; ++i) {
-                if (is_available_[i]) {
-                    size += children_[i]->getSize();
-                }
-            }
+        for (const std::unique_ptr <Leaf> &leaf : leaves_) {
+            size += leaf->reconstructor.getPointCount();
         }
         return size;
     }
 
-    void ReconstructionOcTree::addPoint(glm::vec3 point) {
-        if (point.x < position_.x ||
-            point.y < position_.y ||
-            point.z < position_.z ||
-            point.x > position_.x + range_ ||
-            point.y > position_.y + range_ ||
-            point.z > position_.z + range_) {
-            LOGE("Out of range!");
-            return;
+    int ReconstructionOcTree::getClusterCount() {
+        return leaves_.size();
+    }
+
+    int ReconstructionOcTree::getPlaneCount() {
+        return registry_.getPlaneCount();
+    }
+
+    bool ReconstructionOcTree::getLeafKey(const glm::vec3 &point, uint64_t *key) const {
+        glm::vec3 local = point - position_;
+        if (local.x < 0 || local.y < 0 || local.z < 0 ||
+            local.x > range_ || local.y > range_ || local.z > range_) {
+            return false;
         }
-        updated = true;
-        if (depth_ == 0) {
-            reconstructor->addPoint(point);
-        } else {
-            int index = getChildIndex(point);
-            if (!is_available_[index]) {
-                initChild(point, index);
-            }
-            children_[index]->addPoint(point);
+        // points on the far faces belong to the last leaf, as in the old tree
+        uint32_t x = std::min(static_cast<uint32_t>(local.x * inverse_leaf_range_), resolution_ - 1);
+        uint32_t y = std::min(static_cast<uint32_t>(local.y * inverse_leaf_range_), resolution_ - 1);
+        uint32_t z = std::min(static_cast<uint32_t>(local.z * inverse_leaf_range_), resolution_ - 1);
+        *key = SplitBy3(x) << 2 | SplitBy3(y) << 1 | SplitBy3(z);
+        return true;
+    }
+
+    ReconstructionOcTree::Leaf *ReconstructionOcTree::getLeaf(uint64_t key) {
+        auto inserted = leaf_index_.insert(std::make_pair(key, leaves_.size()));
+        if (inserted.second) {
+            leaves_.push_back(std::unique_ptr<Leaf>(new Leaf()));
+            leaves_.back()->key = key;
+            // the registry meshes the planes of all leaves
+            leaves_.back()->reconstructor.setShared(true);
         }
+        return leaves_[inserted.first->second].get();
     }
 
-    int ReconstructionOcTree::getClusterCount() {
-        if (depth_ != 0) {
-            int size = 0;
-            for (int i = 0; i < 8; ++i) {
-                if (is_available_[i]) {
-                    size += children_[i]->getClusterCount();
+    void ReconstructionOcTree::getNeighbourKeys(uint64_t key,
+                                                std::vector <uint64_t> *keys) const {
+        int x = CompactBy3(key >> 2);
+        int y = CompactBy3(key >> 1);
+        int z = CompactBy3(key);
+        int last = resolution_ - 1;
+        keys->clear();
+        for (int nx = std::max(x - 1, 0); nx <= std::min(x + 1, last); ++nx) {
+            for (int ny = std::max(y - 1, 0); ny <= std::min(y + 1, last); ++ny) {
+                for (int nz = std::max(z - 1, 0); nz <= std::min(z + 1, last); ++nz) {
+                    keys->push_back(SplitBy3(nx) << 2 | SplitBy3(ny) << 1 | SplitBy3(nz));
                 }
             }
-            return size;
         }
-        return 1;
     }
 
-    void ReconstructionOcTree::reconstruct() {
-        if (depth_ == 0 && updated) {
-            reconstructor->reconstruct();
-        } else if (updated) {
-            for (int i = 0; i < 8; ++i) {
-                if (is_available_[i]) {
-                    children_[i]->reconstruct();
-                }
+    void ReconstructionOcTree::addPoint(glm::vec3 point) {
+        addPoints(&point, 1);
+    }
+
+    void ReconstructionOcTree::addPoints(const glm::vec3 *points, size_t count) {
+        int out_of_range = 0;
+        keyed_points_.clear();
+        keyed_points_.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            KeyedPoint keyed;
+            if (!getLeafKey(points[i], &keyed.key)) {
+                ++out_of_range;
+                continue;
             }
+            keyed.point = points[i];
+            keyed_points_.push_back(keyed);
+        }
+        if (out_of_range > 0) {
+            LOGE("%d points out of range!", out_of_range);
         }
-        updated = false;
-    }
 
-    std::vector <glm::vec3> ReconstructionOcTree::getMesh() {
-        if (depth_ != 0) {
-            std::vector <glm::vec3> mesh;
-            for (int i = 0; i < 8; ++i) {
-                if (is_available_[i]) {
-                    std::vector <glm::vec3> childMesh = children_[i]->getMesh();
-                    if (childMesh.size() > 0) {
-                        mesh.insert(mesh.end(), childMesh.begin(), childMesh.end());
-                    }
-                }
+        RadixSortByKey(key_bits_, &keyed_points_, &sort_buffer_);
+
+        // one leaf lookup and one insertion per run of equal keys
+        size_t first = 0;
+        while (first < keyed_points_.size()) {
+            uint64_t key = keyed_points_[first].key;
+            bucket_.clear();
+            size_t last = first;
+            for (; last < keyed_points_.size() && keyed_points_[last].key == key; ++last) {
+                bucket_.push_back(keyed_points_[last].point);
             }
-            return mesh;
+            Leaf *leaf = getLeaf(key);
+            leaf->updated = true;
+            leaf->reconstructor.addPoints(bucket_.data(), bucket_.size());
+            first = last;
         }
-        reconstructor->clearPoints();
-        return reconstructor->getMesh();
     }
 
-
-    void ReconstructionOcTree::clear() {
-        if (depth_ != 0) {
-            for (int i = 0; i < 8; ++i) {
-                if (is_available_[i]) {
-                    children_[i]->clear();
-                }
+    void ReconstructionOcTree::reconstruct() {
+        std::vector <Leaf *> updated;
+        for (const std::unique_ptr <Leaf> &leaf : leaves_) {
+            if (leaf->updated) {
+                updated.push_back(leaf.get());
+                leaf->updated = false;
             }
-        } else {
-            reconstructor->reset();
         }
+        // largest leaves first, so none of them starts last and stretches the pass
+        std::vector <Leaf *> leaves(updated);
+        std::sort(leaves.begin(), leaves.end(), [](Leaf *a, Leaf *b) {
+            return a->reconstructor.getPointCount() > b->reconstructor.getPointCount();
+        });
+        // leaves share no state, the registry merges their planes afterwards
+        ThreadPool::Shared().ParallelFor(leaves.size(), [&leaves](int i) {
+            leaves[i]->reconstructor.reconstruct();
+        });
+
+        // in leaf creation order, so the merges do not depend on the threads
+        std::vector <uint64_t> neighbour_keys;
+        for (Leaf *leaf : updated) {
+            getNeighbourKeys(leaf->key, &neighbour_keys);
+            registry_.update(leaf->key, neighbour_keys, &leaf->reconstructor);
+        }
+        registry_.updateMeshes();
     }
 
-    void ReconstructionOcTree::initChild(glm::vec3 location, int index) {
-        glm::vec3 childPosition;
-        childPosition.x = (location.x > (position_.x + halfRange_))
-                          ? (position_.x + halfRange_) : (position_.x);
-        childPosition.y = (location.y > (position_.y + halfRange_))
-                          ? (position_.y + halfRange_) : (position_.y);
-        childPosition.z = (location.z > (position_.z + halfRange_))
-                          ? (position_.z + halfRange_) : (position_.z);
-        children_[index] = new ReconstructionOcTree(childPosition, halfRange_, depth_ - 1);
-        is_available_[index] = true;
+    std::vector <glm::vec3> ReconstructionOcTree::getMesh() {
+        for (const std::unique_ptr <Leaf> &leaf : leaves_) {
+            leaf->reconstructor.clearPoints();
+        }
+        return registry_.getMesh();
     }
 
+    void ReconstructionOcTree::getMemoryUsage(size_t *point_bytes, size_t *tree_bytes) const {
+        size_t points = (keyed_points_.capacity() + sort_buffer_.capacity()) * sizeof(KeyedPoint) +
+                        bucket_.capacity() * sizeof(glm::vec3);
+        size_t tree = leaves_.capacity() * sizeof(std::unique_ptr <Leaf>) +
+                      leaf_index_.size() * (sizeof(std::pair <const uint64_t, uint32_t>) +
+                                            2 * sizeof(void *)) +
+                      registry_.getBytes();
+        for (const std::unique_ptr <Leaf> &leaf : leaves_) {
+            points += leaf->reconstructor.getPointBytes();
+            tree += sizeof(Leaf) + leaf->reconstructor.getOutlineBytes();
+        }
+        *point_bytes = points;
+        *tree_bytes = tree;
+    }
 
-    int ReconstructionOcTree::getChildIndex(glm::vec3 point) {
-        if (point.x < position_.x + halfRange_) {
-            if (point.y < position_.y + halfRange_) {
-                if (point.z < position_.z + halfRange_) { return 0; } else { return 1; }
-            } else {
-                if (point.z < position_.z + halfRange_) { return 2; } else { return 3; }
-            }
-        } else {
-            if (point.y < position_.y + halfRange_) {
-                if (point.z < position_.z + halfRange_) { return 4; } else { return 5; }
-            } else {
-                if (point.z < position_.z + halfRange_) { return 6; } else { return 7; }
-            }
+    void ReconstructionOcTree::trimPoints() {
+        for (const std::unique_ptr <Leaf> &leaf : leaves_) {
+            leaf->reconstructor.trimPoints();
         }
+        std::vector <KeyedPoint>().swap(keyed_points_);
+        std::vector <KeyedPoint>().swap(sort_buffer_);
+        std::vector <glm::vec3>().swap(bucket_);
+    }
+
+    void ReconstructionOcTree::clear() {
+        leaves_.clear();
+        leaf_index_.clear();
+        registry_.clear();
     }
 
-}
\ No newline at end of file
+}
@@ -1,181 +1,155 @@
+#include <cmath>
+
 #include "tango-augmented-reality/reconstructor.h"
+#include "tango-augmented-reality/plane_ransac.h"
+#include "tango-augmented-reality/profiler.h"
+
+namespace {
+    // scale factor to solve the gap problem between neighbouring hulls
+    const float kHullScale = 1.01f;
+
+    // scales given points around calculated centroid
+    void ScaleAroundCentroid(std::vector <glm::vec3> *points) {
+        glm::vec3 centroid;
+        for (int i = 0; i < points->size(); ++i) {
+            centroid = centroid + (*points)[i];
+        }
+        centroid = centroid / points->size();
+        for (int i = 0; i < points->size(); ++i) {
+            (*points)[i] = (((*points)[i] - centroid) * kHullScale) + centroid;
+        }
+    }
+}  // namespace
 
 namespace tango_augmented_reality {
 
     void Reconstructor::reconstruct() {
-
-        mesh_.clear();
+        ScopedTimer timer(PROFILE_RECONSTRUCT);
+        bool mesh_changed = false;
 
         for (int planeIndex = 0; planeIndex < ransac_detect_planes; ++planeIndex) {
-            // continue with next plane iteration if not enough points available
-            if (points.size() < 4 && !plane_available[planeIndex]) {
+            // known planes only fold in their new inliers
+            if (plane_available[planeIndex]) {
+                if (updatePlane(planes[planeIndex])) {
+                    planes[planeIndex].updateMesh(mesh_occupancy_grid, mesh_vertex_budget);
+                    mesh_changed = true;
+                }
                 continue;
             }
 
-            // RANSAC PLANE DETECTION
-            int calculated_points_size = 0;
-            if ((!plane_available[planeIndex] && points.size() > 4)) {
-                calculated_points_size = points.size();
-                planes[planeIndex] = detectPlane(points);
-                points = ransac_best_not_supporting_points;
-            } else if (plane_available[planeIndex] && planes[planeIndex].points.size() > 4) {
-                calculated_points_size = planes[planeIndex].points.size();
-                planes[planeIndex] = detectPlane(planes[planeIndex].points);
-            } else {
+            // continue with next plane iteration if not enough points available
+            if (points.size() <= 4) {
                 continue;
             }
 
+            // RANSAC PLANE DETECTION on the unassigned points
+            int calculated_points_size = points.size();
+            Plane plane = detectPlane(points);
             if ((calculated_points_size * ransac_sufficient_support) >
                 ransac_best_supporting_points.size()) {
                 continue;
-            } else {
-                plane_available[planeIndex] = true;
             }
 
-            // PROJECT SUPPORTING POINTS TO 2D
-            std::vector <glm::vec2> projection = project(planes[planeIndex],
-                                                         ransac_best_supporting_points);
-
-            // CALCULATE THE CONVEX HULL
-            ConvexHull *h = new ConvexHull();
-            std::vector <glm::vec2> hull = h->generateConvexHull(projection);
-            hull.pop_back();    // remove last point which is available twice
-            if (hull.size() < 4) {
-                plane_available[planeIndex] = false;
+            // PROJECT SUPPORTING POINTS TO 2D AND CALCULATE THE CONVEX HULL
+            // over one sample per cell
+            for (int i = 0; i < ransac_best_supporting_points.size(); ++i) {
+                const glm::vec3 &point = ransac_best_supporting_points[i];
+                plane.points.insert(point, plane.toPlane(point));
+            }
+            plane.points.take(&plane.last_inliers);
+            plane.hull.insert(project(plane.last_inliers));
+            if (plane.hull.size() < 4) {
                 continue;
             }
 
-            // PROJECT BACK TO 3D
-            std::vector <glm::vec3> hull_projection = project(planes[planeIndex], hull);
-
-            // STORE THE LAST CONVEX HULL FOR EACH PLANE
-            planes[planeIndex].points = hull_projection;
-            scaleAroundCentroid(ransac_scale_planes, hull_projection);
-
-            // TRIANGULATION
-            std::vector <glm::vec2> mesh_points;
-            for (int i = 0; i < hull_projection.size() - 2; i++) {
-                mesh_.push_back(hull_projection[0]);
-                mesh_.push_back(hull_projection[i + 1]);
-                mesh_.push_back(hull_projection[i + 2]);
+            planes[planeIndex] = std::move(plane);
+            plane_available[planeIndex] = true;
+            points.swap(ransac_best_not_supporting_points);
+            if (!shared_) {
+                occupy(planes[planeIndex], planes[planeIndex].last_inliers);
+                planes[planeIndex].updateMesh(mesh_occupancy_grid, mesh_vertex_budget);
+                mesh_changed = true;
             }
         }
-    }
 
-    std::vector <glm::vec2> Reconstructor::project(Plane plane, std::vector <glm::vec3> &points) {
-        std::vector <glm::vec2> result;
-        for (int i = 0; i < points.size(); ++i) {
-            glm::vec3 point = points[i];
-            point = point - plane.plane_origin;
-            point = plane.plane_z_rotation * point;
-            result.push_back(glm::vec2(point.x, point.y));
+        if (mesh_changed) {
+            mesh_.clear();
+            for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+                if (plane_available[i]) {
+                    mesh_.insert(mesh_.end(), planes[i].mesh.begin(), planes[i].mesh.end());
+                }
+            }
         }
-        return result;
     }
 
-    std::vector <glm::vec3> Reconstructor::project(Plane plane, std::vector <glm::vec2> &points) {
-        std::vector <glm::vec3> result;
-        for (int i = 0; i < points.size(); ++i) {
-            glm::vec3 point = glm::vec3(points[i].x, points[i].y, 0.0);
-            point = plane.inverse_plane_z_rotation * point;
-            point = point + plane.plane_origin;
-            result.push_back(point);
+    bool Reconstructor::updatePlane(Plane &plane) {
+        plane.last_inliers.clear();
+        if (plane.points.empty()) {
+            return false;
+        }
+        plane.refit();
+        plane.points.take(&plane.last_inliers);
+        if (shared_) {
+            return false;
         }
-        return result;
-    }
 
-    Plane Reconstructor::detectPlane(std::vector < glm::vec3 > &points) {
-        int best_support = 0;
-        Plane result;
-        int ransac_sufficient_support_count = ransac_sufficient_support * points.size();
+        // only new inliers outside the hull touch it
+        bool hull_changed = plane.hull.insert(project(plane.last_inliers));
+        bool occupancy_changed = occupy(plane, plane.last_inliers);
+        return mesh_occupancy_grid ? occupancy_changed : hull_changed;
+    }
 
-        int iterations = ransac_iterations;
-        while (iterations > 0) {
-            iterations--;
-            // 1. pick 3 random points
-            int *selected_index = ransacPickThreeRandomPoints(points);
-
-            // 2. estimate plane from picked points
-            Plane plane = Plane::calculatePlane(points[selected_index[0]],
-                                                points[selected_index[1]],
-                                                points[selected_index[2]]);
-            free(selected_index);
-            // 3. estimate support for calculated plane
-            int support = ransacEstimateSupportingPoints(plane, points);
-            // 4. replace better solutions
-            if (best_support < support) {
-                best_support = support;
-                ransac_best_supporting_points = ransac_supporting_points;
-                ransac_best_not_supporting_points = ransac_not_supporting_points;
-                result = plane;
-            }
-            // 5. stop if support is already sufficient
-            if (best_support >= ransac_sufficient_support_count) {
-                break;
-            }
+    std::vector <glm::vec2> Reconstructor::project(const std::vector <PlaneSample> &samples) {
+        std::vector <glm::vec2> result;
+        result.reserve(samples.size());
+        for (int i = 0; i < samples.size(); ++i) {
+            result.push_back(samples[i].projection);
         }
-        // 6. apply linear regression to optimize plane with supporting points
-        result = ransacApplyLinearRegression(result, ransac_supporting_points);
         return result;
     }
 
-    Plane Reconstructor::ransacApplyLinearRegression(Plane plane, std::vector <glm::vec3> &points) {
-
-        // calculate centroid
-        glm::vec3 centroid;
-        for (int i = 0; i < points.size(); ++i) {
-            centroid += points[i];
+    bool Reconstructor::occupy(Plane &plane, const std::vector <PlaneSample> &samples) {
+        bool changed = false;
+        for (int i = 0; i < samples.size(); ++i) {
+            changed |= plane.occupancy.insert(samples[i].projection, samples[i].count);
         }
-        centroid = centroid / points.size();
+        return changed;
+    }
 
-        // calculate covariance matrix
-        Eigen::Matrix3f cv;
-        for (int i = 0; i < points.size(); ++i) {
-            glm::vec3 s = points[i] - centroid;
-            cv(0, 0) += s.x * s.x;
-            cv(1, 0) += s.x * s.y;
-            cv(2, 0) += s.x * s.z;
-            cv(0, 1) += s.y * s.x;
-            cv(1, 1) += s.y * s.y;
-            cv(2, 1) += s.y * s.z;
-            cv(0, 2) += s.z * s.x;
-            cv(1, 2) += s.z * s.y;
-            cv(2, 2) += s.z * s.z;
-        }
+    Plane Reconstructor::detectPlane(std::vector < glm::vec3 > &points) {
+        int ransac_sufficient_support_count = ransac_sufficient_support * points.size();
 
-        // apply eigenvalue decomposition
-        Eigen::EigenSolver <Eigen::Matrix3f> es(cv);
-        // get eigen vector of smallest eigen value as normal
-        int min_index = 0;
-        for (int i = 0; i < 3; ++i) {
-            if (es.eigenvalues()[i].real() < es.eigenvalues()[i].real()) {
-                min_index = i;
-            }
+        // 1.-5. score hypotheses in parallel until the support is sufficient
+        PlaneHypothesis best = ransac_preemptive
+                               ? DetectPlanePreemptive(points, ransac_iterations,
+                                                       ransac_threshold,
+                                                       ransac_sufficient_support_count,
+                                                       ransac_seed++)
+                               : DetectPlaneRansac(points, ransac_iterations, ransac_threshold,
+                                                   ransac_sufficient_support_count,
+                                                   ransac_seed++);
+        ransac_best_supporting_points.clear();
+        ransac_best_not_supporting_points.clear();
+        if (best.support <= 0) {
+            ransac_best_not_supporting_points = points;
+            return Plane();
         }
-        glm::vec3 normal(es.eigenvectors().col(min_index)[0].real(),
-                         es.eigenvectors().col(min_index)[1].real(),
-                         es.eigenvectors().col(min_index)[2].real());
-        normal = glm::normalize(normal);
-        plane.normal = normal;
-        // new distance is the cross product of normal and centroid
-        plane.distance = glm::dot(normal, centroid);
-        return plane;
-    }
 
-    int Reconstructor::ransacEstimateSupportingPoints(Plane plane,
-                                                      std::vector <glm::vec3> &points) {
-        int support = 0;
-        ransac_supporting_points.clear();
-        ransac_not_supporting_points.clear();
+        // split the points only for the winning plane
+        Plane result(best.normal, best.distance);
         for (int i = 0; i < points.size(); ++i) {
-            if (plane.distanceTo(points[i]) < ransac_threshold) {
-                support++;
-                ransac_supporting_points.push_back(points[i]);
+            if (std::abs(result.distanceTo(points[i])) < ransac_threshold) {
+                ransac_best_supporting_points.push_back(points[i]);
+                result.addToFit(points[i]);
             } else {
-                ransac_not_supporting_points.push_back(points[i]);
+                ransac_best_not_supporting_points.push_back(points[i]);
             }
         }
-        return support;
+        // 6. least squares fit to the supporting points, which also seeds the
+        // running sums later inliers are added to
+        result.refit();
+        result.updateFrame();
+        return result;
     }
 
     void Reconstructor::reset() {
@@ -184,37 +158,11 @@ namespace tango_augmented_reality {
         ransac_best_not_supporting_points.clear();
         ransac_best_supporting_points.clear();
         for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+            planes[i] = Plane();
             plane_available[i] = false;
         }
     }
 
-    int *Reconstructor::ransacPickThreeRandomPoints(std::vector < glm::vec3 > &points) {
-        int *selected_index = (int *) malloc(sizeof(int) * RANSAC_DETECT_PLANES);
-        bool *is_selected = (bool *) malloc(sizeof(bool) * points.size());
-        for (int j = 0; j < points.size(); ++j) {
-            is_selected[j] = false;
-        }
-        for (int i = 0; i < 3; ++i) {
-            do {
-                selected_index[i] = rand() % points.size();
-            } while (is_selected[selected_index[i]]);
-            is_selected[selected_index[i]] = true;
-        }
-        free(is_selected);
-        return selected_index;
-    }
-
-    void Reconstructor::scaleAroundCentroid(float scale, std::vector <glm::vec3> &points) {
-        glm::vec3 centroid;
-        for (int i = 0; i < points.size(); ++i) {
-            centroid = centroid + points[i];
-        }
-        centroid = centroid / points.size();
-        for (int i = 0; i < points.size(); ++i) {
-            points[i] = ((points[i] - centroid) * 1.01) + centroid;
-        }
-    }
-
     Reconstructor::Reconstructor() {
         for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
             plane_available[i] = false;
@@ -222,21 +170,42 @@ namespace tango_augmented_reality {
     }
 
     void Reconstructor::addPoint(glm::vec3 point) {
-        int closest_index = -1;
-        float closest_distance = ransac_threshold;
+        addPoints(&point, 1);
+    }
+
+    void Reconstructor::addPoints(const glm::vec3 *batch, size_t count) {
+        bool any_plane = false;
         for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
             if (plane_available[i]) {
-                float current_distance = planes[i].distanceTo(point);
-                if (current_distance < ransac_threshold && current_distance < closest_distance) {
-                    closest_distance = current_distance;
-                    closest_index = i;
-                }
+                batch_distances[i].resize(count);
+                ComputePlaneDistances(planes[i].normal, planes[i].distance, batch, count,
+                                      batch_distances[i].data());
+                any_plane = true;
             }
         }
-        if (closest_index >= 0) {
-            planes[closest_index].points.push_back(point);
-        } else {
-            points.push_back(point);
+        if (!any_plane) {
+            points.insert(points.end(), batch, batch + count);
+            return;
+        }
+        for (size_t p = 0; p < count; ++p) {
+            int closest_index = -1;
+            float closest_distance = ransac_threshold;
+            for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+                if (plane_available[i]) {
+                    float current_distance = std::abs(batch_distances[i][p]);
+                    if (current_distance < ransac_threshold && current_distance < closest_distance) {
+                        closest_distance = current_distance;
+                        closest_index = i;
+                    }
+                }
+            }
+            if (closest_index >= 0) {
+                Plane &plane = planes[closest_index];
+                plane.points.insert(batch[p], plane.toPlane(batch[p]));
+                plane.addToFit(batch[p]);
+            } else {
+                points.push_back(batch[p]);
+            }
         }
     }
 
@@ -248,7 +217,7 @@ namespace tango_augmented_reality {
         int count = 0;
         for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
             if (plane_available[i]) {
-                count += planes[i].points.size();
+                count += planes[i].point_count;
             }
         }
         count += points.size();
@@ -257,10 +226,15 @@ namespace tango_augmented_reality {
 
     Plane::Plane(glm::vec3 normal, float distance) :
             normal(normal),
-            distance(distance),
-            plane_origin(normal * distance),
-            plane_z_rotation(glm::rotation(normal, glm::vec3(0, 0, 1))),
-            inverse_plane_z_rotation(glm::inverse(glm::rotation(normal, glm::vec3(0, 0, 1)))) { }
+            distance(distance) {
+        updateFrame();
+    }
+
+    void Plane::updateFrame() {
+        plane_origin = normal * distance;
+        plane_z_rotation = glm::rotation(normal, glm::vec3(0, 0, 1));
+        inverse_plane_z_rotation = glm::inverse(plane_z_rotation);
+    }
 
     Plane Plane::calculatePlane(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2) {
         // Vector3s
@@ -274,8 +248,123 @@ namespace tango_augmented_reality {
         return Plane(normal, distance);
     }
 
-    float Plane::distanceTo(glm::vec3 point) {
+    float Plane::distanceTo(glm::vec3 point) const {
         return glm::dot(normal, point) - distance;
     }
 
-}
\ No newline at end of file
+    glm::vec2 Plane::toPlane(glm::vec3 point) const {
+        point = plane_z_rotation * (point - plane_origin);
+        return glm::vec2(point.x, point.y);
+    }
+
+    glm::vec3 Plane::fromPlane(glm::vec2 point) const {
+        glm::vec3 result = inverse_plane_z_rotation * glm::vec3(point.x, point.y, 0.0) +
+                           plane_origin;
+        // the fit may have moved on since the frame was set
+        return result - normal * distanceTo(result);
+    }
+
+    void Plane::updateMesh(bool occupancy_grid, int vertex_budget) {
+        mesh.clear();
+        if (occupancy_grid) {
+            // cells reach past the outermost inliers, no gap to scale over
+            std::vector <glm::vec2> triangles;
+            occupancy.triangulate(vertex_budget, &triangles);
+            mesh.reserve(triangles.size());
+            for (int i = 0; i < triangles.size(); ++i) {
+                mesh.push_back(fromPlane(triangles[i]));
+            }
+            return;
+        }
+
+        // PROJECT BACK TO 3D
+        const std::vector <glm::vec2> &vertices = hull.getVertices();
+        std::vector <glm::vec3> hull_projection;
+        for (int i = 0; i < vertices.size(); ++i) {
+            hull_projection.push_back(fromPlane(vertices[i]));
+        }
+        ScaleAroundCentroid(&hull_projection);
+
+        // TRIANGULATION
+        for (int i = 0; i + 2 < hull_projection.size(); i++) {
+            mesh.push_back(hull_projection[0]);
+            mesh.push_back(hull_projection[i + 1]);
+            mesh.push_back(hull_projection[i + 2]);
+        }
+    }
+
+    void Plane::addToFit(glm::vec3 point) {
+        addToFit(point, 1);
+    }
+
+    void Plane::addToFit(glm::vec3 point, int count) {
+        Eigen::Vector3d p(point.x, point.y, point.z);
+        point_count += count;
+        point_sum += count * p;
+        scatter += count * (p * p.transpose());
+    }
+
+    bool Plane::refit() {
+        if (point_count < 3) {
+            return false;
+        }
+        Eigen::Vector3d centroid = point_sum / point_count;
+        Eigen::Matrix3d covariance = scatter / point_count - centroid * centroid.transpose();
+
+        // eigen vector of the smallest eigen value is the normal, the solver
+        // sorts them ascending
+        Eigen::SelfAdjointEigenSolver <Eigen::Matrix3d> es(covariance);
+        glm::vec3 fitted(es.eigenvectors()(0, 0), es.eigenvectors()(1, 0),
+                         es.eigenvectors()(2, 0));
+        fitted = glm::normalize(fitted);
+        // keep the orientation, distance and point to plane signs depend on it
+        if (glm::dot(fitted, normal) < 0) {
+            fitted = -fitted;
+        }
+        normal = fitted;
+        distance = glm::dot(normal, glm::vec3(centroid.x(), centroid.y(), centroid.z()));
+        return true;
+    }
+
+    size_t Plane::getPointBytes() const {
+        return points.getBytes() + last_inliers.capacity() * sizeof(PlaneSample);
+    }
+
+    size_t Plane::getOutlineBytes() const {
+        return hull.size() * sizeof(glm::vec2) + occupancy.getBytes() +
+               mesh.capacity() * sizeof(glm::vec3);
+    }
+
+    size_t Reconstructor::getPointBytes() const {
+        size_t bytes = (points.capacity() + ransac_best_supporting_points.capacity() +
+                        ransac_best_not_supporting_points.capacity()) * sizeof(glm::vec3);
+        for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+            bytes += planes[i].getPointBytes() + batch_distances[i].capacity() * sizeof(float);
+        }
+        return bytes;
+    }
+
+    size_t Reconstructor::getOutlineBytes() const {
+        size_t bytes = mesh_.capacity() * sizeof(glm::vec3);
+        for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+            bytes += planes[i].getOutlineBytes();
+        }
+        return bytes;
+    }
+
+    void Reconstructor::trimPoints() {
+        size_t kept = 0;
+        for (size_t i = 0; i < points.size(); i += 2) {
+            points[kept++] = points[i];
+        }
+        points.resize(kept);
+        points.shrink_to_fit();
+        std::vector <glm::vec3>().swap(ransac_best_supporting_points);
+        std::vector <glm::vec3>().swap(ransac_best_not_supporting_points);
+        for (int i = 0; i < RANSAC_DETECT_PLANES; ++i) {
+            std::vector <PlaneSample>().swap(planes[i].last_inliers);
+            std::vector <float>().swap(batch_distances[i]);
+        }
+    }
+
+}
@@ -15,16 +15,11 @@
  */
 
 #include <tango-gl/conversions.h>
+#include <tango-core/yuv_converter.h>
 #include "tango-augmented-reality/scene.h"
 
 
 namespace {
-    long long currentTimeInMilliseconds() {
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-        return ((tv.tv_sec * 1000) + (tv.tv_usec / 1000));
-    }
-
     // We want to represent the device properly with respect to the ground so we'll
     // add an offset in z to our origin. We'll set this offset to 1.3 meters based
     // on the average height of a human standing with a Tango device. This allows us
@@ -43,18 +38,34 @@ namespace {
     glm::vec3 kCubeScale = glm::vec3(0.10f, 0.10f, 0.10f);
     const tango_gl::Color kCubeColor(1.0f, 0.f, 0.f);
 
-    inline void Yuv2Rgb(uint8_t yValue, uint8_t uValue, uint8_t vValue, uint8_t *r,
-                        uint8_t *g, uint8_t *b) {
-        *r = yValue + (1.370705 * (vValue - 128));
-        *g = yValue - (0.698001 * (vValue - 128)) - (0.337633 * (uValue - 128));
-        *b = yValue + (1.732446 * (uValue - 128));
+    // Points preallocated per depth frame.
+    const size_t kMaxPointCloudPoints = 20000;
+
+    // microseconds between two memory budget checks, the subsystems need a
+    // frame or more to give their memory back
+    const int64_t kMemoryCheckInterval = 1000000;
+
+    float MedianMs(tango_augmented_reality::ProfileStage stage) {
+        tango_augmented_reality::ProfileStats stats;
+        return tango_augmented_reality::GetProfileStats(stage, false, &stats) ? stats.p50 : 0.0f;
+    }
 
+    // measured cost of one Integrate, the TSDF is integrated and meshed on
+    // its worker thread
+    float IntegrationCostMs(tango_augmented_reality::ARMode mode) {
+        using namespace tango_augmented_reality;
+        if (mode == TSDF) {
+            return MedianMs(PROFILE_CHISEL_ADD_POINTS) + MedianMs(PROFILE_CHISEL_MESH);
+        }
+        return MedianMs(PROFILE_INTEGRATE);
     }
 }  // namespace
 
 namespace tango_augmented_reality {
 
-    Scene::Scene() { }
+    Scene::Scene() : point_cloud_frames_(kMaxPointCloudPoints), tap_requested_(false),
+                     add_object_requested_(false), schedule_reset_requested_(false),
+                     depth_refresh_requested_(true) { }
 
     Scene::~Scene() { }
 
@@ -65,9 +76,6 @@ namespace tango_augmented_reality {
         gl_depth_format_ = GL_UNSIGNED_SHORT;       // 16 Bit
         cv_depth_format_ = CV_16UC1;                // 16 Bit
 
-        // temporary depth_frame cv buffer
-        depth_frame = cv::Mat(depth_height_, depth_width_, cv_depth_format_);
-
         // create drawable with drawable texture
         depth_drawable_ = new DepthDrawable();
 
@@ -75,6 +83,10 @@ namespace tango_augmented_reality {
         glBindTexture(GL_TEXTURE_2D, depth_drawable_->GetTextureId());
         glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, depth_width_, depth_height_, 0,
                      GL_DEPTH_COMPONENT, gl_depth_format_, NULL);
+        // depth textures are only complete with nearest sampling, which the
+        // GPU filter needs to read them
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 
         // create frame buffer with color texture and depth
         glGenFramebuffers(1, &depth_frame_buffer_);
@@ -87,10 +99,35 @@ namespace tango_augmented_reality {
         if (status != GL_FRAMEBUFFER_COMPLETE) {
             LOGE("ERROR in fb %d ", depth_frame_buffer_);
         }
+        // single pass occlusion, drawing the reconstruction twice and blitting
+        // the depth is the fallback
+        if (!occlusion_resolve_.Initialize(depth_drawable_->GetTextureId(), depth_width_,
+                                           depth_height_)) {
+            LOGE("Scene: occlusion resolve unavailable, falling back to the depth blit");
+        }
+
+        // guided filter on the GPU, the CPU filter is the fallback. Its guide is
+        // the RGB texture, or a copy of rgb_frame when the camera texture is
+        // drawn directly.
+        if (!depth_filter_.Initialize(depth_width_, depth_height_)) {
+            async_depth_filter_.Initialize(depth_width_, depth_height_, gl_depth_format_,
+                                           cv_depth_format_);
+        }
+        glGenTextures(1, &guide_texture_);
+        glBindTexture(GL_TEXTURE_2D, guide_texture_);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, depth_width_, depth_height_, 0, GL_RGB,
+                     GL_UNSIGNED_BYTE, NULL);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        gpu_timer_.Initialize();
 
         // Allocating render camera and drawable object.
         // All of these objects are for visualization purposes.
-        yuv_drawable_ = new YUVDrawable();
+        yuv_drawable_ = new YUVDrawable(camera_texture_mode_ ? GL_TEXTURE_EXTERNAL_OES
+                                                             : GL_TEXTURE_2D);
+        rgb_texture_allocated_ = false;
         gesture_camera_ = new tango_gl::GestureCamera();
         axis_ = new tango_gl::Axis();
         frustum_ = new tango_gl::Frustum();
@@ -108,9 +145,10 @@ namespace tango_augmented_reality {
         cube_->SetRotation(kCubeRotation);
         cube_->SetColor(kCubeColor);
 
-        int32_t max_point_cloud_elements;
-        TangoSupport_createXYZij(20000, &XYZij);
         chisel_mesh_ = new ChiselMesh();
+        if (!chunk_store_directory_.empty()) {
+            chisel_mesh_->openStore(chunk_store_directory_);
+        }
         plane_mesh_ = new PlaneMesh();
         gesture_camera_->SetCameraType(tango_gl::GestureCamera::CameraType::kThirdPerson);
     }
@@ -125,6 +163,17 @@ namespace tango_augmented_reality {
         delete grid_;
         delete cube_;
         delete point_cloud_drawable_;
+        delete chisel_mesh_;
+        chisel_mesh_ = nullptr;
+        delete plane_mesh_;
+        depth_filter_.DeleteGlResources();
+        async_depth_filter_.DeleteGlResources();
+        occlusion_resolve_.DeleteGlResources();
+        gpu_timer_.DeleteGlResources();
+        if (guide_texture_) {
+            glDeleteTextures(1, &guide_texture_);
+            guide_texture_ = 0;
+        }
     }
 
     void Scene::SetupViewPort(int x, int y, int w, int h) {
@@ -139,6 +188,16 @@ namespace tango_augmented_reality {
         if (!is_yuv_texture_available_) {
             return;
         }
+        ScopedTimer frame_timer(PROFILE_FRAME);
+        gpu_timer_.Collect();
+
+        // the occlusion depth is only rendered again when this or the view
+        // changes
+        bool scene_changed = depth_refresh_requested_.exchange(false);
+        if (schedule_reset_requested_.exchange(false)) {
+            scheduler_.Reset();
+            scene_changed = true;
+        }
 
 
         if (power_ > 0.0) {
@@ -162,8 +221,23 @@ namespace tango_augmented_reality {
             depth_drawable_->SetRotation(glm::quat(1.0f, 0.0f, 0.0f, 0.0f));
         }
 
-        ConvertYuvToRGBMat();
-        BindRGBMatAsTexture();
+        if (!camera_texture_mode_) {
+            // repeated renders of one color frame keep its texture
+            bool converted;
+            {
+                ScopedTimer timer(PROFILE_YUV_CONVERT);
+                converted = ConvertYuvToRGBMat();
+            }
+            if (converted) {
+                ScopedTimer timer(PROFILE_TEXTURE_UPLOAD, &gpu_timer_);
+                BindRGBMatAsTexture();
+            }
+        } else if (do_filtering) {
+            // the camera texture is drawn directly, the CPU copy is only the
+            // guide image of the filter
+            ScopedTimer timer(PROFILE_YUV_CONVERT);
+            ConvertYuvToRGBMat();
+        }
 
         glEnable(GL_DEPTH_TEST);
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
@@ -196,107 +270,211 @@ namespace tango_augmented_reality {
         }
 
 
-        if ((mode == TSDF || mode == PLANE) &&
-            last_depth_timestamp - last_depth_timestamp_updated > 1.0) {
-            Tap();
+        // the TSDF is raycast into the occlusion depth unless its mesh is shown,
+        // then it is only meshed for that
+        bool raycast_tsdf = mode == TSDF && tsdf_raycast_ && !show_occlusion;
+        if (mode == TSDF) {
+            chisel_mesh_->setMeshing(!raycast_tsdf);
+            scene_changed |= chisel_mesh_->updateRenderMesh();
         }
 
-        if (show_occlusion) {
-            // render reconstructions or pointcloud, depending on mode
-            switch (mode) {
-                case POINTCLOUD: {
-                    std::lock_guard <std::mutex> lock(depth_mutex_);
-                    point_cloud_drawable_->Render(gesture_camera_->GetProjectionMatrix(),
-                                                  gesture_camera_->GetViewMatrix(),
-                                                  point_cloud_transformation, vertices);
-                }
-                    break;
-                case TSDF: {
-                    std::lock_guard <std::mutex> lock(chisel_mesh_->render_mutex);
-                    chisel_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
-                                         gesture_camera_->GetViewMatrix());
-                }
-                    break;
-                case PLANE: {
-                    std::lock_guard <std::mutex> lock(plane_mesh_->render_mutex);
-                    plane_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
-                                        gesture_camera_->GetViewMatrix());
-                }
-                    break;
+        bool new_point_cloud = point_cloud_frames_.Acquire();
+        PointCloudFrame *point_cloud = point_cloud_frames_.Current();
+        if (point_cloud != nullptr) {
+            if (new_point_cloud) {
+                scheduler_.OnDepthPose(point_cloud->XYZij.timestamp, point_cloud->transformation);
+            }
+
+            if (mode == PLANE && new_point_cloud) {
+                // every depth frame feeds the plane tree, Integrate only re-meshes
+                plane_mesh_->insertPoints(glm::transpose(point_cloud->transformation),
+                                          point_cloud->vertices);
+            }
+            bool tap = tap_requested_.exchange(false);
+            if ((mode == TSDF || mode == PLANE) &&
+                (tap || (new_point_cloud &&
+                         scheduler_.ShouldIntegrate(point_cloud->XYZij.timestamp,
+                                                    point_cloud->transformation,
+                                                    IntegrationCostMs(mode))))) {
+                Integrate(point_cloud);
+                // the TSDF mesh arrives later through updateRenderMesh, the
+                // raycast follows the integration of the frame
+                scene_changed |= mode == PLANE || raycast_tsdf;
+            }
+            if (add_object_requested_.exchange(false)) {
+                PlaceObject(point_cloud);
+            }
+            if (mode == POINTCLOUD && (new_point_cloud || upload_pending_)) {
+                // upload once per depth frame, the ring keeps the frames it fuses
+                point_cloud_drawable_->UpdateVertices(point_cloud->vertices,
+                                                      point_cloud->transformation,
+                                                      point_cloud->XYZij.timestamp);
+                upload_pending_ = false;
+                scene_changed = true;
+            } else if (new_point_cloud) {
+                upload_pending_ = true;
             }
         }
 
+        EnforceMemoryBudget();
+
         glEnable(GL_BLEND);
         glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         glEnable(GL_DEPTH_TEST);
 
-        // draw depth to framebuffer object
-        glBindFramebuffer(GL_FRAMEBUFFER, depth_frame_buffer_);
-        glClearColor(0.0, 0.0, 0.0, 0.0);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        // a still view over unchanged geometry keeps last frame's filtered depth
+        bool refresh_depth = scheduler_.ShouldRefreshDepth(gesture_camera_->GetViewMatrix(),
+                                                           scene_changed);
+        if (refresh_depth && raycast_tsdf) {
+            chisel_mesh_->requestDepth(gesture_camera_->GetProjectionMatrix() *
+                                       gesture_camera_->GetViewMatrix(),
+                                       depth_width_, depth_height_);
+        } else if (refresh_depth) {
+            ScopedTimer timer(PROFILE_FBO_PASS, &gpu_timer_);
+            // the only geometry pass, over the whole view at the depth resolution
+            // the filter and its guide work at. It fills the color texture too if
+            // the reconstruction is shown.
+            bool resolve_color = show_occlusion && occlusion_resolve_.IsAvailable();
+            glBindFramebuffer(GL_FRAMEBUFFER, resolve_color ? occlusion_resolve_.GetFrameBuffer()
+                                                            : depth_frame_buffer_);
+            GLint viewport[4];
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            glViewport(0, 0, depth_width_, depth_height_);
+            glClearColor(0.0, 0.0, 0.0, 0.0);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            RenderReconstruction();
+            glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        }
+
+        // a raycast arrives a frame or more after its request
+        bool depth_changed = refresh_depth && !raycast_tsdf;
+        if (raycast_tsdf && chisel_mesh_->takeDepth(&raycast_depth_) &&
+            raycast_depth_.size() == depth_width_ * depth_height_) {
+            glBindTexture(GL_TEXTURE_2D, depth_drawable_->GetTextureId());
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, depth_width_, depth_height_,
+                            GL_DEPTH_COMPONENT, GL_UNSIGNED_SHORT, raycast_depth_.data());
+            glBindTexture(GL_TEXTURE_2D, 0);
+            depth_changed = true;
+        }
+
+        if (depth_changed && do_filtering && depth_filter_.IsAvailable()) {
+            // DEPTH FILTERING on the GPU, straight into the depth texture
+            GLuint guide_texture = yuv_drawable_->GetTextureId();
+            if (camera_texture_mode_) {
+                glBindTexture(GL_TEXTURE_2D, guide_texture_);
+                glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rgb_frame.cols, rgb_frame.rows, GL_RGB,
+                                GL_UNSIGNED_BYTE, rgb_frame.ptr());
+                guide_texture = guide_texture_;
+            }
+            ScopedTimer timer(PROFILE_FILTER, &gpu_timer_);
+            depth_filter_.Apply(guide_texture, depth_drawable_->GetTextureId(),
+                                depth_frame_buffer_, diameter, sigma);
+        } else if (do_filtering && !depth_filter_.IsAvailable()) {
+            // DEPTH FILTERING on the CPU: this frame's depth is read back
+            // asynchronously and the newest filtered frame replaces it. The 16
+            // bit depth is filtered directly, the guide stays 8 bit so sigma
+            // keeps its meaning.
+            ScopedTimer timer(PROFILE_READBACK, &gpu_timer_);
+            if (depth_changed) {
+                async_depth_filter_.Readback(depth_frame_buffer_, rgb_frame, diameter, sigma);
+            }
+            // results of earlier readbacks still belong to the current view
+            async_depth_filter_.Upload(depth_drawable_->GetTextureId());
+        }
+
+        {
+            ScopedTimer timer(PROFILE_OCCLUSION_DRAW, &gpu_timer_);
+            if (occlusion_resolve_.IsAvailable()) {
+                // occlusion depth, and the shown reconstruction, onto the screen
+                occlusion_resolve_.Render(show_occlusion);
+            } else {
+                RenderOcclusionBlit();
+            }
+        }
+        {
+            ScopedTimer timer(PROFILE_DEPTH_PREVIEW, &gpu_timer_);
+            // render drawable depth, over everything but not into the depth
+            // the objects are tested against
+            glDisable(GL_DEPTH_TEST);
+            glDepthMask(GL_FALSE);
+            depth_drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
+            glDepthMask(GL_TRUE);
+            glEnable(GL_DEPTH_TEST);
+        }
 
+        // render rest of drawables
+//        grid_->Render(ar_camera_projection_matrix_, gesture_camera_->GetViewMatrix());
+        cube_->Render(ar_camera_projection_matrix_, gesture_camera_->GetViewMatrix());
+
+    }
+
+    void Scene::RenderOcclusionBlit() {
+        // draws the shown reconstruction a second time on screen and copies the
+        // depth to the main framebuffer
+        if (show_occlusion) {
+            RenderReconstruction();
+        }
+        GLint viewport[4];
+        glGetIntegerv(GL_VIEWPORT, viewport);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, depth_frame_buffer_);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+        glBlitFramebuffer(0, 0, depth_width_, depth_height_, viewport[0], viewport[1],
+                          viewport[0] + viewport[2], viewport[1] + viewport[3],
+                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    }
+
+    void Scene::RenderReconstruction() {
         // render reconstructions or pointcloud, depending on mode
         switch (mode) {
             case POINTCLOUD: {
-                std::lock_guard <std::mutex> lock(depth_mutex_);
+                point_cloud_drawable_->SetFusedFrames(fused_frames_);
                 point_cloud_drawable_->Render(gesture_camera_->GetProjectionMatrix(),
-                                              gesture_camera_->GetViewMatrix(),
-                                              point_cloud_transformation, vertices);
+                                              gesture_camera_->GetViewMatrix());
             }
                 break;
             case TSDF: {
-                std::lock_guard <std::mutex> lock(chisel_mesh_->render_mutex);
                 chisel_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
                                      gesture_camera_->GetViewMatrix());
             }
                 break;
             case PLANE: {
-                std::lock_guard <std::mutex> lock(depth_mutex_);
+                std::lock_guard <std::mutex> lock(plane_mesh_->render_mutex);
                 plane_mesh_->Render(gesture_camera_->GetProjectionMatrix(),
                                     gesture_camera_->GetViewMatrix());
             }
                 break;
         }
+    }
 
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        if (do_filtering) {
-            // DEPTH FILTERING ...
-            // convert from depth component to mat
-            glBindFramebuffer(GL_FRAMEBUFFER, depth_frame_buffer_);
-            glReadPixels(0, 0, depth_frame.cols, depth_frame.rows, GL_DEPTH_COMPONENT,
-                         gl_depth_format_, depth_frame.ptr());
-
-            // apply opencv filters
-            cv::Mat temp_frame(depth_frame.size(), CV_8UC1);
-            depth_frame.convertTo(temp_frame, CV_8U, 0.00390625);
-            long long before = currentTimeInMilliseconds();
-            cv::ximgproc::guidedFilter(rgb_frame, temp_frame, temp_frame, diameter, sigma);
-            long long after = currentTimeInMilliseconds();
-            LOGD("%lld miliseconds for filtering", after - before);
-            temp_frame.convertTo(depth_frame, CV_16UC1, 255);
-
-            // copy back to depth texture
-            glBindTexture(GL_TEXTURE_2D, depth_drawable_->GetTextureId());
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, depth_frame.cols, depth_frame.rows,
-                         0, GL_DEPTH_COMPONENT, gl_depth_format_, depth_frame.ptr());
-            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    void Scene::EnforceMemoryBudget() {
+        int64_t now = ProfileNowMicroseconds();
+        if (now - memory_check_time_ < kMemoryCheckInterval) {
+            return;
         }
-
-        // render drawable depth
-        depth_drawable_->Render(glm::mat4(1.0f), glm::mat4(1.0f));
-
-        // copy depth to main framebuffer
-        glBindFramebuffer(GL_READ_FRAMEBUFFER, depth_frame_buffer_);
-        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
-        glBlitFramebuffer(0, 0, depth_width_, depth_height_, 0, 0, depth_width_, depth_height_,
-                          GL_DEPTH_BUFFER_BIT, GL_NEAREST);
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-        // render rest of drawables
-//        grid_->Render(ar_camera_projection_matrix_, gesture_camera_->GetViewMatrix());
-        cube_->Render(ar_camera_projection_matrix_, gesture_camera_->GetViewMatrix());
-
+        memory_check_time_ = now;
+        // the TSDF worker publishes its chunks itself
+        plane_mesh_->reportMemory();
+        SetMemoryUsage(MEMORY_GPU_BUFFERS,
+                       chisel_mesh_->getGpuBytes() + plane_mesh_->getGpuBytes());
+        if (!IsOverMemoryBudget()) {
+            return;
+        }
+        size_t chisel_bytes = GetMemoryUsage(MEMORY_CHISEL_CHUNKS);
+        size_t plane_bytes = GetMemoryUsage(MEMORY_POINT_BUFFERS) + GetMemoryUsage(MEMORY_OCTREE);
+        if (chisel_bytes >= plane_bytes && chisel_mesh_->shrinkActiveRegion()) {
+            return;
+        }
+        if (GetMemoryUsage(MEMORY_POINT_BUFFERS) > 0) {
+            LOGI("Memory budget exceeded, subsampling %d bytes of plane points",
+                 static_cast<int>(GetMemoryUsage(MEMORY_POINT_BUFFERS)));
+            plane_mesh_->trimPoints();
+            plane_mesh_->reportMemory();
+            return;
+        }
+        LOGE("Memory budget exceeded with nothing left to give up:\n%s",
+             GetMemoryReport().c_str());
     }
 
     void Scene::SetCameraType(tango_gl::GestureCamera::CameraType camera_type) {
@@ -345,95 +523,97 @@ namespace tango_augmented_reality {
             rgb_buffer_.resize(yuv_width_ * yuv_height_ * 3);
             rgb_frame = cv::Mat(depth_height_, depth_width_, CV_8UC3);
 
-            glBindTexture(GL_TEXTURE_2D, yuv_drawable_->GetTextureId());
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, rgb_frame.cols, rgb_frame.rows, 0, GL_RGB,
-                         GL_UNSIGNED_BYTE, NULL);
-
             is_yuv_texture_available_ = true;
         }
 
+        if (camera_texture_mode_ && !do_filtering) {
+            return;
+        }
+
         std::lock_guard <std::mutex> lock(yuv_buffer_mutex_);
         memcpy(&yuv_temp_buffer_[0], buffer->data, yuv_size_);
+        yuv_temp_timestamp_ = buffer->timestamp;
         swap_buffer_signal_ = true;
     }
 
-    void Scene::OnXYZijAvailable(const TangoXYZij *XYZ_ij) {
-        std::vector <float> points;
-        last_depth_timestamp = XYZ_ij->timestamp;
-        for (int i = 0; i < XYZ_ij->xyz_count; ++i) {
-            XYZ_ij->xyz[i][0] = XYZ_ij->xyz[i][0] * .9;
-            XYZ_ij->xyz[i][1] = XYZ_ij->xyz[i][1] * 1.2;
-            points.push_back(XYZ_ij->xyz[i][0]);
-            points.push_back(XYZ_ij->xyz[i][1]);
-            points.push_back(XYZ_ij->xyz[i][2]);
-        }
-        {
-            std::lock_guard <std::mutex> lock(depth_mutex_);
-            TangoSupport_copyXYZij(XYZ_ij, &XYZij);
-            vertices = points;
+    double Scene::LatchColorFrame() {
+        std::lock_guard <std::mutex> lock(yuv_buffer_mutex_);
+        if (swap_buffer_signal_) {
+            std::swap(yuv_buffer_, yuv_temp_buffer_);
+            yuv_timestamp_ = yuv_temp_timestamp_;
+            swap_buffer_signal_ = false;
+            yuv_frame_converted_ = false;
         }
+        return yuv_timestamp_;
     }
 
-    void Scene::ConvertYuvToRGBMat() {
-        {
-            std::lock_guard <std::mutex> lock(yuv_buffer_mutex_);
-            if (swap_buffer_signal_) {
-                std::swap(yuv_buffer_, yuv_temp_buffer_);
-                swap_buffer_signal_ = false;
-            }
+    void Scene::OnXYZijAvailable(const TangoXYZij *XYZ_ij, const glm::mat4 &transformation) {
+        PointCloudFrame *frame = point_cloud_frames_.BeginWrite();
+        point_cloud_frames_.SetPointCount(frame, XYZ_ij->xyz_count);
+        float *points = frame->vertices.data();
+        for (int i = 0; i < XYZ_ij->xyz_count; ++i) {
+            points[i * 3] = XYZ_ij->xyz[i][0] * .9f;
+            points[i * 3 + 1] = XYZ_ij->xyz[i][1] * 1.2f;
+            points[i * 3 + 2] = XYZ_ij->xyz[i][2];
         }
-        size_t x_factor = yuv_height_ / depth_height_;
-        size_t y_factor = yuv_width_ / depth_width_;
-        for (size_t i = 0; i < yuv_height_; ++i) {
-            for (size_t j = 0; j < yuv_width_; ++j) {
-                size_t x_index = j;
-                if (j % 2 != 0) {
-                    x_index = j - 1;
-                }
-                size_t rgb_index = (i * yuv_width_ + j) * 3;
-                cv::Vec3b rgb_dot;
-                Yuv2Rgb(yuv_buffer_[i * yuv_width_ + j],
-                        yuv_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index + 1],
-                        yuv_buffer_[uv_buffer_offset_ + (i / 2) * yuv_width_ + x_index],
-                        &rgb_dot[0], &rgb_dot[1], &rgb_dot[2]);
-                rgb_frame.at<cv::Vec3b>(i / x_factor, j / y_factor) = rgb_dot;
-            }
+        frame->XYZij.timestamp = XYZ_ij->timestamp;
+        frame->transformation = transformation;
+        point_cloud_frames_.Publish();
+    }
+
+    bool Scene::ConvertYuvToRGBMat() {
+        // yuv_buffer_ is only swapped on this thread, in LatchColorFrame
+        if (yuv_frame_converted_) {
+            return false;
         }
-        flip(rgb_frame, rgb_frame, 0);
+        // downsample to the depth resolution, convert and flip in one pass
+        int factor = yuv_width_ / depth_width_;
+        tango_core::ConvertNV21ToRGB(yuv_buffer_.data(), yuv_width_, yuv_height_, factor, true,
+                                     rgb_frame.ptr(), rgb_frame.step);
+        yuv_frame_converted_ = true;
+        return true;
     }
 
     void Scene::BindRGBMatAsTexture() {
         glBindTexture(GL_TEXTURE_2D, yuv_drawable_->GetTextureId());
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, rgb_frame.cols, rgb_frame.rows, 0, GL_RGB,
-                     GL_UNSIGNED_BYTE, rgb_frame.ptr());
+        if (!rgb_texture_allocated_) {
+            // the frame size is only known here, OnFrameAvailable has no context
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, rgb_frame.cols, rgb_frame.rows, 0, GL_RGB,
+                         GL_UNSIGNED_BYTE, rgb_frame.ptr());
+            rgb_texture_allocated_ = true;
+            return;
+        }
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, rgb_frame.cols, rgb_frame.rows, GL_RGB,
+                        GL_UNSIGNED_BYTE, rgb_frame.ptr());
     }
 
     void Scene::ToggleFilter() {
         do_filtering = !do_filtering;
+        depth_refresh_requested_ = true;
     }
 
     void Scene::Tap() {
-        glm::mat4 transformation = glm::transpose(point_cloud_transformation);
-        last_depth_timestamp_updated = XYZij.timestamp;
+        tap_requested_ = true;
+    }
+
+    void Scene::Integrate(PointCloudFrame *point_cloud) {
+        ScopedTimer timer(PROFILE_INTEGRATE);
+        glm::mat4 transformation = glm::transpose(point_cloud->transformation);
+        scheduler_.OnIntegrated(point_cloud->XYZij.timestamp, point_cloud->transformation);
         if (mode == TSDF) {
             LOGD("Collect Points for Chisel");
-            {
-                std::lock_guard <std::mutex> lock(depth_mutex_);
-                chisel_mesh_->addPoints(transformation, depth_intrinsics, &XYZij);
-                chisel_mesh_->updateVertices();
-            }
+            chisel_mesh_->queuePoints(transformation, &point_cloud->XYZij);
         } else if (mode == PLANE) {
-            LOGD("Collect Points for Plane Reconstruction");
-            {
-                std::lock_guard <std::mutex> lock(depth_mutex_);
-                plane_mesh_->addPoints(transformation, vertices);
-                plane_mesh_->updateVertices();
-            }
+            // the frames are already in the tree, see Render
+            LOGD("Reconstruct Planes");
+            plane_mesh_->reconstruct();
+            plane_mesh_->updateVertices();
         }
     }
 
     void Scene::SetMode(int id) {
         mode = (ARMode) id;
+        schedule_reset_requested_ = true;
         switch (mode) {
             case TSDF:
                 break;
@@ -443,24 +623,59 @@ namespace tango_augmented_reality {
     }
 
     void Scene::AddObject(glm::vec3 from, glm::vec3 to) {
-        std::lock_guard <std::mutex> lock(depth_mutex_);
-        glm::mat4 transformation = glm::transpose(point_cloud_transformation);
-        glm::vec4 from_ray = glm::vec4(from, 1) * transformation;
-        glm::vec4 to_ray = glm::vec4(to, 1) * transformation;
-        for (int i = 0; i < vertices.size() / 3; ++i) {
-            glm::vec4 point(vertices[i * 3], vertices[i * 3 + 1], vertices[i * 3 + 2], 1);
-            point = point * transformation;
-            glm::vec4 p1;
-            glm::vec4 n1;
-            glm::vec4 p2;
-            glm::vec4 n2;
-            if (glm::intersectLineSphere(from_ray, to_ray, point, 0.1, p1, n1, p2, n2)) {
-                p1.y = p1.y + 0.1;
-                kCubePosition = glm::vec3(p1);
-                cube_->SetPosition(kCubePosition);
-                break;
+        {
+            std::lock_guard <std::mutex> lock(add_object_mutex_);
+            add_object_from_ = from;
+            add_object_to_ = to;
+        }
+        add_object_requested_ = true;
+    }
+
+    void Scene::PlaceObject(PointCloudFrame *point_cloud) {
+        glm::vec3 from;
+        glm::vec3 to;
+        {
+            std::lock_guard <std::mutex> lock(add_object_mutex_);
+            from = add_object_from_;
+            to = add_object_to_;
+        }
+        // world_T_depth, the ray comes in the depth camera frame
+        const glm::mat4 &transformation = point_cloud->transformation;
+        glm::vec3 origin = glm::vec3(transformation * glm::vec4(from, 1));
+        glm::vec3 end = glm::vec3(transformation * glm::vec4(to, 1));
+        float max_distance = glm::length(end - origin);
+        if (max_distance <= 0.0f) {
+            return;
+        }
+        glm::vec3 direction = (end - origin) / max_distance;
+
+        RayHit hit;
+        bool found = false;
+        if (mode == TSDF) {
+            found = chisel_mesh_->raycast(origin, direction, max_distance, &hit);
+        } else if (mode == PLANE) {
+            found = plane_mesh_->raycast(origin, direction, max_distance, &hit);
+        }
+        if (!found) {
+            // the grid is built in the depth frame once per frame that gets a
+            // tap, so the points need no transformation
+            if (point_ray_index_timestamp_ != point_cloud->XYZij.timestamp) {
+                point_ray_index_.Build(point_cloud->vertices.data(),
+                                       point_cloud->vertices.size() / 3);
+                point_ray_index_timestamp_ = point_cloud->XYZij.timestamp;
+            }
+            glm::vec3 depth_direction = glm::normalize(to - from);
+            found = point_ray_index_.Cast(from, depth_direction, glm::length(to - from), &hit);
+            if (found) {
+                hit.position = glm::vec3(transformation * glm::vec4(hit.position, 1));
+                hit.normal = glm::normalize(glm::vec3(transformation * glm::vec4(hit.normal, 0)));
             }
         }
+        if (found) {
+            // rest the cube on the surface instead of sinking it in
+            kCubePosition = hit.position + hit.normal * kCubeScale.y;
+            cube_->SetPosition(kCubePosition);
+        }
     }
 
     void Scene::ClearReconstruction() {
@@ -472,6 +687,14 @@ namespace tango_augmented_reality {
                 plane_mesh_->clear();
                 break;
         }
+        schedule_reset_requested_ = true;
+    }
+
+    void Scene::OpenChunkStore(const std::string &directory) {
+        chunk_store_directory_ = directory;
+        if (chisel_mesh_ != nullptr) {
+            chisel_mesh_->openStore(directory);
+        }
     }
 
     void Scene::SetDepthIntrinsics(TangoCameraIntrinsics depth_intrinsics_) {
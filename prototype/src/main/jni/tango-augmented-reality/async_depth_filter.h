@@ -0,0 +1,106 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_ASYNC_DEPTH_FILTER_H_
+#define TANGO_AUGMENTED_REALITY_ASYNC_DEPTH_FILTER_H_
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include <GLES3/gl3.h>
+#include <tango-gl/util.h>
+
+#include <opencv2/core/core.hpp>
+
+namespace tango_augmented_reality {
+
+    // CPU guided filter of the occlusion depth without stalling the GL thread.
+    // The depth of frame N is read into a ring of pixel pack buffers while
+    // frame N + 1 renders, filtered on a worker thread and uploaded into the
+    // existing depth texture, so occlusion lags by a frame or more.
+    class AsyncDepthFilter {
+    public:
+        AsyncDepthFilter();
+
+        ~AsyncDepthFilter();
+
+        // Allocates the pixel buffers and starts the worker, call on the GL
+        // thread.
+        //
+        // @param gl_type, cv_type: pixel type of the depth texture.
+        void Initialize(int width, int height, GLenum gl_type, int cv_type);
+
+        // Starts reading the depth attachment of depth_frame_buffer and hands
+        // the newest completed read to the worker together with its guide.
+        //
+        // @param guide: guide image of this frame, copied.
+        // @param radius, eps: as for cv::ximgproc::guidedFilter.
+        void Readback(GLuint depth_frame_buffer, const cv::Mat &guide, int radius, double eps);
+
+        // Writes the newest filtered depth into depth_texture, if there is one.
+        //
+        // @return: true if the texture was updated.
+        bool Upload(GLuint depth_texture);
+
+        // Stops the worker and frees the pixel buffers.
+        void DeleteGlResources();
+
+    private:
+        // read slots in flight, the oldest is overwritten if the GPU is late
+        static const int kRingSize = 3;
+
+        void startWorker();
+
+        void stopWorker();
+
+        void workerLoop();
+
+        // Copies a completed read into the worker input.
+        void consume(int slot);
+
+        void release(int slot);
+
+        int width_ = 0;
+        int height_ = 0;
+        GLenum gl_type_ = GL_UNSIGNED_SHORT;
+
+        GLuint pixel_buffers_[kRingSize];
+        GLsync fences_[kRingSize];
+        cv::Mat guides_[kRingSize];
+        int write_slot_ = 0;
+
+        std::thread worker_;
+        std::mutex mutex_;
+        std::condition_variable condition_;
+        bool stop_worker_ = false;
+
+        // worker input, replaced by newer frames until the worker takes it
+        bool job_pending_ = false;
+        cv::Mat pending_depth_;
+        cv::Mat pending_guide_;
+        int radius_ = 0;
+        double eps_ = 0;
+
+        // worker output, swapped out by Upload
+        bool result_ready_ = false;
+        cv::Mat result_;
+        cv::Mat upload_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_ASYNC_DEPTH_FILTER_H_
@@ -32,13 +32,17 @@
 
 #include <tango_client_api.h>  // NOLINT
 #include <tango-gl/util.h>
+#include <tango-core/pose_buffer.h>
+#include <tango-core/render_requester.h>
 
+#include <tango-augmented-reality/capture_writer.h>
 #include <tango-augmented-reality/pose_data.h>
 #include <tango-augmented-reality/scene.h>
 #include <tango-augmented-reality/tango_event_data.h>
 
-#define SKIP_INTERVAL 2
-#define INIT_DELAY_SECONDS 2
+// sample the color camera as GL_TEXTURE_EXTERNAL_OES instead of uploading
+// CPU converted frames
+#define USE_CAMERA_TEXTURE true
 
 namespace tango_augmented_reality {
 
@@ -98,6 +102,12 @@ namespace tango_augmented_reality {
         // sets the depth visibility
         void setDepthFullscreen(bool show);
 
+        // raycasts the TSDF for the occlusion depth instead of meshing it
+        void setTsdfRaycast(bool enabled);
+
+        // sets the number of point cloud frames fused for the occlusion
+        void setFusedFrames(int count);
+
         // Tango service event callback function for pose data. Called when new events
         // are available from the Tango Service.
         //
@@ -114,6 +124,12 @@ namespace tango_augmented_reality {
         // @param id: depth data
         void onXYZijAvailable(const TangoXYZij *XYZ_ij);
 
+        // Tango service pose callback. Called for every start of service with
+        // respect to device pose.
+        //
+        // @param pose: pose data
+        void onPoseAvailable(const TangoPoseData *pose);
+
         // Tango service image callback. Called when the image is updated.
         //
         // @param buffer: image data
@@ -160,19 +176,33 @@ namespace tango_augmented_reality {
         // triggers the reconstruction resetting
         void clearReconstruction();
 
+        // keep the TSDF chunks in directory across sessions
+        void openChunkStore(const std::string &directory);
+
         // set the current filter object to scene
         void setFilterSettings(int diameter, double sigma);
 
         // set the current joystick movement to scene
         void joyStick(double angle, double power);
 
+        // Start recording depth, pose and color frames of the running session.
+        //
+        // @param: path, file the session is written to, see capture_format.h.
+        //
+        // @return: error code.
+        int StartRecording(const std::string &path);
+
+        // Stop recording and finish the session file.
+        void StopRecording();
+
     private:
         // Get a pose in matrix format with extrinsics in OpenGl space.
         //
         // @param: timstamp, timestamp of the target pose.
+        // @param: pose, pose in matrix format.
         //
-        // @return: pose in matrix format.
-        glm::mat4 GetPoseMatrixAtTimestamp(double timstamp);
+        // @return: false if there is no valid pose at timstamp.
+        bool GetPoseMatrixAtTimestamp(double timstamp, glm::mat4 *pose);
 
         // Query sensor/camera extrinsic from the Tango Service, the extrinsic is only
         // available after the service is connected.
@@ -191,6 +221,13 @@ namespace tango_augmented_reality {
         // thread and TangoService callback thread.
         std::mutex pose_mutex_;
 
+        // poses of the pose callback, depth and color frames look up theirs here
+        tango_core::PoseBuffer pose_buffer_;
+
+        // the last rendered color frame and its pose, GL thread only
+        double color_frame_timestamp_ = -1.0;
+        glm::mat4 color_camera_pose_;
+
         // tango_event_data_ handles all Tango event callbacks,
         // onTangoEventAvailable() in this object will be routed to tango_event_data_
         // to handle.
@@ -202,6 +239,9 @@ namespace tango_augmented_reality {
         // protect tango_event_data_.
         std::mutex tango_event_mutex_;
 
+        // Session recorder, only writes while a recording was started.
+        CaptureWriter capture_writer_;
+
         // main_scene_ includes all drawable object for visualizing Tango device's
         // movement.
         Scene main_scene_;
@@ -222,19 +262,13 @@ namespace tango_augmented_reality {
         // Tango service version string.
         std::string tango_core_version_string_;
 
-        // Cached Java VM, caller activity object and the request render method. These
-        // variables are used for on demand render request from the onTextureAvailable
-        // callback.
+        // Cached Java VM and the caller activity's request render method, used for
+        // on demand render requests from the color frame callbacks.
         JavaVM *java_vm_;
-        jobject calling_activity_obj_;
-        jmethodID on_demand_render_;
-
-        bool init = true;
-        time_t timev;
+        tango_core::RenderRequester render_requester_;
 
         cv::Mat rgb;
 
-        int skip_value = 0;
         float image_width;
         float image_height;
         float fx;
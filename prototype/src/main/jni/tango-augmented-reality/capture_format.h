@@ -0,0 +1,126 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_AUGMENTED_REALITY_CAPTURE_FORMAT_H_
+#define TANGO_AUGMENTED_REALITY_CAPTURE_FORMAT_H_
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tango_augmented_reality {
+
+    // Binary layout of a recorded session. All values are little endian, every
+    // chunk starts 8 byte aligned so its payload can be used in place from a
+    // memory mapped file.
+    //
+    //   CaptureFileHeader
+    //   CaptureChunkHeader + payload, padded to 8 bytes   (repeated)
+    //   CaptureIndexEntry[index_count]
+    //   CaptureFileFooter
+    //
+    // Chunks are only ever appended. The index and footer are written when the
+    // recording is closed, a file without a valid footer is truncated.
+
+    const uint32_t kCaptureMagic = 0x50435254;        // "TRCP"
+    const uint32_t kCaptureFooterMagic = 0x58444e49;  // "INDX"
+    const uint32_t kCaptureVersion = 1;
+    const size_t kCaptureAlignment = 8;
+
+    enum CaptureChunkType {
+        CAPTURE_CHUNK_INTRINSICS = 1,
+        CAPTURE_CHUNK_EXTRINSICS = 2,
+        CAPTURE_CHUNK_POSE = 3,
+        CAPTURE_CHUNK_POINT_CLOUD = 4,
+        CAPTURE_CHUNK_YUV_FRAME = 5
+    };
+
+    struct CaptureFileHeader {
+        uint32_t magic;
+        uint32_t version;
+    };
+
+    struct CaptureChunkHeader {
+        uint32_t type;
+        uint32_t payload_size;
+        double timestamp;
+    };
+
+    struct CaptureIndexEntry {
+        uint64_t offset;
+        uint32_t type;
+        uint32_t payload_size;
+        double timestamp;
+    };
+
+    struct CaptureFileFooter {
+        uint64_t index_offset;
+        uint32_t index_count;
+        uint32_t magic;
+    };
+
+    // Payload of CAPTURE_CHUNK_INTRINSICS, one per camera.
+    struct CaptureIntrinsics {
+        uint32_t camera_id;
+        uint32_t calibration_type;
+        uint32_t width;
+        uint32_t height;
+        double fx;
+        double fy;
+        double cx;
+        double cy;
+        double distortion[5];
+    };
+
+    // Payload of CAPTURE_CHUNK_EXTRINSICS, column major OpenGL matrices as
+    // PoseData keeps them.
+    struct CaptureExtrinsics {
+        float imu_T_device[16];
+        float imu_T_color_camera[16];
+        float imu_T_depth_camera[16];
+    };
+
+    // Payload of CAPTURE_CHUNK_POSE.
+    struct CapturePose {
+        double orientation[4];
+        double translation[3];
+        uint32_t status_code;
+        uint32_t base_frame;
+        uint32_t target_frame;
+        uint32_t reserved;
+    };
+
+    // Payload of CAPTURE_CHUNK_POINT_CLOUD, followed by xyz_count * 3 floats.
+    // point_cloud_transformation is the matrix the scene received for it.
+    struct CapturePointCloud {
+        float point_cloud_transformation[16];
+        uint32_t xyz_count;
+        uint32_t reserved;
+    };
+
+    // Payload of CAPTURE_CHUNK_YUV_FRAME, followed by a width * height * 3 / 2
+    // byte NV21 image.
+    struct CaptureYuvFrame {
+        uint32_t width;
+        uint32_t height;
+    };
+
+    inline size_t CaptureAlign(size_t size) {
+        return (size + kCaptureAlignment - 1) & ~(kCaptureAlignment - 1);
+    }
+
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_CAPTURE_FORMAT_H_
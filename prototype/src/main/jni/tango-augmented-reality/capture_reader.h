@@ -0,0 +1,86 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_AUGMENTED_REALITY_CAPTURE_READER_H_
+#define TANGO_AUGMENTED_REALITY_CAPTURE_READER_H_
+
+#include <string>
+
+#include "tango-augmented-reality/capture_format.h"
+
+namespace tango_augmented_reality {
+
+    // Point cloud chunk as a view into the mapped file.
+    struct CapturePointCloudView {
+        double timestamp;
+        const float *point_cloud_transformation;
+        uint32_t xyz_count;
+        const float (*xyz)[3];
+    };
+
+    // NV21 frame chunk as a view into the mapped file.
+    struct CaptureYuvFrameView {
+        double timestamp;
+        uint32_t width;
+        uint32_t height;
+        const uint8_t *data;
+    };
+
+    // CaptureReader memory maps a recorded session and hands out views into it.
+    // Nothing is copied or parsed up front, opening a session only validates
+    // the header, the footer and the index. Views stay valid until Close().
+    class CaptureReader {
+    public:
+        CaptureReader();
+
+        ~CaptureReader();
+
+        // @return: false if the file is missing, truncated or of another version.
+        bool Open(const std::string &path);
+
+        void Close();
+
+        uint32_t GetChunkCount() const { return index_count_; }
+
+        const CaptureIndexEntry &GetEntry(uint32_t i) const { return index_[i]; }
+
+        // Typed access to chunk i, return nullptr or false if the chunk has
+        // another type or a payload that does not fit.
+        const CaptureIntrinsics *GetIntrinsics(uint32_t i) const;
+
+        const CaptureExtrinsics *GetExtrinsics(uint32_t i) const;
+
+        const CapturePose *GetPose(uint32_t i) const;
+
+        bool GetPointCloud(uint32_t i, CapturePointCloudView *view) const;
+
+        bool GetYuvFrame(uint32_t i, CaptureYuvFrameView *view) const;
+
+        // @return: intrinsics of the given camera or nullptr if not recorded.
+        const CaptureIntrinsics *FindIntrinsics(uint32_t camera_id) const;
+
+    private:
+        const uint8_t *GetPayload(uint32_t i, CaptureChunkType type, size_t min_size) const;
+
+        const uint8_t *data_;
+        size_t size_;
+        const CaptureIndexEntry *index_;
+        uint32_t index_count_;
+    };
+
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_CAPTURE_READER_H_
@@ -0,0 +1,97 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_AUGMENTED_REALITY_CAPTURE_WRITER_H_
+#define TANGO_AUGMENTED_REALITY_CAPTURE_WRITER_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-augmented-reality/capture_format.h"
+
+namespace tango_augmented_reality {
+
+    // CaptureWriter streams a session into the format of capture_format.h. The
+    // Tango callback threads only pack the chunk into a buffer, a background
+    // thread appends it to the file. When the disk can not keep up chunks are
+    // dropped instead of stalling the callbacks.
+    class CaptureWriter {
+    public:
+        CaptureWriter();
+
+        ~CaptureWriter();
+
+        // Creates the file and starts the writer thread.
+        // @return: false if the file could not be created.
+        bool Open(const std::string &path);
+
+        // Flushes pending chunks, writes the index and closes the file.
+        void Close();
+
+        bool IsOpen() const { return is_open_; }
+
+        void WriteIntrinsics(const TangoCameraIntrinsics &intrinsics);
+
+        void WriteExtrinsics(const glm::mat4 &imu_T_device, const glm::mat4 &imu_T_color_camera,
+                             const glm::mat4 &imu_T_depth_camera);
+
+        void WritePose(const TangoPoseData &pose);
+
+        // Records the raw point cloud and the transformation the scene uses for it.
+        void WritePointCloud(const TangoXYZij *XYZ_ij, const glm::mat4 &point_cloud_transformation);
+
+        // Records a NV21 frame downsampled by two in both directions.
+        void WriteYuvFrame(const TangoImageBuffer *buffer);
+
+        // @return: number of chunks dropped because the queue was full.
+        int GetDroppedChunks() const { return dropped_chunks_; }
+
+    private:
+        // Allocates a chunk with header and room for payload_size bytes.
+        std::vector <uint8_t> CreateChunk(CaptureChunkType type, double timestamp,
+                                          size_t payload_size);
+
+        void Enqueue(std::vector <uint8_t> &&chunk);
+
+        void WriterThread();
+
+        FILE *file_;
+        std::thread thread_;
+        std::mutex queue_mutex_;
+        std::condition_variable queue_condition_;
+        std::deque <std::vector <uint8_t>> queue_;
+        size_t queued_bytes_;
+        bool stop_;
+        std::atomic <bool> is_open_;
+        std::atomic <int> dropped_chunks_;
+
+        // Only touched by the writer thread.
+        uint64_t offset_;
+        std::vector <CaptureIndexEntry> index_;
+    };
+
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_CAPTURE_WRITER_H_
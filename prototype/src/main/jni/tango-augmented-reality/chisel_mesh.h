@@ -8,7 +8,15 @@
 
 #include <Eigen/Core>
 
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <memory>
 #include <mutex>
+#include <thread>
+#include <string>
+#include <unordered_set>
+#include <vector>
 
 #include <open_chisel/Chisel.h>
 #include <open_chisel/camera/DepthImage.h>
@@ -23,6 +31,16 @@
 #include <open_chisel/mesh/Mesh.h>
 
 #include <tango_support_api.h>
+#include <tango-core/chunk_file.h>
+#include <tango-core/chunk_recycler.h>
+#include <tango-core/chunk_store.h>
+#include <tango-core/parallel_chisel.h>
+#include <tango-core/resolution_levels.h>
+#include <tango-core/tsdf_raycast.h>
+
+#include "tango-augmented-reality/chunk_mesh_cache.h"
+#include "tango-augmented-reality/indexed_mesh.h"
+#include "tango-augmented-reality/profiler.h"
 
 
 
@@ -31,26 +49,90 @@ typedef boost::shared_ptr<chisel::DepthImage<float>> DepthImagePtr;
 namespace tango_augmented_reality {
 
 
+    // TSDF reconstruction of the depth frames. Chunks seen from close get finer
+    // voxels than distant ones: every resolution level is its own chisel map
+    // integrating the depths of its range, see tango_core::ResolutionLevels,
+    // and a finer level replaces the triangles of the coarser ones where it has
+    // observed the space.
     class ChiselMesh : public tango_gl::DrawableObject {
     public:
         ChiselMesh();
 
         ChiselMesh(GLenum render_mode);
 
+        ~ChiselMesh();
+
         void SetShader();
 
+        // Sets the depth camera and (re)starts the integration thread.
         void init(TangoCameraIntrinsics intrinsics);
 
         void Render(const glm::mat4 &projection_mat, const glm::mat4 &view_mat) const;
 
+        // Synchronous integration and meshing on the calling thread.
         void addPoints(glm::mat4 transformation, TangoCameraIntrinsics intrinsics, TangoXYZij *XYZij);
 
+        // Remeshes the chunks changed by addPoints and queues them for upload.
         void updateVertices();
-        
-        std::mutex render_mutex;
 
+        // Copies the frame into the integration queue and returns. When the
+        // thread falls behind the oldest queued frame is dropped.
+        void queuePoints(glm::mat4 transformation, const TangoXYZij *XYZij);
+
+        // Uploads the chunk meshes changed since the last call, call on the GL
+        // thread before Render.
+        // @return: true if the mesh changed.
+        bool updateRenderMesh();
+
+        // Nearest surface along a world space ray in the uploaded mesh, GL
+        // thread only like updateRenderMesh.
+        bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance,
+                     RayHit *hit) const;
+
+        // Raycasts the TSDF of all levels into a width x height window depth
+        // image of view_projection on the integration thread, after the
+        // newest integrated frame. A newer request replaces a pending one.
+        void requestDepth(const glm::mat4 &view_projection, int width, int height);
+
+        // Takes the newest raycast depth, 16 bit window depths bottom row
+        // first, GL thread.
+        // @return: false if none arrived since the last call.
+        bool takeDepth(std::vector <uint16_t> *depth);
+
+        // Whether the integration thread extracts meshes. Without them Render
+        // and raycast keep the last meshed state, and the changed chunks are
+        // meshed once it is enabled again.
+        void setMeshing(bool enabled);
+
+        // @return: frames dropped from the integration queue so far.
+        int getDroppedFrames() const { return dropped_frames_; }
+
+        // @return: number of triangles of the last updateVertices call, all
+        // levels.
+        size_t getTriangleCount() const { return triangle_count_; }
+
+        // Drops the reconstruction, on the integration thread if it runs.
         void clear();
 
+        // Only chunks within radius metres of the depth camera stay in the map,
+        // the others are compressed and come back once the camera returns.
+        // 0 keeps every chunk.
+        void setActiveRegion(float radius) { active_region_radius_ = radius; }
+
+        // Narrows the active region, so the chunks farthest from the camera
+        // are compressed into the store with the next frame. An unbounded
+        // region starts at the default radius.
+        // @return: false if the region is already at its smallest.
+        bool shrinkActiveRegion();
+
+        // @return: bytes of the GPU buffers of all levels, GL thread.
+        size_t getGpuBytes() const;
+
+        // Keeps the chunks in directory across sessions. Chunks leaving the
+        // active region and, every few seconds, changed ones are written there,
+        // stored chunks load once the camera comes near them.
+        void openStore(const std::string &directory);
+
     protected:
         tango_gl::BoundingBox *bounding_box_;
 
@@ -65,13 +147,139 @@ namespace tango_augmented_reality {
         double farClipping;
         double rayTruncation;
 
-        chisel::ChiselPtr chiselMap;
+        // upsampled depth of the last frame, the levels integrate parts of it
         DepthImagePtr lastDepthImage = DepthImagePtr(new chisel::DepthImage<float>());
-        chisel::ProjectionIntegrator projectionIntegrator;
 
         chisel::Intrinsics chiselIntrinsics;
+        // camera of the full depth range
         chisel::PinholeCamera pinHoleCamera;
 
+    private:
+        // One resolution of the reconstruction. The map and its chunk state
+        // belong to the integration thread, cache to the GL thread.
+        struct Level {
+            Level(const Eigen::Vector3i &chunk_size, float resolution,
+                  size_t recycled_voxel_bytes);
+
+            float resolution;
+            // meshes its dirty chunks on the shared thread pool
+            std::unique_ptr <tango_core::ParallelChisel> map;
+            chisel::ProjectionIntegrator integrator;
+            // pinHoleCamera clipped to the depth range of the level
+            chisel::PinholeCamera camera;
+            DepthImagePtr depth;
+
+            // clears keep the chunks of the last reconstruction for the next one
+            tango_core::ChunkRecycler recycler;
+            // chunks outside the active region
+            tango_core::ChunkStore store;
+            // spill and save target of store once opened
+            tango_core::ChunkFile file;
+            // integrated since the last persistChunks
+            std::unordered_set <chisel::ChunkID, chisel::ChunkHasher> unsaved;
+
+            ChunkMeshCache cache;
+        };
+
+        struct QueuedFrame {
+            glm::mat4 transformation;
+            double timestamp;
+            std::vector <float> points;
+        };
+
+        void startWorker();
+
+        void stopWorker();
+
+        void workerLoop();
+
+        // Chunk meshes of every level are handed to the GL thread in
+        // pending_updates_.
+        void publishUpdates(std::vector <ChunkMeshUpdates> *updates, bool reset);
+
+        // Drops the reconstruction of all levels, integration thread only.
+        void clearLevels();
+
+        // Welds the mesh of a chunk of a level, leaving out the triangles a
+        // finer level has observed.
+        void exportChunk(int level, const chisel::ChunkID &id, ChunkMeshData *data) const;
+
+        // Moves chunks between the maps and their stores around the camera of
+        // the frame just integrated, integration thread only.
+        void updateActiveRegion(const glm::mat4 &transformation);
+
+        // Opens the level directories below store_directory_, integration
+        // thread only.
+        void openChunkFile();
+
+        // Writes the chunks changed since the last call to the level files.
+        void persistChunks();
+
+        // Serves the pending requestDepth, integration thread only.
+        void raycastDepth();
+
+        // Publishes the voxel, store and chunk mesh bytes of all levels,
+        // integration thread only.
+        void reportMemory();
+
+        // (Re)creates the interpolator and lastDepthImage for new intrinsics.
+        void setupDepthUpsampling(const TangoCameraIntrinsics &intrinsics);
+
+        TangoCameraIntrinsics intrinsics_;
+
+        // Upsampling state shared by all frames of one depth camera. The buffer
+        // writes straight into lastDepthImage.
+        TangoSupportDepthInterpolator *depth_interpolator_ = nullptr;
+        TangoSupportDepthBuffer depth_buffer_;
+        TangoCameraIntrinsics depth_buffer_intrinsics_;
+
+        std::thread worker_;
+        std::mutex queue_mutex_;
+        std::condition_variable queue_condition_;
+        std::deque <QueuedFrame> queue_;
+        // point buffers of dequeued frames, reused by queuePoints
+        std::vector <std::vector <float>> spare_points_;
+        bool stop_worker_ = false;
+        bool clear_requested_ = false;
+        bool open_store_requested_ = false;
+        bool mesh_requested_ = false;
+        // view of the pending requestDepth
+        bool depth_requested_ = false;
+        glm::mat4 depth_view_projection_;
+        int depth_width_ = 0;
+        int depth_height_ = 0;
+        std::string store_directory_;
+        std::atomic <int> dropped_frames_;
+        std::atomic <size_t> triangle_count_;
+
+        // finest level first
+        std::vector <std::unique_ptr <Level>> levels_;
+
+        // chunk meshes of each level waiting for upload, reset drops the
+        // caches before them
+        std::mutex updates_mutex_;
+        std::vector <ChunkMeshUpdates> pending_updates_;
+        bool pending_reset_ = false;
+        // newest raycast depth for takeDepth
+        std::vector <uint16_t> pending_depth_;
+        bool depth_ready_ = false;
+
+        // raycast targets of the integration thread
+        std::vector <float> raycast_depth_;
+        std::vector <uint16_t> raycast_window_depth_;
+
+        std::atomic <bool> meshing_enabled_;
+
+        std::atomic <float> active_region_radius_;
+        // the radius changed, the region is updated with the next frame
+        std::atomic <bool> region_reset_requested_;
+        // camera position of the last active region update
+        Eigen::Vector3f region_center_;
+        bool region_valid_ = false;
+        // bytes of the chisel meshes of the last updateVertices
+        size_t chisel_mesh_bytes_ = 0;
+
+        double last_persist_timestamp_ = 0;
     };
 }  // namespace tango_augmented_reality
 #endif  // TANGO_AUGMENTED_REALITY_MESH_H_
@@ -0,0 +1,115 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_AUGMENTED_REALITY_CHUNK_MESH_CACHE_H_
+#define TANGO_AUGMENTED_REALITY_CHUNK_MESH_CACHE_H_
+
+#include <unordered_map>
+#include <vector>
+
+#include <tango-gl/util.h>
+
+#include <open_chisel/ChunkManager.h>
+
+#include "tango-augmented-reality/ray_cast.h"
+#include "tango-augmented-reality/view_frustum.h"
+
+namespace tango_augmented_reality {
+
+    // Indexed triangle mesh of one chisel chunk, empty once the chunk lost its
+    // surface. A chunk holds at most a few thousand vertices, so 16 bit indices
+    // are enough. coarse_indices is a decimated version over the same
+    // vertices with the chunk border unchanged, drawn for distant chunks.
+    // packed_vertices is what gets uploaded, see PackChunkVertices.
+    struct ChunkMeshData {
+        std::vector <GLfloat> vertices;
+        std::vector <GLushort> indices;
+        std::vector <GLushort> coarse_indices;
+        std::vector <GLushort> packed_vertices;
+    };
+
+    // Quantizes world space vertices of chunk id to 16 bit per axis relative
+    // to the chunk, the box spans the chunk and a margin for marching cubes
+    // vertices just outside it. Four values per vertex keep the attribute 4
+    // byte aligned, 8 instead of 12 bytes at about 1/40000 of the chunk edge.
+    void PackChunkVertices(const chisel::ChunkID &id, float chunk_extent,
+                           const std::vector <GLfloat> &vertices,
+                           std::vector <GLushort> *packed);
+
+    // Model matrix turning normalized packed vertices of chunk id back into
+    // world space.
+    glm::mat4 ChunkDecodeMatrix(const chisel::ChunkID &id, float chunk_extent);
+
+    // Meshes of the chunks changed since the last upload, latest wins.
+    typedef std::unordered_map <chisel::ChunkID, ChunkMeshData, chisel::ChunkHasher> ChunkMeshUpdates;
+
+    // GPU side of a chisel reconstruction: one VBO/IBO pair per chunk, so an
+    // update only uploads the chunks that changed. The meshes stay on the CPU
+    // as well for ray casts. All calls need the GL thread.
+    class ChunkMeshCache {
+    public:
+        ChunkMeshCache();
+
+        ~ChunkMeshCache();
+
+        // Uploads the given chunk meshes, replacing older versions of the same
+        // chunks, and takes them over. Buffers of emptied chunks are kept for
+        // reuse.
+        void Apply(ChunkMeshUpdates *updates);
+
+        // Nearest triangle along the ray, only testing the chunks on its path.
+        //
+        // @param chunk_extent: edge of a chunk in meters, chunk ids are
+        //                      floor(position / chunk_extent).
+        bool RayCast(const glm::vec3 &origin, const glm::vec3 &direction, float chunk_extent,
+                     float max_distance, RayHit *hit) const;
+
+        // Draws all chunks with the currently bound program, the ones with
+        // their center farther than lod_distance from eye with their coarse
+        // mesh. Borders match between both, so neighbours do not crack.
+        // Every chunk sets uniform_mvp to mvp times its decode matrix. Chunks
+        // outside the frustum of mvp are skipped and counted into stats.
+        void Render(GLuint attrib_vertices, GLint uniform_mvp, const glm::mat4 &mvp,
+                    GLenum render_mode, const glm::vec3 &eye, float chunk_extent,
+                    float lod_distance, CullStats *stats) const;
+
+        // Drops all chunks and their buffers.
+        void Clear();
+
+        // @return: allocated bytes of all buffers, kept free ones included.
+        size_t GetGpuBytes() const;
+
+    private:
+        struct ChunkBuffers {
+            GLuint vertex_buffer;
+            GLuint index_buffer;
+            // allocated sizes in bytes
+            size_t vertex_capacity;
+            size_t index_capacity;
+            // the coarse indices follow the full ones in the index buffer
+            GLsizei index_count;
+            GLsizei coarse_index_count;
+            ChunkMeshData mesh;
+        };
+
+        ChunkBuffers AcquireBuffers();
+
+        std::unordered_map <chisel::ChunkID, ChunkBuffers, chisel::ChunkHasher> chunks_;
+        std::vector <ChunkBuffers> free_buffers_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_CHUNK_MESH_CACHE_H_
@@ -9,15 +9,36 @@
 
 namespace tango_augmented_reality {
 
+    // Convex hull of a growing 2d point set. Points inside the current hull are
+    // rejected in O(log h), only the ones outside get merged with the hull
+    // vertices, so an update costs time in the new points instead of every
+    // point added so far.
     class ConvexHull {
     public:
 
-        // applies the convex hull algorithm to determine the convex hull
-        std::vector <glm::vec2> generateConvexHull(std::vector <glm::vec2> &points);
+        // adds points to the hull, true if the hull changed
+        bool insert(const std::vector <glm::vec2> &points);
+
+        // tests if a point lies inside or on the current hull
+        bool contains(glm::vec2 point) const;
+
+        // hull vertices in counter clockwise order, no point is repeated
+        const std::vector <glm::vec2> &getVertices() const { return vertices_; }
+
+        size_t size() const { return vertices_.size(); }
+
+        void clear();
 
         // tests if a point is Left|On|Right of an infinite line.
-        double isLeft(glm::vec2 P0, glm::vec2 P1, glm::vec2 P2);
+        static double isLeft(glm::vec2 P0, glm::vec2 P1, glm::vec2 P2);
+
+    private:
+        std::vector <glm::vec2> vertices_;
 
+        // points outside the hull and chain buffer of an insert, kept so
+        // updates do not reallocate
+        std::vector <glm::vec2> candidates_;
+        std::vector <glm::vec2> chain_;
     };
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_GUIDED_DEPTH_FILTER_H_
+#define TANGO_AUGMENTED_REALITY_GUIDED_DEPTH_FILTER_H_
+
+#include <GLES3/gl3.h>
+#include <tango-gl/util.h>
+
+namespace tango_augmented_reality {
+
+    // Guided filter of a depth texture with a color guide texture on the GPU
+    // (He et al., luminance guide). Each of the two box filters of the method
+    // is a horizontal and a vertical pass between float targets, the last pass
+    // writes gl_FragDepth back into the depth texture, so nothing is read back.
+    class GuidedDepthFilter {
+    public:
+        GuidedDepthFilter();
+
+        ~GuidedDepthFilter();
+
+        // Allocates the float targets for width x height textures, call on the
+        // GL thread.
+        //
+        // @return: false if float targets are not color renderable, the CPU
+        //          filter has to be used then.
+        bool Initialize(int width, int height);
+
+        // Filters depth_texture, which must be the depth attachment of
+        // depth_frame_buffer. Both textures are width x height and aligned.
+        // Leaves framebuffer 0 bound and restores the viewport.
+        //
+        // @param radius: box radius in pixels, as for cv::ximgproc::guidedFilter.
+        // @param eps: regularization for guide values in [0, 255], as for
+        //             cv::ximgproc::guidedFilter.
+        void Apply(GLuint guide_texture, GLuint depth_texture, GLuint depth_frame_buffer,
+                   int radius, double eps);
+
+        bool IsAvailable() const { return available_; }
+
+        void DeleteGlResources();
+
+    private:
+        // One box pass of program from source into target.
+        void RunPass(GLuint program, GLuint target, int dx, int dy, int radius);
+
+        int width_;
+        int height_;
+        bool available_;
+
+        // stats pass, box pass, coefficient pass and output pass
+        GLuint stats_program_;
+        GLuint box_program_;
+        GLuint coefficient_program_;
+        GLuint output_program_;
+
+        // ping pong float targets
+        GLuint textures_[2];
+        GLuint frame_buffers_[2];
+
+        // attribute free full screen triangle
+        GLuint vertex_array_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_GUIDED_DEPTH_FILTER_H_
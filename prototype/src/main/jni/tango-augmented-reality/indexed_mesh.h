@@ -0,0 +1,121 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_AUGMENTED_REALITY_INDEXED_MESH_H_
+#define TANGO_AUGMENTED_REALITY_INDEXED_MESH_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <tango-gl/util.h>
+
+#include "tango-augmented-reality/ray_cast.h"
+#include "tango-augmented-reality/view_frustum.h"
+
+namespace tango_augmented_reality {
+
+    // Merges vertices with bitwise identical positions. Marching cubes and the
+    // plane triangulation emit every triangle with its own three vertices, so
+    // welding them shares each vertex between all triangles around it.
+    class VertexWelder {
+    public:
+        void Clear();
+
+        // @return: index of the vertex with this position, added if it is new.
+        uint32_t Add(const glm::vec3 &position);
+
+        // Interleaved xyz of all distinct vertices in the order of their index.
+        const std::vector <GLfloat> &GetVertices() const { return vertices_; }
+
+    private:
+        struct Key {
+            uint32_t x, y, z;
+
+            bool operator==(const Key &other) const {
+                return x == other.x && y == other.y && z == other.z;
+            }
+        };
+
+        struct KeyHasher {
+            size_t operator()(const Key &key) const {
+                return (key.x * 73856093u) ^ (key.y * 19349663u) ^ (key.z * 83492791u);
+            }
+        };
+
+        std::unordered_map <Key, uint32_t, KeyHasher> indices_;
+        std::vector <GLfloat> vertices_;
+    };
+
+    // Welded triangle mesh drawn from a VBO/IBO pair. The geometry is set on any
+    // thread and uploaded by the next Render on the GL thread. Indices are 32 bit
+    // where the context supports them (ES 3 or OES_element_index_uint), otherwise
+    // the mesh is drawn without indices. Triangles are grouped into clusters
+    // of a coarse grid, so Render can skip the ones outside the view.
+    class IndexedMesh {
+    public:
+        IndexedMesh();
+
+        // @param triangles: three vertices per triangle.
+        void SetTriangles(const std::vector <glm::vec3> &triangles);
+
+        void Clear();
+
+        size_t GetTriangleCount() const { return indices_.size() / 3; }
+
+        size_t GetVertexCount() const { return welder_.GetVertices().size() / 3; }
+
+        // Nearest triangle along the ray closer than hit->distance.
+        bool RayCast(const glm::vec3 &origin, const glm::vec3 &direction, RayHit *hit) const;
+
+        // Uploads pending geometry and draws the clusters inside the frustum of
+        // mvp with the currently bound program, counting them into stats.
+        void Render(GLuint attrib_vertices, GLenum render_mode, const glm::mat4 &mvp,
+                    CullStats *stats);
+
+        // Frees the GL buffers, needs the GL thread.
+        void DeleteGlResources();
+
+        // @return: bytes of the uploaded buffers.
+        size_t GetGpuBytes() const { return gpu_bytes_; }
+
+    private:
+        // triangles [first, first + count) of indices_ and their bounds
+        struct Cluster {
+            size_t first;
+            size_t count;
+            glm::vec3 min;
+            glm::vec3 max;
+        };
+
+        void Upload();
+
+        VertexWelder welder_;
+        std::vector <uint32_t> indices_;
+        std::vector <Cluster> clusters_;
+        bool dirty_;
+
+        GLuint vertex_buffer_;
+        GLuint index_buffer_;
+        // number of indices, or of vertices when drawing without indices
+        GLsizei draw_count_;
+        bool indexed_;
+        size_t gpu_bytes_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_INDEXED_MESH_H_
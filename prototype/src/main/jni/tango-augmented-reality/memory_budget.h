@@ -0,0 +1,58 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_MEMORY_BUDGET_H_
+#define TANGO_AUGMENTED_REALITY_MEMORY_BUDGET_H_
+
+#include <stddef.h>
+
+#include <string>
+
+namespace tango_augmented_reality {
+
+    // Subsystems holding memory that grows with the session.
+    enum MemorySubsystem {
+        MEMORY_POINT_BUFFERS = 0,
+        MEMORY_OCTREE,
+        MEMORY_CHISEL_CHUNKS,
+        MEMORY_GPU_BUFFERS,
+        MEMORY_SUBSYSTEM_COUNT
+    };
+
+    // Every subsystem publishes its current bytes from its own thread, the
+    // values are read without locks by any other.
+    void SetMemoryUsage(MemorySubsystem subsystem, size_t bytes);
+
+    size_t GetMemoryUsage(MemorySubsystem subsystem);
+
+    size_t GetTotalMemoryUsage();
+
+    // @param bytes: 0 disables the budget.
+    void SetMemoryBudget(size_t bytes);
+
+    size_t GetMemoryBudget();
+
+    // @return: true if a budget is set and the subsystems exceed it.
+    bool IsOverMemoryBudget();
+
+    // One line per subsystem and the total against the budget, in megabytes.
+    std::string GetMemoryReport();
+
+    const char *GetMemorySubsystemName(MemorySubsystem subsystem);
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_MEMORY_BUDGET_H_
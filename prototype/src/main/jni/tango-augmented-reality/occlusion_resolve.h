@@ -0,0 +1,69 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_OCCLUSION_RESOLVE_H_
+#define TANGO_AUGMENTED_REALITY_OCCLUSION_RESOLVE_H_
+
+#include <GLES3/gl3.h>
+#include <tango-gl/util.h>
+
+namespace tango_augmented_reality {
+
+    // Single geometry pass for the occlusion. The reconstruction is drawn once
+    // into a frame buffer that pairs a color texture with the occlusion depth
+    // texture, then one full screen triangle writes the depth, and the color
+    // if the reconstruction is shown, into the bound frame buffer. This
+    // replaces drawing the reconstruction a second time on screen and blitting
+    // the depth, and a still view resolves from the textures alone.
+    class OcclusionResolve {
+    public:
+        OcclusionResolve();
+
+        ~OcclusionResolve();
+
+        // Attaches depth_texture, width x height, next to a new color texture,
+        // call on the GL thread.
+        //
+        // @return: false if the program or the frame buffer failed, the caller
+        //          has to blit the depth instead.
+        bool Initialize(GLuint depth_texture, int width, int height);
+
+        bool IsAvailable() const { return available_; }
+
+        // Target of the geometry pass when the color is resolved as well.
+        GLuint GetFrameBuffer() const { return frame_buffer_; }
+
+        // Draws the textures over the current viewport. The depth is written
+        // unconditionally, the color with the current blending where the
+        // geometry pass covered a pixel.
+        void Render(bool show_color) const;
+
+        void DeleteGlResources();
+
+    private:
+        bool available_;
+        GLuint program_;
+        GLuint color_texture_;
+        GLuint depth_texture_;
+        GLuint frame_buffer_;
+
+        // attribute free full screen triangle
+        GLuint vertex_array_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_OCCLUSION_RESOLVE_H_
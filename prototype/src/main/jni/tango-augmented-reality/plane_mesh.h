@@ -5,6 +5,7 @@
 #include <tango-gl/drawable_object.h>
 #include <mutex>
 
+#include "tango-augmented-reality/indexed_mesh.h"
 #include "tango-augmented-reality/reconstruction_octree.h"
 
 
@@ -15,14 +16,41 @@ namespace tango_augmented_reality {
 
         PlaneMesh(GLenum render_mode);
 
+        ~PlaneMesh();
+
         void SetShader();
 
         void Render(const glm::mat4 &projection_mat, const glm::mat4 &view_mat) const;
 
+        // Inserts the frame and reconstructs the changed leaves.
         void addPoints(glm::mat4 transformation, std::vector <float> &vertices);
 
+        // Inserts the frame into the tree without reconstructing, cheap enough
+        // to run for every depth frame. The points are multiplied from the left
+        // with transformation, like addPoints does.
+        void insertPoints(const glm::mat4 &transformation, const std::vector <float> &vertices);
+
+        // Runs the plane detection on the leaves changed since the last call.
+        void reconstruct();
+
         void updateVertices();
 
+        // Nearest plane along a world space ray in the last updateVertices mesh.
+        bool raycast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance,
+                     RayHit *hit);
+
+        // @return: number of triangles of the last updateVertices call.
+        size_t getTriangleCount() const { return mesh_.GetTriangleCount(); }
+
+        // Publishes the bytes of the tree's points and of its leaves and planes.
+        void reportMemory();
+
+        // Subsamples the points the tree did not assign to a plane yet.
+        void trimPoints();
+
+        // @return: bytes of the uploaded mesh, GL thread.
+        size_t getGpuBytes() const { return mesh_.GetGpuBytes(); }
+
         std::mutex render_mutex;
 
         void clear();
@@ -33,6 +61,12 @@ namespace tango_augmented_reality {
 
         ReconstructionOcTree* tree;
 
+        // world space points of the last inserted frame
+        std::vector <glm::vec3> transformed_points_;
+
+        // uploaded by the first Render after updateVertices
+        mutable IndexedMesh mesh_;
+
     };
 
 }  // namespace tango_augmented_reality
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_PLANE_OCCUPANCY_GRID_H_
+#define TANGO_AUGMENTED_REALITY_PLANE_OCCUPANCY_GRID_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace tango_augmented_reality {
+
+    // Sparse grid over a plane's 2d projection frame that counts the inliers
+    // per cell. Unlike the convex hull it follows concave outlines and holes,
+    // so L-shaped floors or a table next to a wall are not over-covered.
+    class PlaneOccupancyGrid {
+    public:
+        // @param cell_size: edge length of a cell in meters.
+        explicit PlaneOccupancyGrid(float cell_size = 0.05f);
+
+        // Counts the points into their cells.
+        // @return: true if a cell became occupied.
+        bool insert(const std::vector <glm::vec2> &points);
+
+        // Counts count points at point into its cell.
+        // @return: true if the cell became occupied.
+        bool insert(glm::vec2 point, int count);
+
+        // Centers and point counts of all cells, occupied or not.
+        void getCells(std::vector <glm::vec2> *centers, std::vector <int> *counts) const;
+
+        // @return: number of occupied cells.
+        size_t getOccupiedCount() const { return occupied_count_; }
+
+        // Covers the occupied cells with axis aligned rectangles, two triangles
+        // each. While the rectangles need more than vertex_budget corners, 2x2
+        // cells are merged into one, a merged cell is occupied if any of its
+        // cells is.
+        //
+        // @param triangles: receives three corners per triangle, counter
+        //                   clockwise in the plane frame.
+        void triangulate(int vertex_budget, std::vector <glm::vec2> *triangles) const;
+
+        void clear();
+
+        // @return: approximate heap bytes of the cells.
+        size_t getBytes() const;
+
+    private:
+        struct Rectangle {
+            int x;
+            int y;
+            int width;
+            int height;
+        };
+
+        // greedy rectangle cover of the occupancy at 2^level merged cells
+        void coverCells(int level, std::vector <Rectangle> *rectangles) const;
+
+        float cell_size_;
+        std::unordered_map <uint64_t, uint16_t> cell_points_;
+        size_t occupied_count_ = 0;
+        // bounds of the occupied cells
+        int32_t min_x_ = 0;
+        int32_t min_y_ = 0;
+        int32_t max_x_ = -1;
+        int32_t max_y_ = -1;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_PLANE_OCCUPANCY_GRID_H_
@@ -0,0 +1,65 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_AUGMENTED_REALITY_PLANE_RANSAC_H_
+#define TANGO_AUGMENTED_REALITY_PLANE_RANSAC_H_
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace tango_augmented_reality {
+
+    // Plane hypothesis in hesse normal form and the number of supporting points.
+    struct PlaneHypothesis {
+        glm::vec3 normal;
+        float distance = 0.0f;
+        int support = -1;
+    };
+
+    // Counts the points with |dot(normal, point) - distance| < threshold, four at
+    // a time with NEON where available.
+    int CountPlaneSupport(const glm::vec3 &normal, float distance, float threshold,
+                          const glm::vec3 *points, size_t count);
+
+    // Writes dot(normal, point) - distance of count points to distances, four at
+    // a time with NEON where available.
+    void ComputePlaneDistances(const glm::vec3 &normal, float distance,
+                               const glm::vec3 *points, size_t count, float *distances);
+
+    // RANSAC plane search that scores hypotheses in batches across the shared
+    // thread pool. Hypothesis i draws its sample from its own generator seeded
+    // with (seed, i), so results do not depend on the number of threads.
+    //
+    // @param iterations: maximum number of hypotheses.
+    // @param sufficient_support: stops after the batch reaching this support.
+    // @return: best hypothesis, support stays -1 if no sample was usable.
+    PlaneHypothesis DetectPlaneRansac(const std::vector <glm::vec3> &points, int iterations,
+                                      float threshold, int sufficient_support, uint32_t seed);
+
+    // Preemptive RANSAC: all hypotheses are scored on a growing random subset of
+    // the points, after each round the weaker half is dropped. The search ends
+    // once one hypothesis is left, the subset covers all points, or the leader's
+    // inlier ratio on a large enough subset reaches sufficient_support / size.
+    //
+    // @return: best hypothesis with its support extrapolated to all points.
+    PlaneHypothesis DetectPlanePreemptive(const std::vector <glm::vec3> &points, int hypotheses,
+                                          float threshold, int sufficient_support,
+                                          uint32_t seed);
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_PLANE_RANSAC_H_
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_PLANE_REGISTRY_H_
+#define TANGO_AUGMENTED_REALITY_PLANE_REGISTRY_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "tango-augmented-reality/reconstructor.h"
+
+namespace tango_augmented_reality {
+
+    // Planes shared by the octree leaves. A wall or floor spanning many leaves
+    // is detected in each of them, the registry merges these co-planar leaf
+    // planes of neighbouring leaves into one shared plane with one outline and
+    // one mesh.
+    class PlaneRegistry {
+    public:
+        // Registers the planes of a leaf after its reconstruction. A new leaf
+        // plane joins a compatible shared plane of the leaf or its neighbours,
+        // when it fits several of them they are merged. The leaf planes' last
+        // inliers extend their shared planes.
+        //
+        // @param neighbour_keys: keys of the leaf and its neighbours.
+        void update(uint64_t leaf_key, const std::vector <uint64_t> &neighbour_keys,
+                    Reconstructor *reconstructor);
+
+        // Refits and remeshes the shared planes changed by update.
+        void updateMeshes();
+
+        // @return: triangles of all shared planes.
+        const std::vector <glm::vec3> &getMesh() const { return mesh_; }
+
+        // @return: number of shared planes.
+        int getPlaneCount() const { return plane_count_; }
+
+        void clear();
+
+        // @return: approximate heap bytes of the shared planes and the mesh.
+        size_t getBytes() const;
+
+    private:
+        // shared plane id a merged id went into
+        int find(int id);
+
+        // tests if plane lies in shared_plane
+        bool isCompatible(const Plane &shared_plane, const Plane &plane) const;
+
+        // moves the sums and outline of source into target
+        void merge(int target, int source);
+
+        std::vector <Plane> planes_;
+        // merged planes point to the plane they went into, others to themselves
+        std::vector <int> parents_;
+        std::vector <bool> changed_;
+        // shared planes each leaf contributed to
+        std::unordered_map <uint64_t, std::vector <int>> leaf_planes_;
+        std::vector <glm::vec3> mesh_;
+        bool mesh_changed_ = false;
+        int plane_count_ = 0;
+
+        // cosine of the largest angle between merged normals
+        float merge_normal_cos = 0.985f;
+        // largest distance between a leaf plane's centroid and its shared plane
+        float merge_distance = 0.06f;
+        // mesh the occupied cells of a plane instead of its convex hull
+        bool mesh_occupancy_grid = true;
+        // corners the mesh of one shared plane may use
+        int mesh_vertex_budget = 256;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_PLANE_REGISTRY_H_
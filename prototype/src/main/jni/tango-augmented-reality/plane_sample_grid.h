@@ -0,0 +1,76 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_PLANE_SAMPLE_GRID_H_
+#define TANGO_AUGMENTED_REALITY_PLANE_SAMPLE_GRID_H_
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace tango_augmented_reality {
+
+    // One inlier standing for count inliers of its cell.
+    struct PlaneSample {
+        glm::vec3 point;
+        // point in the plane's projection frame
+        glm::vec2 projection;
+        int count;
+    };
+
+    // Spatially stratified reservoir of the inliers a plane gathers between
+    // two reconstructions. Every cell of a grid over the projection frame keeps
+    // one uniformly drawn inlier and the number of inliers that fell into it,
+    // so the hull and occupancy updates cost time in covered cells instead of
+    // in points, however long the plane was looked at. The fit does not need
+    // the points, it keeps running sums over all of them.
+    class PlaneSampleGrid {
+    public:
+        // @param cell_size: edge length of a cell in meters, the size of the
+        //                   occupancy grid cells keeps their counts exact.
+        // @param capacity: cells kept, inliers of further cells are dropped
+        //                  until the next take or clear.
+        explicit PlaneSampleGrid(float cell_size = 0.05f, size_t capacity = 4096);
+
+        // @param projection: point in the plane's projection frame.
+        void insert(const glm::vec3 &point, glm::vec2 projection);
+
+        const std::vector <PlaneSample> &getSamples() const { return samples_; }
+
+        // Moves the samples out, the grid starts over empty.
+        void take(std::vector <PlaneSample> *samples);
+
+        bool empty() const { return samples_.empty(); }
+
+        void clear();
+
+        // @return: heap bytes of the samples and the cell index.
+        size_t getBytes() const;
+
+    private:
+        float cell_size_;
+        size_t capacity_;
+        std::unordered_map <uint64_t, uint32_t> cells_;
+        std::vector <PlaneSample> samples_;
+        // xorshift state of the reservoir draws
+        uint32_t random_ = 2463534242u;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_PLANE_SAMPLE_GRID_H_
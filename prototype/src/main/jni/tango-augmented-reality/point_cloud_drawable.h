@@ -20,11 +20,16 @@
 #include <jni.h>
 #include <vector>
 
+#include <GLES3/gl3.h>
 #include <tango-gl/util.h>
 
 namespace tango_augmented_reality {
 
-// PointCloudDrawable is responsible for the point cloud rendering.
+// PointCloudDrawable is responsible for the point cloud rendering. The last
+// few depth frames are kept with their poses and all of them are drawn into the
+// current view, the depth test keeps the nearest point of every pixel. The
+// fused occlusion is dense with small points rather than large splats of the
+// newest frame only.
     class PointCloudDrawable {
     public:
         PointCloudDrawable();
@@ -32,20 +37,51 @@ namespace tango_augmented_reality {
         // Free all GL Resources, i.e, shaders, buffers.
         void DeleteGlResources();
 
-        // Update current point cloud data.
+        // Upload a new point cloud frame into the next buffer of the ring. Call
+        // once per depth frame, every Render until the next upload draws it.
+        //
+        // @param vertices: all vertices in this point cloud frame.
+        // @param model_mat: model matrix for this point cloud frame.
+        // @param timestamp: depth timestamp of the frame, in seconds.
+        void UpdateVertices(const std::vector <float> &vertices, const glm::mat4 &model_mat,
+                            double timestamp);
+
+        // Render the fused point cloud frames.
         //
         // @param projection_mat: projection matrix from current render camera.
         // @param view_mat: view matrix from current render camera.
-        // @param model_mat: model matrix for this point cloud frame.
-        // @param vertices: all vertices in this point cloud frame.
-        void Render(glm::mat4 projection_mat, glm::mat4 view_mat, glm::mat4 model_mat,
-                    const std::vector <float> &vertices);
+        void Render(glm::mat4 projection_mat, glm::mat4 view_mat);
 
         void SetVisibility(bool visible);
 
+        // Number of recent frames drawn together, 1 draws the newest frame
+        // only with the large points it needs to cover its holes.
+        void SetFusedFrames(int count);
+
+        // Most frames drawn together.
+        static const int kMaxFusedFrames = 4;
+
     private:
-        // Vertex buffer of the point cloud geometry.
-        GLuint vertex_buffers_;
+        // Number of buffers the uploads rotate through. The next upload goes
+        // to a buffer the last Render did not draw, so a new frame never waits
+        // for the GPU.
+        static const int kBufferCount = kMaxFusedFrames + 1;
+
+        // Vertex buffers of the point cloud geometry.
+        GLuint vertex_buffers_[kBufferCount];
+
+        // Allocated size of each buffer in floats.
+        size_t buffer_capacity_[kBufferCount];
+
+        // Number of points, pose and timestamp of the frame in each buffer.
+        GLsizei point_count_[kBufferCount];
+        glm::mat4 model_mat_[kBufferCount];
+        double timestamp_[kBufferCount];
+
+        // Buffer holding the last uploaded frame.
+        int current_buffer_;
+
+        int fused_frames_ = kMaxFusedFrames;
 
         // Shader to display point cloud.
         GLuint shader_program_;
@@ -53,12 +89,14 @@ namespace tango_augmented_reality {
         // Handle to vertex attribute value in the shader.
         GLuint vertices_handle_;
 
-        GLboolean vertices_visible_handle_;
+        GLint vertices_visible_handle_;
 
         bool visible = true;
 
         // Handle to the model view projection matrix uniform in the shader.
         GLuint mvp_handle_;
+
+        GLint point_size_handle_;
     };
 }  // namespace tango_point_cloud
 
@@ -0,0 +1,66 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_AUGMENTED_REALITY_POINT_CLOUD_FRAME_POOL_H_
+#define TANGO_AUGMENTED_REALITY_POINT_CLOUD_FRAME_POOL_H_
+
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <tango_client_api.h>  // NOLINT
+
+#include "tango-augmented-reality/triple_buffer.h"
+
+namespace tango_augmented_reality {
+
+    // One depth frame with the scene's point scaling applied. XYZij.xyz points
+    // into vertices, so the frame can be handed to code that expects either.
+    struct PointCloudFrame {
+        std::vector <float> vertices;
+        TangoXYZij XYZij;
+        glm::mat4 transformation;
+    };
+
+    // Triple buffer of preallocated point cloud frames between the depth
+    // callback (single producer) and the GL thread (single consumer).
+    class PointCloudFramePool {
+    public:
+        // @param max_points: points per frame to preallocate, larger frames grow the
+        //                    producer's slot.
+        explicit PointCloudFramePool(size_t max_points);
+
+        // Producer side. Fill the returned frame, then Publish it. The frame stays
+        // owned by the producer until Publish.
+        PointCloudFrame *BeginWrite() { return frames_.BeginWrite(); }
+
+        // Resizes the frame returned by BeginWrite to point_count points.
+        void SetPointCount(PointCloudFrame *frame, size_t point_count);
+
+        void Publish() { frames_.Publish(); }
+
+        // Consumer side. Takes the most recently published frame if there is one.
+        // @return: true if Current changed.
+        bool Acquire() { return frames_.Acquire(); }
+
+        // Frame taken by the last successful Acquire, nullptr before the first.
+        PointCloudFrame *Current() { return frames_.Current(); }
+
+    private:
+        TripleBuffer <PointCloudFrame> frames_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_POINT_CLOUD_FRAME_POOL_H_
@@ -55,6 +55,7 @@ class PoseData {
   // @param: imu_T_device, imu_T_device_ matrix.
   void SetImuTDevice(const glm::mat4& imu_T_device) {
     imu_T_device_ = imu_T_device;
+    UpdateCameraFrames();
   }
 
   // @return: color camera frame with respect to IMU frame.
@@ -67,12 +68,14 @@ class PoseData {
   // @param: imu_T_color_camera, imu_T_color_camera_ matrix.
   void SetImuTColorCamera(const glm::mat4& imu_T_color_camera) {
     imu_T_color_camera_ = imu_T_color_camera;
+    UpdateCameraFrames();
   }
 
   // Set depth camera frame with respect to IMU frame matrix.
   // @param: imu_T_depth_camera, imu_T_depth_camera_ matrix.
   void SetImuTDepthCamera(const glm::mat4& imu_T_depth_camera) {
     imu_T_depth_camera_ = imu_T_depth_camera;
+    UpdateCameraFrames();
   }
 
   // Get pose transformation in OpenGL coordinate system. This function also
@@ -102,6 +105,10 @@ class PoseData {
   // Format the pose debug string based on current pose and previous pose data.
   void FormatPoseString();
 
+  // Precomputes the constant part of the extrinsics chains, called whenever
+  // one of the extrinsics is set.
+  void UpdateCameraFrames();
+
   // Device frame with respect to IMU frame.
   glm::mat4 imu_T_device_;
 
@@ -111,6 +118,11 @@ class PoseData {
   // Depth camera frame with respect to IMU frame.
   glm::mat4 imu_T_depth_camera_;
 
+  // Constant factors of the chains, the pose is the only part that changes.
+  glm::mat4 opengl_world_T_tango_world_;
+  glm::mat4 device_T_opengl_color_camera_;
+  glm::mat4 device_T_opengl_depth_camera_;
+
   // Pose data of current frame.
   TangoPoseData cur_pose_;
 
@@ -0,0 +1,138 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_PROFILER_H_
+#define TANGO_AUGMENTED_REALITY_PROFILER_H_
+
+#include <stdint.h>
+
+#include <string>
+
+#include <GLES3/gl3.h>
+
+namespace tango_augmented_reality {
+
+    // Timed stages of the render thread and the reconstruction workers.
+    enum ProfileStage {
+        PROFILE_FRAME = 0,
+        PROFILE_YUV_CONVERT,
+        PROFILE_TEXTURE_UPLOAD,
+        PROFILE_OCCLUSION_DRAW,
+        PROFILE_FBO_PASS,
+        PROFILE_READBACK,
+        PROFILE_FILTER,
+        PROFILE_DEPTH_PREVIEW,
+        PROFILE_INTEGRATE,
+        PROFILE_CHISEL_ADD_POINTS,
+        PROFILE_CHISEL_MESH,
+        PROFILE_RECONSTRUCT,
+        PROFILE_TSDF_RAYCAST,
+        PROFILE_STAGE_COUNT
+    };
+
+    // Per frame counts of the render thread, the last value is reported.
+    enum ProfileCounter {
+        PROFILE_DRAWN_BATCHES = 0,
+        PROFILE_CULLED_BATCHES,
+        PROFILE_COUNTER_COUNT
+    };
+
+    // Rolling statistics of the last samples of one stage, in milliseconds.
+    struct ProfileStats {
+        uint32_t count = 0;
+        float mean = 0.0f;
+        float p50 = 0.0f;
+        float p90 = 0.0f;
+        float p99 = 0.0f;
+    };
+
+    // Every thread records into its own ring of the last samples per stage,
+    // without locks. Readers merge the rings of all live threads, a ring is
+    // dropped when its thread exits.
+    //
+    // @param gpu: sample is GPU time measured by GpuTimer.
+    void RecordProfileSample(ProfileStage stage, uint32_t microseconds, bool gpu = false);
+
+    // @return: false if the stage has no samples yet.
+    bool GetProfileStats(ProfileStage stage, bool gpu, ProfileStats *stats);
+
+    void SetProfileCounter(ProfileCounter counter, int value);
+
+    int GetProfileCounter(ProfileCounter counter);
+
+    // One line per stage with samples, CPU and GPU, then the counters.
+    std::string GetProfileReport();
+
+    const char *GetProfileStageName(ProfileStage stage);
+
+    const char *GetProfileCounterName(ProfileCounter counter);
+
+    int64_t ProfileNowMicroseconds();
+
+    // GPU time of render stages via EXT_disjoint_timer_query. Queries are read
+    // a few frames later when their results are available, stages may not
+    // nest. Without the extension all calls do nothing.
+    class GpuTimer {
+    public:
+        GpuTimer();
+
+        // Checks for the extension and creates the queries, call on the GL
+        // thread.
+        void Initialize();
+
+        void DeleteGlResources();
+
+        bool IsAvailable() const { return available_; }
+
+        void Begin(ProfileStage stage);
+
+        void End();
+
+        // Records the results that arrived, call once per frame.
+        void Collect();
+
+    private:
+        // frames a query may stay in flight before its slot is reused
+        static const int kLatency = 4;
+
+        bool available_;
+        GLuint queries_[PROFILE_STAGE_COUNT][kLatency];
+        bool pending_[PROFILE_STAGE_COUNT][kLatency];
+        int next_[PROFILE_STAGE_COUNT];
+        int active_stage_;
+    };
+
+    // Records the lifetime of the scope as a sample of stage, and its GPU time
+    // if a GpuTimer is given.
+    class ScopedTimer {
+    public:
+        explicit ScopedTimer(ProfileStage stage, GpuTimer *gpu_timer = nullptr);
+
+        ~ScopedTimer();
+
+    private:
+        ProfileStage stage_;
+        GpuTimer *gpu_timer_;
+        int64_t start_;
+
+        ScopedTimer(const ScopedTimer &);
+
+        ScopedTimer &operator=(const ScopedTimer &);
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_PROFILER_H_
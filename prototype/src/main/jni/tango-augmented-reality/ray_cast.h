@@ -0,0 +1,141 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_RAY_CAST_H_
+#define TANGO_AUGMENTED_REALITY_RAY_CAST_H_
+
+#include <stdint.h>
+
+#include <cmath>
+#include <unordered_map>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+namespace tango_augmented_reality {
+
+    // Nearest surface along a ray.
+    struct RayHit {
+        glm::vec3 position;
+        // unit normal facing the ray origin
+        glm::vec3 normal;
+        // distance from the origin along the ray
+        float distance = 0.0f;
+    };
+
+    // Visits the cells of a uniform grid a ray passes through, in order, with
+    // the ray distances it enters and leaves them at (Amanatides & Woo).
+    // Stops after max_distance or when visit(x, y, z, enter, exit) returns
+    // false.
+    //
+    // @param direction: unit direction of the ray.
+    template <typename Visitor>
+    void TraverseGrid(const glm::vec3 &origin, const glm::vec3 &direction, float cell_size,
+                      float max_distance, Visitor visit) {
+        int cell[3];
+        int step[3];
+        float next[3];
+        float delta[3];
+        for (int i = 0; i < 3; ++i) {
+            cell[i] = static_cast<int>(std::floor(origin[i] / cell_size));
+            if (direction[i] > 0.0f) {
+                step[i] = 1;
+                next[i] = ((cell[i] + 1) * cell_size - origin[i]) / direction[i];
+                delta[i] = cell_size / direction[i];
+            } else if (direction[i] < 0.0f) {
+                step[i] = -1;
+                next[i] = (cell[i] * cell_size - origin[i]) / direction[i];
+                delta[i] = -cell_size / direction[i];
+            } else {
+                step[i] = 0;
+                next[i] = INFINITY;
+                delta[i] = INFINITY;
+            }
+        }
+        float enter = 0.0f;
+        while (enter <= max_distance) {
+            int axis = next[0] < next[1] ? (next[0] < next[2] ? 0 : 2)
+                                         : (next[1] < next[2] ? 1 : 2);
+            float exit = next[axis];
+            if (!visit(cell[0], cell[1], cell[2], enter, exit)) {
+                return;
+            }
+            cell[axis] += step[axis];
+            next[axis] += delta[axis];
+            enter = exit;
+        }
+    }
+
+    // Nearest hit of a ray with a triangle soup of three vertices per
+    // triangle, hits beyond hit->distance are ignored.
+    //
+    // @param direction: unit direction of the ray.
+    // @return: true if hit was updated.
+    bool RayCastTriangles(const glm::vec3 &origin, const glm::vec3 &direction,
+                          const glm::vec3 *triangles, size_t triangle_count, RayHit *hit);
+
+    // Same for an indexed mesh of three floats per vertex.
+    bool RayCastIndexedTriangles(const glm::vec3 &origin, const glm::vec3 &direction,
+                                 const float *vertices, const uint16_t *indices,
+                                 size_t index_count, RayHit *hit);
+
+    bool RayCastIndexedTriangles(const glm::vec3 &origin, const glm::vec3 &direction,
+                                 const float *vertices, const uint32_t *indices,
+                                 size_t index_count, RayHit *hit);
+
+    // Uniform grid over one point cloud, for picking points along a ray. Build
+    // is linear in the points, a ray only looks at the cells near its path.
+    class PointCloudRayIndex {
+    public:
+        // @param cell_size: edge of a grid cell, the largest pick radius.
+        explicit PointCloudRayIndex(float cell_size = 0.05f);
+
+        // @param xyz: count points of three floats.
+        void Build(const float *xyz, size_t count);
+
+        void Clear();
+
+        // The nearest point along the ray closer than cell_size to it. The
+        // normal is fitted to the points around it.
+        //
+        // @param direction: unit direction of the ray.
+        bool Cast(const glm::vec3 &origin, const glm::vec3 &direction, float max_distance,
+                  RayHit *hit) const;
+
+    private:
+        struct CellRange {
+            uint32_t begin;
+            uint32_t end;
+        };
+
+        static uint64_t Key(int x, int y, int z);
+
+        const CellRange *Find(int x, int y, int z) const;
+
+        // normal of the points within two cells of position, facing direction's
+        // origin
+        glm::vec3 FitNormal(const glm::vec3 &position, const glm::vec3 &direction) const;
+
+        float cell_size_;
+        // points sorted by cell
+        std::vector <glm::vec3> points_;
+        std::unordered_map <uint64_t, CellRange> cells_;
+        std::vector <std::pair <uint64_t, uint32_t>> sort_buffer_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_RAY_CAST_H_
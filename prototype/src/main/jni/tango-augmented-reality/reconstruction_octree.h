@@ -3,7 +3,11 @@
 //
 
 #include <tango-gl/util.h>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
 #include <vector>
+#include "plane_registry.h"
 #include "reconstructor.h"
 
 #ifndef MASTERPROTOTYPE_RECONSTRUCTION_OCTREE_H
@@ -11,6 +15,9 @@
 
 namespace tango_augmented_reality {
 
+    // Leaves of a regular octree over a cube. Only the leaves hold data, so
+    // they are kept flat in a pool and found by the Morton code of their grid
+    // cell instead of descending depth levels of nodes.
     class ReconstructionOcTree {
     public:
 
@@ -22,9 +29,15 @@ namespace tango_augmented_reality {
         // counts the filled cluster in Octree
         int getClusterCount();
 
-        // add a single point to the deepest level
+        // counts the planes after merging them across clusters
+        int getPlaneCount();
+
+        // add a single point to its leaf
         void addPoint(glm::vec3 point);
 
+        // add count points, they are binned by leaf with a radix sort and each
+        // leaf gets its bucket in one call
+        void addPoints(const glm::vec3 *points, size_t count);
 
         // triggers the clusters reconstruction
         void reconstruct();
@@ -32,33 +45,61 @@ namespace tango_augmented_reality {
         // collects the reconstructed mesg from each cluster
         std::vector <glm::vec3> getMesh();
 
-        // instance of a reconstructor for mesh generation
-        Reconstructor *reconstructor;
-
-        // removes the current plane reconstruction
+        // removes the current plane reconstruction and frees all leaves
         void clear();
 
+        // Heap bytes of the points waiting in the leaves and the sort buffers,
+        // and of the leaves, their planes and the merged planes.
+        void getMemoryUsage(size_t *point_bytes, size_t *tree_bytes) const;
+
+        // Subsamples the points waiting for plane detection in every leaf and
+        // frees the sort buffers, for when the memory budget is exceeded.
+        void trimPoints();
+
     private:
-        // size of a cubic node
+        struct KeyedPoint {
+            uint64_t key;
+            glm::vec3 point;
+        };
+
+        struct Leaf {
+            uint64_t key;
+            Reconstructor reconstructor;
+            // boolean flag if the points got updated
+            bool updated = false;
+        };
+
+        // size of the cubic root node
         float range_;
-        // size / 2 of a cubic node
-        float halfRange_;
-        // depth tree depth of current node
-        int depth_;
-        // spatial position of node
+        // inverse edge length of a leaf
+        float inverse_leaf_range_;
+        // leaves per axis
+        uint32_t resolution_;
+        // significant bits of a leaf Morton code
+        int key_bits_;
+        // spatial position of the root node
         glm::vec3 position_;
-        // array of child node status
-        bool is_available_[8];
-        // 8 children of a node
-        ReconstructionOcTree **children_;
-        // boolean flag if the points got updated
-        bool updated;
-
-        // get Octree child index of a given point
-        int getChildIndex(glm::vec3 point);
-
-        // initializes an Octree child node at a given location
-        void initChild(glm::vec3 location, int index);
+
+        // sort buffers of addPoints, kept to avoid reallocating per frame
+        std::vector <KeyedPoint> keyed_points_;
+        std::vector <KeyedPoint> sort_buffer_;
+        std::vector <glm::vec3> bucket_;
+
+        // planes of all leaves, merged across leaf borders
+        PlaneRegistry registry_;
+
+        // leaf pool and the index of each leaf by Morton code
+        std::vector <std::unique_ptr<Leaf>> leaves_;
+        std::unordered_map <uint64_t, uint32_t> leaf_index_;
+
+        // Morton code of the leaf holding point, false if it is outside the root
+        bool getLeafKey(const glm::vec3 &point, uint64_t *key) const;
+
+        // finds or creates the leaf of a Morton code
+        Leaf *getLeaf(uint64_t key);
+
+        // Morton codes of the leaf and its up to 26 neighbours
+        void getNeighbourKeys(uint64_t key, std::vector <uint64_t> *keys) const;
     };
 
 }
@@ -10,6 +10,8 @@
 #include <Eigen/Eigenvalues>
 
 #include "convex_hull.h"
+#include "plane_occupancy_grid.h"
+#include "plane_sample_grid.h"
 
 #ifndef MASTERPROTOTYPE_RECONSTRUCTOR_H
 #define MASTERPROTOTYPE_RECONSTRUCTOR_H
@@ -25,32 +27,73 @@ namespace tango_augmented_reality {
         // plane distance from origin (hesse normal form)
         float distance = 0.0;
 
-        // variables for the projection calculation
+        // variables for the projection calculation, fixed when the plane is
+        // detected so the hull coordinates stay valid while the fit is refined
         glm::vec3 plane_origin;
         glm::quat plane_z_rotation;
         glm::quat inverse_plane_z_rotation;
 
-        // current 3d convex hull of plane
-        std::vector <glm::vec3> points;
+        // inliers assigned since the last reconstruction, waiting for the hull,
+        // one sample per occupancy cell
+        PlaneSampleGrid points;
+
+        // current 2d convex hull of plane in the projection frame
+        ConvexHull hull;
+
+        // inlier coverage of plane in the projection frame
+        PlaneOccupancyGrid occupancy;
+
+        // triangles of the current hull
+        std::vector <glm::vec3> mesh;
+
+        // inlier samples folded in by the last reconstruction
+        std::vector <PlaneSample> last_inliers;
+
+        // plane of the PlaneRegistry this plane is part of
+        int shared_id = -1;
+
+        // running sums over all inliers, the fit follows from them
+        size_t point_count = 0;
+        Eigen::Vector3d point_sum = Eigen::Vector3d::Zero();
+        Eigen::Matrix3d scatter = Eigen::Matrix3d::Zero();
 
         Plane(glm::vec3 normal, float distance);
 
         Plane() { };
 
-        Plane &operator=(const Plane &plane) {
-            normal = plane.normal;
-            distance = plane.distance;
-            plane_origin = plane.plane_origin;
-            plane_z_rotation = plane.plane_z_rotation;
-            inverse_plane_z_rotation = plane.inverse_plane_z_rotation;
-            points = plane.points;
-        };
+        // calculates the signed distance between a point and this plane
+        float distanceTo(glm::vec3 point) const;
+
+        // project a point into the projection frame
+        glm::vec2 toPlane(glm::vec3 point) const;
+
+        // project a point back from the projection frame onto the plane
+        glm::vec3 fromPlane(glm::vec2 point) const;
+
+        // adds an inlier to the running sums in O(1)
+        void addToFit(glm::vec3 point);
+
+        // adds count inliers at point to the running sums
+        void addToFit(glm::vec3 point, int count);
+
+        // fits normal and distance to all inliers so far, false if they are
+        // too few, the projection frame stays untouched
+        bool refit();
+
+        // sets the projection frame from normal and distance
+        void updateFrame();
 
-        // calculates the distance between a point and this plane
-        float distanceTo(glm::vec3 point);
+        // triangulates the occupancy or the hull into mesh
+        void updateMesh(bool occupancy_grid, int vertex_budget);
 
         // computes the plane model from three points
         static Plane calculatePlane(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2);
+
+        // @return: heap bytes of the pending and last inliers.
+        size_t getPointBytes() const;
+
+        // @return: heap bytes of the outline, occupancy and mesh.
+        size_t getOutlineBytes() const;
     };
 
     class Reconstructor {
@@ -67,6 +110,9 @@ namespace tango_augmented_reality {
         // add a point to a plane or the main point pool
         void addPoint(glm::vec3 point);
 
+        // adds count points, each plane tests the whole batch at once
+        void addPoints(const glm::vec3 *points, size_t count);
+
         // clear points of the main point pool
         void clearPoints();
 
@@ -76,6 +122,27 @@ namespace tango_augmented_reality {
         // resets the reconstructor
         void reset();
 
+        // @return: heap bytes of the point pool, the ransac buffers and the
+        // planes' inliers.
+        size_t getPointBytes() const;
+
+        // @return: heap bytes of the planes' outlines and the mesh.
+        size_t getOutlineBytes() const;
+
+        // Keeps every second point of the pool and frees the buffers of the
+        // last reconstruction. The planes' fits live in their running sums,
+        // so only the detection of new planes sees fewer points.
+        void trimPoints();
+
+        // leaves meshing to a PlaneRegistry, the planes only refit and hand
+        // their new inliers on in Plane::last_inliers
+        void setShared(bool shared) { shared_ = shared; }
+
+        // @return: true if plane i got detected
+        bool isPlaneAvailable(int i) const { return plane_available[i]; }
+
+        Plane &getPlane(int i) { return planes[i]; }
+
         Reconstructor();
 
 
@@ -83,41 +150,38 @@ namespace tango_augmented_reality {
         // the resulting mesh
         std::vector <glm::vec3> mesh_;
 
-        // uses RANSAC to detect a plane model
+        // uses RANSAC to detect a plane model, fitted to its supporting points
         Plane detectPlane(std::vector <glm::vec3> &points);
 
-        // project points onto the plane
-        std::vector <glm::vec2> project(Plane plane, std::vector <glm::vec3> &points);
-
-        // project points back from the plane
-        std::vector <glm::vec3> project(Plane plane, std::vector <glm::vec2> &points);
-
-        // computes the support of the plane against points with ransac_threshold
-        int ransacEstimateSupportingPoints(Plane plane, std::vector <glm::vec3> &points);
-
-        // computes the support of the plane against points with ransac_threshold
-        int *ransacPickThreeRandomPoints(std::vector < glm::vec3 > &points);
+        // adds the plane's new inliers to its hull and occupancy and refines
+        // the fit, true if the outline used for meshing changed
+        bool updatePlane(Plane &plane);
 
-        // method to apply linear regression with best supporting points and plane
-        Plane ransacApplyLinearRegression(Plane plane,  std::vector <glm::vec3> &points);
+        // projections of the samples, in the frame they were inserted with
+        std::vector <glm::vec2> project(const std::vector <PlaneSample> &samples);
 
-        // scales given points around calculated centroid
-        void scaleAroundCentroid(float scale, std::vector <glm::vec3> &points);
+        // counts the samples into the plane's occupancy grid, true if a cell
+        // became occupied
+        bool occupy(Plane &plane, const std::vector <PlaneSample> &samples);
 
         // how many random samples we're going to test
         int ransac_iterations = 12;
+        // score the samples preemptively on growing subsets instead of all points
+        bool ransac_preemptive = true;
         // threshold between plane and point to count a point as supporting
         float ransac_threshold = 0.12;
         // amount of points, which should support the plane model to be sufficient
         float ransac_sufficient_support = 0.33;
         // how many planes per cluster getting detected
         const int ransac_detect_planes = RANSAC_DETECT_PLANES;
-        // scale factor to solve the gap problem
-        float ransac_scale_planes = 0.1;
-        // supporting points of ransac estimation
-        std::vector <glm::vec3> ransac_supporting_points;
-        // not supporting points of ransac estimation
-        std::vector <glm::vec3> ransac_not_supporting_points;
+        // mesh the occupied cells of a plane instead of its convex hull
+        bool mesh_occupancy_grid = true;
+        // corners the occupancy mesh of one plane may use
+        int mesh_vertex_budget = 64;
+        // a PlaneRegistry meshes the planes
+        bool shared_ = false;
+        // seed of the next ransac search
+        uint32_t ransac_seed = 1;
         // supporting points of best ransac estimation
         std::vector <glm::vec3> ransac_best_supporting_points;
         // not supporting points of best ransac estimation
@@ -126,6 +190,8 @@ namespace tango_augmented_reality {
         std::array<Plane, RANSAC_DETECT_PLANES> planes;
         // available planes
         std::array<bool, RANSAC_DETECT_PLANES> plane_available;
+        // distances of the current addPoints batch to each plane
+        std::array<std::vector <float>, RANSAC_DETECT_PLANES> batch_distances;
 
     };
 
@@ -32,8 +32,16 @@
 
 #include <tango-augmented-reality/pose_data.h>
 #include <tango-augmented-reality/point_cloud_drawable.h>
+#include <tango-augmented-reality/point_cloud_frame_pool.h>
 #include <tango-augmented-reality/yuv_drawable.h>
 #include <tango-augmented-reality/depth_drawable.h>
+#include <tango-augmented-reality/guided_depth_filter.h>
+#include <tango-augmented-reality/async_depth_filter.h>
+#include <tango-augmented-reality/memory_budget.h>
+#include <tango-augmented-reality/occlusion_resolve.h>
+#include <tango-augmented-reality/profiler.h>
+#include <tango-augmented-reality/ray_cast.h>
+#include <tango-augmented-reality/update_scheduler.h>
 #include <tango-augmented-reality/chisel_mesh.h>
 #include <tango-augmented-reality/plane_mesh.h>
 #include <tango-augmented-reality/ar_object.h>
@@ -113,10 +121,6 @@ namespace tango_augmented_reality {
             ar_camera_projection_matrix_ = projection_matrix;
         }
 
-        void SetPointCloudTransformation(glm::mat4 _point_cloud_transformation) {
-            point_cloud_transformation = _point_cloud_transformation;
-        }
-
         // Set the frustum render drawable object's scale. For the best visialization
         // result, we set the camera frustum object's scale to the physical camera's
         // aspect ratio.
@@ -141,31 +145,80 @@ namespace tango_augmented_reality {
         // Updates the yuv_drawable
         void OnFrameAvailable(const TangoImageBuffer *buffer);
 
-        // Updates the depth information
-        void OnXYZijAvailable(const TangoXYZij *XYZ_ij);
+        // Updates the depth information, called from the depth callback thread.
+        // @param transformation: world from depth camera matrix of this frame.
+        void OnXYZijAvailable(const TangoXYZij *XYZ_ij, const glm::mat4 &transformation);
+
+        // Choose between sampling the Tango camera texture (GL_TEXTURE_EXTERNAL_OES)
+        // and converting every color frame on the CPU, has to be set before
+        // InitGLContent.
+        void SetCameraTextureMode(bool enabled) { camera_texture_mode_ = enabled; }
+
+        bool IsCameraTextureMode() const { return camera_texture_mode_; }
+
+        // @return: true if the color frame should be converted, called from
+        //          the camera callback thread. Frames pass until the first one
+        //          is converted, Render waits for it before it reaches the
+        //          depth pose that warms the scheduler up.
+        bool ShouldProcessColorFrame() {
+            return !is_yuv_texture_available_ || scheduler_.ShouldProcessColorFrame();
+        }
+
+        // @return: texture id to connect to the color camera in camera texture mode.
+        GLuint GetCameraTextureId() const { return yuv_drawable_->GetTextureId(); }
+
+        // Takes over the newest color frame from the camera callback, call on
+        // the GL thread before Render.
+        //
+        // @return: timestamp of the latched frame, 0 before the first one.
+        double LatchColorFrame();
 
-        void ConvertYuvToRGBMat();
+        // Converts the latched color frame into rgb_frame.
+        //
+        // @return: false if it was converted already.
+        bool ConvertYuvToRGBMat();
 
         void BindRGBMatAsTexture();
 
         void ToggleFilter();
 
+        // Integrates the next rendered depth frame into the TSDF, or remeshes the
+        // planes, which take in every depth frame.
         void Tap();
 
+        // Places the cube on the next rendered depth frame along the ray.
         void AddObject(glm::vec3 from, glm::vec3 to);
 
         void SetMode(int id);
 
-        void SetShowOcclusion(bool show) { show_occlusion = show; }
+        void SetShowOcclusion(bool show) {
+            show_occlusion = show;
+            // the color texture is only filled while the reconstruction is shown
+            depth_refresh_requested_ = true;
+        }
 
         void SetDepthFullscreen(bool show) { depth_fullscreen = show; }
 
+        // In TSDF mode the occlusion depth is raycast from the TSDF instead of
+        // rendered from its mesh, while the mesh is not shown.
+        void SetTsdfRaycast(bool enabled) {
+            tsdf_raycast_ = enabled;
+            depth_refresh_requested_ = true;
+        }
+
+        // Number of point cloud frames fused for the occlusion, 1 draws the
+        // latest frame only with the old large splats.
+        void SetFusedFrames(int count) { fused_frames_ = count; }
+
         ARMode GetMode() { return mode; }
 
         void SetDepthIntrinsics(TangoCameraIntrinsics depth_intrinsics_);
 
         void ClearReconstruction();
 
+        // Persists the TSDF chunks in directory, also before InitGLContent.
+        void OpenChunkStore(const std::string &directory);
+
         void SetFilterSettings(int diameter_, double sigma_) {
             diameter = diameter_;
             sigma = sigma_;
@@ -174,6 +227,24 @@ namespace tango_augmented_reality {
         void joyStick(double angle, double power);
 
     private:
+        // Render thread side of Tap and AddObject.
+        void Integrate(PointCloudFrame *point_cloud);
+
+        void PlaceObject(PointCloudFrame *point_cloud);
+
+        // Draws the reconstruction of the current mode with the gesture camera.
+        void RenderReconstruction();
+
+        // Occlusion without OcclusionResolve: the shown reconstruction is drawn
+        // on screen and the depth blitted over the viewport.
+        void RenderOcclusionBlit();
+
+        // Updates the memory accounting of the GL thread side about once a
+        // second and, over the budget, gives up data of the largest
+        // reconstruction: the TSDF compresses more of its distant chunks, the
+        // plane tree subsamples its unassigned points.
+        void EnforceMemoryBudget();
+
         // Video overlay drawable object to display the camera image.
         YUVDrawable *yuv_drawable_;
 
@@ -197,7 +268,10 @@ namespace tango_augmented_reality {
         // A cub placed at (0.0f, 0.0f, -1.0f) location.
         ArObject *cube_;
 
-        ChiselMesh *chisel_mesh_;
+        ChiselMesh *chisel_mesh_ = nullptr;
+
+        // chunk store the next chisel_mesh_ opens, empty for none
+        std::string chunk_store_directory_;
 
         PlaneMesh *plane_mesh_;
 
@@ -215,8 +289,6 @@ namespace tango_augmented_reality {
         // The projection matrix for the first person AR camera.
         glm::mat4 ar_camera_projection_matrix_;
 
-        glm::mat4 point_cloud_transformation;
-
         size_t depth_width_;
         size_t depth_height_;
 
@@ -237,30 +309,65 @@ namespace tango_augmented_reality {
         std::atomic <bool> is_yuv_texture_available_;
         std::atomic <bool> swap_buffer_signal_;
         std::mutex yuv_buffer_mutex_;
+        // timestamps of the frames in yuv_temp_buffer_ and yuv_buffer_
+        double yuv_temp_timestamp_ = 0.0;
+        double yuv_timestamp_ = 0.0;
+        bool yuv_frame_converted_ = false;
+        bool rgb_texture_allocated_ = false;
 
         cv::Mat rgb_frame;
-        cv::Mat depth_frame;
-        std::vector <float> vertices;
+        // depth frames from the callback, consumed by the render thread only
+        PointCloudFramePool point_cloud_frames_;
+
+        // a frame arrived outside POINTCLOUD mode and was not uploaded yet
+        bool upload_pending_ = false;
+
+        // time of the last EnforceMemoryBudget check
+        int64_t memory_check_time_ = 0;
 
-        std::mutex depth_mutex_;
+        std::atomic <bool> tap_requested_;
+        std::atomic <bool> add_object_requested_;
+        std::mutex add_object_mutex_;
+        glm::vec3 add_object_from_;
+        glm::vec3 add_object_to_;
+        // points of the frame PlaceObject last fell back to
+        PointCloudRayIndex point_ray_index_;
+        double point_ray_index_timestamp_ = -1.0;
+
+        // when to integrate, convert color frames and refresh the depth
+        UpdateScheduler scheduler_;
+        std::atomic <bool> schedule_reset_requested_;
+        std::atomic <bool> depth_refresh_requested_;
 
         GLuint depth_frame_buffer_;
         GLuint depth_frame_buffer_depth_texture_;
 
-        TangoCameraIntrinsics depth_intrinsics;
+        // the GPU filter, or the CPU filter where float targets are missing
+        GuidedDepthFilter depth_filter_;
+        AsyncDepthFilter async_depth_filter_;
+
+        // single pass occlusion over the depth texture of depth_frame_buffer_
+        OcclusionResolve occlusion_resolve_;
+
+        // GPU time of the render stages, where the driver supports it
+        GpuTimer gpu_timer_;
+        GLuint guide_texture_ = 0;
 
-        TangoXYZij XYZij;
+        // last raycast TSDF depth, uploaded into the depth texture
+        std::vector <uint16_t> raycast_depth_;
+
+        TangoCameraIntrinsics depth_intrinsics;
 
         int diameter = 5;
         double sigma = 2.5;
 
         bool do_filtering = false;
+        bool camera_texture_mode_ = false;
         bool show_occlusion = false;
         bool depth_fullscreen = false;
+        bool tsdf_raycast_ = false;
+        int fused_frames_ = PointCloudDrawable::kMaxFusedFrames;
         ARMode mode = POINTCLOUD;
-
-        double last_depth_timestamp = 0;
-        double last_depth_timestamp_updated = 0;
     };
 }  // namespace tango_augmented_reality
 
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_AUGMENTED_REALITY_THREAD_POOL_H_
+#define TANGO_AUGMENTED_REALITY_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tango_augmented_reality {
+
+    // Fixed set of worker threads for data parallel loops of the reconstruction.
+    // The calling thread works on its own loop as well, so ParallelFor may be
+    // nested inside a loop body without deadlocking.
+    class ThreadPool {
+    public:
+        // Pool with one thread per big core, shared by all reconstructions.
+        static ThreadPool &Shared();
+
+        // @param worker_count: threads besides the calling one, may be 0.
+        explicit ThreadPool(int worker_count);
+
+        ~ThreadPool();
+
+        // @return: threads working on a loop, including the caller.
+        int GetConcurrency() const { return workers_.size() + 1; }
+
+        // Runs body(i) for every i in [0, count) and returns when all are done.
+        void ParallelFor(int count, const std::function<void(int)> &body);
+
+    private:
+        struct Loop {
+            const std::function<void(int)> *body;
+            int count;
+            std::atomic<int> next;
+            std::atomic<int> done;
+        };
+
+        // Runs iterations of loop until none are left.
+        void RunIterations(Loop *loop);
+
+        void WorkerLoop();
+
+        std::vector <std::thread> workers_;
+        std::mutex mutex_;
+        std::condition_variable work_condition_;
+        std::condition_variable done_condition_;
+        std::deque <std::shared_ptr<Loop>> loops_;
+        bool stop_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_THREAD_POOL_H_
@@ -0,0 +1,74 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef TANGO_AUGMENTED_REALITY_TRIPLE_BUFFER_H_
+#define TANGO_AUGMENTED_REALITY_TRIPLE_BUFFER_H_
+
+#include <atomic>
+
+namespace tango_augmented_reality {
+
+    // Lock free hand off of the latest value from one producer thread to one
+    // consumer thread. Each side owns one of three slots, the third is shared
+    // and swapped with an atomic exchange, so neither side ever waits or copies.
+    // Values the consumer did not pick up in time are overwritten.
+    template<typename T>
+    class TripleBuffer {
+    public:
+        static const int kSlotCount = 3;
+
+        TripleBuffer() : write_index_(0), read_index_(1), shared_(2), has_value_(false) { }
+
+        // Slot access for preallocation before both threads run.
+        T &Slot(int index) { return slots_[index]; }
+
+        // Producer side. Fill the returned slot, then Publish it.
+        T *BeginWrite() { return &slots_[write_index_]; }
+
+        void Publish() {
+            int previous = shared_.exchange(write_index_ | kFreshBit, std::memory_order_acq_rel);
+            write_index_ = previous & ~kFreshBit;
+        }
+
+        // Consumer side. Takes the most recently published value if there is one.
+        // @return: true if Current changed.
+        bool Acquire() {
+            if ((shared_.load(std::memory_order_relaxed) & kFreshBit) == 0) {
+                return false;
+            }
+            int previous = shared_.exchange(read_index_, std::memory_order_acq_rel);
+            read_index_ = previous & ~kFreshBit;
+            has_value_ = true;
+            return true;
+        }
+
+        // Value taken by the last successful Acquire, nullptr before the first.
+        T *Current() { return has_value_ ? &slots_[read_index_] : nullptr; }
+
+    private:
+        // set in shared_ when the slot it names was published after the last Acquire
+        static const int kFreshBit = 4;
+
+        T slots_[kSlotCount];
+
+        int write_index_;
+        int read_index_;
+        std::atomic<int> shared_;
+        bool has_value_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_TRIPLE_BUFFER_H_
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_UPDATE_SCHEDULER_H_
+#define TANGO_AUGMENTED_REALITY_UPDATE_SCHEDULER_H_
+
+#include <atomic>
+
+#include <glm/glm.hpp>
+
+namespace tango_augmented_reality {
+
+    // Decides when the expensive stages run, from the device motion and the
+    // measured stage costs of the profiler. While the device moves the
+    // reconstruction integrates as often as its cost allows, while it is
+    // still, integration, depth refresh and color conversion idle.
+    //
+    // Color frame calls come from the camera thread, all others from the GL
+    // thread.
+    class UpdateScheduler {
+    public:
+        UpdateScheduler();
+
+        // Starts over, e.g. after a mode switch: integrates the next depth
+        // frame and refreshes the depth. Color frames keep flowing. Call on
+        // the GL thread.
+        void Reset();
+
+        // Updates the motion estimate from the world from depth camera pose
+        // of a new depth frame.
+        void OnDepthPose(double timestamp, const glm::mat4 &pose);
+
+        // @return: true if the device moved faster than the still thresholds
+        //          over the last depth frames.
+        bool IsMoving() const { return moving_; }
+
+        // Color frames are skipped until the first depth frame arrived, then
+        // converted every frame while moving and every few frames when still.
+        // Also skips frames when the render thread is slower than the camera.
+        bool ShouldProcessColorFrame();
+
+        // @param pose: world from depth camera pose of the current frame.
+        // @param cost_ms: measured cost of one integration in this mode.
+        // @return: true once the device moved far enough since the last
+        //          integration and the cost budget allows another one, or
+        //          once after it came to rest.
+        bool ShouldIntegrate(double timestamp, const glm::mat4 &pose, float cost_ms);
+
+        void OnIntegrated(double timestamp, const glm::mat4 &pose);
+
+        // The occlusion depth only changes with the view or the geometry, a
+        // still view over unchanged geometry keeps the last filtered depth.
+        //
+        // @param view: view matrix the depth is rendered with.
+        // @param scene_changed: the drawn geometry changed this frame.
+        bool ShouldRefreshDepth(const glm::mat4 &view, bool scene_changed);
+
+    private:
+        std::atomic <bool> warm_;
+        std::atomic <bool> moving_;
+
+        // camera thread
+        int color_frames_skipped_;
+
+        // GL thread
+        bool has_depth_pose_;
+        double last_depth_timestamp_;
+        glm::mat4 last_depth_pose_;
+        float linear_speed_;
+        float angular_speed_;
+
+        bool has_integrated_;
+        double last_integration_timestamp_;
+        glm::mat4 last_integration_pose_;
+
+        bool has_depth_view_;
+        double last_depth_refresh_;
+        glm::mat4 last_depth_view_;
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_UPDATE_SCHEDULER_H_
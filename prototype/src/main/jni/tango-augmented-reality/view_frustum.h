@@ -0,0 +1,47 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef TANGO_AUGMENTED_REALITY_VIEW_FRUSTUM_H_
+#define TANGO_AUGMENTED_REALITY_VIEW_FRUSTUM_H_
+
+#include <glm/glm.hpp>
+
+namespace tango_augmented_reality {
+
+    // Batches a draw call kept or skipped.
+    struct CullStats {
+        int drawn = 0;
+        int culled = 0;
+    };
+
+    // Clip planes of a view projection matrix (Gribb & Hartmann), for culling
+    // whole chunks or mesh clusters before they are drawn.
+    class ViewFrustum {
+    public:
+        // @param view_projection: from the space of the boxes to clip space.
+        explicit ViewFrustum(const glm::mat4 &view_projection);
+
+        // Conservative: false only if the box is completely outside one plane.
+        bool IsBoxVisible(const glm::vec3 &min, const glm::vec3 &max) const;
+
+    private:
+        // inside where dot(plane.xyz, p) + plane.w >= 0
+        glm::vec4 planes_[6];
+    };
+}  // namespace tango_augmented_reality
+
+#endif  // TANGO_AUGMENTED_REALITY_VIEW_FRUSTUM_H_
@@ -18,11 +18,15 @@
 #define TANGO_VIDEO_OVERLAY_YUV_DRAWABLE_H_
 
 #include "tango-gl/drawable_object.h"
+#include <GLES2/gl2ext.h>
 #include <string>
 namespace tango_augmented_reality {
     class YUVDrawable : public tango_gl::DrawableObject {
     public:
-        YUVDrawable();
+        // @param: texture_target, GL_TEXTURE_2D to show an uploaded RGB texture,
+        //         GL_TEXTURE_EXTERNAL_OES to sample the Tango camera texture
+        //         directly, the YUV conversion happens in the external sampler.
+        YUVDrawable(GLenum texture_target = GL_TEXTURE_2D);
 
         void Render(const glm::mat4 &projection_mat, const glm::mat4 &view_mat) const;
 
@@ -30,10 +34,14 @@ namespace tango_augmented_reality {
 
         void SetTextureId(GLuint texture_id) { texture_id_ = texture_id; }
 
+        GLenum GetTextureTarget() const { return texture_target_; }
+
     private:
         // This id is populated on construction, and is passed to the tango service.
         GLuint texture_id_;
 
+        GLenum texture_target_;
+
         GLuint attrib_texture_coords_;
         GLuint uniform_texture_;
         GLuint vertex_buffers_[3];
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstdio>
+
+#include "tango-augmented-reality/thread_pool.h"
+
+namespace {
+    // Cores running at the highest maximum frequency. On big.LITTLE devices the
+    // little cores would only stretch a loop, since every iteration waits for
+    // the slowest one.
+    int CountBigCores() {
+        int cores = std::max(1u, std::thread::hardware_concurrency());
+        long highest = 0;
+        int big_cores = 0;
+        for (int cpu = 0; cpu < cores; ++cpu) {
+            char path[96];
+            snprintf(path, sizeof(path),
+                     "/sys/devices/system/cpu/cpu%d/cpufreq/cpuinfo_max_freq", cpu);
+            FILE *file = fopen(path, "r");
+            if (file == nullptr) {
+                return cores;
+            }
+            long frequency = 0;
+            if (fscanf(file, "%ld", &frequency) != 1) {
+                frequency = 0;
+            }
+            fclose(file);
+            if (frequency > highest) {
+                highest = frequency;
+                big_cores = 1;
+            } else if (frequency == highest) {
+                ++big_cores;
+            }
+        }
+        return std::max(1, big_cores);
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    ThreadPool &ThreadPool::Shared() {
+        static ThreadPool pool(CountBigCores() - 1);
+        return pool;
+    }
+
+    ThreadPool::ThreadPool(int worker_count) : stop_(false) {
+        for (int i = 0; i < worker_count; ++i) {
+            workers_.push_back(std::thread(&ThreadPool::WorkerLoop, this));
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard <std::mutex> lock(mutex_);
+            stop_ = true;
+        }
+        work_condition_.notify_all();
+        for (std::thread &worker : workers_) {
+            worker.join();
+        }
+    }
+
+    void ThreadPool::RunIterations(Loop *loop) {
+        int i;
+        while ((i = loop->next.fetch_add(1)) < loop->count) {
+            (*loop->body)(i);
+            if (loop->done.fetch_add(1) + 1 == loop->count) {
+                std::lock_guard <std::mutex> lock(mutex_);
+                done_condition_.notify_all();
+            }
+        }
+    }
+
+    void ThreadPool::WorkerLoop() {
+        while (true) {
+            std::shared_ptr <Loop> loop;
+            {
+                std::unique_lock <std::mutex> lock(mutex_);
+                work_condition_.wait(lock, [this] { return stop_ || !loops_.empty(); });
+                if (stop_) {
+                    return;
+                }
+                loop = loops_.front();
+                if (loop->next >= loop->count) {
+                    // every iteration is taken, the owner waits for the rest
+                    loops_.pop_front();
+                    continue;
+                }
+            }
+            RunIterations(loop.get());
+        }
+    }
+
+    void ThreadPool::ParallelFor(int count, const std::function<void(int)> &body) {
+        if (count <= 0) {
+            return;
+        }
+        if (workers_.empty() || count == 1) {
+            for (int i = 0; i < count; ++i) {
+                body(i);
+            }
+            return;
+        }
+
+        std::shared_ptr <Loop> loop = std::make_shared<Loop>();
+        loop->body = &body;
+        loop->count = count;
+        loop->next = 0;
+        loop->done = 0;
+        {
+            std::lock_guard <std::mutex> lock(mutex_);
+            loops_.push_back(loop);
+        }
+        work_condition_.notify_all();
+
+        RunIterations(loop.get());
+
+        std::unique_lock <std::mutex> lock(mutex_);
+        done_condition_.wait(lock, [&loop] { return loop->done == loop->count; });
+        for (auto queued = loops_.begin(); queued != loops_.end(); ++queued) {
+            if (*queued == loop) {
+                loops_.erase(queued);
+                break;
+            }
+        }
+    }
+}  // namespace tango_augmented_reality
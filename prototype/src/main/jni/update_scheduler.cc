@@ -0,0 +1,159 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <algorithm>
+#include <cmath>
+
+#include "tango-augmented-reality/profiler.h"
+#include "tango-augmented-reality/update_scheduler.h"
+
+namespace {
+    // below both speeds the device counts as still, m/s and rad/s
+    const float kStillSpeed = 0.05f;
+    const float kStillAngularSpeed = 0.1f;
+    // weight of the newest depth frame in the smoothed speeds
+    const float kSpeedSmoothing = 0.5f;
+
+    // motion since the last integration that is worth another one
+    const float kIntegrateDistance = 0.05f;
+    const float kIntegrateAngle = 0.1f;
+    // smaller motion is integrated once the device came to rest
+    const float kRestDistance = 0.01f;
+    const float kRestAngle = 0.02f;
+    // share of the time integration may take at most
+    const float kIntegrationDutyCycle = 0.3f;
+
+    // color frames converted when still, one in kStillColorStride
+    const int kStillColorStride = 4;
+    const float kCameraFrameMs = 1000.0f / 30.0f;
+
+    // view changes below this do not move the depth by a pixel
+    const float kViewDistance = 0.002f;
+    const float kViewAngle = 0.002f;
+    // a still depth is refreshed at least this often, seconds
+    const double kMaxDepthAge = 1.0;
+
+    float Distance(const glm::mat4 &a, const glm::mat4 &b) {
+        return glm::length(glm::vec3(a[3]) - glm::vec3(b[3]));
+    }
+
+    // angle of the rotation between the orientations of a and b
+    float Angle(const glm::mat4 &a, const glm::mat4 &b) {
+        // trace of transpose(Ra) * Rb
+        float trace = glm::dot(glm::vec3(a[0]), glm::vec3(b[0])) +
+                      glm::dot(glm::vec3(a[1]), glm::vec3(b[1])) +
+                      glm::dot(glm::vec3(a[2]), glm::vec3(b[2]));
+        float cosine = (trace - 1.0f) * 0.5f;
+        return std::acos(std::max(-1.0f, std::min(1.0f, cosine)));
+    }
+
+    double NowSeconds() {
+        return tango_augmented_reality::ProfileNowMicroseconds() * 1e-6;
+    }
+}  // namespace
+
+namespace tango_augmented_reality {
+
+    UpdateScheduler::UpdateScheduler() :
+            warm_(false),
+            color_frames_skipped_(0) {
+        Reset();
+    }
+
+    void UpdateScheduler::Reset() {
+        // warm_ stays, renders are only requested by color frames, so gating
+        // them again until the next depth pose would never render that pose
+        moving_ = false;
+        has_depth_pose_ = false;
+        last_depth_timestamp_ = 0.0;
+        linear_speed_ = 0.0f;
+        angular_speed_ = 0.0f;
+        has_integrated_ = false;
+        last_integration_timestamp_ = 0.0;
+        has_depth_view_ = false;
+        last_depth_refresh_ = 0.0;
+    }
+
+    void UpdateScheduler::OnDepthPose(double timestamp, const glm::mat4 &pose) {
+        if (has_depth_pose_ && timestamp > last_depth_timestamp_) {
+            float dt = static_cast<float>(timestamp - last_depth_timestamp_);
+            float linear = Distance(last_depth_pose_, pose) / dt;
+            float angular = Angle(last_depth_pose_, pose) / dt;
+            linear_speed_ += kSpeedSmoothing * (linear - linear_speed_);
+            angular_speed_ += kSpeedSmoothing * (angular - angular_speed_);
+            moving_ = linear_speed_ > kStillSpeed || angular_speed_ > kStillAngularSpeed;
+        }
+        has_depth_pose_ = true;
+        last_depth_timestamp_ = timestamp;
+        last_depth_pose_ = pose;
+        warm_ = true;
+    }
+
+    bool UpdateScheduler::ShouldProcessColorFrame() {
+        if (!warm_) {
+            return false;
+        }
+        int stride = moving_ ? 1 : kStillColorStride;
+        // no point in converting frames the render thread cannot show
+        ProfileStats frame;
+        if (GetProfileStats(PROFILE_FRAME, false, &frame)) {
+            stride = std::max(stride, static_cast<int>(std::ceil(frame.p50 / kCameraFrameMs)));
+        }
+        if (++color_frames_skipped_ < stride) {
+            return false;
+        }
+        color_frames_skipped_ = 0;
+        return true;
+    }
+
+    bool UpdateScheduler::ShouldIntegrate(double timestamp, const glm::mat4 &pose, float cost_ms) {
+        if (!has_integrated_) {
+            return true;
+        }
+        double min_interval = cost_ms * 1e-3 / kIntegrationDutyCycle;
+        if (timestamp - last_integration_timestamp_ < min_interval) {
+            return false;
+        }
+        float distance = Distance(last_integration_pose_, pose);
+        float angle = Angle(last_integration_pose_, pose);
+        if (moving_) {
+            return distance > kIntegrateDistance || angle > kIntegrateAngle;
+        }
+        return distance > kRestDistance || angle > kRestAngle;
+    }
+
+    void UpdateScheduler::OnIntegrated(double timestamp, const glm::mat4 &pose) {
+        has_integrated_ = true;
+        last_integration_timestamp_ = timestamp;
+        last_integration_pose_ = pose;
+    }
+
+    bool UpdateScheduler::ShouldRefreshDepth(const glm::mat4 &view, bool scene_changed) {
+        double now = NowSeconds();
+        // with equal rotations the view translations move as far as the camera
+        bool refresh = scene_changed || !has_depth_view_ ||
+                       now - last_depth_refresh_ > kMaxDepthAge ||
+                       Angle(last_depth_view_, view) > kViewAngle ||
+                       Distance(last_depth_view_, view) > kViewDistance;
+        if (refresh) {
+            has_depth_view_ = true;
+            last_depth_refresh_ = now;
+            last_depth_view_ = view;
+        }
+        return refresh;
+    }
+}  // namespace tango_augmented_reality
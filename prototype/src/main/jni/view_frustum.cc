@@ -0,0 +1,43 @@
+/*
+ * Copyright 2014 Google Inc. All Rights Reserved.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include "tango-augmented-reality/view_frustum.h"
+
+namespace tango_augmented_reality {
+
+    ViewFrustum::ViewFrustum(const glm::mat4 &view_projection) {
+        // glm is column major, row i of the matrix is column i of the transpose
+        glm::mat4 rows = glm::transpose(view_projection);
+        for (int axis = 0; axis < 3; ++axis) {
+            planes_[2 * axis] = rows[3] + rows[axis];
+            planes_[2 * axis + 1] = rows[3] - rows[axis];
+        }
+    }
+
+    bool ViewFrustum::IsBoxVisible(const glm::vec3 &min, const glm::vec3 &max) const {
+        for (const glm::vec4 &plane : planes_) {
+            // the corner farthest along the plane normal
+            glm::vec3 corner(plane.x >= 0.0f ? max.x : min.x,
+                             plane.y >= 0.0f ? max.y : min.y,
+                             plane.z >= 0.0f ? max.z : min.z);
+            if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+                return false;
+            }
+        }
+        return true;
+    }
+}  // namespace tango_augmented_reality
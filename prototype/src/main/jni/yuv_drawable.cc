@@ -44,22 +44,42 @@ namespace {
                     "void main() {\n"
                     "  gl_FragColor = texture2D(texture, f_textureCoords);\n"
                     "}\n";
+
+    // The camera texture stores the first image row at v = 0, the uploaded
+    // RGB texture is flipped, so v is mirrored here.
+    const std::string kExternalFragmentShader =
+            "#extension GL_OES_EGL_image_external : require\n"
+                    "precision highp float;\n"
+                    "precision highp int;\n"
+                    "uniform samplerExternalOES texture;\n"
+                    "varying vec2 f_textureCoords;\n"
+                    "void main() {\n"
+                    "  gl_FragColor = texture2D(texture,\n"
+                    "      vec2(f_textureCoords.x, 1.0 - f_textureCoords.y));\n"
+                    "}\n";
 }
 
 namespace tango_augmented_reality {
 
-    YUVDrawable::YUVDrawable() {
+    YUVDrawable::YUVDrawable(GLenum texture_target) : texture_target_(texture_target) {
         glEnable(GL_VERTEX_PROGRAM_POINT_SIZE);
+        const std::string &fragment_shader = texture_target_ == GL_TEXTURE_EXTERNAL_OES ?
+                                             kExternalFragmentShader : kFragmetnShader;
         shader_program_ = tango_gl::util::CreateProgram(kVertexShader.c_str(),
-                                                        kFragmetnShader.c_str());
+                                                        fragment_shader.c_str());
         if (!shader_program_) {
             LOGE("Could not create program.");
         }
 
         glGenTextures(1, &texture_id_);
-        glBindTexture(GL_TEXTURE_2D, texture_id_);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(texture_target_, texture_id_);
+        if (texture_target_ == GL_TEXTURE_EXTERNAL_OES) {
+            glTexParameteri(texture_target_, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(texture_target_, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        } else {
+            glTexParameteri(texture_target_, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+            glTexParameteri(texture_target_, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        }
         uniform_texture_ = glGetUniformLocation(shader_program_, "texture");
 
         glGenBuffers(3, vertex_buffers_);
@@ -106,7 +126,7 @@ namespace tango_augmented_reality {
 
         glUniform1i(uniform_texture_, 2);
         glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, texture_id_);
+        glBindTexture(texture_target_, texture_id_);
 
         glm::mat4 model_mat = GetTransformationMatrix();
         glm::mat4 mvp_mat = projection_mat * view_mat * model_mat;